@@ -107,7 +107,9 @@ static AppWindowHandle * appGlCoreInitInternal(const int glVersionMajor, const i
     std::printf("GLSL_VERSION: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 
     std::printf("Attempting to initialize sample renderer with GL Core profile...\n");
-    (*outRenderInterface) = new ntb::RenderInterfaceDefaultGLCore(windowWidth, windowHeight);
+    ntb::RenderInterfaceDefaultGLCore * renderInterface = new ntb::RenderInterfaceDefaultGLCore(windowWidth, windowHeight);
+    std::printf("Buffer streaming: %s\n", renderInterface->bufferStreamingToString(renderInterface->getBufferStreaming()));
+    (*outRenderInterface) = renderInterface;
 
     return reinterpret_cast<AppWindowHandle *>(window);
 }
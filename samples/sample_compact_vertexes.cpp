@@ -0,0 +1,116 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_compact_vertexes.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Compares the size of a text heavy frame with full VertexPTC vertexes and with VertexPTCCompact
+//  (RenderInterface::supportsCompactVertexes), using the software rasterizer, which draws the
+//  compact frames through the default RenderInterface::drawPackedFrame() that unpacks them again.
+//  Prints the vertex bytes of each frame in both draw orders, with and without primitive sorting.
+//  Returns non-zero if a compact frame is not smaller, if any pixel differs from the full format
+//  frame by more than the rounding of the texture coordinates, or if a frame with a Panel moved
+//  outside the compact position range does not fall back to the full format.
+// ================================================================================================
+
+#define NTB_DEFAULT_RENDERER_SOFTWARE
+#include "ntb_renderer_software.hpp"
+#include "sample_utils.hpp"
+
+// ========================================================
+
+// Takes compact vertexes if enabled and keeps the vertex bytes of the last frame submitted.
+class CompactVertexRenderer final : public SoftwareForwardingRenderer
+{
+public:
+    explicit CompactVertexRenderer(ntb::RenderInterfaceSoftware * sw) : SoftwareForwardingRenderer(sw) { }
+    ~CompactVertexRenderer();
+
+    bool supportsCompactVertexes() const override
+    {
+        return useCompact;
+    }
+    void drawPackedFrame(const ntb::PackedFrame & frame) override
+    {
+        wasCompact  = (frame.compactVerts != nullptr);
+        vertexBytes = frame.vertCount * int(sizeof(ntb::VertexPTC)) + frame.lineVertCount * int(sizeof(ntb::VertexPC));
+        if (wasCompact)
+        {
+            vertexBytes += frame.compactVertCount * int(sizeof(ntb::VertexPTCCompact));
+        }
+        // The default implementation, which unpacks the compact vertexes for draw2DTriangles().
+        RenderInterface::drawPackedFrame(frame);
+    }
+
+    bool useCompact  = false;
+    bool wasCompact  = false;
+    int  vertexBytes = 0;
+};
+CompactVertexRenderer::~CompactVertexRenderer()
+{ }
+
+static std::vector<std::uint8_t> renderFormat(ntb::RenderInterfaceSoftware & software, CompactVertexRenderer & renderer,
+                                              ntb::GUI * gui, const bool compact)
+{
+    renderer.useCompact = compact;
+    return renderFrame(software, gui);
+}
+
+// Same frame in both formats. Returns false if the compact one isn't any smaller or looks different.
+// The quantized UVs move the bilinear samples of the glyphs a tiny bit, which is allowed to change a
+// color channel by one.
+static bool compareFormats(ntb::RenderInterfaceSoftware & software, CompactVertexRenderer & renderer,
+                           ntb::GUI * gui, const char * title)
+{
+    const std::vector<std::uint8_t> fullImage = renderFormat(software, renderer, gui, false);
+    const int fullBytes = renderer.vertexBytes;
+
+    const std::vector<std::uint8_t> compactImage = renderFormat(software, renderer, gui, true);
+    const int compactBytes = renderer.vertexBytes;
+
+    const int differing = countDifferingPixels(fullImage, compactImage, 0);
+    const int differingMoreThanRounding = countDifferingPixels(fullImage, compactImage, 1);
+
+    std::printf("%-20s: %6i vertex bytes full, %6i compact (%.1f%%), %i pixels differ, %i by more than 1.\n", title,
+                fullBytes, compactBytes, 100.0 * compactBytes / fullBytes, differing, differingMoreThanRounding);
+
+    return renderer.wasCompact && compactBytes < fullBytes && differingMoreThanRounding == 0;
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    ntb::RenderInterfaceSoftware software(kWidth, kHeight);
+    CompactVertexRenderer renderer(&software);
+    ntb::initialize(&shell, &renderer);
+
+    TextPanelsData data;
+    ntb::GUI * gui = createTextPanelsGUI("Compact vertexes", data);
+    gui->onMouseMotion(150, 120);
+
+    bool ok = true;
+    ok &= compareFormats(software, renderer, gui, "Depth layers");
+    gui->setPrimitiveSorting(true);
+    ok &= compareFormats(software, renderer, gui, "Depth layers, sorted");
+    gui->setPrimitiveSorting(false);
+
+    software.setDrawWithDepthTest(false);
+    ok &= compareFormats(software, renderer, gui, "Painter");
+    gui->setPrimitiveSorting(true);
+    ok &= compareFormats(software, renderer, gui, "Painter, sorted");
+    gui->setPrimitiveSorting(false);
+    software.savePNG("sample_compact_vertexes.png");
+
+    // Way past the 8192 pixels a compact position can reach.
+    gui->findPanel("Panel 2")->setPosition(9000, 20);
+    renderFormat(software, renderer, gui, true);
+    std::printf("Panel out of the compact range: frame %s.\n", renderer.wasCompact ? "still COMPACT" : "in the full format");
+    ok &= !renderer.wasCompact;
+
+    ntb::shutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_frame_allocations.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Checks that GUI::onFrameRender() makes no memory allocations once the UI has warmed up.
+//  Renders a Panel with a few hundred variables, including long strings and values that
+//  format to long text, changing some of them every frame. Prints the allocation counters
+//  of each subsystem and returns non-zero if any steady-state frame allocated memory. Runs
+//  a second time with a renderer that takes compact vertexes and glyph instances, but leaves
+//  unpacking them to the default RenderInterface::drawPackedFrame().
+// ================================================================================================
+
+#include "ntb.hpp"
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+#if !defined(NEO_TWEAK_BAR_STD_STRING_INTEROP)
+    #error "NEO_TWEAK_BAR_STD_STRING_INTEROP is required for this sample!"
+#endif // NEO_TWEAK_BAR_STD_STRING_INTEROP
+
+// ========================================================
+
+class MyNTBShellInterfaceNull final : public ntb::ShellInterface
+{
+public:
+    ~MyNTBShellInterfaceNull();
+    std::int64_t getTimeMilliseconds() const override { return timeMs; }
+    std::int64_t timeMs = 0;
+};
+MyNTBShellInterfaceNull::~MyNTBShellInterfaceNull()
+{ }
+
+class MyNTBRenderInterfaceNull final : public ntb::RenderInterface
+{
+public:
+    ~MyNTBRenderInterfaceNull();
+    bool supportsCompactVertexes() const override { return compactVertexes; }
+    bool supportsGlyphInstances() const override { return glyphInstances; }
+    void getViewport(int * viewportX, int * viewportY, int * viewportWidth, int * viewportHeight) const override
+    {
+        *viewportX = 0;
+        *viewportY = 0;
+        *viewportWidth  = 1024;
+        *viewportHeight = 768;
+    }
+    bool compactVertexes = false;
+    bool glyphInstances  = false;
+};
+MyNTBRenderInterfaceNull::~MyNTBRenderInterfaceNull()
+{ }
+
+// ========================================================
+
+enum class Quality
+{
+    Low,
+    Medium,
+    High
+};
+
+static const ntb::EnumConstant qualityConsts[] =
+{
+    ntb::EnumTypeDecl<Quality>(),
+    ntb::EnumConstant("Low",    Quality::Low),
+    ntb::EnumConstant("Medium", Quality::Medium),
+    ntb::EnumConstant("High",   Quality::High)
+};
+
+static const int kNumFloats = 300;
+
+struct SampleData
+{
+    float       floats[kNumFloats] = {};
+    float       vec4[4]   = {};
+    float       color[4]  = { 1.0f, 0.5f, 0.25f, 1.0f };
+    bool        flag      = false;
+    double      huge      = 1e100; // "%f" formats to over a hundred chars.
+    Quality     quality   = Quality::Medium;
+    char        cstr[64]  = "a C string value longer than the inline SmallStr buffer";
+    std::string stdStr    = "a std::string value also longer than the inline buffer";
+};
+
+// Mix of changed, unchanged and forced refresh frames, with the mouse hovering around.
+static void runFrame(ntb::GUI * gui, MyNTBShellInterfaceNull & shell, SampleData & data, const int i)
+{
+    shell.timeMs += 16;
+    data.floats[i % kNumFloats] += 0.5f;
+    data.vec4[i % 4] -= 0.25f;
+    data.huge = (i % 2) ? 1e100 : -3e99;
+    if ((i % 10) == 0)
+    {
+        data.flag = !data.flag;
+        data.stdStr[0] = static_cast<char>('a' + (i / 10) % 26);
+    }
+
+    gui->onMouseMotion(100 + (i % 17) * 20, 100 + (i % 23) * 25);
+    gui->onFrameRender((i % 50) == 0);
+}
+
+static void printStats(const char * title, const ntb::AllocationStats & stats)
+{
+    std::printf("%s: %lld allocations\n", title, static_cast<long long>(stats.getTotalAllocCount()));
+    for (int i = 0; i < int(ntb::MemoryTag::Count); ++i)
+    {
+        const ntb::MemoryTag tag = ntb::MemoryTag(i);
+        if (stats.getAllocCount(tag) != 0)
+        {
+            std::printf("  %-14s %6lld allocs, %8lld bytes\n", ntb::memoryTagToString(tag),
+                        static_cast<long long>(stats.getAllocCount(tag)),
+                        static_cast<long long>(stats.getAllocBytes(tag)));
+        }
+    }
+}
+
+// Warms up the GUI, then returns the number of steady-state frames that allocated memory.
+static int runFrames(ntb::GUI * gui, MyNTBShellInterfaceNull & shell, SampleData & data, const char * title)
+{
+    std::printf("---- %s ----\n", title);
+
+    // Warm-up: The first frames allocate the batches, caches and frame arena.
+    const int warmUpFrames = 60;
+    for (int i = 0; i < warmUpFrames; ++i)
+    {
+        runFrame(gui, shell, data, i);
+    }
+    printStats("Warm-up", ntb::getAllocationStats());
+
+    // Steady state: Same kind of frames, which should no longer allocate.
+    ntb::resetAllocationStats();
+    int allocatingFrames = 0;
+
+    const int frameCount = 300;
+    for (int i = 0; i < frameCount; ++i)
+    {
+        runFrame(gui, shell, data, warmUpFrames + i);
+
+        if (gui->getLastFrameAllocationStats().getTotalAllocCount() != 0)
+        {
+            ++allocatingFrames;
+        }
+    }
+
+    printStats("Steady state", ntb::getAllocationStats());
+    std::printf("%i of %i frames allocated memory.\n", allocatingFrames, frameCount);
+
+    ntb::resetAllocationStats();
+    return allocatingFrames;
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    MyNTBRenderInterfaceNull renderer;
+    ntb::initialize(&shell, &renderer);
+
+    static SampleData data;
+    ntb::GUI * gui = ntb::createGUI("Frame allocations");
+    ntb::Panel * panel = gui->createPanel("Variables");
+    panel->setSize(600, 740);
+
+    // Long values first, so they are visible.
+    panel->addStringRW("cstr", data.cstr, ntb::lengthOfArray(data.cstr));
+    panel->addStringRW("stdStr", &data.stdStr);
+    panel->addNumberRW("huge", &data.huge);
+    panel->addEnumRW("quality", &data.quality, qualityConsts, ntb::lengthOfArray(qualityConsts));
+    panel->addFloatVecRW("vec4", data.vec4, 4);
+    panel->addColorRW("color", data.color, 4);
+    panel->addBoolRW("flag", &data.flag);
+
+    ntb::Variable * group = panel->addHierarchyParent("Group");
+    for (int i = 0; i < kNumFloats; ++i)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "Settings/Float_%03d", i);
+        panel->addNumberRW((i % 2) ? group : nullptr, name, &data.floats[i]);
+    }
+
+    int allocatingFrames = runFrames(gui, shell, data, "Default renderer");
+
+    renderer.compactVertexes = true;
+    renderer.glyphInstances  = true;
+    allocatingFrames += runFrames(gui, shell, data, "Compact vertexes and glyph instances");
+
+    ntb::shutdown();
+    return (allocatingFrames == 0) ? 0 : 1;
+}
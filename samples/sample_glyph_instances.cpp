@@ -0,0 +1,137 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_glyph_instances.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Compares the size of a text heavy frame with the text drawn as triangles and as one GlyphInstance
+//  per glyph (RenderInterface::supportsGlyphInstances), using the software rasterizer, which draws
+//  the instances through the default RenderInterface::drawPackedFrame() that expands them to quads.
+//  Prints the vertex, index and instance bytes of each frame in both draw orders, with and without
+//  primitive sorting, and the time to build and draw the frames. Returns non-zero if the instanced
+//  frame is not smaller, if any pixel differs from the triangles frame by more than the rounding of
+//  the texture coordinates, or if a frame redrawn from the cached Panel geometry differs from the
+//  first one.
+// ================================================================================================
+
+#define NTB_DEFAULT_RENDERER_SOFTWARE
+#include "ntb_renderer_software.hpp"
+#include "sample_utils.hpp"
+
+#include <chrono>
+
+// ========================================================
+
+// Takes glyph instances if enabled and keeps the sizes of the last frame submitted.
+class GlyphInstanceRenderer final : public SoftwareForwardingRenderer
+{
+public:
+    explicit GlyphInstanceRenderer(ntb::RenderInterfaceSoftware * sw) : SoftwareForwardingRenderer(sw) { }
+    ~GlyphInstanceRenderer();
+
+    bool supportsGlyphInstances() const override
+    {
+        return useGlyphs;
+    }
+    void drawPackedFrame(const ntb::PackedFrame & frame) override
+    {
+        frameBytes = frame.vertCount     * int(sizeof(ntb::VertexPTC))       +
+                     frame.lineVertCount * int(sizeof(ntb::VertexPC))        +
+                     frame.indexCount    * int(sizeof(std::uint16_t))        +
+                     frame.glyphCount    * int(sizeof(ntb::GlyphInstance));
+        glyphCount = frame.glyphCount;
+        // The default implementation, which expands the glyph instances for draw2DTriangles().
+        RenderInterface::drawPackedFrame(frame);
+    }
+
+    bool useGlyphs  = false;
+    int  frameBytes = 0;
+    int  glyphCount = 0;
+};
+GlyphInstanceRenderer::~GlyphInstanceRenderer()
+{ }
+
+static std::vector<std::uint8_t> renderFrames(ntb::RenderInterfaceSoftware & software, GlyphInstanceRenderer & renderer,
+                                              ntb::GUI * gui, const bool glyphs, const int frameCount, double * ms)
+{
+    renderer.useGlyphs = glyphs;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        gui->onFrameRender(true);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    if (ms != nullptr)
+    {
+        *ms = std::chrono::duration<double, std::milli>(end - start).count() / frameCount;
+    }
+    return copyFramebuffer(software);
+}
+
+// Same frame with both text paths. Returns false if the instanced frame isn't any smaller or looks different.
+// The quantized UVs of the instances move the bilinear samples of the glyphs a tiny bit, which is allowed
+// to change a color channel by one. The first instanced frame rebuilds the Panel geometry, the next ones
+// draw from the cached segments and must look the same.
+static bool compareTextPaths(ntb::RenderInterfaceSoftware & software, GlyphInstanceRenderer & renderer,
+                             ntb::GUI * gui, const char * title)
+{
+    const int frameCount = 10;
+    double trisMs = 0.0, glyphsMs = 0.0;
+
+    const std::vector<std::uint8_t> trisImage = renderFrames(software, renderer, gui, false, frameCount, &trisMs);
+    const int trisBytes = renderer.frameBytes;
+
+    const std::vector<std::uint8_t> firstGlyphsImage = renderFrames(software, renderer, gui, true, 1, nullptr);
+    const std::vector<std::uint8_t> glyphsImage = renderFrames(software, renderer, gui, true, frameCount, &glyphsMs);
+    const int glyphsBytes = renderer.frameBytes;
+    const int glyphCount  = renderer.glyphCount;
+
+    const int differing = countDifferingPixels(trisImage, glyphsImage, 0);
+    const int differingMoreThanRounding = countDifferingPixels(trisImage, glyphsImage, 1);
+    const int differingFromFirst = countDifferingPixels(firstGlyphsImage, glyphsImage, 0);
+
+    // Four vertexes and six indexes per glyph as triangles.
+    const int glyphAsTrisBytes = int(sizeof(ntb::VertexPTC)) * 4 + int(sizeof(std::uint16_t)) * 6;
+    std::printf("%-20s: %6i frame bytes with text as triangles, %6i instanced, %i glyphs at %i bytes instead of %i (%.1fx). "
+                "%i pixels differ, %i by more than 1. %.3f / %.3f ms/frame.\n", title,
+                trisBytes, glyphsBytes, glyphCount, int(sizeof(ntb::GlyphInstance)), glyphAsTrisBytes,
+                double(glyphAsTrisBytes) / sizeof(ntb::GlyphInstance), differing, differingMoreThanRounding, trisMs, glyphsMs);
+
+    if (differingFromFirst != 0)
+    {
+        std::printf("  %i pixels differ between the first and the cached instanced frames!\n", differingFromFirst);
+    }
+    return glyphCount > 0 && glyphsBytes < trisBytes && differingMoreThanRounding == 0 && differingFromFirst == 0;
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    ntb::RenderInterfaceSoftware software(kWidth, kHeight);
+    GlyphInstanceRenderer renderer(&software);
+    ntb::initialize(&shell, &renderer);
+
+    TextPanelsData data;
+    ntb::GUI * gui = createTextPanelsGUI("Glyph instances", data);
+    gui->onMouseMotion(150, 120);
+
+    bool ok = true;
+    ok &= compareTextPaths(software, renderer, gui, "Depth layers");
+    gui->setPrimitiveSorting(true);
+    ok &= compareTextPaths(software, renderer, gui, "Depth layers, sorted");
+    gui->setPrimitiveSorting(false);
+
+    software.setDrawWithDepthTest(false);
+    ok &= compareTextPaths(software, renderer, gui, "Painter");
+    gui->setPrimitiveSorting(true);
+    ok &= compareTextPaths(software, renderer, gui, "Painter, sorted");
+    gui->setPrimitiveSorting(false);
+    software.savePNG("sample_glyph_instances.png");
+
+    ntb::shutdown();
+    return ok ? 0 : 1;
+}
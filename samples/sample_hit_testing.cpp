@@ -0,0 +1,135 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_hit_testing.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Times the mouse motion events over a Panel with a growing number of variables, which only
+//  test the widgets around the cursor (see Widget::refreshHitBounds), so the time per event
+//  should stay about the same as the Panel grows. For each size, a second GUI, identical but
+//  only given the last mouse position, is rendered with the software rasterizer next to the
+//  first one. Returns non-zero if the two images differ, meaning some widget skipped by the
+//  hit testing was left with the hover state of an older mouse position.
+// ================================================================================================
+
+#define NTB_DEFAULT_RENDERER_SOFTWARE
+#include "ntb_renderer_software.hpp"
+#include "sample_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// ========================================================
+
+struct SampleData
+{
+    std::vector<float> floats;
+    bool               flags[8] = {};
+    float              color[4] = { 1.0f, 0.5f, 0.25f, 1.0f };
+    std::string        name     = "Hit testing";
+};
+
+static ntb::GUI * createSampleGUI(const char * guiName, SampleData & data, const int varCount)
+{
+    ntb::GUI * gui = ntb::createGUI(guiName);
+
+    ntb::Panel * panel1 = gui->createPanel("Variables");
+    panel1->setPosition(20, 20);
+    panel1->setSize(420, 720);
+    panel1->addStringRW("name", &data.name);
+    panel1->addColorRW("color", data.color, 4);
+
+    data.floats.resize(varCount);
+    for (int i = 0; i < varCount; ++i)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "Var_%05d", i);
+        if ((i % 10) == 0)
+        {
+            panel1->addBoolRW(name, &data.flags[(i / 10) % ntb::lengthOfArray(data.flags)]);
+        }
+        else
+        {
+            data.floats[i] = i * 0.5f;
+            panel1->addNumberRW(name, &data.floats[i]);
+        }
+    }
+
+    ntb::Panel * panel2 = gui->createPanel("Small");
+    panel2->setPosition(480, 100);
+    panel2->setSize(360, 300);
+    panel2->addStringRO("name", &data.name);
+    panel2->addColorRO("color", data.color, 4);
+
+    return gui;
+}
+
+// Random walk of the cursor over both Panels, with a jump every now and then. Returns false if the
+// GUI that got all the events doesn't look the same as the one that only got the last position.
+static bool runBenchmark(ntb::RenderInterfaceSoftware & renderer, const int varCount, const int motionCount)
+{
+    SampleData data, dataRef;
+    ntb::GUI * gui    = createSampleGUI("Hit testing", data, varCount);
+    ntb::GUI * guiRef = createSampleGUI("Hit testing reference", dataRef, varCount);
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> step(-40, 40);
+    std::uniform_int_distribution<int> jumpX(0, kWidth - 1);
+    std::uniform_int_distribution<int> jumpY(0, kHeight - 1);
+
+    int mx = 200, my = 400;
+    double totalMs = 0.0;
+    for (int i = 0; i < motionCount; ++i)
+    {
+        if ((i % 50) == 0)
+        {
+            mx = jumpX(rng);
+            my = jumpY(rng);
+        }
+        else
+        {
+            mx = std::min(std::max(mx + step(rng), 0), kWidth  - 1);
+            my = std::min(std::max(my + step(rng), 0), kHeight - 1);
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        gui->onMouseMotion(mx, my);
+        const auto end = std::chrono::high_resolution_clock::now();
+        totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    guiRef->onMouseMotion(mx, my);
+
+    const std::vector<std::uint8_t> image    = renderFrame(renderer, gui);
+    const std::vector<std::uint8_t> imageRef = renderFrame(renderer, guiRef);
+
+    const int differing = countDifferingPixels(image, imageRef);
+
+    std::printf("%5i variables: %.4f ms/motion over %i motions, %i pixels differ from the reference.\n",
+                varCount, totalMs / motionCount, motionCount, differing);
+
+    ntb::destroyGUI(gui);
+    ntb::destroyGUI(guiRef);
+    return differing == 0;
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    ntb::RenderInterfaceSoftware renderer(kWidth, kHeight);
+    ntb::initialize(&shell, &renderer);
+
+    bool ok = true;
+    ok &= runBenchmark(renderer, 10,   5000);
+    ok &= runBenchmark(renderer, 100,  5000);
+    ok &= runBenchmark(renderer, 1000, 5000);
+    ok &= runBenchmark(renderer, 5000, 5000);
+    renderer.savePNG("sample_hit_testing.png");
+
+    ntb::shutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_line_quads.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Benchmarks drawing lines as native lines against drawing them as quads in the 2D triangles
+//  batch (GUI::setLinesAsQuads), using the software rasterizer. For each mode, at UI scaling 1
+//  and 2 and in both draw orders, prints the draw commands and the vertex and index volume of
+//  the frame, and the time to build and rasterize it. Returns non-zero if a frame with quads
+//  still has a lines command, or if more than a few pixels differ between native lines and one
+//  pixel wide quads in painter's order (in depth layers order, the quads are drawn before the
+//  text instead of after it, which changes the blending of a few translucent pixels).
+// ================================================================================================
+
+#define NTB_DEFAULT_RENDERER_SOFTWARE
+#include "ntb_renderer_software.hpp"
+#include "sample_utils.hpp"
+
+#include <chrono>
+
+// ========================================================
+
+// Keeps the sizes of the last frame submitted.
+class FrameSizeRenderer final : public SoftwareForwardingRenderer
+{
+public:
+    explicit FrameSizeRenderer(ntb::RenderInterfaceSoftware * sw) : SoftwareForwardingRenderer(sw) { }
+    ~FrameSizeRenderer();
+
+    void drawPackedFrame(const ntb::PackedFrame & frame) override
+    {
+        vertexBytes  = frame.vertCount * int(sizeof(ntb::VertexPTC)) + frame.lineVertCount * int(sizeof(ntb::VertexPC));
+        indexBytes   = frame.indexCount * int(sizeof(std::uint16_t));
+        commands     = frame.commandCount;
+        lineCommands = 0;
+        for (int c = 0; c < frame.commandCount; ++c)
+        {
+            lineCommands += (frame.commands[c].type == ntb::DrawCommandType::Lines);
+        }
+        software->drawPackedFrame(frame);
+    }
+
+    int vertexBytes  = 0;
+    int indexBytes   = 0;
+    int commands     = 0;
+    int lineCommands = 0;
+};
+FrameSizeRenderer::~FrameSizeRenderer()
+{ }
+
+// ========================================================
+
+struct SampleData
+{
+    float       floats[30] = {};
+    float       color[4]   = { 0.5f, 0.75f, 1.0f, 1.0f };
+    bool        flag       = true;
+    std::string name       = "Line quads";
+};
+
+// Built again for each run, so the panels start at the size of the current UI scaling.
+static ntb::GUI * createSampleGUI(SampleData & data, const bool linesAsQuads, const float uiScaling)
+{
+    ntb::GUI * gui = ntb::createGUI("Line quads");
+    gui->setLinesAsQuads(linesAsQuads);
+    gui->setGlobalUIScaling(uiScaling);
+
+    for (int p = 0; p < 3; ++p)
+    {
+        char title[32];
+        std::snprintf(title, sizeof(title), "Panel %i", p);
+
+        ntb::Panel * panel = gui->createPanel(title);
+        panel->setPosition(20 + p * 330, 20 + p * 40);
+        panel->addStringRW("name", &data.name);
+        panel->addBoolRW("flag", &data.flag);
+        panel->addColorRW("color", data.color, 4);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "Float_%02d", i);
+            panel->addNumberRW(name, &data.floats[p * 10 + i]);
+        }
+    }
+    return gui;
+}
+
+static std::vector<std::uint8_t> runBenchmark(ntb::RenderInterfaceSoftware & software, FrameSizeRenderer & renderer,
+                                              const bool linesAsQuads, const float uiScaling, bool * ok)
+{
+    const bool painterOrder = !software.isDrawingWithDepthTest();
+    const int frameCount = 20;
+    SampleData data;
+    ntb::GUI * gui = createSampleGUI(data, linesAsQuads, uiScaling);
+    gui->onMouseMotion(150, 120);
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        gui->onFrameRender(true);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(end - start).count() / frameCount;
+
+    std::printf("%-7s %-12s scale %.0f: %3i commands (%3i lines), %6i vertex bytes, %5i index bytes, %3i lines rasterized, %.3f ms/frame\n",
+                painterOrder ? "Painter" : "Depth", linesAsQuads ? "Line quads" : "Native lines", uiScaling,
+                renderer.commands, renderer.lineCommands,
+                renderer.vertexBytes, renderer.indexBytes, software.getLastFrameLineCount(), ms);
+
+    if (linesAsQuads && renderer.lineCommands != 0)
+    {
+        *ok = false;
+    }
+
+    ntb::destroyGUI(gui);
+    return copyFramebuffer(software);
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    ntb::RenderInterfaceSoftware software(kWidth, kHeight);
+    FrameSizeRenderer renderer(&software);
+    ntb::initialize(&shell, &renderer);
+
+    bool ok = true;
+    runBenchmark(software, renderer, false, 1.0f, &ok);
+    runBenchmark(software, renderer, true,  1.0f, &ok);
+    runBenchmark(software, renderer, false, 2.0f, &ok);
+    runBenchmark(software, renderer, true,  2.0f, &ok);
+    software.savePNG("sample_line_quads.png"); // Lines as quads at scale 2.
+
+    software.setDrawWithDepthTest(false);
+    const std::vector<std::uint8_t> nativeImage = runBenchmark(software, renderer, false, 1.0f, &ok);
+    const std::vector<std::uint8_t> quadsImage  = runBenchmark(software, renderer, true,  1.0f, &ok);
+    runBenchmark(software, renderer, false, 2.0f, &ok);
+    runBenchmark(software, renderer, true,  2.0f, &ok);
+
+    // The diagonals of the arrowheads can light the pixel next to the native one where they
+    // pass exactly between two pixels. Anything more means the quads are misplaced.
+    const int maxDiagonalTies = 64;
+    const int differing = countDifferingPixels(nativeImage, quadsImage);
+    std::printf("%i pixels differ between native lines and one pixel wide quads.\n", differing);
+    ok &= (differing <= maxDiagonalTies);
+    ntb::shutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_number_format_bench.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Microbenchmark for the number => string conversions used to display variable values.
+//  Compares SmallStr::fromNumber() against the snprintf/divide-loop implementation it
+//  replaced and checks that both produce exactly the same text for every NumberFormat.
+// ================================================================================================
+
+#include "ntb.hpp"
+#include "ntb_utils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+// ========================================================
+
+class MyNTBShellInterfaceNull final : public ntb::ShellInterface
+{
+public:
+    ~MyNTBShellInterfaceNull();
+    std::int64_t getTimeMilliseconds() const override { return 0; }
+};
+MyNTBShellInterfaceNull::~MyNTBShellInterfaceNull()
+{ }
+
+class MyNTBRenderInterfaceNull final : public ntb::RenderInterface
+{
+public:
+    ~MyNTBRenderInterfaceNull();
+};
+MyNTBRenderInterfaceNull::~MyNTBRenderInterfaceNull()
+{ }
+
+// ========================================================
+// Reference implementations (previous library code):
+// ========================================================
+
+static void refFloatToString(const double num, const int decimals, char * buffer, const int bufferSize)
+{
+    std::snprintf(buffer, bufferSize, "%.*f", decimals, num);
+    buffer[bufferSize - 1] = '\0';
+
+    // Trim trailing zeros to the right of the decimal point:
+    for (char * ptr = buffer; *ptr != '\0'; ++ptr)
+    {
+        if (*ptr != '.')
+        {
+            continue;
+        }
+        while (*++ptr != '\0')
+        {
+        }
+        while (*--ptr == '0')
+        {
+            *ptr = '\0';
+        }
+        if (*ptr == '.')
+        {
+            *ptr = '\0';
+        }
+        break;
+    }
+}
+
+static void refIntToString(std::uint64_t number, char * dest, const int numBase, const bool isNegative)
+{
+    char * ptr = dest;
+    if (numBase == 16)
+    {
+        *ptr++ = '0';
+        *ptr++ = 'x';
+    }
+    else if (isNegative && numBase == 10)
+    {
+        *ptr++ = '-';
+        number = 0 - number;
+    }
+
+    char * firstDigit = ptr;
+    do
+    {
+        const int digitVal = number % numBase;
+        number /= numBase;
+        *ptr++ = static_cast<char>((digitVal > 9) ? ((digitVal - 10) + 'A') : (digitVal + '0'));
+    } while (number > 0);
+
+    *ptr-- = '\0';
+    while (firstDigit < ptr)
+    {
+        const char tmp = *ptr;
+        *ptr-- = *firstDigit;
+        *firstDigit++ = tmp;
+    }
+}
+
+// ========================================================
+
+// Small xorshift PRNG so results are repeatable across platforms.
+static std::uint64_t g_rngState = 0x9E3779B97F4A7C15ull;
+static std::uint64_t nextRandom()
+{
+    g_rngState ^= g_rngState << 13;
+    g_rngState ^= g_rngState >> 7;
+    g_rngState ^= g_rngState << 17;
+    return g_rngState;
+}
+
+// Mix of values a tweak UI would typically display: small magnitudes,
+// values near rounding ties, large integers and random bit patterns.
+static double randomDouble(const int i)
+{
+    switch (i % 4)
+    {
+    case 0  : return (static_cast<double>(nextRandom() % 2000001) - 1000000.0) / 1000.0;
+    case 1  : return (static_cast<double>(nextRandom() % 20001) - 10000.0) * 0.0005;
+    case 2  : return static_cast<double>(static_cast<std::int64_t>(nextRandom()) >> (nextRandom() % 64));
+    default :
+        {
+            double d;
+            const std::uint64_t bits = nextRandom();
+            std::memcpy(&d, &bits, sizeof(d));
+            return d;
+        }
+    } // switch (i % 4)
+}
+
+// Format string given to SmallStr::fromNumber() and the precision it stands for.
+struct FloatFormat
+{
+    const char * format;
+    int          decimals;
+};
+
+static int validate(const int count)
+{
+    static const FloatFormat formats[] = { { "%f", 6 }, { "%.3f", 3 }, { "%.0f", 0 }, { "%.9f", 9 } };
+    static const double edgeCases[] = {
+        0.0, -0.0, 0.5, 1.5, 2.5, -2.5, 0.0005, 0.0015, 0.0025, -0.0004, 1e-320, 1e300,
+        9007199254740992.0, 18446744073709551615.0, 1.0 / 3.0, 123456789.987654321
+    };
+
+    // Same size as SmallStr's conversion buffer, which truncates the longest values.
+    int mismatches = 0;
+    char expected[128];
+
+    auto check = [&](const double value, const FloatFormat & ff)
+    {
+        refFloatToString(value, ff.decimals, expected, sizeof(expected));
+        const ntb::SmallStr result = ntb::SmallStr::fromNumber(value, 10, ff.format);
+        if (std::strcmp(result.c_str(), expected) != 0)
+        {
+            if (++mismatches <= 10)
+            {
+                std::printf("MISMATCH (%s) %.17g: got '%s', expected '%s'\n", ff.format, value, result.c_str(), expected);
+            }
+        }
+    };
+
+    for (const FloatFormat & ff : formats)
+    {
+        for (const double value : edgeCases)
+        {
+            check(value, ff);
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            check(randomDouble(i), ff);
+        }
+    }
+
+    static const int bases[] = { 2, 8, 10, 16 };
+    for (const int base : bases)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const std::int64_t value = static_cast<std::int64_t>(nextRandom()) >> (nextRandom() % 64);
+            refIntToString(static_cast<std::uint64_t>(value), expected, base, (value < 0));
+            const ntb::SmallStr result = ntb::SmallStr::fromNumber(value, base);
+            if (std::strcmp(result.c_str(), expected) != 0)
+            {
+                if (++mismatches <= 10)
+                {
+                    std::printf("MISMATCH (base %i) %lld: got '%s', expected '%s'\n",
+                                base, static_cast<long long>(value), result.c_str(), expected);
+                }
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+// ========================================================
+
+using Clock = std::chrono::high_resolution_clock;
+
+template<typename Func>
+static double timeMs(Func fn)
+{
+    const auto start = Clock::now();
+    fn();
+    const auto end = Clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void benchmark(const int count)
+{
+    double * values = new double[count];
+    std::int64_t * integers = new std::int64_t[count];
+    for (int i = 0; i < count; ++i)
+    {
+        values[i]   = (static_cast<double>(nextRandom() % 2000001) - 1000000.0) / 1000.0;
+        integers[i] = static_cast<std::int64_t>(nextRandom()) >> (nextRandom() % 64);
+    }
+
+    // Accumulate the lengths so the compiler can't discard the conversions.
+    std::size_t sink = 0;
+    char buffer[128];
+
+    static const FloatFormat formats[] = { { "%f", 6 }, { "%.3f", 3 } };
+    for (const FloatFormat & ff : formats)
+    {
+        const double refMs = timeMs([&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                refFloatToString(values[i], ff.decimals, buffer, sizeof(buffer));
+                sink += std::strlen(buffer);
+            }
+        });
+        const double newMs = timeMs([&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                sink += ntb::SmallStr::fromNumber(values[i], 10, ff.format).getLength();
+            }
+        });
+        std::printf("float  %-6s snprintf: %8.2f ms | fromNumber: %8.2f ms | %.2fx\n",
+                    ff.format, refMs, newMs, refMs / newMs);
+    }
+
+    static const int bases[] = { 2, 8, 10, 16 };
+    for (const int base : bases)
+    {
+        const double refMs = timeMs([&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                refIntToString(static_cast<std::uint64_t>(integers[i]), buffer, base, (integers[i] < 0));
+                sink += std::strlen(buffer);
+            }
+        });
+        const double newMs = timeMs([&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                sink += ntb::SmallStr::fromNumber(integers[i], base).getLength();
+            }
+        });
+        std::printf("int    base %-2i  divide: %8.2f ms | fromNumber: %8.2f ms | %.2fx\n",
+                    base, refMs, newMs, refMs / newMs);
+    }
+
+    std::printf("(checksum %zu)\n", sink);
+    delete[] values;
+    delete[] integers;
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    MyNTBRenderInterfaceNull renderer;
+    ntb::initialize(&shell, &renderer);
+
+    const int mismatches = validate(200000);
+    std::printf("Validation: %i mismatches\n", mismatches);
+
+    benchmark(1000000);
+
+    ntb::shutdown();
+    return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,319 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_render_recording.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Records a few seconds of UI frames rendered with the software rasterizer into a render stream
+//  file, then memory-maps the file and replays it at full speed, first into a null renderer to
+//  measure the decoding throughput alone, then into a fresh software renderer. Prints the stream
+//  size against the raw size of the submitted data and the replay throughput. Then replays a few
+//  hand-made streams with draw commands that reach outside of their frame, which the replayer
+//  must reject without drawing them. Returns non-zero if the replay fails, the replayed image
+//  differs from the recorded one or a malformed stream isn't rejected.
+// ================================================================================================
+
+#define NTB_DEFAULT_RENDERER_SOFTWARE
+#include "ntb_renderer_software.hpp"
+
+#define NTB_DEFAULT_RENDERER_RECORDING
+#include "ntb_renderer_recording.hpp"
+
+#include "sample_utils.hpp"
+
+#include <cstring>
+
+// ========================================================
+
+class MyNTBRenderInterfaceNull final : public ntb::RenderInterface
+{
+public:
+    ~MyNTBRenderInterfaceNull();
+};
+MyNTBRenderInterfaceNull::~MyNTBRenderInterfaceNull()
+{ }
+
+// The stream has no framebuffer clears, so this clears the software
+// framebuffer at the start of every frame, recorded or replayed.
+class ClearingSoftwareRenderer final : public SoftwareForwardingRenderer
+{
+public:
+    explicit ClearingSoftwareRenderer(ntb::RenderInterfaceSoftware * sw) : SoftwareForwardingRenderer(sw) { }
+    ~ClearingSoftwareRenderer();
+
+    void drawPackedFrame(const ntb::PackedFrame & frame) override
+    {
+        software->drawPackedFrame(frame);
+    }
+};
+ClearingSoftwareRenderer::~ClearingSoftwareRenderer()
+{ }
+
+// ========================================================
+
+static const char * const kStreamFile = "sample_render_recording.ntbr";
+
+struct SampleData
+{
+    float       floats[60] = {};
+    float       color[4]   = { 0.2f, 0.6f, 1.0f, 1.0f };
+    bool        flag       = false;
+    std::string name       = "Recorded frames";
+};
+
+static void recordFrames(ntb::RenderInterfaceRecorder & recorder, MyNTBShellInterfaceNull & shell, const int frameCount)
+{
+    static SampleData data;
+    ntb::GUI * gui = ntb::createGUI("Recording");
+
+    ntb::Panel * panel = gui->createPanel("Recorded");
+    panel->setPosition(40, 40);
+    panel->setSize(500, 680);
+    panel->addStringRW("name", &data.name);
+    panel->addBoolRW("flag", &data.flag);
+    panel->addColorRW("color", data.color, 4);
+
+    for (int i = 0; i < ntb::lengthOfArray(data.floats); ++i)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "Float_%02d", i);
+        panel->addNumberRW(name, &data.floats[i]);
+    }
+
+    // Values change every few frames and the UI is static in between,
+    // like a typical session, so some frames are exact repeats.
+    for (int i = 0; i < frameCount; ++i)
+    {
+        shell.timeMs += 16;
+        if ((i % 4) == 0)
+        {
+            data.floats[(i / 4) % ntb::lengthOfArray(data.floats)] += 1.25f;
+            data.flag = !data.flag;
+            gui->onMouseMotion(100 + (i % 13) * 25, 100 + (i % 7) * 60);
+        }
+        gui->onFrameRender();
+    }
+
+    recorder.closeFile();
+    ntb::destroyGUI(gui);
+}
+
+static void printReplayStats(const char * title, const ntb::RenderReplayStats & stats)
+{
+    std::printf("%s: %i frames (%i repeated), %i draw commands, %lld vertexes, %lld indexes\n", title,
+                stats.frames, stats.repeatedFrames, stats.drawCommands,
+                static_cast<long long>(stats.vertexes), static_cast<long long>(stats.indexes));
+    std::printf("  %.3f ms, %.1f frames/s, %.1f MB/s of stream\n",
+                stats.milliseconds, stats.getFramesPerSecond(), stats.getMegabytesPerSecond());
+}
+
+// ========================================================
+// Malformed streams:
+// ========================================================
+
+struct TestDrawInfo
+{
+    int firstIndex;
+    int indexCount;
+};
+
+struct TestCommand
+{
+    ntb::DrawCommandType type;
+    std::uint64_t firstVertex, vertexCount;
+    std::uint64_t firstIndex,  indexCount;
+    std::uint64_t firstDrawInfo, drawInfoCount;
+};
+
+static void writeVarint(std::vector<std::uint8_t> & out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+static void writeSigned(std::vector<std::uint8_t> & out, const std::int64_t value)
+{
+    writeVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+// Stream with a single PackedFrame of untextured vertexes at the origin, encoded like the recorder does.
+static std::vector<std::uint8_t> makeFrameStream(const int vertCount, const std::vector<int> & indexes,
+                                                 const std::vector<TestDrawInfo> & drawInfos,
+                                                 const std::vector<TestCommand> & commands)
+{
+    std::vector<std::uint8_t> payload;
+    writeVarint(payload, vertCount);
+    writeVarint(payload, indexes.size());
+    writeVarint(payload, 0); // Line vertexes.
+    writeVarint(payload, drawInfos.size());
+    writeVarint(payload, commands.size());
+    writeSigned(payload, 1); // frameMaxZ
+    payload.push_back(static_cast<std::uint8_t>(ntb::DrawOrder::DepthLayers));
+
+    for (int v = 0; v < vertCount; ++v)
+    {
+        payload.insert(payload.end(), 6, 0); // XYZ, UV and color all zero.
+    }
+
+    int prevIndex = 0;
+    for (const int index : indexes)
+    {
+        writeSigned(payload, index - prevIndex);
+        prevIndex = index;
+    }
+
+    TestDrawInfo prevInfo = {};
+    for (const TestDrawInfo & info : drawInfos)
+    {
+        writeVarint(payload, 0);             // Texture.
+        payload.insert(payload.end(), 8, 0); // Viewport and clip box.
+        writeSigned(payload, info.firstIndex - prevInfo.firstIndex);
+        writeSigned(payload, info.indexCount - prevInfo.indexCount);
+        prevInfo = info;
+    }
+
+    for (const TestCommand & cmd : commands)
+    {
+        payload.push_back(static_cast<std::uint8_t>(cmd.type));
+        writeVarint(payload, 0); // Texture.
+        writeVarint(payload, cmd.firstVertex);
+        writeVarint(payload, cmd.vertexCount);
+        writeVarint(payload, cmd.firstIndex);
+        writeVarint(payload, cmd.indexCount);
+        writeVarint(payload, cmd.firstDrawInfo);
+        writeVarint(payload, cmd.drawInfoCount);
+    }
+
+    ntb::RenderStreamHeader header = {};
+    std::memcpy(header.magic, "NTBR", 4);
+    header.version    = ntb::RenderStreamHeader::kVersion;
+    header.headerSize = sizeof(header);
+
+    std::vector<std::uint8_t> stream(reinterpret_cast<const std::uint8_t *>(&header),
+                                     reinterpret_cast<const std::uint8_t *>(&header) + sizeof(header));
+    stream.push_back(static_cast<std::uint8_t>(ntb::RenderStreamOp::PackedFrame));
+    writeVarint(stream, payload.size());
+    stream.insert(stream.end(), payload.begin(), payload.end());
+    return stream;
+}
+
+// Replays each stream into the software renderer, which would read out of bounds drawing the
+// malformed ones. Returns false if a valid stream is rejected or a malformed one is accepted.
+static bool replayMalformedStreams(ntb::RenderStreamReplayer & replayer, ntb::RenderInterface & target)
+{
+    using ntb::DrawCommandType;
+    struct TestStream
+    {
+        const char * description;
+        bool valid;
+        std::vector<std::uint8_t> stream;
+    };
+
+    const TestStream tests[] =
+    {
+        { "valid triangles", true,
+          makeFrameStream(3, { 0, 1, 2 }, {}, { { DrawCommandType::Triangles, 0, 3, 0, 3, 0, 0 } }) },
+        { "valid clipped triangles", true,
+          makeFrameStream(3, { 0, 1, 2, 2, 1, 0 }, { { 0, 3 }, { 0, 3 } },
+                          { { DrawCommandType::Triangles,        0, 3, 0, 3, 0, 0 },
+                            { DrawCommandType::ClippedTriangles, 0, 3, 3, 3, 0, 2 } }) },
+        { "vertex range overflowing an int", false,
+          makeFrameStream(1, { 0, 0, 0 }, {}, { { DrawCommandType::Triangles, 0x7FFFFFFF, 1, 0, 3, 0, 0 } }) },
+        { "index range overflowing an int", false,
+          makeFrameStream(1, { 0, 0, 0 }, {}, { { DrawCommandType::Triangles, 0, 1, 0x7FFFFFFF, 1, 0, 0 } }) },
+        { "offset past an int", false,
+          makeFrameStream(1, { 0, 0, 0 }, {}, { { DrawCommandType::Triangles, 0x100000000ull, 1, 0, 3, 0, 0 } }) },
+        { "index past the command vertexes", false,
+          makeFrameStream(1, { 0, 5000, 0 }, {}, { { DrawCommandType::Triangles, 0, 1, 0, 3, 0, 0 } }) },
+        { "index past the second command vertexes", false,
+          makeFrameStream(4, { 0, 1, 2, 0, 1, 2 }, {},
+                          { { DrawCommandType::Triangles, 0, 3, 0, 3, 0, 0 },
+                            { DrawCommandType::Triangles, 3, 1, 3, 3, 0, 0 } }) },
+        { "clipped range past the command indexes", false,
+          makeFrameStream(3, { 0, 1, 2, 2, 1, 0 }, { { 2, 3 } },
+                          { { DrawCommandType::ClippedTriangles, 0, 3, 3, 3, 0, 1 } }) },
+        { "clipped range overflowing an int", false,
+          makeFrameStream(3, { 0, 1, 2 }, { { 0x7FFFFFFF, 1 } },
+                          { { DrawCommandType::ClippedTriangles, 0, 3, 0, 3, 0, 1 } }) },
+    };
+
+    bool ok = true;
+    for (const TestStream & test : tests)
+    {
+        ntb::RenderReplayStats stats;
+        const bool accepted = replayer.replay(test.stream.data(), test.stream.size(), target, &stats);
+        const bool passed   = (accepted == test.valid) && (stats.frames == (test.valid ? 1 : 0));
+
+        std::printf("Stream with %-40s %-8s %s\n", test.description, accepted ? "accepted" : "rejected", passed ? "" : "(WRONG)");
+        ok &= passed;
+    }
+    return ok;
+}
+
+// ========================================================
+
+int main()
+{
+    const int frameCount = 120;
+
+    MyNTBShellInterfaceNull shell;
+    ntb::RenderInterfaceSoftware software(kWidth, kHeight);
+    ClearingSoftwareRenderer clearing(&software);
+    ntb::RenderInterfaceRecorder recorder(&clearing);
+    ntb::initialize(&shell, &recorder);
+
+    if (!recorder.openFile(kStreamFile))
+    {
+        return 1;
+    }
+    recordFrames(recorder, shell, frameCount);
+
+    const std::vector<std::uint8_t> recordedImage = copyFramebuffer(software);
+
+    std::printf("Recorded %i frames (%i repeats) into \"%s\".\n",
+                recorder.getFrameCount(), recorder.getRepeatedFrameCount(), kStreamFile);
+    std::printf("Submitted %lld bytes, stream is %lld bytes (%.1f%%).\n",
+                static_cast<long long>(recorder.getRawBytesSubmitted()),
+                static_cast<long long>(recorder.getStreamBytesRecorded()),
+                100.0 * recorder.getStreamBytesRecorded() / recorder.getRawBytesSubmitted());
+
+    ntb::RenderStreamFile streamFile;
+    if (!streamFile.open(kStreamFile))
+    {
+        return 1;
+    }
+    std::printf("Stream file %s.\n", streamFile.isMemoryMapped() ? "memory-mapped" : "loaded into memory");
+
+    bool ok = true;
+    ntb::RenderStreamReplayer replayer;
+    ntb::RenderReplayStats stats;
+
+    // Decoding alone. The first replays warm up the scratch arrays, the last one is reported.
+    MyNTBRenderInterfaceNull nullRenderer;
+    for (int loop = 0; loop < 5; ++loop)
+    {
+        ok &= replayer.replay(streamFile.getData(), streamFile.getSize(), nullRenderer, &stats);
+    }
+    printReplayStats("Null renderer replay", stats);
+
+    // Decoding and rasterization; the last replayed frame must match the last recorded one.
+    ntb::RenderInterfaceSoftware replaySoftware(kWidth, kHeight);
+    ClearingSoftwareRenderer replayClearing(&replaySoftware);
+    ok &= replayer.replay(streamFile.getData(), streamFile.getSize(), replayClearing, &stats);
+    printReplayStats("Software renderer replay", stats);
+
+    const bool imagesMatch = (std::memcmp(recordedImage.data(), replaySoftware.getFramebufferPixels(), recordedImage.size()) == 0);
+    std::printf("Replayed image %s the recorded one.\n", imagesMatch ? "matches" : "DIFFERS from");
+
+    ok &= replayMalformedStreams(replayer, replaySoftware);
+
+    streamFile.close();
+    ntb::shutdown();
+    return (ok && imagesMatch) ? 0 : 1;
+}
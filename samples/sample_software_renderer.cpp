@@ -0,0 +1,164 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_software_renderer.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Renders a few Panels with the CPU software rasterizer, without a window or GPU, and saves
+//  the framebuffer to sample_software_renderer.png/.ppm. Times the rasterizer with one thread
+//  and with one per hardware thread (at least four), checking that both produce the same image.
+//  Also times the frame without the depth test, in painter's draw order, and reports how many
+//  pixels differ (translucent elements blend over what was drawn before them in that mode).
+//  Both modes are then drawn again with primitive sorting enabled, printing the number of draw
+//  commands before and after. Sorting keeps the draw order of overlapping elements, so both
+//  sorted frames must match the unsorted painter's order frame.
+//  If the path of a golden PPM image is given in the command line, the frame is also compared
+//  against it.
+//  Returns non-zero if any of the images differ.
+// ================================================================================================
+
+#define NTB_DEFAULT_RENDERER_SOFTWARE
+#include "ntb_renderer_software.hpp"
+#include "sample_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// ========================================================
+
+struct SampleData
+{
+    float       floats[40] = {};
+    float       vec3[3]    = { 0.25f, -1.0f, 3.5f };
+    float       color[4]   = { 1.0f, 0.5f, 0.25f, 0.75f };
+    bool        flag       = true;
+    int         counter    = 42;
+    std::string name       = "Software rasterizer";
+};
+
+static ntb::GUI * createSampleGUI(SampleData & data)
+{
+    ntb::GUI * gui = ntb::createGUI("Software renderer");
+
+    ntb::Panel * panel1 = gui->createPanel("Settings");
+    panel1->setPosition(20, 20);
+    panel1->setSize(360, 500);
+    panel1->addStringRW("name", &data.name);
+    panel1->addNumberRW("counter", &data.counter);
+    panel1->addBoolRW("flag", &data.flag);
+    panel1->addFloatVecRW("vec3", data.vec3, 3);
+    panel1->addColorRW("color", data.color, 4);
+
+    ntb::Variable * group = panel1->addHierarchyParent("Floats");
+    for (int i = 0; i < ntb::lengthOfArray(data.floats); ++i)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "Float_%02d", i);
+        data.floats[i] = i * 1.5f;
+        panel1->addNumberRW(group, name, &data.floats[i]);
+    }
+
+    ntb::Panel * panel2 = gui->createPanel("Overlapping");
+    panel2->setPosition(300, 200);
+    panel2->setSize(400, 300);
+    panel2->addColorRO("color", data.color, 4);
+    panel2->addNumberRO("counter", &data.counter);
+
+    return gui;
+}
+
+static double renderFrames(ntb::RenderInterfaceSoftware & renderer, ntb::GUI * gui, const int frameCount)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        renderer.clearFramebuffer(ntb::packColor(40, 40, 48, 255));
+        gui->onFrameRender(true);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / frameCount;
+}
+
+static void printDrawCallStats(const char * title, const ntb::DrawCallStats & stats)
+{
+    std::printf("%s: %i primitives, %i commands in order, %i submitted.\n",
+                title, stats.primitives, stats.inOrderCommands, stats.commands);
+}
+
+// Renders with primitive sorting, after an unsorted frame, and compares against the painter's order image.
+static bool checkSortedFrame(ntb::RenderInterfaceSoftware & renderer, ntb::GUI * gui, const char * title,
+                             const std::vector<std::uint8_t> & painterImage)
+{
+    printDrawCallStats(title, gui->getLastFrameDrawCallStats());
+
+    gui->setPrimitiveSorting(true);
+    const double msSorted = renderFrames(renderer, gui, 1);
+    gui->setPrimitiveSorting(false);
+
+    const bool sortedMatch = (std::memcmp(painterImage.data(), renderer.getFramebufferPixels(), painterImage.size()) == 0);
+    printDrawCallStats("  sorted", gui->getLastFrameDrawCallStats());
+    std::printf("  %.3f ms/frame, sorted image %s.\n", msSorted, sortedMatch ? "matches" : "DIFFERS");
+    return sortedMatch;
+}
+
+// ========================================================
+
+int main(int argc, const char * argv[])
+{
+    const int frameCount = 20;
+
+    MyNTBShellInterfaceNull shell;
+    ntb::RenderInterfaceSoftware renderer(kWidth, kHeight, 1);
+    ntb::initialize(&shell, &renderer);
+
+    SampleData data;
+    ntb::GUI * gui = createSampleGUI(data);
+    gui->onMouseMotion(150, 120);
+
+    // Single threaded frame is the reference for the multithreaded one.
+    const double msSingle = renderFrames(renderer, gui, frameCount);
+    const std::vector<std::uint8_t> reference = copyFramebuffer(renderer);
+
+    // At least a few threads, so tiles are spread across workers even on a single core.
+    renderer.setThreadCount(std::max(4, static_cast<int>(std::thread::hardware_concurrency())));
+    const double msMulti = renderFrames(renderer, gui, frameCount);
+    const bool threadsMatch = (std::memcmp(reference.data(), renderer.getFramebufferPixels(), reference.size()) == 0);
+
+    std::printf("%ix%i, %i triangles, %i lines per frame.\n", kWidth, kHeight,
+                renderer.getLastFrameTriangleCount(), renderer.getLastFrameLineCount());
+    std::printf("1 thread:  %.3f ms/frame\n", msSingle);
+    std::printf("%i threads: %.3f ms/frame\n", renderer.getThreadCount(), msMulti);
+    std::printf("Single and multithreaded images %s.\n", threadsMatch ? "match" : "DIFFER");
+
+    bool ok = threadsMatch;
+    ok &= renderer.savePNG("sample_software_renderer.png");
+    ok &= renderer.savePPM("sample_software_renderer.ppm");
+
+    // Painter's order, no depth buffer. The golden image comparison below
+    // is for the depth tested frame, so it is restored afterwards.
+    renderer.setDrawWithDepthTest(false);
+    const double msPainter = renderFrames(renderer, gui, frameCount);
+    const std::vector<std::uint8_t> painterImage = copyFramebuffer(renderer);
+    const int painterDiffs = countDifferingPixels(reference, painterImage);
+    std::printf("Painter order: %.3f ms/frame, %i pixels differ from the depth tested frame.\n", msPainter, painterDiffs);
+    ok &= checkSortedFrame(renderer, gui, "Painter order", painterImage);
+
+    renderer.setDrawWithDepthTest(true);
+    renderFrames(renderer, gui, 1);
+    ok &= checkSortedFrame(renderer, gui, "Depth layers", painterImage);
+    renderFrames(renderer, gui, 1);
+
+    if (argc > 1)
+    {
+        const int differing = renderer.compareWithPPM(argv[1]);
+        std::printf("%i pixels differ from golden image \"%s\".\n", differing, argv[1]);
+        ok &= (differing == 0);
+    }
+
+    ntb::shutdown();
+    return ok ? 0 : 1;
+}
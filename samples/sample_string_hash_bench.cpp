@@ -0,0 +1,233 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_string_hash_bench.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Collision and throughput benchmark for the hash used for GUI, Panel and Variable names.
+//  Compares ntb::hashString() against the One-at-a-Time hash it replaced, over sets of
+//  names shaped like the ones typically found in tweak UIs (flat, hierarchical, arrays).
+// ================================================================================================
+
+#include "ntb.hpp"
+#include "ntb_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ========================================================
+
+class MyNTBShellInterfaceNull final : public ntb::ShellInterface
+{
+public:
+    ~MyNTBShellInterfaceNull();
+    std::int64_t getTimeMilliseconds() const override { return 0; }
+};
+MyNTBShellInterfaceNull::~MyNTBShellInterfaceNull()
+{ }
+
+class MyNTBRenderInterfaceNull final : public ntb::RenderInterface
+{
+public:
+    ~MyNTBRenderInterfaceNull();
+};
+MyNTBRenderInterfaceNull::~MyNTBRenderInterfaceNull()
+{ }
+
+// ========================================================
+
+// Previous library hash: Jenkins One-at-a-Time.
+static std::uint32_t oatHashString(const char * cstr)
+{
+    std::uint32_t h = 0;
+    while (*cstr != '\0')
+    {
+        h += *cstr++;
+        h += (h << 10);
+        h ^= (h >>  6);
+    }
+    h += (h <<  3);
+    h ^= (h >> 11);
+    h += (h << 15);
+    return h;
+}
+
+// Keys computed at compile time must match the runtime hash codes.
+constexpr std::uint32_t kCompileTimeKeys[] = {
+    ntb::hashStringCT(""),
+    ntb::hashStringCT("speed"),
+    ntb::hashStringCT("Scene/Lights/PointLight_0042/Attenuation/Quadratic")
+};
+static const char * const kCompileTimeKeyNames[] = {
+    "",
+    "speed",
+    "Scene/Lights/PointLight_0042/Attenuation/Quadratic"
+};
+
+// ========================================================
+
+using NameSet = std::vector<std::string>;
+
+static NameSet makeFlatNames(const int count)
+{
+    static const char * const words[] = {
+        "speed", "gravity", "friction", "intensity", "radius", "color", "scale", "offset",
+        "enabled", "count", "damping", "exposure", "gamma", "fov", "near", "far"
+    };
+
+    NameSet names;
+    for (int i = 0; i < count; ++i)
+    {
+        names.push_back(std::string(words[i % ntb::lengthOfArray(words)]) + "_" + std::to_string(i));
+    }
+    return names;
+}
+
+static NameSet makeHierarchicalNames(const int count)
+{
+    static const char * const groups[]  = { "Scene", "Render", "Physics", "Audio", "AI", "Debug" };
+    static const char * const objects[] = { "PointLight", "Camera", "RigidBody", "Emitter", "Agent", "Probe" };
+    static const char * const fields[]  = {
+        "Attenuation/Quadratic", "Transform/Position/X", "Material/Roughness",
+        "Settings/MaxIterations", "Colors/Diffuse/Red", "Limits/AngularVelocity"
+    };
+
+    NameSet names;
+    for (int i = 0; i < count; ++i)
+    {
+        char buffer[256];
+        std::snprintf(buffer, sizeof(buffer), "%s/%s_%04d/%s",
+                      groups[i % ntb::lengthOfArray(groups)],
+                      objects[(i / 7) % ntb::lengthOfArray(objects)], i,
+                      fields[(i / 3) % ntb::lengthOfArray(fields)]);
+        names.push_back(buffer);
+    }
+    return names;
+}
+
+static NameSet makeArrayNames(const int count)
+{
+    static const char * const members[] = { "position.x", "position.y", "velocity.z", "lifetime" };
+
+    NameSet names;
+    for (int i = 0; i < count; ++i)
+    {
+        const int index = i / ntb::lengthOfArray(members);
+        names.push_back("particles[" + std::to_string(index) + "]." + members[i % ntb::lengthOfArray(members)]);
+    }
+    return names;
+}
+
+// ========================================================
+
+// Full 32-bit collisions: distinct names that got the same hash code.
+// Plus collisions in the low bits, which is what HashIndex uses to pick the slot.
+template<typename HashFunc>
+static void reportCollisions(const char * hashName, const NameSet & names, HashFunc hashFunc)
+{
+    std::vector<std::uint32_t> codes;
+    codes.reserve(names.size());
+    for (const std::string & name : names)
+    {
+        codes.push_back(hashFunc(name.c_str()));
+    }
+
+    std::vector<std::uint32_t> sorted = codes;
+    std::sort(sorted.begin(), sorted.end());
+    const std::size_t unique = std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+
+    // Table sized like HashIndex would for this many items (power of two, load <= 1/2).
+    std::uint32_t tableSize = 16;
+    while (tableSize < names.size() * 2)
+    {
+        tableSize *= 2;
+    }
+
+    std::vector<int> buckets(tableSize, 0);
+    int maxBucket = 0;
+    for (const std::uint32_t code : codes)
+    {
+        maxBucket = std::max(maxBucket, ++buckets[code & (tableSize - 1)]);
+    }
+    std::size_t usedBuckets = 0;
+    for (const int b : buckets)
+    {
+        usedBuckets += (b != 0) ? 1 : 0;
+    }
+
+    std::printf("  %-10s 32-bit collisions: %6zu | slot collisions (%u slots): %6zu | max per slot: %i\n",
+                hashName, names.size() - unique, tableSize, names.size() - usedBuckets, maxBucket);
+}
+
+template<typename HashFunc>
+static double measureMBPerSec(const NameSet & names, const int repeats, HashFunc hashFunc, std::uint32_t & sink)
+{
+    std::size_t totalBytes = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeats; ++r)
+    {
+        for (const std::string & name : names)
+        {
+            sink += hashFunc(name.c_str());
+            totalBytes += name.length();
+        }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    return (static_cast<double>(totalBytes) / (1024.0 * 1024.0)) / seconds;
+}
+
+static void runNameSet(const char * setName, const NameSet & names)
+{
+    std::size_t totalLength = 0;
+    for (const std::string & name : names)
+    {
+        totalLength += name.length();
+    }
+
+    std::printf("%s: %zu names, %.1f chars average\n", setName, names.size(),
+                static_cast<double>(totalLength) / names.size());
+
+    reportCollisions("OAT", names, oatHashString);
+    reportCollisions("hashString", names, ntb::hashString);
+
+    std::uint32_t sink = 0;
+    const double oatSpeed = measureMBPerSec(names, 20, oatHashString, sink);
+    const double newSpeed = measureMBPerSec(names, 20, ntb::hashString, sink);
+    std::printf("  throughput: OAT %.1f MB/s | hashString %.1f MB/s | %.2fx (sink %08X)\n\n",
+                oatSpeed, newSpeed, newSpeed / oatSpeed, sink);
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    MyNTBRenderInterfaceNull renderer;
+    ntb::initialize(&shell, &renderer);
+
+    int failures = 0;
+    for (int i = 0; i < ntb::lengthOfArray(kCompileTimeKeys); ++i)
+    {
+        if (kCompileTimeKeys[i] != ntb::hashString(kCompileTimeKeyNames[i]))
+        {
+            std::printf("hashStringCT(\"%s\") doesn't match the runtime hash!\n", kCompileTimeKeyNames[i]);
+            ++failures;
+        }
+    }
+
+    const int count = 100000;
+    runNameSet("Flat names",         makeFlatNames(count));
+    runNameSet("Hierarchical names", makeHierarchicalNames(count));
+    runNameSet("Array element names", makeArrayNames(count));
+
+    ntb::shutdown();
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_threaded_updates.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Stress test of GUI::publishVariableValue(). Many producer threads publish increasing counters to
+//  variables of their own, by Variable pointer and by name hash code, while the main thread renders
+//  the GUI, which copies the published values into the variables and formats them for display.
+//  After each frame the main thread checks that no value went backwards and that no color came out
+//  torn, with components from different updates. Once the producers are done, every variable must
+//  hold the last value its producer published. The queue is allocated by whichever producer
+//  publishes first, so nothing must be allocated for it before that. Build with -fsanitize=thread
+//  to check that none of the variable memory is touched by two threads at once. Returns non-zero
+//  if any check fails.
+// ================================================================================================
+
+#include "ntb.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// ========================================================
+
+class MyNTBShellInterfaceNull final : public ntb::ShellInterface
+{
+public:
+    ~MyNTBShellInterfaceNull();
+    std::int64_t getTimeMilliseconds() const override { return 0; }
+};
+MyNTBShellInterfaceNull::~MyNTBShellInterfaceNull()
+{ }
+
+class MyNTBRenderInterfaceNull final : public ntb::RenderInterface
+{
+public:
+    ~MyNTBRenderInterfaceNull();
+};
+MyNTBRenderInterfaceNull::~MyNTBRenderInterfaceNull()
+{ }
+
+// ========================================================
+
+static const int kProducerCount    = 16;
+static const int kUpdatesPerThread = 20000;
+
+// Only ever written by the render thread, through the update queue.
+struct ProducerVars
+{
+    float          counterF  = 0.0f;
+    std::int32_t   counterI  = 0;
+    float          color[4] = {};
+    ntb::Variable * floatVar = nullptr;
+    ntb::Variable * colorVar = nullptr;
+    std::uint32_t  intHash  = 0;
+
+    // Counts kept by the producer, read after it is joined.
+    int published = 0;
+    int retries   = 0;
+};
+
+static void producerThread(ntb::GUI * gui, ProducerVars * vars)
+{
+    for (int n = 1; n <= kUpdatesPerThread; ++n)
+    {
+        const float value = float(n);
+        const float color[4] = { value, value, value, value };
+
+        // Retry when the queue is full, so every value is published once the render thread catches up.
+        int published = 0;
+        while (published < 3)
+        {
+            bool ok = false;
+            switch (published)
+            {
+            case 0  : ok = gui->publishVariableValue(vars->floatVar, value); break;
+            case 1  : ok = gui->publishVariableValue(vars->intHash, std::int32_t(n)); break;
+            default : ok = gui->publishVariableValue(vars->colorVar, color); break;
+            } // switch (published)
+
+            if (ok)
+            {
+                ++published;
+            }
+            else
+            {
+                ++vars->retries;
+                std::this_thread::yield();
+            }
+        }
+        vars->published += published;
+    }
+}
+
+// Checks the values after a frame against the ones after the previous frame.
+static int checkValues(const std::vector<ProducerVars> & vars, std::vector<float> & lastSeen)
+{
+    int errors = 0;
+    for (std::size_t i = 0; i < vars.size(); ++i)
+    {
+        const ProducerVars & v = vars[i];
+        if (v.color[0] != v.color[1] || v.color[0] != v.color[2] || v.color[0] != v.color[3])
+        {
+            std::printf("Torn color of producer %i: %.0f %.0f %.0f %.0f\n", int(i), v.color[0], v.color[1], v.color[2], v.color[3]);
+            ++errors;
+        }
+        if (v.counterF < lastSeen[i])
+        {
+            std::printf("Counter of producer %i went back from %.0f to %.0f\n", int(i), lastSeen[i], v.counterF);
+            ++errors;
+        }
+        lastSeen[i] = v.counterF;
+    }
+    return errors;
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull  shellInterface;
+    MyNTBRenderInterfaceNull renderInterface;
+    ntb::initialize(&shellInterface, &renderInterface);
+
+    ntb::GUI * gui = ntb::createGUI("Threaded updates");
+    ntb::Panel * panel = gui->createPanel("Producers");
+    panel->setSize(400, 2000); // All rows in view, so all of them are formatted every frame.
+
+    std::vector<ProducerVars> vars(kProducerCount);
+    for (int i = 0; i < kProducerCount; ++i)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "float_%02d", i);
+        vars[i].floatVar = panel->addNumberRO(name, &vars[i].counterF);
+
+        std::snprintf(name, sizeof(name), "int_%02d", i);
+        vars[i].intHash = panel->addNumberRO(name, &vars[i].counterI)->getHashCode();
+
+        std::snprintf(name, sizeof(name), "color_%02d", i);
+        vars[i].colorVar = panel->addColorRO(name, vars[i].color, 4);
+    }
+
+    int errors = 0;
+    const int varUpdatesTag = int(ntb::MemoryTag::VarUpdates);
+
+    // Nothing published yet, so there is no queue to allocate or drain.
+    gui->onFrameRender(false);
+    if (ntb::getAllocationStats().allocCount[varUpdatesTag] != 0)
+    {
+        std::printf("The queue was allocated before anything was published!\n");
+        ++errors;
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    std::atomic<int> running{ kProducerCount };
+    std::vector<std::thread> producers;
+    for (int i = 0; i < kProducerCount; ++i)
+    {
+        producers.emplace_back([gui, &vars, &running, i]()
+        {
+            producerThread(gui, &vars[i]);
+            running.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    int frames = 0;
+    std::vector<float> lastSeen(kProducerCount, 0.0f);
+    while (running.load(std::memory_order_acquire) > 0)
+    {
+        gui->onFrameRender(false);
+        errors += checkValues(vars, lastSeen);
+        ++frames;
+    }
+
+    for (std::thread & producer : producers)
+    {
+        producer.join();
+    }
+
+    // The values published last might still be waiting.
+    gui->onFrameRender(false);
+    errors += checkValues(vars, lastSeen);
+    ++frames;
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    int published = 0, retries = 0;
+    for (int i = 0; i < kProducerCount; ++i)
+    {
+        const ProducerVars & v = vars[i];
+        if (v.counterF != float(kUpdatesPerThread) || v.counterI != kUpdatesPerThread || v.color[0] != float(kUpdatesPerThread))
+        {
+            std::printf("Producer %i ended at %.0f / %i / %.0f instead of %i\n", i, v.counterF, int(v.counterI), v.color[0], kUpdatesPerThread);
+            ++errors;
+        }
+        published += v.published;
+        retries   += v.retries;
+    }
+
+    // Only one of the producers that raced to publish first allocated the queue.
+    if (ntb::getAllocationStats().allocCount[varUpdatesTag] != 1)
+    {
+        std::printf("The queue was allocated %i times!\n", int(ntb::getAllocationStats().allocCount[varUpdatesTag]));
+        ++errors;
+    }
+
+    // A variable destroyed with values still waiting for it, which must be discarded.
+    float doomed = 0.0f;
+    ntb::Variable * doomedVar = panel->addNumberRO("doomed", &doomed);
+    for (int n = 0; n < 10; ++n)
+    {
+        gui->publishVariableValue(doomedVar, float(n));
+    }
+    panel->destroyVariable(doomedVar);
+    gui->onFrameRender(false);
+
+    std::printf("%i producers published %i values in %.2f ms over %i frames (%.0f values/frame), "
+                "%i retries with the queue full, %i errors.\n",
+                kProducerCount, published, ms, frames, double(published) / frames, retries, errors);
+
+    ntb::shutdown(); // This will also free the GUI instance.
+    return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+#pragma once
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_utils.hpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Setup shared by the samples that render with the software rasterizer and compare the images:
+//  a null shell, a RenderInterface that forwards to RenderInterfaceSoftware, a text heavy GUI and
+//  the framebuffer copy and compare helpers. Include it after ntb_renderer_software.hpp.
+// ================================================================================================
+
+#include "ntb_renderer_software.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if !defined(NEO_TWEAK_BAR_STD_STRING_INTEROP)
+    #error "NEO_TWEAK_BAR_STD_STRING_INTEROP is required for this sample!"
+#endif // NEO_TWEAK_BAR_STD_STRING_INTEROP
+
+// ========================================================
+
+static const int kWidth  = 1024;
+static const int kHeight = 768;
+
+// Fixed time unless the sample advances it, so the cursor blinking
+// and other time-based visuals are the same every run.
+class MyNTBShellInterfaceNull final : public ntb::ShellInterface
+{
+public:
+    std::int64_t getTimeMilliseconds() const override { return timeMs; }
+    std::int64_t timeMs = 0;
+};
+
+// Forwards to the software renderer, clearing the framebuffer when a frame begins.
+// The samples derive from it to see the frames before they are drawn. Packed frames
+// go through the default RenderInterface::drawPackedFrame() unless overridden.
+class SoftwareForwardingRenderer : public ntb::RenderInterface
+{
+public:
+    explicit SoftwareForwardingRenderer(ntb::RenderInterfaceSoftware * sw) : software(sw) { }
+
+    // Not copyable.
+    SoftwareForwardingRenderer(const SoftwareForwardingRenderer &) = delete;
+    SoftwareForwardingRenderer & operator = (const SoftwareForwardingRenderer &) = delete;
+
+    void beginDraw() override
+    {
+        software->clearFramebuffer(ntb::packColor(40, 40, 48, 255));
+        software->beginDraw();
+    }
+    void endDraw() override
+    {
+        software->endDraw();
+    }
+    void getViewport(int * x, int * y, int * w, int * h) const override
+    {
+        software->getViewport(x, y, w, h);
+    }
+    ntb::DrawOrder getDrawOrder() const override
+    {
+        return software->getDrawOrder();
+    }
+    ntb::TextureHandle createTexture(int w, int h, int c, const void * pixels) override
+    {
+        return software->createTexture(w, h, c, pixels);
+    }
+    void destroyTexture(ntb::TextureHandle texture) override
+    {
+        software->destroyTexture(texture);
+    }
+    void drawClipped2DTriangles(const ntb::VertexPTC * verts, int vertCount,
+                                const std::uint16_t * indexes, int indexCount,
+                                const ntb::DrawClippedInfo * drawInfo,
+                                int drawInfoCount, int frameMaxZ) override
+    {
+        software->drawClipped2DTriangles(verts, vertCount, indexes, indexCount, drawInfo, drawInfoCount, frameMaxZ);
+    }
+    void draw2DTriangles(const ntb::VertexPTC * verts, int vertCount,
+                         const std::uint16_t * indexes, int indexCount,
+                         ntb::TextureHandle texture, int frameMaxZ) override
+    {
+        software->draw2DTriangles(verts, vertCount, indexes, indexCount, texture, frameMaxZ);
+    }
+    void draw2DLines(const ntb::VertexPC * verts, int vertCount, int frameMaxZ) override
+    {
+        software->draw2DLines(verts, vertCount, frameMaxZ);
+    }
+
+protected:
+    ntb::RenderInterfaceSoftware * software;
+};
+
+// ========================================================
+
+// Three overlapping Panels of long strings and numbers, mostly text.
+struct TextPanelsData
+{
+    float       floats[60] = {};
+    float       color[4]   = { 0.5f, 0.75f, 1.0f, 0.5f };
+    std::string names[6];
+};
+
+inline ntb::GUI * createTextPanelsGUI(const char * guiName, TextPanelsData & data)
+{
+    ntb::GUI * gui = ntb::createGUI(guiName);
+
+    for (int p = 0; p < 3; ++p)
+    {
+        char title[32];
+        std::snprintf(title, sizeof(title), "Panel %i", p);
+
+        ntb::Panel * panel = gui->createPanel(title);
+        panel->setPosition(20 + p * 330, 20 + p * 30);
+        panel->setSize(320, 640);
+        panel->addColorRW("color", data.color, 4);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            std::string & name = data.names[p * 2 + i];
+            name = "The quick brown fox jumps over the lazy dog";
+            panel->addStringRW(i == 0 ? "text_a" : "text_b", &name);
+        }
+        for (int i = 0; i < 20; ++i)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "Float_Value_%02d", i);
+            data.floats[p * 20 + i] = i * 1.234f;
+            panel->addNumberRW(name, &data.floats[p * 20 + i]);
+        }
+    }
+    return gui;
+}
+
+// ========================================================
+
+inline std::vector<std::uint8_t> copyFramebuffer(const ntb::RenderInterfaceSoftware & software)
+{
+    return std::vector<std::uint8_t>(software.getFramebufferPixels(), software.getFramebufferPixels() + (kWidth * kHeight * 4));
+}
+
+// Clears the framebuffer and draws one frame of the GUI, redrawing everything.
+inline std::vector<std::uint8_t> renderFrame(ntb::RenderInterfaceSoftware & software, ntb::GUI * gui)
+{
+    software.clearFramebuffer(ntb::packColor(40, 40, 48, 255));
+    gui->onFrameRender(true);
+    return copyFramebuffer(software);
+}
+
+// Pixels left of column 'maxX' with any channel more than 'tolerance' apart.
+inline int countDifferingPixels(const std::vector<std::uint8_t> & a, const std::vector<std::uint8_t> & b,
+                                const int tolerance = 0, const int maxX = kWidth)
+{
+    int differing = 0;
+    for (int y = 0; y < kHeight; ++y)
+    {
+        for (int x = 0; x < maxX; ++x)
+        {
+            const int p = (x + y * kWidth) * 4;
+            for (int c = 0; c < 4; ++c)
+            {
+                if (std::abs(a[p + c] - b[p + c]) > tolerance)
+                {
+                    ++differing;
+                    break;
+                }
+            }
+        }
+    }
+    return differing;
+}
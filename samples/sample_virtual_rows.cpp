@@ -0,0 +1,149 @@
+
+// ================================================================================================
+// -*- C++ -*-
+// File: sample_virtual_rows.cpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Scrolls a Panel with a growing number of variables, of which the WindowWidget only lays out,
+//  draws, hit tests and polls the rows in view (see WindowWidget::updateVarRows), so the time per
+//  scroll step and per frame should stay about the same as the Panel grows. Each Panel starts with
+//  a collapsed hierarchy of a thousand variables, which must take no rows. After scrolling almost
+//  to the end, the Panel is rendered with the software rasterizer next to a reference Panel that
+//  only has the variables from the first one in view. Returns non-zero if the two images differ
+//  anywhere but in the scroll bar.
+// ================================================================================================
+
+#define NTB_DEFAULT_RENDERER_SOFTWARE
+#include "ntb_renderer_software.hpp"
+#include "sample_utils.hpp"
+
+#include <chrono>
+
+// ========================================================
+
+static const int kPanelX = 20;
+static const int kPanelY = 20;
+static const int kPanelW = 420;
+static const int kPanelH = 700;
+
+// The scroll bar is on the right side of the Panel and
+// the only thing expected to differ from the reference.
+static const int kCompareMaxX = kPanelX + kPanelW - 60;
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double elapsedMs(const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Variables [firstVar, floats.size()) after a collapsed hierarchy with hiddenCount variables, if any.
+static ntb::GUI * createSampleGUI(const char * guiName, std::vector<float> & floats, const int firstVar, const int hiddenCount)
+{
+    ntb::GUI * gui = ntb::createGUI(guiName);
+
+    ntb::Panel * panel = gui->createPanel("Virtual rows");
+    panel->setPosition(kPanelX, kPanelY);
+    panel->setSize(kPanelW, kPanelH);
+
+    if (hiddenCount > 0)
+    {
+        ntb::Variable * hidden = panel->addHierarchyParent("Hidden");
+        for (int i = 0; i < hiddenCount; ++i)
+        {
+            panel->addNumberRO(hidden, "Hidden_Var", &floats[i % floats.size()]);
+        }
+        hidden->collapseHierarchy();
+    }
+
+    const int varCount = static_cast<int>(floats.size());
+    for (int i = firstVar; i < varCount; ++i)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "Var_%06d", i);
+        panel->addNumberRW(name, &floats[i]);
+    }
+
+    // Cursor over the scroll bar, so the wheel scrolls the Panel without hovering any of the rows.
+    gui->onMouseMotion(kPanelX + kPanelW - 20, kPanelY + kPanelH / 2);
+    return gui;
+}
+
+// Scrolls down to scrollSteps rows below the top. The first few steps also draw a frame, like when
+// dragging the scroll bar. Returns false if the result doesn't look like the reference Panel.
+static bool runBenchmark(ntb::RenderInterfaceSoftware & renderer, const int varCount, const int hiddenCount)
+{
+    const int timedSteps  = 100;
+    const int scrollSteps = varCount - 40; // Past the last page, since the hidden rows take none.
+    const int frameCount  = 10;
+
+    std::vector<float> floats(varCount);
+    for (int i = 0; i < varCount; ++i)
+    {
+        floats[i] = i * 0.5f;
+    }
+
+    Clock::time_point start = Clock::now();
+    ntb::GUI * gui = createSampleGUI("Virtual rows", floats, 0, hiddenCount);
+    const double createMs = elapsedMs(start);
+
+    // Full redraw, polling and tessellating the rows in view.
+    start = Clock::now();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        renderer.clearFramebuffer(ntb::packColor(40, 40, 48, 255));
+        gui->onFrameRender(true);
+    }
+    const double frameMs = elapsedMs(start) / frameCount;
+
+    // One row per wheel step, drawing the Panel again after each.
+    start = Clock::now();
+    for (int i = 0; i < timedSteps; ++i)
+    {
+        gui->onMouseScroll(-1);
+        renderer.clearFramebuffer(ntb::packColor(40, 40, 48, 255));
+        gui->onFrameRender(false);
+    }
+    const double stepMs = elapsedMs(start) / timedSteps;
+
+    for (int i = timedSteps; i < scrollSteps; ++i)
+    {
+        gui->onMouseScroll(-1);
+    }
+
+    // The first row in view is the one scrollSteps rows down. The Hidden parent is row zero.
+    ntb::GUI * guiRef = createSampleGUI("Virtual rows reference", floats, scrollSteps - 1, 0);
+
+    const std::vector<std::uint8_t> image    = renderFrame(renderer, gui);
+    const std::vector<std::uint8_t> imageRef = renderFrame(renderer, guiRef);
+
+    const int differing = countDifferingPixels(image, imageRef, 0, kCompareMaxX);
+
+    std::printf("%6i variables (+%i collapsed): created in %8.2f ms, %.4f ms/frame, %.4f ms/scroll step with a frame, "
+                "%i pixels differ from the reference.\n",
+                varCount, hiddenCount, createMs, frameMs, stepMs, differing);
+
+    ntb::destroyGUI(gui);
+    ntb::destroyGUI(guiRef);
+    return differing == 0;
+}
+
+// ========================================================
+
+int main()
+{
+    MyNTBShellInterfaceNull shell;
+    ntb::RenderInterfaceSoftware renderer(kWidth, kHeight);
+    ntb::initialize(&shell, &renderer);
+
+    bool ok = true;
+    ok &= runBenchmark(renderer, 1000,   1000);
+    ok &= runBenchmark(renderer, 10000,  1000);
+    ok &= runBenchmark(renderer, 100000, 1000);
+    renderer.savePNG("sample_virtual_rows.png");
+
+    ntb::shutdown();
+    return ok ? 0 : 1;
+}
@@ -240,8 +240,9 @@ int main(const int argc, const char * argv[])
         }
 
         // Var data display widgets inside a window/panel:
+        ntb::WindowWidget * varWindow = nullptr;
         {
-            auto varWindow = new ntb::WindowWidget{};
+            varWindow = new ntb::WindowWidget{};
             varWindow->init(gui, nullptr, ntb::Rectangle{ 1000, 20, 1500, 600 }, true, false, "Variables Test", 40, 28, 40, 25);
             varWindow->setTextScaling(1.5f);
             varWindow->setButtonTextScaling(1.0f);
@@ -252,6 +253,10 @@ int main(const int argc, const char * argv[])
             constexpr int varHeight = 50;
             constexpr int varOffsY  = 8;
 
+            // The window stacks the vars from the top, in hierarchy order.
+            // Only the X and width of each rect below are used.
+            varWindow->setVarRowLayout(varStartY - varWindow->getRect().yMins, varHeight + varOffsY);
+
             ntb::Rectangle rect;
             int y = varStartY;
 
@@ -313,12 +318,14 @@ int main(const int argc, const char * argv[])
             var7->setTextScaling(1.5f);
             variables.pushBack(var7);
 
+            varWindow->updateVarRows();
+
             #if NEO_TWEAK_BAR_DEBUG
             varWindow->printHierarchy();
             std::cout << "\n";
             #endif // NEO_TWEAK_BAR_DEBUG
 
-            // Only have to add the window, since each var widget is a child, directly or indirectly.
+            // Only have to add the window, since the var widgets in view are its children.
             widgets.pushBack(varWindow);
         }
 
@@ -375,6 +382,9 @@ int main(const int argc, const char * argv[])
                 }
             }
 
+            // Lay out the vars scrolled into view or expanded since the last frame.
+            varWindow->updateVarRows();
+
             // Render our widgets:
             widgets.forEach<ntb::Widget *>(
                 [](ntb::Widget * widget, ntb::GeometryBatch * batch)
@@ -67,6 +67,11 @@ void ShellInterface::memFree(void * ptrToFree)
     }
 }
 
+bool ShellInterface::usePooledObjectAllocation() const
+{
+    return true;
+}
+
 // ========================================================
 // RenderInterface defaults:
 // ========================================================
@@ -92,6 +97,24 @@ int RenderInterface::getMaxZ() const
     return 999999;
 }
 
+DrawOrder RenderInterface::getDrawOrder() const
+{
+    // Depth tested layers, so the GL renderers can batch by primitive type.
+    return DrawOrder::DepthLayers;
+}
+
+bool RenderInterface::supportsCompactVertexes() const
+{
+    // Only worth it for renderers that upload the frame.
+    return false;
+}
+
+bool RenderInterface::supportsGlyphInstances() const
+{
+    // Text is tessellated into quads on the CPU.
+    return false;
+}
+
 void RenderInterface::getViewport(int * viewportX, int * viewportY,
                                   int * viewportW, int * viewportH) const
 {
@@ -130,6 +153,113 @@ void RenderInterface::drawClipped2DTriangles(const VertexPTC *, int, const std::
     // Nothing.
 }
 
+// Scratch memory of the default drawPackedFrame(), where the compact vertexes are unpacked to and
+// the glyph quads are built. Only grows, so drawing doesn't allocate once the biggest command was
+// seen. The quad indexes are the same for every batch, so they are only built when growing.
+// Freed by shutdown().
+static PODArray g_drawScratchVerts{ sizeof(VertexPTC), MemoryTag::Renderer };
+static PODArray g_glyphQuadIndexes{ sizeof(std::uint16_t), MemoryTag::Renderer };
+
+// Default path of the Glyphs commands: the quads are built back
+// and drawn as triangles, as many as 16-bits indexes can address.
+static void drawGlyphInstances(RenderInterface & renderer, const PackedFrame & frame, const DrawCommand & cmd)
+{
+    constexpr int kMaxGlyphsPerDraw = (UINT16_MAX + 1) / 4;
+    const int batchSize = std::min(cmd.vertexCount, kMaxGlyphsPerDraw);
+
+    const int builtQuads = g_glyphQuadIndexes.getSize() / 6;
+    if (builtQuads < batchSize)
+    {
+        g_glyphQuadIndexes.resize(batchSize * 6);
+        std::uint16_t * indexes = g_glyphQuadIndexes.getData<std::uint16_t>();
+        for (int g = builtQuads; g < batchSize; ++g)
+        {
+            const std::uint16_t quadIndexes[6] = { 0, 1, 2, 2, 1, 3 };
+            for (int i = 0; i < 6; ++i)
+            {
+                indexes[g * 6 + i] = static_cast<std::uint16_t>(g * 4 + quadIndexes[i]);
+            }
+        }
+    }
+
+    g_drawScratchVerts.resize(batchSize * 4);
+    VertexPTC * verts = g_drawScratchVerts.getData<VertexPTC>();
+    const std::uint16_t * indexes = g_glyphQuadIndexes.getData<std::uint16_t>();
+
+    for (int first = 0; first < cmd.vertexCount; first += batchSize)
+    {
+        const int count = std::min(batchSize, cmd.vertexCount - first);
+        for (int g = 0; g < count; ++g)
+        {
+            const GlyphInstance & glyph = frame.glyphs[cmd.firstVertex + first + g];
+            const Float32 x0 = glyph.x;
+            const Float32 y0 = glyph.y;
+            const Float32 x1 = x0 + frame.glyphWidth  * glyph.scale;
+            const Float32 y1 = y0 + frame.glyphHeight * glyph.scale;
+            const Float32 u0 = static_cast<Float32>(glyph.u) / UINT16_MAX;
+            const Float32 v0 = static_cast<Float32>(glyph.v) / UINT16_MAX;
+            const Float32 u1 = u0 + frame.glyphUVWidth;
+            const Float32 v1 = v0 + frame.glyphUVHeight;
+
+            VertexPTC * quad = verts + g * 4;
+            quad[0] = { x0, y0, glyph.z, u0, v0, glyph.color };
+            quad[1] = { x0, y1, glyph.z, u0, v1, glyph.color };
+            quad[2] = { x1, y0, glyph.z, u1, v0, glyph.color };
+            quad[3] = { x1, y1, glyph.z, u1, v1, glyph.color };
+        }
+        renderer.draw2DTriangles(verts, count * 4, indexes, count * 6, cmd.texture, frame.frameMaxZ);
+    }
+}
+
+void RenderInterface::drawPackedFrame(const PackedFrame & frame)
+{
+    for (int c = 0; c < frame.commandCount; ++c)
+    {
+        const DrawCommand & cmd = frame.commands[c];
+        switch (cmd.type)
+        {
+        case DrawCommandType::Triangles :
+            if (frame.compactVerts != nullptr)
+            {
+                g_drawScratchVerts.resize(cmd.vertexCount);
+                VertexPTC * verts = g_drawScratchVerts.getData<VertexPTC>();
+                for (int v = 0; v < cmd.vertexCount; ++v)
+                {
+                    verts[v] = unpackCompactVertex(frame.compactVerts[cmd.firstVertex + v]);
+                }
+                draw2DTriangles(verts, cmd.vertexCount, frame.indexes + cmd.firstIndex, cmd.indexCount,
+                                cmd.texture, frame.frameMaxZ);
+            }
+            else
+            {
+                draw2DTriangles(frame.verts + cmd.firstVertex, cmd.vertexCount,
+                                frame.indexes + cmd.firstIndex, cmd.indexCount,
+                                cmd.texture, frame.frameMaxZ);
+            }
+            break;
+
+        case DrawCommandType::ClippedTriangles :
+            drawClipped2DTriangles(frame.verts + cmd.firstVertex, cmd.vertexCount,
+                                   frame.indexes + cmd.firstIndex, cmd.indexCount,
+                                   frame.drawInfos + cmd.firstDrawInfo, cmd.drawInfoCount,
+                                   frame.frameMaxZ);
+            break;
+
+        case DrawCommandType::Lines :
+            draw2DLines(frame.lineVerts + cmd.firstVertex, cmd.vertexCount, frame.frameMaxZ);
+            break;
+
+        case DrawCommandType::Glyphs :
+            drawGlyphInstances(*this, frame, cmd);
+            break;
+
+        default :
+            errorF("Bad draw command type in RenderInterface::drawPackedFrame!");
+            break;
+        } // switch (cmd.type)
+    }
+}
+
 TextureHandle RenderInterface::createCheckerboardTexture(int widthPixels, int heightPixels, int squares)
 {
     NTB_ASSERT(widthPixels  > 0);
@@ -144,7 +274,7 @@ TextureHandle RenderInterface::createCheckerboardTexture(int widthPixels, int he
         { 255, 255, 255, 255 }
     };
     const int checkerSize = widthPixels / squares; // Size of one checker square, in pixels.
-    std::uint8_t * buffer = implAllocT<std::uint8_t>(widthPixels * heightPixels * 4);
+    std::uint8_t * buffer = implAllocT<std::uint8_t>(MemoryTag::Renderer, widthPixels * heightPixels * 4);
 
     for (int y = 0; y < heightPixels; ++y)
     {
@@ -166,6 +296,44 @@ TextureHandle RenderInterface::createCheckerboardTexture(int widthPixels, int he
     return newTex;
 }
 
+// ========================================================
+// VertexPTCCompact packing:
+// ========================================================
+
+bool isCompactVertexInRange(const VertexPTC & vert)
+{
+    // Bounds of the rounded fixed point values, half a step inside the int16 limits.
+    const Float32 minXY = (INT16_MIN + 0.5f) / kCompactVertexSubpixels;
+    const Float32 maxXY = (INT16_MAX - 0.5f) / kCompactVertexSubpixels;
+    return (vert.x >= minXY && vert.x <= maxXY && vert.y >= minXY && vert.y <= maxXY &&
+            vert.u >= 0.0f  && vert.u <= 1.0f  && vert.v >= 0.0f  && vert.v <= 1.0f);
+}
+
+VertexPTCCompact packCompactVertex(const VertexPTC & vert)
+{
+    VertexPTCCompact packed;
+    packed.x      = static_cast<std::int16_t>(std::lround(vert.x * kCompactVertexSubpixels));
+    packed.y      = static_cast<std::int16_t>(std::lround(vert.y * kCompactVertexSubpixels));
+    packed.z      = static_cast<std::int16_t>(vert.z);
+    packed.u      = static_cast<std::uint16_t>(std::lround(vert.u * UINT16_MAX));
+    packed.v      = static_cast<std::uint16_t>(std::lround(vert.v * UINT16_MAX));
+    packed.unused = 0;
+    packed.color  = vert.color;
+    return packed;
+}
+
+VertexPTC unpackCompactVertex(const VertexPTCCompact & packed)
+{
+    VertexPTC vert;
+    vert.x     = static_cast<Float32>(packed.x) / kCompactVertexSubpixels;
+    vert.y     = static_cast<Float32>(packed.y) / kCompactVertexSubpixels;
+    vert.z     = static_cast<Float32>(packed.z);
+    vert.u     = static_cast<Float32>(packed.u) / UINT16_MAX;
+    vert.v     = static_cast<Float32>(packed.v) / UINT16_MAX;
+    vert.color = packed.color;
+    return vert;
+}
+
 // ========================================================
 // class VarCallbacksAny:
 // ========================================================
@@ -246,6 +414,8 @@ bool initialize(ShellInterface * shell, RenderInterface * renderer)
 void shutdown()
 {
     destroyAllGUIs();
+    g_drawScratchVerts.deallocate();
+    g_glyphQuadIndexes.deallocate();
 }
 
 ShellInterface & getShellInterface()
@@ -264,35 +434,40 @@ RenderInterface & getRenderInterface()
 // GUI management:
 // ========================================================
 
-static PODArray g_allGUIs{ sizeof(GUIImpl *) };
+static PODArray   g_allGUIs{ sizeof(GUIImpl *) };
+static HashIndex  g_allGUIsIndex{};
+static ObjectPool g_guiPool{ sizeof(GUIImpl), 4 };
 
 GUI * findGUI(const char * guiName)
 {
-    return findItemByName<GUIImpl *>(g_allGUIs, guiName);
+    return findItemByName<GUIImpl *>(g_allGUIs, g_allGUIsIndex, guiName);
 }
 
 GUI * findGUI(std::uint32_t guiNameHashCode)
 {
-    return findItemByHashCode<GUIImpl *>(g_allGUIs, guiNameHashCode);
+    return findItemByHashCode<GUIImpl *>(g_allGUIs, g_allGUIsIndex, guiNameHashCode);
 }
 
 GUI * createGUI(const char * guiName)
 {
     NTB_ASSERT(guiName != nullptr);
-    GUIImpl * gui = construct(implAllocT<GUIImpl>());
+    GUIImpl * gui = construct(poolAllocT<GUIImpl>(g_guiPool));
     gui->init(guiName);
     g_allGUIs.pushBack(gui);
+    g_allGUIsIndex.insert(gui->getHashCode(), gui);
     return gui;
 }
 
 bool destroyGUI(GUI * gui)
 {
-    return eraseAndDestroyItem<GUIImpl *>(g_allGUIs, gui);
+    g_allGUIsIndex.invalidate();
+    return eraseAndDestroyItem<GUIImpl *>(g_allGUIs, gui, g_guiPool);
 }
 
 void destroyAllGUIs()
 {
-    destroyAllItems<GUIImpl *>(g_allGUIs);
+    destroyAllItems<GUIImpl *>(g_allGUIs, g_guiPool);
+    g_allGUIsIndex.deallocate();
 }
 
 int getGUICount()
@@ -305,6 +480,45 @@ void enumerateAllGUIs(GUIEnumerateCallback enumCallback, void * userContext)
     g_allGUIs.forEach<GUIImpl *>(enumCallback, userContext);
 }
 
+ObjectPoolStats getObjectPoolStats()
+{
+    ObjectPoolStats poolStats = g_guiPool.getStats();
+    const int count = g_allGUIs.getSize();
+    for (int i = 0; i < count; ++i)
+    {
+        const GUIImpl * gui = g_allGUIs.get<GUIImpl *>(i);
+        poolStats += gui->getObjectPoolStats();
+    }
+    return poolStats;
+}
+
+AllocationStats getAllocationStats()
+{
+    return g_allocationStats;
+}
+
+void resetAllocationStats()
+{
+    g_allocationStats = AllocationStats{};
+}
+
+const char * memoryTagToString(const MemoryTag tag)
+{
+    switch (tag)
+    {
+    case MemoryTag::GeometryBatch : return "GeometryBatch";
+    case MemoryTag::SmallStr      : return "SmallStr";
+    case MemoryTag::PODArray      : return "PODArray";
+    case MemoryTag::Widgets       : return "Widgets";
+    case MemoryTag::ObjectPool    : return "ObjectPool";
+    case MemoryTag::HashIndex     : return "HashIndex";
+    case MemoryTag::FrameArena    : return "FrameArena";
+    case MemoryTag::Renderer      : return "Renderer";
+    case MemoryTag::VarUpdates    : return "VarUpdates";
+    default                       : return "Unknown";
+    } // switch (tag)
+}
+
 // ========================================================
 // Library error handler:
 // ========================================================
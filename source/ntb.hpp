@@ -141,6 +141,88 @@ constexpr T clamp(const T x, const T minimum, const T maximum)
     return (x < minimum) ? minimum : (x > maximum) ? maximum : x;
 }
 
+// ========================================================
+// Name hashing:
+// ========================================================
+
+namespace detail
+{
+
+// Word-at-a-time string hash, with the rounds and final avalanche
+// of XXH64, processing 8 bytes per step plus a tail of up to 7 bytes.
+// Written as single-expression constexpr functions so that the same
+// code can hash string literals at compile time (see hashStringCT).
+constexpr std::uint64_t kHashPrime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t kHashPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t kHashPrime3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t kHashPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t kHashPrime5 = 0x27D4EB2F165667C5ull;
+
+constexpr std::uint64_t hashRotl(const std::uint64_t x, const int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+constexpr std::uint64_t hashXorShift(const std::uint64_t x, const int s)
+{
+    return x ^ (x >> s);
+}
+
+// Little-endian load of 'n' (up to 8) bytes.
+constexpr std::uint64_t hashLoadBytes(const char * s, const int n)
+{
+    return (n == 0) ? 0 : (std::uint64_t(static_cast<unsigned char>(s[0])) | (hashLoadBytes(s + 1, n - 1) << 8));
+}
+
+constexpr std::uint64_t hashWord(const std::uint64_t h, const std::uint64_t word)
+{
+    return hashRotl(h ^ (hashRotl(word * kHashPrime2, 31) * kHashPrime1), 27) * kHashPrime1 + kHashPrime4;
+}
+
+constexpr std::uint64_t hashTail(const std::uint64_t h, const std::uint64_t tail)
+{
+    return hashRotl(h ^ (tail * kHashPrime1), 23) * kHashPrime2 + kHashPrime3;
+}
+
+constexpr std::uint64_t hashAvalanche(const std::uint64_t h)
+{
+    return hashXorShift(hashXorShift(hashXorShift(h, 33) * kHashPrime2, 29) * kHashPrime3, 32);
+}
+
+constexpr std::uint64_t hashSeed(const int length)
+{
+    return kHashPrime5 + std::uint64_t(length);
+}
+
+constexpr std::uint32_t hashFinal(const std::uint64_t h)
+{
+    return static_cast<std::uint32_t>(hashAvalanche(h));
+}
+
+constexpr std::uint64_t hashBytesCT(const char * s, const int length, const std::uint64_t h)
+{
+    return (length >= 8) ? hashBytesCT(s + 8, length - 8, hashWord(h, hashLoadBytes(s, 8))) :
+           (length >  0) ? hashTail(h, hashLoadBytes(s, length)) : h;
+}
+
+constexpr int lengthOfStringCT(const char * s)
+{
+    return (*s == '\0') ? 0 : 1 + lengthOfStringCT(s + 1);
+}
+
+} // namespace detail {}
+
+// Compile-time version of the hash used for GUI, Panel and Variable names.
+// Yields the same values as their getHashCode(), so it can be used to look
+// them up by hash code with keys computed from string literals, e.g.:
+//   constexpr std::uint32_t kSpeedKey = ntb::hashStringCT("speed");
+//   panel->findVariable(kSpeedKey);
+constexpr std::uint32_t hashStringCT(const char * cstr)
+{
+    return detail::hashFinal(detail::hashBytesCT(cstr, detail::lengthOfStringCT(cstr),
+                                                 detail::hashSeed(detail::lengthOfStringCT(cstr))));
+}
+
 // ========================================================
 // Input helpers:
 // ========================================================
@@ -233,12 +315,108 @@ public:
     virtual void * memAlloc(std::uint32_t sizeInBytes);
     virtual void memFree(void * ptrToFree);
 
+    // GUI, Panel and Variable objects are by default carved out of pools
+    // of contiguous memory blocks (each block allocated with memAlloc),
+    // with a separate pool for the Variables of each Panel. Return false
+    // to have each object allocated individually with memAlloc instead.
+    // Only queried when a pool has no live objects, so changing the
+    // returned value on the fly is safe.
+    virtual bool usePooledObjectAllocation() const;
+
     // Get the current time in milliseconds for things like
     // cursor animation and other UI effects. This method
     // is required and must be implemented.
     virtual std::int64_t getTimeMilliseconds() const = 0;
 };
 
+// ========================================================
+// struct ObjectPoolStats:
+// ========================================================
+
+// Memory usage of the object pools (see ShellInterface::usePooledObjectAllocation).
+struct ObjectPoolStats
+{
+    std::int64_t totalAllocs  = 0; // Objects allocated since the pool was created.
+    std::int64_t totalFrees   = 0; // Objects freed since the pool was created.
+    std::int32_t liveObjects  = 0; // Objects currently allocated.
+    std::int32_t freeSlots    = 0; // Unused object slots in the allocated blocks.
+    std::int32_t blockCount   = 0; // Blocks currently allocated with ShellInterface::memAlloc.
+    std::int32_t blockBytes   = 0; // Total size in bytes of the allocated blocks.
+
+    // Fraction of the pooled slots not holding a live object, in the [0,1] range.
+    Float32 getFragmentation() const
+    {
+        const std::int32_t slotCount = liveObjects + freeSlots;
+        return (slotCount > 0) ? static_cast<Float32>(freeSlots) / static_cast<Float32>(slotCount) : 0.0f;
+    }
+
+    ObjectPoolStats & operator += (const ObjectPoolStats & other)
+    {
+        totalAllocs += other.totalAllocs;
+        totalFrees  += other.totalFrees;
+        liveObjects += other.liveObjects;
+        freeSlots   += other.freeSlots;
+        blockCount  += other.blockCount;
+        blockBytes  += other.blockBytes;
+        return *this;
+    }
+};
+
+// ========================================================
+// struct AllocationStats:
+// ========================================================
+
+// Library subsystems that allocate memory with ShellInterface::memAlloc.
+enum class MemoryTag : std::uint8_t
+{
+    GeometryBatch, // Vertex/index batches of the frame and the Panel geometry caches.
+    SmallStr,      // Heap buffers of strings longer than the inline storage.
+    PODArray,      // Other dynamic arrays, like the lists of GUIs, Panels and Variables.
+    Widgets,       // Child lists, popup editors and other memory owned by the Widgets.
+    ObjectPool,    // Blocks of the GUI, Panel and Variable pools.
+    HashIndex,     // Name lookup tables.
+    FrameArena,    // Per-frame scratch memory of each GUI.
+    Renderer,      // Texture images and records of the built-in renderers.
+    VarUpdates,    // Queues of the variable values published by other threads.
+
+    // Number of entries in this enum. Internal use.
+    Count
+};
+
+// Allocation counters for each MemoryTag. The library-wide stats accumulate
+// from startup or the last resetAllocationStats(). See getAllocationStats().
+struct AllocationStats
+{
+    std::int64_t allocCount[int(MemoryTag::Count)] = {}; // ShellInterface::memAlloc calls.
+    std::int64_t allocBytes[int(MemoryTag::Count)] = {}; // Sum of the requested sizes.
+
+    std::int64_t getAllocCount(const MemoryTag tag) const { return allocCount[int(tag)]; }
+    std::int64_t getAllocBytes(const MemoryTag tag) const { return allocBytes[int(tag)]; }
+
+    std::int64_t getTotalAllocCount() const
+    {
+        std::int64_t total = 0;
+        for (int i = 0; i < int(MemoryTag::Count); ++i)
+        {
+            total += allocCount[i];
+        }
+        return total;
+    }
+
+    AllocationStats & operator -= (const AllocationStats & other)
+    {
+        for (int i = 0; i < int(MemoryTag::Count); ++i)
+        {
+            allocCount[i] -= other.allocCount[i];
+            allocBytes[i] -= other.allocBytes[i];
+        }
+        return *this;
+    }
+};
+
+// Name of the subsystem, for printing the stats.
+const char * memoryTagToString(MemoryTag tag);
+
 // ========================================================
 // class RenderInterface and helpers:
 // ========================================================
@@ -280,6 +458,124 @@ struct VertexPC
     Color32 color;
 };
 
+// Steps per pixel of the fixed point X and Y of VertexPTCCompact, which
+// covers positions in the [-8192,8192) range with a quarter pixel precision.
+constexpr int kCompactVertexSubpixels = 4;
+
+// Highest Z layer a VertexPTCCompact can hold.
+constexpr int kCompactVertexMaxZ = INT16_MAX;
+
+// VertexPTC quantized to 16 bytes instead of 24: X and Y in fixed point (kCompactVertexSubpixels
+// steps per pixel), the Z layer as an integer and UVs normalized to [0,65535], for renderers that
+// upload the frame to the GPU. See RenderInterface::supportsCompactVertexes().
+struct VertexPTCCompact
+{
+    std::int16_t  x, y, z;
+    std::uint16_t u, v;
+    std::uint16_t unused; // Keeps the color 4-bytes aligned.
+    Color32       color;
+};
+
+// True if the vertex fits the ranges of VertexPTCCompact, Z aside (the Z layers are checked per frame).
+bool isCompactVertexInRange(const VertexPTC & vert);
+
+// Packing rounds to the nearest representable value. The vertex must be isCompactVertexInRange().
+VertexPTCCompact packCompactVertex(const VertexPTC & vert);
+VertexPTC unpackCompactVertex(const VertexPTCCompact & packed);
+
+// What a PackedFrame DrawCommand draws.
+enum class DrawCommandType
+{
+    Triangles,        // Indexed triangles with an optional texture.
+    ClippedTriangles, // Indexed triangles drawn once per DrawClippedInfo.
+    Lines,            // Unindexed lines from the PackedFrame line vertexes.
+    Glyphs            // One textured quad per PackedFrame::glyphs instance.
+};
+
+// A text glyph, for renderers that supportsGlyphInstances(). The quad has its top-left corner at
+// [x,y], at layer z, and is PackedFrame::glyphWidth/glyphHeight times 'scale' in size. The texture
+// coordinates go from [u,v] (normalized to [0,65535]) to [u,v] + PackedFrame::glyphUVWidth/glyphUVHeight.
+// The four corners get the same color. 24 bytes, against 108 for the vertexes and indexes of a quad.
+struct GlyphInstance
+{
+    Float32       x, y, z;
+    Float32       scale;
+    std::uint16_t u, v;
+    Color32       color;
+};
+
+// How the GeometryBatch orders the primitives of a frame. See RenderInterface::getDrawOrder().
+enum class DrawOrder
+{
+    DepthLayers, // Each primitive gets its own Z layer and commands are grouped by type. Needs a depth test.
+    Painter      // Commands follow the order the UI was drawn in, all at Z 0. No depth test needed.
+};
+
+// A range of the packed frame streams, in submission order.
+struct DrawCommand
+{
+    DrawCommandType type;
+
+    // Triangles and Glyphs only. May be null for color-only drawing.
+    TextureHandle texture;
+
+    // Range of PackedFrame::verts (or PackedFrame::lineVerts for Lines, PackedFrame::glyphs for
+    // Glyphs, or PackedFrame::compactVerts for Triangles if the frame has compact vertexes).
+    int firstVertex;
+    int vertexCount;
+
+    // Range of PackedFrame::indexes. The indexes are relative to firstVertex,
+    // so no command addresses more than 65536 vertexes. Unused by Lines and Glyphs.
+    int firstIndex;
+    int indexCount;
+
+    // ClippedTriangles only. Range of PackedFrame::drawInfos. Their
+    // firstIndex is relative to the command's firstIndex.
+    int firstDrawInfo;
+    int drawInfoCount;
+};
+
+// All the geometry of a frame, with each stream in a single array.
+struct PackedFrame
+{
+    const VertexPTC       * verts;
+    const std::uint16_t   * indexes;
+    const VertexPC        * lineVerts;
+    const DrawClippedInfo * drawInfos;
+    const DrawCommand     * commands;
+
+    // Null unless the renderer supportsCompactVertexes() and the frame fits the compact ranges.
+    // When set, the Triangles commands draw from these and only the ClippedTriangles from verts.
+    const VertexPTCCompact * compactVerts;
+    int compactVertCount;
+
+    // Text of the frame if the renderer supportsGlyphInstances(), otherwise empty and the
+    // glyphs are regular Triangles. The glyph sizes are for a GlyphInstance scale of 1.
+    const GlyphInstance * glyphs;
+    int glyphCount;
+    Float32 glyphWidth, glyphHeight;
+    Float32 glyphUVWidth, glyphUVHeight;
+
+    int vertCount;
+    int indexCount;
+    int lineVertCount;
+    int drawInfoCount;
+    int commandCount;
+    int frameMaxZ;
+
+    // Order the commands were generated in. With DrawOrder::Painter every
+    // primitive is at Z 0, so frameMaxZ is always 1 and depth can be ignored.
+    DrawOrder drawOrder;
+};
+
+// Draw command counts of a packed frame. See GUI::getLastFrameDrawCallStats().
+struct DrawCallStats
+{
+    int primitives;      // Draw calls made to the GeometryBatch. A whole string of text counts as one.
+    int inOrderCommands; // Commands needed to draw the primitives strictly in the order they were drawn.
+    int commands;        // Commands actually submitted, grouped by type or sorted by layer.
+};
+
 class RenderInterface
 {
 public:
@@ -295,6 +591,23 @@ public:
     // Default value returned is = 999999.
     virtual int getMaxZ() const;
 
+    // Optional. How the primitives of each frame should be ordered; queried at the start of every frame.
+    // DrawOrder::DepthLayers (the default) relies on the depth test to layer the UI, so commands can be
+    // grouped by type, while DrawOrder::Painter emits them in draw order with no per-primitive Z, for
+    // renderers that draw without a depth buffer. The number of Z layers is then also not limited by getMaxZ().
+    virtual DrawOrder getDrawOrder() const;
+
+    // Optional. Return true to get the vertexes of the Triangles commands in PackedFrame::compactVerts
+    // when they fit, which takes a third less memory to upload. Queried at the end of every frame.
+    // The default drawPackedFrame() unpacks them back for draw2DTriangles(). Defaults to false.
+    virtual bool supportsCompactVertexes() const;
+
+    // Optional. Return true to get the text as Glyphs commands, with one GlyphInstance per glyph
+    // instead of a quad of vertexes, for renderers that can expand the quads on the GPU. Queried
+    // at the start of every frame. The default drawPackedFrame() builds the quads back for
+    // draw2DTriangles(). Defaults to false.
+    virtual bool supportsGlyphInstances() const;
+
     // Optional. Returns the dimensions of the rendering viewport/window.
     // Defaults returned are = [0,0, 1024,768]
     virtual void getViewport(int * viewportX, int * viewportY,
@@ -316,7 +629,8 @@ public:
     virtual void draw2DLines(const VertexPC * verts, int vertCount, int frameMaxZ);
 
     // Optional. Draw a batch of indexed 2D triangles - Texture will be null for color only triangles.
-    // Vertexes are in screen-space, according to the size given by getViewport().
+    // Vertexes are in screen-space, according to the size given by getViewport(). Batches never
+    // exceed 65536 vertexes; larger frames are split into several calls, so 16-bits indexes suffice.
     virtual void draw2DTriangles(const VertexPTC * verts, int vertCount,
                                  const std::uint16_t * indexes, int indexCount,
                                  TextureHandle texture, int frameMaxZ);
@@ -329,6 +643,11 @@ public:
                                         const DrawClippedInfo * drawInfo,
                                         int drawInfoCount, int frameMaxZ);
 
+    // Optional. Receives the whole frame at once, between beginDraw() and endDraw(), so the
+    // vertexes and indexes can be uploaded in one go and the commands drawn from offsets.
+    // The default implementation forwards each command to the draw methods above.
+    virtual void drawPackedFrame(const PackedFrame & frame);
+
     // Creates a simple black-and-white checkerboard texture for debugging.
     TextureHandle createCheckerboardTexture(int widthPixels, int heightPixels, int squares);
 };
@@ -1134,6 +1453,7 @@ public:
     // Miscellaneous accessors:
     virtual const char * getName() const = 0;
     virtual std::uint32_t getHashCode() const = 0;
+    virtual ObjectPoolStats getVariablePoolStats() const = 0;
 
     virtual const GUI * getGUI() const = 0;
     virtual GUI * getGUI() = 0;
@@ -1197,8 +1517,47 @@ public:
     virtual bool onMouseScroll(int yScroll) = 0; // +Y=forward, -Y=back
 
     // Draws the UI using the current RenderInterface.
+    // If nothing in the UI changed since the previous frame, the last frame's geometry
+    // is resubmitted as it is. Setting forceRefresh always rebuilds the whole UI geometry.
     virtual void onFrameRender(bool forceRefresh = false) = 0;
 
+    // Allocations made during the last onFrameRender(), per subsystem. Transient frame
+    // memory comes from a per-GUI arena, so once the UI settles these should all be zero.
+    virtual AllocationStats getLastFrameAllocationStats() const = 0;
+
+    // Lets the GUI reorder primitives that don't overlap on screen, grouping them by layer and
+    // texture so each frame takes as few draw commands as possible. The image is the same as
+    // drawing everything in order, which also fixes the blending of translucent elements drawn
+    // before the opaque ones in DrawOrder::DepthLayers. Off by default.
+    virtual void setPrimitiveSorting(bool enable) = 0;
+    virtual bool isSortingPrimitives() const = 0;
+
+    // Command counts of the frame built by the last onFrameRender() that wasn't a resubmit.
+    virtual DrawCallStats getLastFrameDrawCallStats() const = 0;
+
+    // Draws lines (outlines, separators, etc) as thin quads with the other untextured triangles,
+    // instead of as native lines in a draw command of their own. Quad lines also get wider with
+    // setGlobalUIScaling(), while native lines are always one pixel wide. Off by default.
+    virtual void setLinesAsQuads(bool enable) = 0;
+    virtual bool isDrawingLinesAsQuads() const = 0;
+
+    // Thread-safe way of updating variables bound to memory that other threads would otherwise
+    // write while the GUI reads it. Any thread can publish the full value of a variable (e.g.
+    // 4 floats for a ColorF of 4 elements), which is copied into the memory of the variable at
+    // the start of the next onFrameRender(), in the order published, so only the thread that
+    // renders the GUI touches that memory. By hash code, the value goes to the first variable
+    // with that name in any of the Panels. Returns false, dropping the value, if too many were
+    // published since the last frame or if the value is bigger than any variable can be.
+    // Values for strings, callback variables or of the wrong size are dropped with an error
+    // when applied. A variable must not be destroyed while other threads might still publish
+    // to it; the values already published to it are discarded. The first value published
+    // allocates the queue, with ShellInterface::memAlloc() called by the publishing thread.
+    virtual bool publishVariableValue(Variable * variable, const void * value, int sizeBytes) = 0;
+    virtual bool publishVariableValue(std::uint32_t varNameHashCode, const void * value, int sizeBytes) = 0;
+
+    template<typename T> bool publishVariableValue(Variable * variable, const T & value) { return publishVariableValue(variable, &value, int(sizeof(T))); }
+    template<typename T> bool publishVariableValue(std::uint32_t varNameHashCode, const T & value) { return publishVariableValue(varNameHashCode, &value, int(sizeof(T))); }
+
     // Other UI control methods:
     virtual void minimizeAllPanels() = 0;
     virtual void maximizeAllPanels() = 0;
@@ -1271,6 +1630,15 @@ void destroyAllGUIs();
 void enumerateAllGUIs(GUIEnumerateCallback enumCallback, void * userContext);
 int getGUICount();
 
+// Combined stats of all the object pools: GUIs, Panels of
+// every GUI and Variables of every Panel. See ObjectPoolStats.
+ObjectPoolStats getObjectPoolStats();
+
+// Library-wide allocation counters (see AllocationStats). Reset
+// to start counting from a known point, e.g. after warming up.
+AllocationStats getAllocationStats();
+void resetAllocationStats();
+
 // ========================================================
 // Library error handler:
 // ========================================================
@@ -329,7 +329,7 @@ static std::uint8_t * decompressFontBitmap()
 
     // Allocate the decompression buffer:
     const int uncompressedSizeBytes = getFontCharSet().bitmapDecompressSize;
-    std::uint8_t * uncompressedData = implAllocT<std::uint8_t>(uncompressedSizeBytes);
+    std::uint8_t * uncompressedData = implAllocT<std::uint8_t>(MemoryTag::Renderer, uncompressedSizeBytes);
 
     // Decode the bitmap pixels (stored with an LZW-flavor of compression):
     const int bytesDecoded = lzwDecompress(compressedData,
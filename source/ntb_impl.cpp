@@ -9,6 +9,8 @@
 
 #include "ntb_impl.hpp"
 
+#include <thread>
+
 namespace ntb
 {
 
@@ -47,7 +49,10 @@ VariableImpl::VariableImpl()
 
 VariableImpl::~VariableImpl()
 {
-    VarDisplayWidget::orphanAllChildren();
+    if (panel != nullptr)
+    {
+        static_cast<GUIImpl *>(panel->getGUI())->onVariableDestroyed(this);
+    }
 }
 
 void VariableImpl::init(PanelImpl * myPanel, Variable * myParent, const char * myName, bool readOnly, VariableType varType,
@@ -117,32 +122,27 @@ void VariableImpl::init(PanelImpl * myPanel, Variable * myParent, const char * m
     auto parentVarImpl = static_cast<VariableImpl *>(myParent);
     auto parentWidget  = static_cast<VarDisplayWidget *>(parentVarImpl);
 
-    // Hierarchy layout:
+    // Hierarchy layout. Only the horizontal placement matters here,
+    // the window stacks the rows (see WindowWidget::updateVarRows).
     Rectangle varRect{};
     if (parentWidget != nullptr)
     {
         // Adjust for the hierarchy expand/collapse button if needed:
         if (!parentWidget->hasExpandCollapseButton())
         {
-            Rectangle parentRect = parentWidget->getRect();
-            parentRect = parentRect.shrunk(parentWidget->getExpandCollapseButtonSize() / 2, 0);
-            parentRect.moveBy(parentWidget->getExpandCollapseButtonSize() / 2, 0);
-            parentWidget->setRect(parentRect);
+            const int halfButtonSize = parentWidget->getExpandCollapseButtonSize() / 2;
+            parentWidget->setRowIndent(parentWidget->getRowIndent() + halfButtonSize * 2);
         }
 
-        const int siblingCount = parentWidget->getChildCount();
-
-        varRect = parentWidget->getRect();
-        varRect.moveBy(window->uiScaled(kVarNestOffsetX), window->uiScaled(kVarHeight + kVarInBetweenSpacing) * (siblingCount + 1));
-        varRect = varRect.shrunk(window->uiScaled(kVarNestOffsetX), 0);
+        varRect.xMins = windowRect.getX() + parentWidget->getRowIndent() + window->uiScaled(kVarNestOffsetX) * 2;
     }
     else
     {
         varRect.xMins = windowRect.getX() + window->uiScaled(kVarLeftSpacing);
-        varRect.yMins = windowRect.getY() + window->uiScaled(kVarTopSpacing) + (window->uiScaled(kVarHeight + kVarInBetweenSpacing) * panel->getVariablesCount());
-        varRect.xMaxs = varRect.xMins + windowRect.getWidth() - window->uiScaled(kVarRightSpacing) - window->uiScaled(kVarLeftSpacing);
-        varRect.yMaxs = varRect.yMins + window->uiScaled(kVarHeight);
     }
+    varRect.yMins = windowRect.getY() + window->uiScaled(kVarTopSpacing);
+    varRect.xMaxs = windowRect.xMaxs - window->uiScaled(kVarRightSpacing);
+    varRect.yMaxs = varRect.yMins + window->uiScaled(kVarHeight);
 
     std::uint32_t varWidgetFlags = 0;
     bool checkboxInitialState = false;
@@ -192,6 +192,7 @@ Variable * VariableImpl::setName(const char * newName)
 {
     VarDisplayWidget::setVarName(newName);
     hashCode = hashString(newName);
+    panel->onVariableRenamed();
     return this;
 }
 
@@ -240,6 +241,7 @@ Variable * VariableImpl::expandHierarchy()
 Variable * VariableImpl::numberFormat(NumberFormat format)
 {
     this->numberFmt = format;
+    this->valueSnapshotValid = false;
     return this;
 }
 
@@ -247,6 +249,7 @@ Variable * VariableImpl::displayColorAsText(bool displayAsRgbaNumbers)
 {
     if (isColorVar())
     {
+        valueSnapshotValid = false;
         if (!displayAsRgbaNumbers) // Display as a colored rectangle?
         {
             const Color32 varColor = getVarColorValue();
@@ -276,6 +279,22 @@ Variable * VariableImpl::valueStep(Float64 step)
     return this;
 }
 
+bool VariableImpl::setVarValueBytes(const void * value, const int sizeBytes)
+{
+    // Only plain values in memory of our own. Strings and callbacks can't be copied byte by byte.
+    const int varSize = getVarValueSizeBytes();
+    if (varData == nullptr || varSize == 0 || sizeBytes != varSize)
+    {
+        errorF("Can't set a value of %i bytes to variable '%s'", sizeBytes, getName());
+        return false;
+    }
+
+    // Read-only is only for the UI. The new value gets
+    // picked up as a change when the variable is polled.
+    std::memcpy(varData, value, sizeBytes);
+    return true;
+}
+
 VariableType VariableImpl::getType() const
 {
     return varType;
@@ -312,6 +331,17 @@ bool VariableImpl::isEditPopupVar() const
     return false;
 }
 
+bool VariableImpl::onGetVarValueColor(Color32 & color) const
+{
+    if (!isColorVar() || (varData == nullptr && optionalCallbacks.isNull()))
+    {
+        return false;
+    }
+
+    color = getVarColorValue();
+    return true;
+}
+
 bool VariableImpl::onGetVarValueText(SmallStr & valueText) const
 {
     if (varData == nullptr && optionalCallbacks.isNull())
@@ -347,6 +377,13 @@ bool VariableImpl::onGetVarValueText(SmallStr & valueText) const
         }
     }
 
+    return formatVarValueText(valuePtr, valueText);
+}
+
+bool VariableImpl::formatVarValueText(const void * valuePtr, SmallStr & valueText) const
+{
+    NTB_ASSERT(valuePtr != nullptr);
+
     // Convert value to string:
     switch (varType)
     {
@@ -529,6 +566,96 @@ bool VariableImpl::onGetVarValueText(SmallStr & valueText) const
     return true;
 }
 
+bool VariableImpl::onUpdateVarValueText(SmallStr & valueText, bool & changed) const
+{
+    // Strings have no fixed size, so they are always reformatted.
+    const int valueSize = getVarValueSizeBytes();
+    if (valueSize == 0)
+    {
+        valueSnapshotValid = false;
+        return VarDisplayWidget::onUpdateVarValueText(valueText, changed);
+    }
+
+    changed = false;
+    if (varData == nullptr && optionalCallbacks.isNull())
+    {
+        return false;
+    }
+
+    const void * valuePtr = nullptr;
+    NTB_ALIGNED(char tempValueBuffer[kVarCallbackDataMaxSize], 16) = {};
+
+    if (varData != nullptr)
+    {
+        valuePtr = varData;
+    }
+    else
+    {
+        optionalCallbacks.callGetter(tempValueBuffer);
+        valuePtr = tempValueBuffer;
+    }
+
+    // Same bytes as when the text was last formatted? Then nothing to do.
+    if (valueSnapshotValid && std::memcmp(valueSnapshot, valuePtr, valueSize) == 0)
+    {
+        return true;
+    }
+
+    SmallStr newValueText;
+    newValueText.markTransient();
+    if (!formatVarValueText(valuePtr, newValueText))
+    {
+        valueSnapshotValid = false;
+        return false;
+    }
+
+    std::memcpy(valueSnapshot, valuePtr, valueSize);
+    valueSnapshotValid = true;
+
+    // Different bytes might still format to the same text (i.e.: past the displayed precision).
+    if (newValueText != valueText)
+    {
+        valueText = newValueText;
+        changed   = true;
+    }
+    return true;
+}
+
+int VariableImpl::getVarValueSizeBytes() const
+{
+    int size = 0;
+    switch (varType)
+    {
+    case VariableType::Enum :
+        NTB_ASSERT(enumConstants != nullptr);
+        size = int(enumConstants[0].value); // First constant holds the enum size.
+        break;
+    case VariableType::VecF     :
+    case VariableType::DirVec3  :
+    case VariableType::Quat4    :
+    case VariableType::ColorF   : size = int(sizeof(Float32)) * elementCount; break;
+    case VariableType::Color8B  : size = int(sizeof(std::uint8_t)) * elementCount; break;
+    case VariableType::ColorU32 : size = int(sizeof(Color32));       break;
+    case VariableType::Bool     : size = int(sizeof(bool));          break;
+    case VariableType::Ptr      : size = int(sizeof(void *));        break;
+    case VariableType::Int8     : size = int(sizeof(std::int8_t));   break;
+    case VariableType::UInt8    : size = int(sizeof(std::uint8_t));  break;
+    case VariableType::Int16    : size = int(sizeof(std::int16_t));  break;
+    case VariableType::UInt16   : size = int(sizeof(std::uint16_t)); break;
+    case VariableType::Int32    : size = int(sizeof(std::int32_t));  break;
+    case VariableType::UInt32   : size = int(sizeof(std::uint32_t)); break;
+    case VariableType::Int64    : size = int(sizeof(std::int64_t));  break;
+    case VariableType::UInt64   : size = int(sizeof(std::uint64_t)); break;
+    case VariableType::Flt32    : size = int(sizeof(Float32));       break;
+    case VariableType::Flt64    : size = int(sizeof(Float64));       break;
+    case VariableType::Char     : size = int(sizeof(char));          break;
+    default                     : size = 0; break; // Strings or invalid.
+    } // switch (varType)
+
+    // Too big for the snapshot buffer? Then just always reformat.
+    return (size <= int(sizeof(valueSnapshot))) ? size : 0;
+}
+
 void VariableImpl::onSetVarValueText(const SmallStr & valueText)
 {
     NTB_ASSERT(!readOnly);
@@ -1082,7 +1209,7 @@ void VariableImpl::onEditPopupButton(bool state)
 
                 auto onEntrySelected = ListWidget::OnEntrySelectedDelegate::fromClassMethod<VariableImpl, &VariableImpl::onListEntrySelected>(this);
 
-                auto listWidget = construct(implAllocT<ListWidget>());
+                auto listWidget = construct(implAllocT<ListWidget>(MemoryTag::Widgets));
                 listWidget->init(gui, this, listRect, true, onEntrySelected);
 
                 listWidget->allocEntries(elementCount - 1);
@@ -1114,7 +1241,7 @@ void VariableImpl::onEditPopupButton(bool state)
                 auto onColorSelected = ColorPickerWidget::OnColorSelectedDelegate::fromClassMethod<VariableImpl, &VariableImpl::onColorPickerColorSelected>(this);
                 auto onClosed = ColorPickerWidget::OnClosedDelegate::fromClassMethod<VariableImpl, &VariableImpl::onColorPickerClosed>(this);
 
-                auto colorPicker = construct(implAllocT<ColorPickerWidget>());
+                auto colorPicker = construct(implAllocT<ColorPickerWidget>(MemoryTag::Widgets));
 
                 colorPicker->init(gui, this, colorPickerRect, true,
                                   Widget::uiScaled(30), Widget::uiScaled(18),
@@ -1155,7 +1282,7 @@ void VariableImpl::onEditPopupButton(bool state)
                 auto onAnglesChanged = View3DWidget::OnAnglesChangedDelegate::fromClassMethod<VariableImpl, &VariableImpl::onView3DAnglesChanged>(this);
                 auto onClosed = View3DWidget::OnClosedDelegate::fromClassMethod<VariableImpl, &VariableImpl::onView3DClosed>(this);
 
-                auto view3d = construct(implAllocT<View3DWidget>());
+                auto view3d = construct(implAllocT<View3DWidget>(MemoryTag::Widgets));
 
                 view3d->init(gui, this, view3dRect, true, getVarName().c_str(),
                              Widget::uiScaled(30), Widget::uiScaled(18), Widget::uiScaled(10),
@@ -1186,7 +1313,7 @@ void VariableImpl::onEditPopupButton(bool state)
                 auto onGetFieldValueText = MultiEditFieldWidget::OnGetFieldValueTextDelegate::fromClassMethod<VariableImpl, &VariableImpl::onMultiEditWidgetGetFieldValueText>(this);
                 auto onClosed = MultiEditFieldWidget::OnClosedDelegate::fromClassMethod<VariableImpl, &VariableImpl::onMultiEditWidgetClosed>(this);
 
-                auto multiEditWidget = construct(implAllocT<MultiEditFieldWidget>());
+                auto multiEditWidget = construct(implAllocT<MultiEditFieldWidget>(MemoryTag::Widgets));
 
                 multiEditWidget->init(gui, this, multiEditRect, true, getVarName().c_str(),
                                       Widget::uiScaled(30), Widget::uiScaled(18), onGetFieldValueText, onClosed);
@@ -1219,7 +1346,7 @@ void VariableImpl::onEditPopupButton(bool state)
                 auto onGetFloatValue = FloatValueSliderWidget::OnGetFloatValueDelegate::fromClassMethod<VariableImpl, &VariableImpl::onValueSliderWidgetGetFloatValue>(this);
                 auto onClosed = FloatValueSliderWidget::OnClosedDelegate::fromClassMethod<VariableImpl, &VariableImpl::onValueSliderWidgetClosed>(this);
 
-                auto sliderWidget = construct(implAllocT<FloatValueSliderWidget>());
+                auto sliderWidget = construct(implAllocT<FloatValueSliderWidget>(MemoryTag::Widgets));
 
                 sliderWidget->init(gui, this, sliderRect, true, getVarName().c_str(),
                                    Widget::uiScaled(30), Widget::uiScaled(18), onGetFloatValue, onClosed);
@@ -1262,8 +1389,8 @@ PanelImpl::PanelImpl()
 
 PanelImpl::~PanelImpl()
 {
-    window.orphanAllChildren();
     PanelImpl::destroyAllVariables();
+    window.orphanAllChildren();
 }
 
 void PanelImpl::init(GUIImpl * myGUI, const char * myName)
@@ -1282,6 +1409,8 @@ void PanelImpl::init(GUIImpl * myGUI, const char * myName)
     window.init(myGUI, nullptr, rect, visible, resizeable, myName,
                 Widget::uiScaleBy(kPanelTitleBarHeight, scale), Widget::uiScaleBy(kPanelTitleBarBtnSize, scale),
                 Widget::uiScaleBy(kPanelScrollBarWidth, scale), Widget::uiScaleBy(kPanelScrollBarBtnSize, scale));
+
+    window.setVarRowLayout(window.uiScaled(kVarTopSpacing), window.uiScaled(kVarHeight + kVarInBetweenSpacing));
 }
 
 Variable * PanelImpl::addVariableRO(VariableType type, Variable * parent, const char * name, const void * var,
@@ -1291,12 +1420,13 @@ Variable * PanelImpl::addVariableRO(VariableType type, Variable * parent, const
     NTB_ASSERT(name != nullptr);
     NTB_ASSERT(var  != nullptr);
 
-    VariableImpl * newVar = construct(implAllocT<VariableImpl>());
+    VariableImpl * newVar = construct(poolAllocT<VariableImpl>(variablePool));
 
     const bool readOnly = true;
     newVar->init(this, parent, name, readOnly, type, const_cast<void *>(var), elementCount, enumConstants, nullptr);
 
     variables.pushBack(newVar);
+    variableIndex.insert(newVar->getHashCode(), newVar);
     return newVar;
 }
 
@@ -1307,12 +1437,13 @@ Variable * PanelImpl::addVariableRW(VariableType type, Variable * parent, const
     NTB_ASSERT(name != nullptr);
     NTB_ASSERT(var  != nullptr);
 
-    VariableImpl * newVar = construct(implAllocT<VariableImpl>());
+    VariableImpl * newVar = construct(poolAllocT<VariableImpl>(variablePool));
 
     const bool readOnly = false;
     newVar->init(this, parent, name, readOnly, type, var, elementCount, enumConstants, nullptr);
 
     variables.pushBack(newVar);
+    variableIndex.insert(newVar->getHashCode(), newVar);
     return newVar;
 }
 
@@ -1323,33 +1454,38 @@ Variable * PanelImpl::addVariableCB(VariableType type, Variable * parent, const
     NTB_ASSERT(name != nullptr);
     NTB_ASSERT(!callbacks.isNull());
 
-    VariableImpl * newVar = construct(implAllocT<VariableImpl>());
+    VariableImpl * newVar = construct(poolAllocT<VariableImpl>(variablePool));
 
     const bool readOnly = (access == VarAccess::RO);
     newVar->init(this, parent, name, readOnly, type, nullptr, elementCount, enumConstants, &callbacks);
 
     variables.pushBack(newVar);
+    variableIndex.insert(newVar->getHashCode(), newVar);
     return newVar;
 }
 
 Variable * PanelImpl::findVariable(const char * varName) const
 {
-    return findItemByName<VariableImpl *>(variables, varName);
+    return findItemByName<VariableImpl *>(variables, variableIndex, varName);
 }
 
 Variable * PanelImpl::findVariable(std::uint32_t varNameHashCode) const
 {
-    return findItemByHashCode<VariableImpl *>(variables, varNameHashCode);
+    return findItemByHashCode<VariableImpl *>(variables, variableIndex, varNameHashCode);
 }
 
 bool PanelImpl::destroyVariable(Variable * variable)
 {
-    return eraseAndDestroyItem<VariableImpl *>(variables, variable);
+    window.markDirty();
+    variableIndex.invalidate();
+    return eraseAndDestroyItem<VariableImpl *>(variables, variable, variablePool);
 }
 
 void PanelImpl::destroyAllVariables()
 {
-    destroyAllItems<VariableImpl *>(variables);
+    window.removeAllVarRows();
+    destroyAllItems<VariableImpl *>(variables, variablePool);
+    variableIndex.deallocate();
 }
 
 int PanelImpl::getVariablesCount() const
@@ -1366,6 +1502,7 @@ Panel * PanelImpl::setName(const char * newName)
 {
     window.setTitle(newName);
     hashCode = hashString(newName);
+    static_cast<GUIImpl *>(getGUI())->onPanelRenamed();
     return this;
 }
 
@@ -1389,14 +1526,49 @@ bool PanelImpl::onMouseScroll(int yScroll)
     return window.onMouseScroll(yScroll);
 }
 
-void PanelImpl::onFrameRender(GeometryBatch & geoBatch, bool forceRefresh)
+bool PanelImpl::needsRedraw()
 {
-    // TODO: Implement forced refresh?
-    // We could potentially keep track if any widget in the UI has changed
-    // and if not just re-submit the same GeometryBatch from the previous frame.
-    (void)forceRefresh;
+    // Lay out the rows in view if the list or the scroll position changed.
+    window.updateVarRows();
 
-    window.onDraw(geoBatch);
+    if (window.isDirty())
+    {
+        return true;
+    }
+
+    // User variables can change at any time without us being notified,
+    // so we have to poll the displayed values to find out if they changed.
+    // Only the ones in view, the others are refreshed when scrolled back in.
+    const int count = window.getVarRowsInViewCount();
+    for (int i = 0; i < count; ++i)
+    {
+        if (window.getVarRowInView(i)->refreshValueText())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PanelImpl::onFrameRender(GeometryBatch & geoBatch, const bool forceRefresh)
+{
+    // Only panels that changed get re-tessellated. The others
+    // append the geometry cached from the last time they were drawn,
+    // unless the draw order or the line settings changed since then.
+    if (forceRefresh || window.isDirty() || cachedGeometry.isEmpty() ||
+        !geoBatch.canAppendSegment(cachedGeometry))
+    {
+        // Cleared before drawing, so that any state change made by
+        // the widgets while drawing will trigger another redraw.
+        window.clearDirty();
+        geoBatch.beginSegment(cachedGeometry);
+        window.onDraw(geoBatch);
+        geoBatch.endSegment();
+    }
+    else
+    {
+        geoBatch.appendSegment(cachedGeometry);
+    }
 }
 
 Variable * PanelImpl::addHierarchyParent(const char * name)
@@ -1408,9 +1580,10 @@ Variable * PanelImpl::addHierarchyParent(Variable * parent, const char * name)
 {
     NTB_ASSERT(name != nullptr);
 
-    VariableImpl * newVar = construct(implAllocT<VariableImpl>());
+    VariableImpl * newVar = construct(poolAllocT<VariableImpl>(variablePool));
     newVar->init(this, parent, name, true, VariableType::Undefined, nullptr, 0, nullptr, nullptr);
     variables.pushBack(newVar);
+    variableIndex.insert(newVar->getHashCode(), newVar);
 
     return newVar;
 }
@@ -1435,6 +1608,147 @@ Panel * PanelImpl::setSize(int newWidth, int newHeight)
     return this;
 }
 
+// ========================================================
+// class VariableUpdateQueue:
+// ========================================================
+
+static_assert((VariableUpdateQueue::Capacity & (VariableUpdateQueue::Capacity - 1)) == 0, "Capacity must be a power of two!");
+
+VariableUpdateQueue::~VariableUpdateQueue()
+{
+    implFree(slots.load(std::memory_order_acquire));
+}
+
+VariableUpdateQueue::Slot * VariableUpdateQueue::allocateSlots()
+{
+    // Only one producer allocates. The others wait for it, which only happens the first time.
+    if (allocating.exchange(true, std::memory_order_acq_rel))
+    {
+        Slot * newSlots;
+        while ((newSlots = slots.load(std::memory_order_acquire)) == nullptr)
+        {
+            std::this_thread::yield();
+        }
+        return newSlots;
+    }
+
+    // Not with implAllocT, since g_allocationStats belongs to the render thread.
+    // The consumer counts this allocation when it first sees the slots.
+    Slot * newSlots = static_cast<Slot *>(getShellInterface().memAlloc(Capacity * sizeof(Slot)));
+    NTB_ASSERT(newSlots != nullptr);
+
+    // Slot i is free for the producer that gets write position i.
+    for (int i = 0; i < Capacity; ++i)
+    {
+        construct(&newSlots[i]);
+        newSlots[i].sequence.store(std::uint32_t(i), std::memory_order_relaxed);
+    }
+
+    slots.store(newSlots, std::memory_order_release);
+    return newSlots;
+}
+
+bool VariableUpdateQueue::push(Variable * variable, const std::uint32_t hashCode, const void * value, const int sizeBytes)
+{
+    if (value == nullptr || sizeBytes <= 0 || sizeBytes > MaxValueBytes)
+    {
+        return false;
+    }
+
+    Slot * const allSlots = isAllocated() ? slots.load(std::memory_order_acquire) : allocateSlots();
+
+    Slot * slot;
+    std::uint32_t pos = writePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        slot = &allSlots[pos & (Capacity - 1)];
+        const std::uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const std::int32_t diff = std::int32_t(sequence - pos);
+
+        if (diff == 0)
+        {
+            // Free for this lap. Take it, unless another producer got it first, which reloads 'pos'.
+            if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Still holds the update from the previous lap: full until the consumer catches up.
+            return false;
+        }
+        else
+        {
+            pos = writePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->update.variable  = variable;
+    slot->update.hashCode  = hashCode;
+    slot->update.sizeBytes = sizeBytes;
+    std::memcpy(slot->update.value, value, sizeBytes);
+
+    // Hands the slot over to the consumer.
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool VariableUpdateQueue::pop(Update & outUpdate)
+{
+    Slot * const allSlots = slots.load(std::memory_order_acquire);
+    if (allSlots == nullptr)
+    {
+        return false;
+    }
+
+    if (!allocationCounted)
+    {
+        g_allocationStats.allocCount[int(MemoryTag::VarUpdates)] += 1;
+        g_allocationStats.allocBytes[int(MemoryTag::VarUpdates)] += Capacity * sizeof(Slot);
+        allocationCounted = true;
+    }
+
+    Slot & slot = allSlots[readPos & (Capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != readPos + 1)
+    {
+        return false;
+    }
+
+    outUpdate = slot.update;
+
+    // Free for the producers of the next lap.
+    slot.sequence.store(readPos + Capacity, std::memory_order_release);
+    ++readPos;
+    return true;
+}
+
+void VariableUpdateQueue::forgetVariable(const Variable * variable)
+{
+    Slot * const allSlots = slots.load(std::memory_order_acquire);
+    if (allSlots == nullptr)
+    {
+        return;
+    }
+
+    // The ready slots belong to the consumer until popped, so they can be changed in place.
+    // Stops at the first one still being written, which can't be for a variable being
+    // destroyed, unless its producer broke the rules.
+    for (int i = 0; i < Capacity; ++i)
+    {
+        const std::uint32_t pos = readPos + std::uint32_t(i);
+        Slot & slot = allSlots[pos & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+        {
+            break;
+        }
+        if (slot.update.variable == variable)
+        {
+            slot.update.sizeBytes = 0;
+        }
+    }
+}
+
 // ========================================================
 // class GUIImpl:
 // ========================================================
@@ -1455,31 +1769,48 @@ void GUIImpl::init(const char * myName)
 
 Panel * GUIImpl::findPanel(const char * panelName) const
 {
-    return findItemByName<PanelImpl *>(panels, panelName);
+    return findItemByName<PanelImpl *>(panels, panelIndex, panelName);
 }
 
 Panel * GUIImpl::findPanel(std::uint32_t panelNameHashCode) const
 {
-    return findItemByHashCode<PanelImpl *>(panels, panelNameHashCode);
+    return findItemByHashCode<PanelImpl *>(panels, panelIndex, panelNameHashCode);
+}
+
+ObjectPoolStats GUIImpl::getObjectPoolStats() const
+{
+    ObjectPoolStats poolStats = panelPool.getStats();
+    const int count = panels.getSize();
+    for (int i = 0; i < count; ++i)
+    {
+        const PanelImpl * panel = panels.get<PanelImpl *>(i);
+        poolStats += panel->getVariablePoolStats();
+    }
+    return poolStats;
 }
 
 Panel * GUIImpl::createPanel(const char * panelName)
 {
     NTB_ASSERT(panelName != nullptr);
-    PanelImpl * panel = construct(implAllocT<PanelImpl>());
+    PanelImpl * panel = construct(poolAllocT<PanelImpl>(panelPool));
     panel->init(this, panelName);
     panels.pushBack(panel);
+    panelIndex.insert(panel->getHashCode(), panel);
     return panel;
 }
 
 bool GUIImpl::destroyPanel(Panel * panel)
 {
-    return eraseAndDestroyItem<PanelImpl *>(panels, panel);
+    geoBatchOutdated = true;
+    panelIndex.invalidate();
+    return eraseAndDestroyItem<PanelImpl *>(panels, panel, panelPool);
 }
 
 void GUIImpl::destroyAllPanels()
 {
-    destroyAllItems<PanelImpl *>(panels);
+    geoBatchOutdated = true;
+    destroyAllItems<PanelImpl *>(panels, panelPool);
+    panelIndex.deallocate();
 }
 
 int GUIImpl::getPanelCount() const
@@ -1550,17 +1881,122 @@ bool GUIImpl::onMouseScroll(int yScroll)
 
 void GUIImpl::onFrameRender(bool forceRefresh)
 {
-    geoBatch.beginDraw();
+    // Before polling the variables, so the values published since the last frame show up in this one.
+    if (varUpdates.isAllocated())
+    {
+        applyVariableUpdates();
+    }
+
+    const AllocationStats allocStatsBefore = g_allocationStats;
 
+    // Temporary strings formatted during the frame come from the frame arena.
+    FrameArena::Scope frameArenaScope{ geoBatch.getFrameArena() };
     const int count = panels.getSize();
+
+    // If nothing changed since the last frame we can skip drawing
+    // the widgets and just submit the same geometry once again.
+    // Every panel has to be polled, since needsRedraw() is also
+    // what flags the panels with changed variables for redraw.
+    bool rebuild = forceRefresh || geoBatchOutdated ||
+                   (geoBatch.getDrawOrder() != getRenderInterface().getDrawOrder()) ||
+                   (geoBatch.isUsingGlyphInstances() != getRenderInterface().supportsGlyphInstances());
     for (int i = 0; i < count; ++i)
     {
         PanelImpl * panel = panels.get<PanelImpl *>(i);
-        panel->onFrameRender(geoBatch, forceRefresh);
+        if (panel->needsRedraw())
+        {
+            rebuild = true;
+        }
+    }
+
+    if (!rebuild)
+    {
+        geoBatch.resubmitLastFrame();
+    }
+    else
+    {
+        geoBatch.beginDraw();
+
+        for (int i = 0; i < count; ++i)
+        {
+            PanelImpl * panel = panels.get<PanelImpl *>(i);
+            panel->onFrameRender(geoBatch, forceRefresh);
+        }
+
+        // Submit to the RenderInterface.
+        geoBatch.endDraw();
+        geoBatchOutdated = false;
+    }
+
+    lastFrameAllocStats  = g_allocationStats;
+    lastFrameAllocStats -= allocStatsBefore;
+}
+
+bool GUIImpl::publishVariableValue(Variable * variable, const void * value, const int sizeBytes)
+{
+    NTB_ASSERT(variable != nullptr);
+    return varUpdates.push(variable, 0, value, sizeBytes);
+}
+
+bool GUIImpl::publishVariableValue(const std::uint32_t varNameHashCode, const void * value, const int sizeBytes)
+{
+    return varUpdates.push(nullptr, varNameHashCode, value, sizeBytes);
+}
+
+void GUIImpl::applyVariableUpdates()
+{
+    // At most a full queue per frame, or producers that keep
+    // publishing could keep the render thread in here forever.
+    VariableUpdateQueue::Update update;
+    for (int i = 0; i < VariableUpdateQueue::Capacity && varUpdates.pop(update); ++i)
+    {
+        if (update.sizeBytes == 0)
+        {
+            continue; // Variable destroyed after publishing.
+        }
+
+        Variable * variable = update.variable;
+        if (variable == nullptr)
+        {
+            const int count = panels.getSize();
+            for (int p = 0; p < count && variable == nullptr; ++p)
+            {
+                variable = panels.get<PanelImpl *>(p)->findVariable(update.hashCode);
+            }
+            if (variable == nullptr)
+            {
+                errorF("No variable with hash code 0x%08X to publish a value to", update.hashCode);
+                continue;
+            }
+        }
+        else if (variable->getGUI() != this)
+        {
+            errorF("Variable '%s' published to a GUI that doesn't own it", variable->getName());
+            continue;
+        }
+
+        static_cast<VariableImpl *>(variable)->setVarValueBytes(update.value, update.sizeBytes);
     }
+}
 
-    // Submit to the RenderInterface.
-    geoBatch.endDraw();
+void GUIImpl::setPrimitiveSorting(const bool enable)
+{
+    if (enable != geoBatch.isSortingPrimitives())
+    {
+        // Panel segments don't depend on it, only the packing of the frame.
+        geoBatch.setSortPrimitives(enable);
+        geoBatchOutdated = true;
+    }
+}
+
+void GUIImpl::setLinesAsQuads(const bool enable)
+{
+    if (enable != geoBatch.isDrawingLinesAsQuads())
+    {
+        // The panels see their segments no longer match and draw them again.
+        geoBatch.setLinesAsQuads(enable);
+        geoBatchOutdated = true;
+    }
 }
 
 void GUIImpl::minimizeAllPanels()
@@ -1605,6 +2041,13 @@ void GUIImpl::showAllPanels()
 
 void GUIImpl::setGlobalUIScaling(Float32 scaling)
 {
+    // Also the starting size of the panels created from now on.
+    globalUIScaling = scaling;
+
+    // Lines drawn as quads scale with the rest of the UI, in whole pixels so they stay sharp.
+    geoBatch.setLineWidth(Widget::uiScaleBy(1.0, scaling));
+    geoBatchOutdated = true;
+
     const int count = panels.getSize();
     for (int i = 0; i < count; ++i)
     {
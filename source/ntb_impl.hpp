@@ -11,6 +11,8 @@
 #include "ntb_utils.hpp"
 #include "ntb_widgets.hpp"
 
+#include <atomic>
+
 namespace ntb
 {
 
@@ -53,6 +55,9 @@ public:
     Variable * valueRange(Float64 valueMin, Float64 valueMax, bool clamped) override;
     Variable * valueStep(Float64 step) override;
 
+    // Copies a value published by another thread into the variable memory (see GUI::publishVariableValue()).
+    bool setVarValueBytes(const void * value, int sizeBytes);
+
 private:
 
     bool isNumberVar() const;
@@ -60,6 +65,8 @@ private:
     bool isEditPopupVar() const;
     template<typename OP> void applyNumberVarOp(const OP & op);
     Color32 getVarColorValue() const;
+    bool formatVarValueText(const void * valuePtr, SmallStr & valueText) const;
+    int getVarValueSizeBytes() const;
     Vec3 getVarRotationAnglesValue() const;
 
     // Widget Delegates:
@@ -75,6 +82,8 @@ private:
 
     // VarDisplayWidget overrides:
     bool onGetVarValueText(SmallStr & valueText) const override;
+    bool onGetVarValueColor(Color32 & color) const override;
+    bool onUpdateVarValueText(SmallStr & valueText, bool & changed) const override;
     void onSetVarValueText(const SmallStr & valueText) override;
     void onIncrementButton() override;
     void onDecrementButton() override;
@@ -96,6 +105,11 @@ private:
     NumberFormat         numberFmt{ NumberFormat::Decimal };
     bool                 clamped{ false }; // If true clamps to [valueMin,valueMax]
     bool                 readOnly{ false };
+
+    // Raw bytes of the variable value when its text was last formatted,
+    // so the text conversion can be skipped if the value didn't change.
+    mutable bool         valueSnapshotValid{ false };
+    mutable std::uint8_t valueSnapshot[32]{};
 };
 
 // ========================================================
@@ -117,11 +131,17 @@ public:
     bool onMouseScroll(int yScroll);
     void onFrameRender(GeometryBatch & geoBatch, bool forceRefresh);
 
+    // Variable name changed, so its hash code in the lookup index is out-of-date.
+    void onVariableRenamed() { variableIndex.invalidate(); }
+
+    // True if anything in the panel changed since it was last drawn.
+    bool needsRedraw();
+
     void setMinimized(bool minimized) { window.setMinimized(minimized); }
     void setVisible(bool visible)     { window.setVisible(visible); }
 
-    void setUIScaling(Float32 s)   { window.setScaling(s); }
-    void setTextScaling(Float32 s) { window.setTextScaling(s); }
+    void setUIScaling(Float32 s)   { window.setScaling(s); window.invalidateVarRows(false); }
+    void setTextScaling(Float32 s) { window.setTextScaling(s); window.invalidateVarRows(false); }
 
     WindowWidget * getWindow() { return &window; }
 
@@ -159,12 +179,83 @@ public:
     Panel * setName(const char * newName) override;
     const char * getName() const override { return window.getTitle(); }
     std::uint32_t getHashCode() const override { return hashCode; }
+    ObjectPoolStats getVariablePoolStats() const override { return variablePool.getStats(); }
 
 private:
 
     std::uint32_t hashCode{ 0 }; // Hash of name/window title for fast lookup.
+    ObjectPool    variablePool{ sizeof(VariableImpl), 64 }; // Must outlive the variables.
     PODArray      variables{ sizeof(VariableImpl *) };
     WindowWidget  window{};
+
+    // Lookup by name/hash code for findVariable(). Mutable since rebuilt on demand.
+    mutable HashIndex variableIndex{};
+
+    // Geometry of the window from the last time it was redrawn.
+    GeometrySegment cachedGeometry{};
+};
+
+// ========================================================
+// class VariableUpdateQueue:
+// ========================================================
+
+// Bounded lock-free queue of the variable values published by any number of threads with
+// GUI::publishVariableValue(), applied by the one thread that renders the GUI. Each slot has
+// a sequence number telling if it is free for the next lap of the producers or holds a value
+// ready for the consumer, so the producers only contend for the increment of the write position.
+// Most GUIs never publish anything, so the slots are only allocated by the first push.
+class VariableUpdateQueue final
+{
+public:
+
+    static constexpr int Capacity      = 1024; // Must be a power of two.
+    static constexpr int MaxValueBytes = 32;   // Biggest value of any variable, see VariableImpl::getVarValueSizeBytes().
+
+    struct Update
+    {
+        Variable *    variable;  // Null if published by hash code.
+        std::uint32_t hashCode;
+        int           sizeBytes; // Zero if the variable was destroyed after publishing.
+        std::uint8_t  value[MaxValueBytes];
+    };
+
+    VariableUpdateQueue() = default;
+    ~VariableUpdateQueue();
+
+    // Not copyable.
+    VariableUpdateQueue(const VariableUpdateQueue &) = delete;
+    VariableUpdateQueue & operator = (const VariableUpdateQueue &) = delete;
+
+    // Any thread. False if full or if the value doesn't fit.
+    bool push(Variable * variable, std::uint32_t hashCode, const void * value, int sizeBytes);
+
+    // Consumer thread only. False if empty, or if the oldest update is still being written.
+    bool pop(Update & outUpdate);
+
+    // Consumer thread only. False until something is first pushed.
+    bool isAllocated() const { return slots.load(std::memory_order_acquire) != nullptr; }
+
+    // Consumer thread only. Marks the updates waiting for the variable as discarded.
+    void forgetVariable(const Variable * variable);
+
+private:
+
+    struct Slot
+    {
+        std::atomic<std::uint32_t> sequence;
+        Update update;
+    };
+
+    Slot * allocateSlots();
+
+    std::atomic<Slot *>        slots{ nullptr };
+    std::atomic<bool>          allocating{ false }; // Set by the producer that gets to allocate the slots.
+    std::atomic<std::uint32_t> writePos{ 0 };
+
+    // Keeps the consumer state off the cache line the producers keep writing.
+    std::uint8_t  padding[64]{};
+    std::uint32_t readPos{ 0 };
+    bool          allocationCounted{ false }; // Added to g_allocationStats by the consumer.
 };
 
 // ========================================================
@@ -194,6 +285,19 @@ public:
     bool onMouseScroll(int yScroll) override;
     void onFrameRender(bool forceRefresh = false) override;
 
+    using GUI::publishVariableValue;
+    bool publishVariableValue(Variable * variable, const void * value, int sizeBytes) override;
+    bool publishVariableValue(std::uint32_t varNameHashCode, const void * value, int sizeBytes) override;
+    void onVariableDestroyed(const Variable * variable) { varUpdates.forgetVariable(variable); }
+
+    AllocationStats getLastFrameAllocationStats() const override { return lastFrameAllocStats; }
+
+    void setPrimitiveSorting(bool enable) override;
+    bool isSortingPrimitives() const override { return geoBatch.isSortingPrimitives(); }
+    DrawCallStats getLastFrameDrawCallStats() const override { return geoBatch.getLastDrawCallStats(); }
+    void setLinesAsQuads(bool enable) override;
+    bool isDrawingLinesAsQuads() const override { return geoBatch.isDrawingLinesAsQuads(); }
+
     void minimizeAllPanels() override;
     void maximizeAllPanels() override;
     void hideAllPanels() override;
@@ -206,16 +310,29 @@ public:
 
     void setName(const char * newName) { name = newName; hashCode = hashString(newName); }
     const char * getName() const override { return name.c_str(); }
+    void onPanelRenamed() { panelIndex.invalidate(); }
+
+    // Stats of the pool of Panels plus the Variable pools of each Panel.
+    ObjectPoolStats getObjectPoolStats() const;
     std::uint32_t getHashCode() const override { return hashCode; }
 
 private:
 
+    void applyVariableUpdates();
+
     std::uint32_t hashCode{ 0 }; // Hash of name for fast lookup.
     SmallStr      name{};
+    ObjectPool    panelPool{ sizeof(PanelImpl), 8 }; // Must outlive the panels.
     PODArray      panels{ sizeof(PanelImpl *) };
+    mutable HashIndex panelIndex{}; // Lookup for findPanel(). Mutable since rebuilt on demand.
     GeometryBatch geoBatch{};
+    bool          geoBatchOutdated{ true }; // Forces a rebuild when panels are removed.
     Float32       globalUIScaling{ 1.0f };
     Float32       globalTextScaling{ 1.0f };
+    AllocationStats lastFrameAllocStats{}; // Allocations made by the last onFrameRender().
+
+    // Values published by other threads, applied at the start of onFrameRender().
+    VariableUpdateQueue varUpdates{};
 };
 
 } // namespace ntb {}
@@ -12,6 +12,20 @@
 //  include it. You still have to provide your platform-specific GL headers or extension wranglers
 //  before including this file, then #define NTB_DEFAULT_RENDERER_GL_CORE before including the file
 //  in a .cpp to enable the implementation.
+//
+//  Vertex and index data is streamed through a triple-buffered ring of GL buffers by default.
+//  Persistently mapped storage is used when the context supports it (GL 4.4 or ARB_buffer_storage),
+//  otherwise unsynchronized glMapBufferRange on a ring that is orphaned when it needs to grow.
+//  Contexts without sync objects fall back to one glBufferData per draw call.
+//
+//  With GL 4.3 (or ARB_multi_draw_indirect), the clipped triangles of the 3D widgets are drawn with
+//  a single glMultiDrawElementsIndirect per texture, with the viewports and clip boxes applied in
+//  the shaders, instead of one glViewport/glScissor/glDrawElements per DrawClippedInfo.
+//
+//  The unclipped triangles are uploaded as 16 bytes VertexPTCCompact when the frame fits them,
+//  and expanded back to floats by the vertex attribute fetch and the position scale uniform.
+//  With GL 3.3, text is uploaded as one GlyphInstance per glyph and each instance is expanded
+//  to a quad in the vertex shader, instead of four vertexes and six indexes.
 // ================================================================================================
 
 #include "ntb.hpp"
@@ -36,6 +50,26 @@ public:
     RenderInterfaceDefaultGLCore(const RenderInterfaceDefaultGLCore &) = delete;
     RenderInterfaceDefaultGLCore & operator = (const RenderInterfaceDefaultGLCore &) = delete;
 
+    // How vertexes and indexes get to the GL.
+    enum class BufferStreaming
+    {
+        Disabled,     // glBufferData with GL_DYNAMIC_DRAW on every draw call (reallocates storage).
+        MapRange,     // Ring buffer written with unsynchronized glMapBufferRange. Needs GL 3.2.
+        PersistentMap // Ring buffer with persistent/coherent storage, mapped once. Needs GL 4.4.
+    };
+
+    // Data written to the GL by the last beginDraw/endDraw pair.
+    struct FrameUploadStats
+    {
+        std::int64_t vertexBytes;   // Bytes of vertex data copied to GL buffers.
+        std::int64_t indexBytes;    // Bytes of index data copied to GL buffers.
+        std::int64_t indirectBytes; // Bytes of glMultiDrawElementsIndirect commands copied to GL buffers.
+        int          uploadCount;   // Number of separate uploads (one per stream per draw).
+        int          drawCalls;     // glDraw* calls issued. A multi-draw counts as one.
+        int          bufferAllocs;  // Buffer storage (re)allocations: glBufferData/glBufferStorage calls.
+        int          fenceWaits;    // Times the CPU blocked waiting for the GPU to release a ring region.
+    };
+
     // -- Local queries and helpers --
 
     bool isCheckingGLErrors() const;
@@ -44,15 +78,44 @@ public:
     bool isSavingGLStates() const;
     void setSaveGLStates(bool doSave);
 
+    // Drawing without the depth test makes the GUIs generate their frames in DrawOrder::Painter.
     bool isDrawingWithDepthTest() const;
     void setDrawWithDepthTest(bool doDepthTest);
 
     bool isDrawingLineSmooth() const;
     void setDrawWithLineSmooth(bool useLineSmooth);
 
+    // Draw the text with one instanced quad per glyph. Needs GL 3.3.
+    // Defaults to true if supported by the context. Ignored if not supported.
+    void setUseGlyphInstances(bool useInstances);
+    bool isUsingGlyphInstances() const;
+    bool isGlyphInstancingSupported() const;
+
+    // Take the frames with VertexPTCCompact vertexes when they fit. Defaults to true.
+    // Takes effect on the next frame the GUIs build (resubmitted frames keep their format).
+    bool isUsingCompactVertexes() const;
+    void setUseCompactVertexes(bool useCompact);
+
     void setWindowDimensions(int w, int h);
     const char * getGlslVersionString() const;
 
+    // Defaults to the best mode supported by the context. Requesting an unsupported
+    // mode falls back to the next best one, so check the result with getBufferStreaming().
+    // Must not be called between beginDraw/endDraw.
+    void setBufferStreaming(BufferStreaming mode);
+    BufferStreaming getBufferStreaming() const;
+    bool isBufferStreamingSupported(BufferStreaming mode) const;
+    static const char * bufferStreamingToString(BufferStreaming mode);
+
+    // Draw all the DrawClippedInfos that share a texture with a single multi-draw call.
+    // Defaults to true if supported by the context. Ignored if not supported.
+    void setBatchClippedDraws(bool doBatch);
+    bool isBatchingClippedDraws() const;
+    bool isMultiDrawIndirectSupported() const;
+
+    // Counters for the last frame, updated by endDraw().
+    const FrameUploadStats & getLastFrameUploadStats() const;
+
     // Explicitly free all allocated textures, invalidating any existing TextureHandles.
     // Implicitly called by the destructor.
     void freeAllTextures();
@@ -69,6 +132,9 @@ public:
 
     void beginDraw() override;
     void endDraw()   override;
+    DrawOrder getDrawOrder() const override;
+    bool supportsCompactVertexes() const override;
+    bool supportsGlyphInstances() const override;
 
     void getViewport(int * viewportX, int * viewportY,
                      int * viewportW, int * viewportH) const override;
@@ -93,9 +159,38 @@ public:
                                 const DrawClippedInfo * drawInfo,
                                 int drawInfoCount, int frameMaxZ) override;
 
+    void drawPackedFrame(const PackedFrame & frame) override;
+
 private:
 
+    // Each ring buffer is split into this many regions, one per frame in flight.
+    static const int kStreamRegions = 3;
+
+    // Max DrawClippedInfos per multi-draw call. Sizes the shader uniform arrays.
+    static const int kMaxClippedDrawsPerBatch = 64;
+
+    // Layout defined by glMultiDrawElementsIndirect.
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct GLStreamBuffer
+    {
+        GLenum         target;      // GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER.
+        GLuint         handle;      // 0 when not streaming.
+        GLsizeiptr     regionSize;  // Size in bytes of each of the kStreamRegions regions.
+        GLsizeiptr     writeOffset; // Next free byte in the current frame's region.
+        std::uint8_t * mappedPtr;   // Whole buffer, only for BufferStreaming::PersistentMap.
+    };
+
     static void * offsetPtr(std::size_t offset);
+    static GLsizeiptr alignStreamOffset(GLsizeiptr offset);
+    static bool hasGLExtension(const char * extName);
     static void checkGLError(const char * file, int line);
     static const char * errorToString(GLenum errorCode);
     static void compileShader(GLuint * shader);
@@ -105,9 +200,33 @@ private:
     void initBuffers();
     void makeWhiteTexture();
 
+    bool initStreamBuffer(GLStreamBuffer * stream, GLsizeiptr regionSize);
+    void freeStreamBuffer(GLStreamBuffer * stream);
+    void freeStreamBuffers();
+    void waitStreamRegion();
+    void fenceStreamRegion();
+    GLintptr uploadStream(GLStreamBuffer * stream, GLuint legacyBuffer, const void * data, GLsizeiptr sizeBytes);
+    bool reserveStream(GLStreamBuffer * stream, GLsizeiptr sizeBytes);
+    bool writeStream(GLStreamBuffer * stream, const void * data, GLsizeiptr sizeBytes, GLintptr * outBufferOffset);
+
     void recordGLStates();
     void restoreGLStates() const;
 
+    void setLines2DVertexFormat(GLintptr vbOffset);
+    void setTris2DVertexFormat(GLintptr vbOffset);
+    void setTris2DCompactVertexFormat(GLintptr vbOffset);
+    void setTris2DPositionScale(bool compact);
+    void setGlyphs2DVertexFormat(GLintptr vbOffset);
+    void resetGlyphs2DVertexFormat();
+    void setGlyphs2DProgram(const PackedFrame & frame);
+    void setLines2DProgram(int frameMaxZ);
+    void setTris2DProgram(int frameMaxZ);
+    void bindTris2DTexture(TextureHandle texture, GLuint * currentTexId);
+    void drawClippedRanges(const DrawClippedInfo * drawInfo, int drawInfoCount, GLintptr ibOffset,
+                           int frameMaxZ, GLuint * currentTexId);
+    void drawClippedRangesBatched(const DrawClippedInfo * drawInfo, int drawInfoCount, GLintptr ibOffset,
+                                  int frameMaxZ, GLuint * currentTexId);
+
     struct {
         bool  cullFaceEnabled;
         bool  scissorTestEnabled;
@@ -124,6 +243,7 @@ private:
         GLint vao;
         GLint vbo;
         GLint ibo;
+        GLint drawIndirectBuffer;
     } glStates;
 
     char glslVersionStr[64];
@@ -132,13 +252,33 @@ private:
     bool  saveGLStates;  // Always defaults to true.
     bool  drawWithDepth; // Always defaults to true.
     bool  lineSmooth;    // Always defaults to false.
+    bool  compactVerts;  // Always defaults to true.
     GLint windowWidth;
     GLint windowHeight;
 
     GLuint vao;
     GLuint vboLines2D;
     GLuint vboTris2D;
+    GLuint vboCompact2D;
+    GLuint vboGlyphs2D;
     GLuint iboTris2D;
+    GLuint vboDrawIndexes;  // [0, kMaxClippedDrawsPerBatch) as per-instance floats.
+    GLuint drawIndirectBuf; // Commands for the multi-draws if not streaming.
+
+    BufferStreaming  bufferStreaming;
+    bool             hasSyncObjects;
+    bool             hasBufferStorage;
+    bool             hasMultiDrawIndirect;
+    bool             hasInstancedArrays;
+    bool             batchClippedDraws;
+    bool             glyphInstances;
+    int              streamRegion;
+    GLsync           streamFences[kStreamRegions];
+    GLStreamBuffer   vertexStream;
+    GLStreamBuffer   indexStream;
+    GLStreamBuffer   indirectStream;
+    FrameUploadStats currUploadStats;
+    FrameUploadStats lastUploadStats;
 
     GLuint shaderProgLines2D;
     GLint  shaderProgLines2D_ScreenParams;
@@ -148,9 +288,25 @@ private:
     GLuint shaderProgTris2D;
     GLint  shaderProgTris2D_ScreenParams;
     GLint  shaderProgTris2D_ColorTexture;
+    GLint  shaderProgTris2D_PositionScale;
     GLuint vsTris2D;
     GLuint fsTris2D;
 
+    GLuint shaderProgGlyphs2D;
+    GLint  shaderProgGlyphs2D_ScreenParams;
+    GLint  shaderProgGlyphs2D_GlyphSize;
+    GLint  shaderProgGlyphs2D_ColorTexture;
+    GLuint vsGlyphs2D; // Uses fsTris2D.
+
+    GLuint shaderProgClipped2D;
+    GLint  shaderProgClipped2D_ScreenParams;
+    GLint  shaderProgClipped2D_FullViewport;
+    GLint  shaderProgClipped2D_Viewports;
+    GLint  shaderProgClipped2D_ClipBoxes;
+    GLint  shaderProgClipped2D_ColorTexture;
+    GLuint vsClipped2D;
+    GLuint fsClipped2D;
+
     struct GLTextureRecord : public ListNode<GLTextureRecord>
     {
         GLint  width;
@@ -204,6 +360,31 @@ inline void RenderInterfaceDefaultGLCore::setDrawWithLineSmooth(const bool useLi
     lineSmooth = useLineSmooth;
 }
 
+inline void RenderInterfaceDefaultGLCore::setUseGlyphInstances(const bool useInstances)
+{
+    glyphInstances = useInstances && hasInstancedArrays;
+}
+
+inline bool RenderInterfaceDefaultGLCore::isUsingGlyphInstances() const
+{
+    return glyphInstances;
+}
+
+inline bool RenderInterfaceDefaultGLCore::isGlyphInstancingSupported() const
+{
+    return hasInstancedArrays;
+}
+
+inline bool RenderInterfaceDefaultGLCore::isUsingCompactVertexes() const
+{
+    return compactVerts;
+}
+
+inline void RenderInterfaceDefaultGLCore::setUseCompactVertexes(const bool useCompact)
+{
+    compactVerts = useCompact;
+}
+
 inline void RenderInterfaceDefaultGLCore::setWindowDimensions(const int w, const int h)
 {
     windowWidth  = w;
@@ -215,11 +396,52 @@ inline const char * RenderInterfaceDefaultGLCore::getGlslVersionString() const
     return glslVersionStr;
 }
 
+inline RenderInterfaceDefaultGLCore::BufferStreaming RenderInterfaceDefaultGLCore::getBufferStreaming() const
+{
+    return bufferStreaming;
+}
+
+inline bool RenderInterfaceDefaultGLCore::isBufferStreamingSupported(const BufferStreaming mode) const
+{
+    switch (mode)
+    {
+    case BufferStreaming::PersistentMap : return hasBufferStorage && hasSyncObjects;
+    case BufferStreaming::MapRange      : return hasSyncObjects;
+    default                             : return true;
+    } // switch (mode)
+}
+
+inline void RenderInterfaceDefaultGLCore::setBatchClippedDraws(const bool doBatch)
+{
+    batchClippedDraws = doBatch && hasMultiDrawIndirect;
+}
+
+inline bool RenderInterfaceDefaultGLCore::isBatchingClippedDraws() const
+{
+    return batchClippedDraws;
+}
+
+inline bool RenderInterfaceDefaultGLCore::isMultiDrawIndirectSupported() const
+{
+    return hasMultiDrawIndirect;
+}
+
+inline const RenderInterfaceDefaultGLCore::FrameUploadStats & RenderInterfaceDefaultGLCore::getLastFrameUploadStats() const
+{
+    return lastUploadStats;
+}
+
 inline void * RenderInterfaceDefaultGLCore::offsetPtr(std::size_t offset)
 {
     return reinterpret_cast<void *>(offset);
 }
 
+inline GLsizeiptr RenderInterfaceDefaultGLCore::alignStreamOffset(const GLsizeiptr offset)
+{
+    // Keep each upload 16 bytes aligned, which suits both the vertex attributes and the indexes.
+    return (offset + 15) & ~GLsizeiptr(15);
+}
+
 } // namespace ntb {}
 
 // ================== End of header file ==================
@@ -244,12 +466,25 @@ RenderInterfaceDefaultGLCore::RenderInterfaceDefaultGLCore(const int windowW, co
     , saveGLStates(true)
     , drawWithDepth(true)
     , lineSmooth(false)
+    , compactVerts(true)
     , windowWidth(windowW)
     , windowHeight(windowH)
     , vao(0)
     , vboLines2D(0)
     , vboTris2D(0)
+    , vboCompact2D(0)
+    , vboGlyphs2D(0)
     , iboTris2D(0)
+    , vboDrawIndexes(0)
+    , drawIndirectBuf(0)
+    , bufferStreaming(BufferStreaming::Disabled)
+    , hasSyncObjects(false)
+    , hasBufferStorage(false)
+    , hasMultiDrawIndirect(false)
+    , hasInstancedArrays(false)
+    , batchClippedDraws(false)
+    , glyphInstances(false)
+    , streamRegion(0)
     , shaderProgLines2D(0)
     , shaderProgLines2D_ScreenParams(-1)
     , vsLines2D(0)
@@ -257,18 +492,41 @@ RenderInterfaceDefaultGLCore::RenderInterfaceDefaultGLCore(const int windowW, co
     , shaderProgTris2D(0)
     , shaderProgTris2D_ScreenParams(-1)
     , shaderProgTris2D_ColorTexture(-1)
+    , shaderProgTris2D_PositionScale(-1)
     , vsTris2D(0)
     , fsTris2D(0)
+    , shaderProgGlyphs2D(0)
+    , shaderProgGlyphs2D_ScreenParams(-1)
+    , shaderProgGlyphs2D_GlyphSize(-1)
+    , shaderProgGlyphs2D_ColorTexture(-1)
+    , vsGlyphs2D(0)
+    , shaderProgClipped2D(0)
+    , shaderProgClipped2D_ScreenParams(-1)
+    , shaderProgClipped2D_FullViewport(-1)
+    , shaderProgClipped2D_Viewports(-1)
+    , shaderProgClipped2D_ClipBoxes(-1)
+    , shaderProgClipped2D_ColorTexture(-1)
+    , vsClipped2D(0)
+    , fsClipped2D(0)
     , whiteTexture(nullptr)
 {
     std::memset(&glStates,       0, sizeof(glStates));
     std::memset(&glslVersionStr, 0, sizeof(glslVersionStr));
+    std::memset(streamFences,     0, sizeof(streamFences));
+    std::memset(&vertexStream,    0, sizeof(vertexStream));
+    std::memset(&indexStream,     0, sizeof(indexStream));
+    std::memset(&indirectStream,  0, sizeof(indirectStream));
+    std::memset(&currUploadStats, 0, sizeof(currUploadStats));
+    std::memset(&lastUploadStats, 0, sizeof(lastUploadStats));
 
     // Get initial in case user calls getViewport() before a beginDraw/endDraw pair.
     glGetIntegerv(GL_VIEWPORT, glStates.viewport);
 
     initBuffers();
     initShaders();
+
+    // Use the best streaming mode available.
+    setBufferStreaming(BufferStreaming::PersistentMap);
 }
 
 RenderInterfaceDefaultGLCore::~RenderInterfaceDefaultGLCore()
@@ -381,15 +639,17 @@ void RenderInterfaceDefaultGLCore::initShaders()
         "in vec2 in_TexCoords;\n"
         "in vec4 in_Color;\n"
         "uniform vec3 u_ScreenParams;\n"
+        "uniform vec3 u_PositionScale;\n"
         "\n"
         "out vec2 v_TexCoords;\n"
         "out vec4 v_Color;\n"
         "\n"
         "void main()\n"
         "{\n"
-        "    gl_Position.x = toNormScreenX(in_Position.x, u_ScreenParams.x);\n"
-        "    gl_Position.y = toNormScreenY(in_Position.y, u_ScreenParams.y);\n"
-        "    gl_Position.z = remapZ(in_Position.z, 0.0, u_ScreenParams.z, -1.0, 1.0);\n"
+        "    vec3 position = in_Position * u_PositionScale;\n"
+        "    gl_Position.x = toNormScreenX(position.x, u_ScreenParams.x);\n"
+        "    gl_Position.y = toNormScreenY(position.y, u_ScreenParams.y);\n"
+        "    gl_Position.z = remapZ(position.z, 0.0, u_ScreenParams.z, -1.0, 1.0);\n"
         "    gl_Position.w = 1.0;\n"
         "    v_TexCoords   = in_TexCoords;\n"
         "    v_Color       = in_Color;\n"
@@ -425,8 +685,9 @@ void RenderInterfaceDefaultGLCore::initShaders()
     glBindAttribLocation(shaderProgTris2D, 2, "in_Color");
     linkProgram(&shaderProgTris2D);
 
-    shaderProgTris2D_ScreenParams = glGetUniformLocation(shaderProgTris2D, "u_ScreenParams");
-    shaderProgTris2D_ColorTexture = glGetUniformLocation(shaderProgTris2D, "u_ColorTexture");
+    shaderProgTris2D_ScreenParams  = glGetUniformLocation(shaderProgTris2D, "u_ScreenParams");
+    shaderProgTris2D_ColorTexture  = glGetUniformLocation(shaderProgTris2D, "u_ColorTexture");
+    shaderProgTris2D_PositionScale = glGetUniformLocation(shaderProgTris2D, "u_PositionScale");
 
     if (shaderProgTris2D_ScreenParams < 0)
     {
@@ -436,6 +697,170 @@ void RenderInterfaceDefaultGLCore::initShaders()
     {
         errorF("Unable to get uniform var 'shaderProgTris2D_ColorTexture' location!");
     }
+    if (shaderProgTris2D_PositionScale < 0)
+    {
+        errorF("Unable to get uniform var 'shaderProgTris2D_PositionScale' location!");
+    }
+
+    //
+    // Instanced text glyphs shader:
+    // Each instance is a GlyphInstance, expanded to a quad drawn as a
+    // triangle strip. Vertex IDs 0-3 are the corners, in the same order
+    // as the quads of the text triangles batch. u_GlyphSize is the size of
+    // the glyph in pixels (xy) and in texture coordinates (zw) at scale 1.
+    //
+    static const char vsGlyphs2DSource[] =
+        "\n"
+        "in vec3  in_Position;\n"
+        "in vec2  in_TexCoords;\n"
+        "in vec4  in_Color;\n"
+        "in float in_Scale;\n"
+        "uniform vec3 u_ScreenParams;\n"
+        "uniform vec4 u_GlyphSize;\n"
+        "\n"
+        "out vec2 v_TexCoords;\n"
+        "out vec4 v_Color;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    vec2 corner   = vec2(float(gl_VertexID / 2), float(gl_VertexID % 2));\n"
+        "    vec2 position = in_Position.xy + corner * (u_GlyphSize.xy * in_Scale);\n"
+        "    gl_Position.x = toNormScreenX(position.x, u_ScreenParams.x);\n"
+        "    gl_Position.y = toNormScreenY(position.y, u_ScreenParams.y);\n"
+        "    gl_Position.z = remapZ(in_Position.z, 0.0, u_ScreenParams.z, -1.0, 1.0);\n"
+        "    gl_Position.w = 1.0;\n"
+        "    v_TexCoords   = in_TexCoords + corner * u_GlyphSize.zw;\n"
+        "    v_Color       = in_Color;\n"
+        "}\n";
+
+    if (hasInstancedArrays)
+    {
+        vsGlyphs2D = glCreateShader(GL_VERTEX_SHADER);
+        const char * vsGlyphs2DStrings[] = { glslVersionStr, vsCommon, vsGlyphs2DSource };
+        glShaderSource(vsGlyphs2D, ntb::lengthOfArray(vsGlyphs2DStrings), vsGlyphs2DStrings, nullptr);
+        compileShader(&vsGlyphs2D);
+
+        shaderProgGlyphs2D = glCreateProgram();
+        glAttachShader(shaderProgGlyphs2D, vsGlyphs2D);
+        glAttachShader(shaderProgGlyphs2D, fsTris2D);
+        glBindAttribLocation(shaderProgGlyphs2D, 0, "in_Position");
+        glBindAttribLocation(shaderProgGlyphs2D, 1, "in_TexCoords");
+        glBindAttribLocation(shaderProgGlyphs2D, 2, "in_Color");
+        glBindAttribLocation(shaderProgGlyphs2D, 3, "in_Scale");
+        linkProgram(&shaderProgGlyphs2D);
+
+        shaderProgGlyphs2D_ScreenParams = glGetUniformLocation(shaderProgGlyphs2D, "u_ScreenParams");
+        shaderProgGlyphs2D_GlyphSize    = glGetUniformLocation(shaderProgGlyphs2D, "u_GlyphSize");
+        shaderProgGlyphs2D_ColorTexture = glGetUniformLocation(shaderProgGlyphs2D, "u_ColorTexture");
+
+        if (shaderProgGlyphs2D_ScreenParams < 0 || shaderProgGlyphs2D_GlyphSize < 0 || shaderProgGlyphs2D_ColorTexture < 0)
+        {
+            errorF("Unable to get uniform vars of 'shaderProgGlyphs2D'! Drawing text as triangles.");
+            hasInstancedArrays = false;
+            glyphInstances     = false;
+        }
+    }
+
+    if (!hasMultiDrawIndirect)
+    {
+        return;
+    }
+
+    //
+    // Batched clipped triangles shaders:
+    // Same as the 2D triangles, but each draw of a multi-draw has its own viewport
+    // and clip box. Replicates glViewport in the vertex shader and glScissor with
+    // a discard, so the whole batch is drawn with the full framebuffer viewport.
+    //
+    char vsClipped2DArrays[256];
+    std::snprintf(vsClipped2DArrays, sizeof(vsClipped2DArrays),
+                  "\n"
+                  "uniform vec4 u_Viewports[%i];\n"
+                  "uniform vec4 u_ClipBoxes[%i];\n",
+                  kMaxClippedDrawsPerBatch, kMaxClippedDrawsPerBatch);
+
+    static const char vsClipped2DSource[] =
+        "\n"
+        "in vec3  in_Position;\n"
+        "in vec2  in_TexCoords;\n"
+        "in vec4  in_Color;\n"
+        "in float in_DrawIndex;\n"
+        "uniform vec3 u_ScreenParams;\n"
+        "uniform vec4 u_FullViewport;\n"
+        "\n"
+        "out vec2 v_TexCoords;\n"
+        "out vec4 v_Color;\n"
+        "flat out vec4 v_ClipBox;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    int  drawIndex = int(in_DrawIndex);\n"
+        "    vec4 viewport  = u_Viewports[drawIndex];\n"
+        "    vec4 clipBox   = u_ClipBoxes[drawIndex];\n"
+        "\n"
+        "    // Window position the draw's glViewport would map it to, then back to NDC of the full viewport.\n"
+        "    vec2 ndc = vec2(toNormScreenX(in_Position.x, u_ScreenParams.x), toNormScreenY(in_Position.y, u_ScreenParams.y));\n"
+        "    vec2 win = viewport.xy + (ndc + 1.0) * 0.5 * viewport.zw;\n"
+        "    gl_Position.xy = ((win - u_FullViewport.xy) / u_FullViewport.zw) * 2.0 - 1.0;\n"
+        "    gl_Position.z  = remapZ(in_Position.z, 0.0, u_ScreenParams.z, -1.0, 1.0);\n"
+        "    gl_Position.w  = 1.0;\n"
+        "\n"
+        "    // glViewport also clips the primitives to the viewport rectangle.\n"
+        "    v_ClipBox.xy = max(clipBox.xy, viewport.xy);\n"
+        "    v_ClipBox.zw = min(clipBox.xy + clipBox.zw, viewport.xy + viewport.zw);\n"
+        "    v_TexCoords  = in_TexCoords;\n"
+        "    v_Color      = in_Color;\n"
+        "}\n";
+    static const char fsClipped2DSource[] =
+        "\n"
+        "in vec2 v_TexCoords;\n"
+        "in vec4 v_Color;\n"
+        "flat in vec4 v_ClipBox;\n"
+        "uniform sampler2D u_ColorTexture;\n"
+        "\n"
+        "out vec4 out_FragColor;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    if (any(lessThan(gl_FragCoord.xy, v_ClipBox.xy)) ||\n"
+        "        any(greaterThanEqual(gl_FragCoord.xy, v_ClipBox.zw)))\n"
+        "    {\n"
+        "        discard;\n"
+        "    }\n"
+        "    out_FragColor = v_Color * texture(u_ColorTexture, v_TexCoords);\n"
+        "}\n";
+
+    vsClipped2D = glCreateShader(GL_VERTEX_SHADER);
+    const char * vsClipped2DStrings[] = { glslVersionStr, vsCommon, vsClipped2DArrays, vsClipped2DSource };
+    glShaderSource(vsClipped2D, ntb::lengthOfArray(vsClipped2DStrings), vsClipped2DStrings, nullptr);
+    compileShader(&vsClipped2D);
+
+    fsClipped2D = glCreateShader(GL_FRAGMENT_SHADER);
+    const char * fsClipped2DStrings[] = { glslVersionStr, fsClipped2DSource };
+    glShaderSource(fsClipped2D, ntb::lengthOfArray(fsClipped2DStrings), fsClipped2DStrings, nullptr);
+    compileShader(&fsClipped2D);
+
+    shaderProgClipped2D = glCreateProgram();
+    glAttachShader(shaderProgClipped2D, vsClipped2D);
+    glAttachShader(shaderProgClipped2D, fsClipped2D);
+    glBindAttribLocation(shaderProgClipped2D, 0, "in_Position");
+    glBindAttribLocation(shaderProgClipped2D, 1, "in_TexCoords");
+    glBindAttribLocation(shaderProgClipped2D, 2, "in_Color");
+    glBindAttribLocation(shaderProgClipped2D, 3, "in_DrawIndex");
+    linkProgram(&shaderProgClipped2D);
+
+    shaderProgClipped2D_ScreenParams = glGetUniformLocation(shaderProgClipped2D, "u_ScreenParams");
+    shaderProgClipped2D_FullViewport = glGetUniformLocation(shaderProgClipped2D, "u_FullViewport");
+    shaderProgClipped2D_Viewports    = glGetUniformLocation(shaderProgClipped2D, "u_Viewports");
+    shaderProgClipped2D_ClipBoxes    = glGetUniformLocation(shaderProgClipped2D, "u_ClipBoxes");
+    shaderProgClipped2D_ColorTexture = glGetUniformLocation(shaderProgClipped2D, "u_ColorTexture");
+
+    if (shaderProgClipped2D == 0 || shaderProgClipped2D_Viewports < 0 || shaderProgClipped2D_ClipBoxes < 0)
+    {
+        errorF("Unable to set up the batched clipped draws shader! Falling back to a draw call per DrawClippedInfo.");
+        hasMultiDrawIndirect = false;
+        batchClippedDraws    = false;
+    }
 }
 
 void RenderInterfaceDefaultGLCore::compileShader(GLuint * shader)
@@ -501,7 +926,300 @@ void RenderInterfaceDefaultGLCore::initBuffers()
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vboLines2D);
     glGenBuffers(1, &vboTris2D);
+    glGenBuffers(1, &vboCompact2D);
+    glGenBuffers(1, &vboGlyphs2D);
     glGenBuffers(1, &iboTris2D);
+
+    vertexStream.target   = GL_ARRAY_BUFFER;
+    indexStream.target    = GL_ELEMENT_ARRAY_BUFFER;
+    indirectStream.target = GL_DRAW_INDIRECT_BUFFER;
+
+    GLint glMajor = 0;
+    GLint glMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &glMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &glMinor);
+    const int glVersion = (glMajor * 10) + glMinor;
+
+    // Streaming writes through GL_COPY_WRITE_BUFFER (GL 3.1) so it never disturbs
+    // the element buffer binding of whatever VAO is bound. Fences are GL 3.2.
+    hasSyncObjects   = (glVersion >= 32) || (glVersion >= 31 && hasGLExtension("GL_ARB_sync"));
+    hasBufferStorage = (glVersion >= 44) || hasGLExtension("GL_ARB_buffer_storage");
+
+    // The multi-draw gets the index of each draw from an instanced attribute with
+    // baseInstance, which avoids depending on gl_DrawID (GL 4.6) in the shader.
+    hasMultiDrawIndirect = (glVersion >= 43) ||
+                           (glVersion >= 33 && hasGLExtension("GL_ARB_multi_draw_indirect") &&
+                                               hasGLExtension("GL_ARB_base_instance"));
+    batchClippedDraws = hasMultiDrawIndirect;
+
+    // glVertexAttribDivisor and gl_VertexID are core in GL 3.3.
+    hasInstancedArrays = (glVersion >= 33);
+    glyphInstances     = hasInstancedArrays;
+
+    if (hasMultiDrawIndirect)
+    {
+        GLfloat drawIndexes[kMaxClippedDrawsPerBatch];
+        for (int i = 0; i < kMaxClippedDrawsPerBatch; ++i)
+        {
+            drawIndexes[i] = static_cast<GLfloat>(i);
+        }
+
+        glGenBuffers(1, &vboDrawIndexes);
+        glGenBuffers(1, &drawIndirectBuf);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vboDrawIndexes);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(drawIndexes), drawIndexes, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+bool RenderInterfaceDefaultGLCore::hasGLExtension(const char * const extName)
+{
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+
+    for (GLint e = 0; e < numExtensions; ++e)
+    {
+        const char * ext = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, e));
+        if (ext != nullptr && std::strcmp(ext, extName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char * RenderInterfaceDefaultGLCore::bufferStreamingToString(const BufferStreaming mode)
+{
+    switch (mode)
+    {
+    case BufferStreaming::Disabled      : return "Disabled";
+    case BufferStreaming::MapRange      : return "MapRange";
+    case BufferStreaming::PersistentMap : return "PersistentMap";
+    default                             : return "Unknown";
+    } // switch (mode)
+}
+
+void RenderInterfaceDefaultGLCore::setBufferStreaming(BufferStreaming mode)
+{
+    if (mode == BufferStreaming::PersistentMap && !isBufferStreamingSupported(mode))
+    {
+        mode = BufferStreaming::MapRange;
+    }
+    if (mode == BufferStreaming::MapRange && !isBufferStreamingSupported(mode))
+    {
+        mode = BufferStreaming::Disabled;
+    }
+
+    // Buffers still in use by the GPU are only released by GL when it is done with them.
+    freeStreamBuffers();
+    bufferStreaming = mode;
+
+    if (bufferStreaming != BufferStreaming::Disabled)
+    {
+        // Initial sizes fit a few panels. The ring grows if a frame needs more.
+        if (!initStreamBuffer(&vertexStream, 256 * 1024) ||
+            !initStreamBuffer(&indexStream,  64  * 1024) ||
+            (hasMultiDrawIndirect && !initStreamBuffer(&indirectStream, 4 * 1024)))
+        {
+            errorF("Failed to map GL stream buffers! Falling back to BufferStreaming::Disabled.");
+            setBufferStreaming(BufferStreaming::Disabled);
+        }
+    }
+}
+
+bool RenderInterfaceDefaultGLCore::initStreamBuffer(GLStreamBuffer * stream, const GLsizeiptr regionSize)
+{
+    NTB_ASSERT(bufferStreaming != BufferStreaming::Disabled);
+
+    const GLsizeiptr totalSize = regionSize * kStreamRegions;
+    if (stream->handle == 0)
+    {
+        glGenBuffers(1, &stream->handle);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, stream->handle);
+    if (bufferStreaming == BufferStreaming::PersistentMap)
+    {
+        // Immutable storage, so this is always a new buffer (see freeStreamBuffer).
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags);
+        stream->mappedPtr = static_cast<std::uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+    }
+    else
+    {
+        // Orphans the previous storage if the buffer is being resized.
+        glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+        stream->mappedPtr = nullptr;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    stream->regionSize  = regionSize;
+    stream->writeOffset = 0;
+    currUploadStats.bufferAllocs++;
+
+    return (bufferStreaming != BufferStreaming::PersistentMap || stream->mappedPtr != nullptr);
+}
+
+void RenderInterfaceDefaultGLCore::freeStreamBuffer(GLStreamBuffer * stream)
+{
+    if (stream->handle != 0)
+    {
+        // Deleting also unmaps it.
+        glDeleteBuffers(1, &stream->handle);
+    }
+
+    stream->handle      = 0;
+    stream->regionSize  = 0;
+    stream->writeOffset = 0;
+    stream->mappedPtr   = nullptr;
+}
+
+void RenderInterfaceDefaultGLCore::freeStreamBuffers()
+{
+    for (int r = 0; r < kStreamRegions; ++r)
+    {
+        if (streamFences[r] != nullptr)
+        {
+            glDeleteSync(streamFences[r]);
+            streamFences[r] = nullptr;
+        }
+    }
+
+    freeStreamBuffer(&vertexStream);
+    freeStreamBuffer(&indexStream);
+    freeStreamBuffer(&indirectStream);
+    streamRegion = 0;
+}
+
+void RenderInterfaceDefaultGLCore::waitStreamRegion()
+{
+    GLsync & fence = streamFences[streamRegion];
+    if (fence != nullptr)
+    {
+        // The region was last written kStreamRegions frames ago, so normally this doesn't block.
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            currUploadStats.fenceWaits++;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000); // 1 second
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    vertexStream.writeOffset   = 0;
+    indexStream.writeOffset    = 0;
+    indirectStream.writeOffset = 0;
+}
+
+void RenderInterfaceDefaultGLCore::fenceStreamRegion()
+{
+    NTB_ASSERT(streamFences[streamRegion] == nullptr);
+    streamFences[streamRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    streamRegion = (streamRegion + 1) % kStreamRegions;
+}
+
+GLintptr RenderInterfaceDefaultGLCore::uploadStream(GLStreamBuffer * stream, const GLuint legacyBuffer,
+                                                    const void * data, const GLsizeiptr sizeBytes)
+{
+    if (stream->target == GL_ARRAY_BUFFER)
+    {
+        currUploadStats.vertexBytes += sizeBytes;
+    }
+    else if (stream->target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        currUploadStats.indexBytes += sizeBytes;
+    }
+    else
+    {
+        currUploadStats.indirectBytes += sizeBytes;
+    }
+    currUploadStats.uploadCount++;
+
+    if (bufferStreaming != BufferStreaming::Disabled)
+    {
+        GLintptr bufferOffset = 0;
+        if (writeStream(stream, data, sizeBytes, &bufferOffset))
+        {
+            glBindBuffer(stream->target, stream->handle);
+            return bufferOffset;
+        }
+        // Else writeStream() fell back to BufferStreaming::Disabled.
+    }
+
+    glBindBuffer(stream->target, legacyBuffer);
+    glBufferData(stream->target, sizeBytes, data, GL_DYNAMIC_DRAW);
+    currUploadStats.bufferAllocs++;
+    return 0;
+}
+
+bool RenderInterfaceDefaultGLCore::reserveStream(GLStreamBuffer * stream, const GLsizeiptr sizeBytes)
+{
+    if (alignStreamOffset(stream->writeOffset) + sizeBytes > stream->regionSize)
+    {
+        // Out of room for this frame. The draws already issued keep the old storage alive,
+        // but anything uploaded and not yet drawn is lost, hence reserving for whole frames.
+        GLsizeiptr newRegionSize = stream->regionSize * 2;
+        while (newRegionSize < sizeBytes)
+        {
+            newRegionSize *= 2;
+        }
+
+        if (bufferStreaming == BufferStreaming::PersistentMap)
+        {
+            freeStreamBuffer(stream);
+        }
+
+        if (!initStreamBuffer(stream, newRegionSize))
+        {
+            errorF("Failed to map GL stream buffer! Falling back to BufferStreaming::Disabled.");
+            setBufferStreaming(BufferStreaming::Disabled);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RenderInterfaceDefaultGLCore::writeStream(GLStreamBuffer * stream, const void * data,
+                                               const GLsizeiptr sizeBytes, GLintptr * outBufferOffset)
+{
+    if (!reserveStream(stream, sizeBytes))
+    {
+        return false;
+    }
+
+    const GLsizeiptr offset = alignStreamOffset(stream->writeOffset);
+    const GLintptr bufferOffset = (stream->regionSize * streamRegion) + offset;
+    if (bufferStreaming == BufferStreaming::PersistentMap)
+    {
+        std::memcpy(stream->mappedPtr + bufferOffset, data, sizeBytes);
+    }
+    else
+    {
+        // The fences ensure the GPU is no longer reading this range, so no need to synchronize.
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, stream->handle);
+        void * mappedPtr = glMapBufferRange(GL_COPY_WRITE_BUFFER, bufferOffset, sizeBytes, flags);
+        if (mappedPtr == nullptr)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            errorF("Failed to map a GL buffer range! Falling back to BufferStreaming::Disabled.");
+
+            setBufferStreaming(BufferStreaming::Disabled);
+            return false;
+        }
+        std::memcpy(mappedPtr, data, sizeBytes);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    stream->writeOffset = offset + sizeBytes;
+    (*outBufferOffset)  = bufferOffset;
+    return true;
 }
 
 void RenderInterfaceDefaultGLCore::makeWhiteTexture()
@@ -555,6 +1273,12 @@ void RenderInterfaceDefaultGLCore::beginDraw()
     // Using a shared VAO to simplify stuff.
     glBindVertexArray(vao);
 
+    std::memset(&currUploadStats, 0, sizeof(currUploadStats));
+    if (bufferStreaming != BufferStreaming::Disabled)
+    {
+        waitStreamRegion();
+    }
+
     if (checkGLErrors)
     {
         checkGLError(__FILE__, __LINE__);
@@ -563,6 +1287,12 @@ void RenderInterfaceDefaultGLCore::beginDraw()
 
 void RenderInterfaceDefaultGLCore::endDraw()
 {
+    if (bufferStreaming != BufferStreaming::Disabled)
+    {
+        fenceStreamRegion();
+    }
+    lastUploadStats = currUploadStats;
+
     if (saveGLStates)
     {
         restoreGLStates();
@@ -574,6 +1304,22 @@ void RenderInterfaceDefaultGLCore::endDraw()
     }
 }
 
+DrawOrder RenderInterfaceDefaultGLCore::getDrawOrder() const
+{
+    // Without the depth test, the UI is layered by drawing it in order.
+    return drawWithDepth ? DrawOrder::DepthLayers : DrawOrder::Painter;
+}
+
+bool RenderInterfaceDefaultGLCore::supportsCompactVertexes() const
+{
+    return compactVerts;
+}
+
+bool RenderInterfaceDefaultGLCore::supportsGlyphInstances() const
+{
+    return glyphInstances;
+}
+
 void RenderInterfaceDefaultGLCore::getViewport(int * viewportX, int * viewportY,
                                                int * viewportW, int * viewportH) const
 {
@@ -597,7 +1343,7 @@ TextureHandle RenderInterfaceDefaultGLCore::createTexture(int widthPixels, int h
     NTB_ASSERT(colorChannels <= 4); // Up to GL_RGBA
     NTB_ASSERT(pixels != nullptr);
 
-    GLTextureRecord * newTex = implAllocT<GLTextureRecord>();
+    GLTextureRecord * newTex = implAllocT<GLTextureRecord>(MemoryTag::Renderer);
     newTex->width  = widthPixels;
     newTex->height = heightPixels;
     newTex->texId  = 0;
@@ -721,9 +1467,14 @@ void RenderInterfaceDefaultGLCore::freeAllTextures()
 
 void RenderInterfaceDefaultGLCore::freeAllShadersAndBuffes()
 {
+    freeStreamBuffers();
+    bufferStreaming = BufferStreaming::Disabled;
+
     glDeleteVertexArrays(1, &vao);
     glDeleteBuffers(1, &vboLines2D);
     glDeleteBuffers(1, &vboTris2D);
+    glDeleteBuffers(1, &vboCompact2D);
+    glDeleteBuffers(1, &vboGlyphs2D);
     glDeleteBuffers(1, &iboTris2D);
 
     glDeleteProgram(shaderProgLines2D);
@@ -734,9 +1485,20 @@ void RenderInterfaceDefaultGLCore::freeAllShadersAndBuffes()
     glDeleteShader(vsTris2D);
     glDeleteShader(fsTris2D);
 
+    glDeleteProgram(shaderProgGlyphs2D);
+    glDeleteShader(vsGlyphs2D);
+
+    glDeleteBuffers(1, &vboDrawIndexes);
+    glDeleteBuffers(1, &drawIndirectBuf);
+    glDeleteProgram(shaderProgClipped2D);
+    glDeleteShader(vsClipped2D);
+    glDeleteShader(fsClipped2D);
+
     vao               = 0;
     vboLines2D        = 0;
     vboTris2D         = 0;
+    vboCompact2D      = 0;
+    vboGlyphs2D       = 0;
     iboTris2D         = 0;
     shaderProgLines2D = 0;
     vsLines2D         = 0;
@@ -744,26 +1506,101 @@ void RenderInterfaceDefaultGLCore::freeAllShadersAndBuffes()
     shaderProgTris2D  = 0;
     vsTris2D          = 0;
     fsTris2D          = 0;
+    vboDrawIndexes    = 0;
+    drawIndirectBuf   = 0;
 
-    shaderProgLines2D_ScreenParams = -1;
+    shaderProgGlyphs2D  = 0;
+    vsGlyphs2D          = 0;
+    glyphInstances      = false;
+
+    shaderProgClipped2D = 0;
+    vsClipped2D         = 0;
+    fsClipped2D         = 0;
+    batchClippedDraws   = false;
+
+    shaderProgLines2D_ScreenParams = -1;
     shaderProgTris2D_ScreenParams  = -1;
     shaderProgTris2D_ColorTexture  = -1;
+    shaderProgTris2D_PositionScale = -1;
+
+    shaderProgGlyphs2D_ScreenParams = -1;
+    shaderProgGlyphs2D_GlyphSize    = -1;
+    shaderProgGlyphs2D_ColorTexture = -1;
+
+    shaderProgClipped2D_ScreenParams = -1;
+    shaderProgClipped2D_FullViewport = -1;
+    shaderProgClipped2D_Viewports    = -1;
+    shaderProgClipped2D_ClipBoxes    = -1;
+    shaderProgClipped2D_ColorTexture = -1;
 }
 
-void RenderInterfaceDefaultGLCore::draw2DLines(const VertexPC * verts, int vertCount, int frameMaxZ)
+void RenderInterfaceDefaultGLCore::setLines2DVertexFormat(const GLintptr vbOffset)
 {
-    NTB_ASSERT(verts != nullptr);
-    NTB_ASSERT(vertCount > 0);
+    glEnableVertexAttribArray(0); // Position
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPC), offsetPtr(vbOffset));
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboLines2D);
-    glBufferData(GL_ARRAY_BUFFER, vertCount * sizeof(VertexPC), verts, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(1); // Color
+    glVertexAttribPointer(1, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPC), offsetPtr(vbOffset + sizeof(float) * 3));
+}
 
+void RenderInterfaceDefaultGLCore::setTris2DVertexFormat(const GLintptr vbOffset)
+{
     glEnableVertexAttribArray(0); // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPC), offsetPtr(0));
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPTC), offsetPtr(vbOffset));
 
-    glEnableVertexAttribArray(1); // Color
-    glVertexAttribPointer(1, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPC), offsetPtr(sizeof(float) * 3));
+    glEnableVertexAttribArray(1); // Texture coordinate
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(VertexPTC), offsetPtr(vbOffset + sizeof(float) * 3));
+
+    glEnableVertexAttribArray(2); // Color
+    glVertexAttribPointer(2, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPTC), offsetPtr(vbOffset + sizeof(float) * 5));
+}
+
+void RenderInterfaceDefaultGLCore::setTris2DCompactVertexFormat(const GLintptr vbOffset)
+{
+    // Positions stay integers, scaled back to pixels by setTris2DPositionScale().
+    glEnableVertexAttribArray(0); // Position
+    glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(VertexPTCCompact), offsetPtr(vbOffset));
+
+    glEnableVertexAttribArray(1); // Texture coordinate
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(VertexPTCCompact), offsetPtr(vbOffset + sizeof(std::int16_t) * 3));
+
+    glEnableVertexAttribArray(2); // Color
+    glVertexAttribPointer(2, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPTCCompact), offsetPtr(vbOffset + sizeof(std::int16_t) * 6));
+}
+
+void RenderInterfaceDefaultGLCore::setGlyphs2DVertexFormat(const GLintptr vbOffset)
+{
+    // One GlyphInstance per quad, so every attribute advances per instance.
+    glEnableVertexAttribArray(0); // Position
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), offsetPtr(vbOffset));
+
+    glEnableVertexAttribArray(3); // Scale
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), offsetPtr(vbOffset + sizeof(float) * 3));
+
+    glEnableVertexAttribArray(1); // Texture coordinate
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(GlyphInstance), offsetPtr(vbOffset + sizeof(float) * 4));
+
+    glEnableVertexAttribArray(2); // Color
+    glVertexAttribPointer(2, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), offsetPtr(vbOffset + sizeof(float) * 5));
 
+    for (GLuint attrib = 0; attrib < 4; ++attrib)
+    {
+        glVertexAttribDivisor(attrib, 1);
+    }
+}
+
+void RenderInterfaceDefaultGLCore::resetGlyphs2DVertexFormat()
+{
+    // Back to the per-vertex attributes the other formats expect.
+    for (GLuint attrib = 0; attrib < 4; ++attrib)
+    {
+        glVertexAttribDivisor(attrib, 0);
+    }
+    glDisableVertexAttribArray(3);
+}
+
+void RenderInterfaceDefaultGLCore::setLines2DProgram(const int frameMaxZ)
+{
     // Set shader:
     glUseProgram(shaderProgLines2D);
 
@@ -772,46 +1609,61 @@ void RenderInterfaceDefaultGLCore::draw2DLines(const VertexPC * verts, int vertC
                 static_cast<GLfloat>(glStates.viewport[2] - glStates.viewport[0]),
                 static_cast<GLfloat>(glStates.viewport[3] - glStates.viewport[1]),
                 static_cast<GLfloat>(frameMaxZ));
+}
 
-    // Draw call:
-    glDrawArrays(GL_LINES, 0, vertCount);
+void RenderInterfaceDefaultGLCore::setTris2DProgram(const int frameMaxZ)
+{
+    // Set shader:
+    glUseProgram(shaderProgTris2D);
 
-    if (checkGLErrors)
-    {
-        checkGLError(__FILE__, __LINE__);
-    }
+    // Set uniform vec3 u_ScreenParams:
+    glUniform3f(shaderProgTris2D_ScreenParams,
+                static_cast<GLfloat>(glStates.viewport[2] - glStates.viewport[0]),
+                static_cast<GLfloat>(glStates.viewport[3] - glStates.viewport[1]),
+                static_cast<GLfloat>(frameMaxZ));
+
+    // Set texture to TMU 0:
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(shaderProgTris2D_ColorTexture, 0);
+
+    setTris2DPositionScale(false);
 }
 
-void RenderInterfaceDefaultGLCore::draw2DTriangles(const VertexPTC * verts, int vertCount,
-                                                   const std::uint16_t * indexes, int indexCount,
-                                                   TextureHandle texture, int frameMaxZ)
+void RenderInterfaceDefaultGLCore::setGlyphs2DProgram(const PackedFrame & frame)
 {
-    NTB_ASSERT(verts   != nullptr);
-    NTB_ASSERT(indexes != nullptr);
-    NTB_ASSERT(vertCount  > 0);
-    NTB_ASSERT(indexCount > 0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vboTris2D);
-    glBufferData(GL_ARRAY_BUFFER, vertCount * sizeof(VertexPTC), verts, GL_DYNAMIC_DRAW);
+    // Set shader:
+    glUseProgram(shaderProgGlyphs2D);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboTris2D);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(std::uint16_t), indexes, GL_DYNAMIC_DRAW);
+    // Set uniform vec3 u_ScreenParams:
+    glUniform3f(shaderProgGlyphs2D_ScreenParams,
+                static_cast<GLfloat>(glStates.viewport[2] - glStates.viewport[0]),
+                static_cast<GLfloat>(glStates.viewport[3] - glStates.viewport[1]),
+                static_cast<GLfloat>(frame.frameMaxZ));
 
-    glEnableVertexAttribArray(0); // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPTC), offsetPtr(0));
+    // Set uniform vec4 u_GlyphSize:
+    glUniform4f(shaderProgGlyphs2D_GlyphSize, frame.glyphWidth, frame.glyphHeight,
+                frame.glyphUVWidth, frame.glyphUVHeight);
 
-    glEnableVertexAttribArray(1); // Texture coordinate
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(VertexPTC), offsetPtr(sizeof(float) * 3));
+    // Set texture to TMU 0:
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(shaderProgGlyphs2D_ColorTexture, 0);
+}
 
-    glEnableVertexAttribArray(2); // Color
-    glVertexAttribPointer(2, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPTC), offsetPtr(sizeof(float) * 5));
+void RenderInterfaceDefaultGLCore::setTris2DPositionScale(const bool compact)
+{
+    // Set uniform vec3 u_PositionScale (the tris program must be current):
+    const GLfloat xyScale = compact ? (1.0f / kCompactVertexSubpixels) : 1.0f;
+    glUniform3f(shaderProgTris2D_PositionScale, xyScale, xyScale, 1.0f);
+}
 
+void RenderInterfaceDefaultGLCore::bindTris2DTexture(TextureHandle texture, GLuint * currentTexId)
+{
     // Texture is optional.
     // If not set, use a default white texture so we can share the same shader program.
-    glActiveTexture(GL_TEXTURE0);
+    GLuint texId;
     if (texture != nullptr)
     {
-        glBindTexture(GL_TEXTURE_2D, reinterpret_cast<const GLTextureRecord *>(texture)->texId);
+        texId = reinterpret_cast<const GLTextureRecord *>(texture)->texId;
     }
     else
     {
@@ -820,23 +1672,182 @@ void RenderInterfaceDefaultGLCore::draw2DTriangles(const VertexPTC * verts, int
             makeWhiteTexture();
             NTB_ASSERT(whiteTexture != nullptr);
         }
-        glBindTexture(GL_TEXTURE_2D, whiteTexture->texId);
+        texId = whiteTexture->texId;
     }
 
-    // Set shader:
-    glUseProgram(shaderProgTris2D);
+    if (texId != (*currentTexId))
+    {
+        glBindTexture(GL_TEXTURE_2D, texId);
+        (*currentTexId) = texId;
+    }
+}
 
-    // Set uniform vec3 u_ScreenParams:
-    glUniform3f(shaderProgTris2D_ScreenParams,
+void RenderInterfaceDefaultGLCore::drawClippedRanges(const DrawClippedInfo * drawInfo, const int drawInfoCount,
+                                                     const GLintptr ibOffset, const int frameMaxZ, GLuint * currentTexId)
+{
+    if (batchClippedDraws)
+    {
+        drawClippedRangesBatched(drawInfo, drawInfoCount, ibOffset, frameMaxZ, currentTexId);
+        return;
+    }
+
+    glEnable(GL_SCISSOR_TEST);
+
+    for (int i = 0; i < drawInfoCount; ++i)
+    {
+        int viewportX = drawInfo[i].viewportX;
+        int viewportY = drawInfo[i].viewportY;
+        int viewportW = drawInfo[i].viewportW;
+        int viewportH = drawInfo[i].viewportH;
+
+        int clipX = drawInfo[i].clipBoxX;
+        int clipY = drawInfo[i].clipBoxY;
+        int clipW = drawInfo[i].clipBoxW;
+        int clipH = drawInfo[i].clipBoxH;
+
+        // Invert Y for OpenGL. In GL the origin of the
+        // window/framebuffer is the bottom left corner,
+        // and so is the origin of the viewport/scissor-box
+        // (that's why the `- viewportH` part is also needed).
+        const int framebufferH = glStates.viewport[3] - glStates.viewport[1];
+        viewportY = framebufferH - viewportY - viewportH;
+        clipY = framebufferH - clipY - clipH;
+
+        glViewport(viewportX, viewportY, viewportW, viewportH);
+        glScissor(clipX, clipY, clipW, clipH);
+
+        bindTris2DTexture(drawInfo[i].texture, currentTexId);
+
+        // Issue the draw call:
+        glDrawElements(GL_TRIANGLES, drawInfo[i].indexCount, GL_UNSIGNED_SHORT,
+                       offsetPtr(ibOffset + drawInfo[i].firstIndex * sizeof(std::uint16_t)));
+        currUploadStats.drawCalls++;
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(glStates.viewport[0], glStates.viewport[1],
+               glStates.viewport[2], glStates.viewport[3]);
+}
+
+void RenderInterfaceDefaultGLCore::drawClippedRangesBatched(const DrawClippedInfo * drawInfo, const int drawInfoCount,
+                                                            const GLintptr ibOffset, const int frameMaxZ, GLuint * currentTexId)
+{
+    glUseProgram(shaderProgClipped2D);
+    glUniform3f(shaderProgClipped2D_ScreenParams,
                 static_cast<GLfloat>(glStates.viewport[2] - glStates.viewport[0]),
                 static_cast<GLfloat>(glStates.viewport[3] - glStates.viewport[1]),
                 static_cast<GLfloat>(frameMaxZ));
+    glUniform4f(shaderProgClipped2D_FullViewport,
+                static_cast<GLfloat>(glStates.viewport[0]), static_cast<GLfloat>(glStates.viewport[1]),
+                static_cast<GLfloat>(glStates.viewport[2]), static_cast<GLfloat>(glStates.viewport[3]));
+    glUniform1i(shaderProgClipped2D_ColorTexture, 0);
+
+    // The draw index of each command reaches the shaders through baseInstance.
+    GLint oldArrayBuffer = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &oldArrayBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vboDrawIndexes);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), offsetPtr(0));
+    glVertexAttribDivisor(3, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, oldArrayBuffer);
+
+    const int framebufferH = glStates.viewport[3] - glStates.viewport[1];
+    const GLuint ibFirstIndex = static_cast<GLuint>(ibOffset / sizeof(std::uint16_t));
+
+    GLfloat viewports[kMaxClippedDrawsPerBatch * 4];
+    GLfloat clipBoxes[kMaxClippedDrawsPerBatch * 4];
+    DrawElementsIndirectCommand commands[kMaxClippedDrawsPerBatch];
+
+    // One multi-draw per run of DrawClippedInfos with the same texture.
+    for (int first = 0; first < drawInfoCount;)
+    {
+        const TextureHandle texture = drawInfo[first].texture;
 
-    // Set texture to TMU 0:
-    glUniform1i(shaderProgTris2D_ColorTexture, 0);
+        int count = 0;
+        for (; count < kMaxClippedDrawsPerBatch && (first + count) < drawInfoCount; ++count)
+        {
+            const DrawClippedInfo & info = drawInfo[first + count];
+            if (info.texture != texture)
+            {
+                break;
+            }
+
+            // Invert Y for OpenGL, same as the unbatched path.
+            viewports[count * 4 + 0] = static_cast<GLfloat>(info.viewportX);
+            viewports[count * 4 + 1] = static_cast<GLfloat>(framebufferH - info.viewportY - info.viewportH);
+            viewports[count * 4 + 2] = static_cast<GLfloat>(info.viewportW);
+            viewports[count * 4 + 3] = static_cast<GLfloat>(info.viewportH);
+
+            clipBoxes[count * 4 + 0] = static_cast<GLfloat>(info.clipBoxX);
+            clipBoxes[count * 4 + 1] = static_cast<GLfloat>(framebufferH - info.clipBoxY - info.clipBoxH);
+            clipBoxes[count * 4 + 2] = static_cast<GLfloat>(info.clipBoxW);
+            clipBoxes[count * 4 + 3] = static_cast<GLfloat>(info.clipBoxH);
+
+            commands[count].count         = static_cast<GLuint>(info.indexCount);
+            commands[count].instanceCount = 1;
+            commands[count].firstIndex    = ibFirstIndex + static_cast<GLuint>(info.firstIndex);
+            commands[count].baseVertex    = 0; // Already applied by the attribute offsets.
+            commands[count].baseInstance  = static_cast<GLuint>(count);
+        }
+
+        glUniform4fv(shaderProgClipped2D_Viewports, count, viewports);
+        glUniform4fv(shaderProgClipped2D_ClipBoxes, count, clipBoxes);
+        bindTris2DTexture(texture, currentTexId);
+
+        const GLintptr cmdOffset = uploadStream(&indirectStream, drawIndirectBuf, commands,
+                                                count * sizeof(DrawElementsIndirectCommand));
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, offsetPtr(cmdOffset), count, 0);
+        currUploadStats.drawCalls++;
+
+        first += count;
+    }
+
+    glVertexAttribDivisor(3, 0);
+    glDisableVertexAttribArray(3);
+}
+
+void RenderInterfaceDefaultGLCore::draw2DLines(const VertexPC * verts, int vertCount, int frameMaxZ)
+{
+    NTB_ASSERT(verts != nullptr);
+    NTB_ASSERT(vertCount > 0);
+
+    const GLintptr vbOffset = uploadStream(&vertexStream, vboLines2D, verts, vertCount * sizeof(VertexPC));
+    setLines2DVertexFormat(vbOffset);
+    setLines2DProgram(frameMaxZ);
 
     // Draw call:
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, nullptr);
+    glDrawArrays(GL_LINES, 0, vertCount);
+    currUploadStats.drawCalls++;
+
+    if (checkGLErrors)
+    {
+        checkGLError(__FILE__, __LINE__);
+    }
+}
+
+void RenderInterfaceDefaultGLCore::draw2DTriangles(const VertexPTC * verts, int vertCount,
+                                                   const std::uint16_t * indexes, int indexCount,
+                                                   TextureHandle texture, int frameMaxZ)
+{
+    NTB_ASSERT(verts   != nullptr);
+    NTB_ASSERT(indexes != nullptr);
+    NTB_ASSERT(vertCount  > 0);
+    NTB_ASSERT(indexCount > 0);
+
+    // Indexes are relative to the first vertex of the batch, so the vertex
+    // offset goes into the attribute pointers and the index offset into the draw.
+    const GLintptr vbOffset = uploadStream(&vertexStream, vboTris2D, verts, vertCount * sizeof(VertexPTC));
+    const GLintptr ibOffset = uploadStream(&indexStream, iboTris2D, indexes, indexCount * sizeof(std::uint16_t));
+
+    setTris2DVertexFormat(vbOffset);
+    setTris2DProgram(frameMaxZ);
+
+    GLuint currentTexId = 0;
+    bindTris2DTexture(texture, &currentTexId);
+
+    // Draw call:
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, offsetPtr(ibOffset));
+    currUploadStats.drawCalls++;
 
     if (checkGLErrors)
     {
@@ -857,90 +1868,149 @@ void RenderInterfaceDefaultGLCore::drawClipped2DTriangles(const VertexPTC * vert
     NTB_ASSERT(indexCount    > 0);
     NTB_ASSERT(drawInfoCount > 0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboTris2D);
-    glBufferData(GL_ARRAY_BUFFER, vertCount * sizeof(VertexPTC), verts, GL_DYNAMIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboTris2D);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(std::uint16_t), indexes, GL_DYNAMIC_DRAW);
-
-    glEnableVertexAttribArray(0); // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPTC), offsetPtr(0));
-
-    glEnableVertexAttribArray(1); // Texture coordinate
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(VertexPTC), offsetPtr(sizeof(float) * 3));
+    const GLintptr vbOffset = uploadStream(&vertexStream, vboTris2D, verts, vertCount * sizeof(VertexPTC));
+    const GLintptr ibOffset = uploadStream(&indexStream, iboTris2D, indexes, indexCount * sizeof(std::uint16_t));
 
-    glEnableVertexAttribArray(2); // Color
-    glVertexAttribPointer(2, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPTC), offsetPtr(sizeof(float) * 5));
+    setTris2DVertexFormat(vbOffset);
+    setTris2DProgram(frameMaxZ);
 
-    glActiveTexture(GL_TEXTURE0);
-    glEnable(GL_SCISSOR_TEST);
+    GLuint currentTexId = 0;
+    drawClippedRanges(drawInfo, drawInfoCount, ibOffset, frameMaxZ, &currentTexId);
 
-    // Set shader:
-    glUseProgram(shaderProgTris2D);
+    if (checkGLErrors)
+    {
+        checkGLError(__FILE__, __LINE__);
+    }
+}
 
-    // Set uniform vec3 u_ScreenParams:
-    glUniform3f(shaderProgTris2D_ScreenParams,
-                static_cast<GLfloat>(glStates.viewport[2] - glStates.viewport[0]),
-                static_cast<GLfloat>(glStates.viewport[3] - glStates.viewport[1]),
-                static_cast<GLfloat>(frameMaxZ));
+void RenderInterfaceDefaultGLCore::drawPackedFrame(const PackedFrame & frame)
+{
+    const bool hasCompactVerts    = (frame.compactVerts != nullptr);
+    const GLsizeiptr vertBytes    = frame.vertCount     * sizeof(VertexPTC);
+    const GLsizeiptr compactBytes = hasCompactVerts ? frame.compactVertCount * sizeof(VertexPTCCompact) : 0;
+    const GLsizeiptr indexBytes   = frame.indexCount    * sizeof(std::uint16_t);
+    const GLsizeiptr lineBytes    = frame.lineVertCount * sizeof(VertexPC);
+    const GLsizeiptr glyphBytes   = frame.glyphCount    * sizeof(GlyphInstance);
+
+    // Everything is uploaded before the first draw, so the ring must not grow midway.
+    // Room for aligning the start of each upload after the first.
+    if (bufferStreaming != BufferStreaming::Disabled)
+    {
+        reserveStream(&vertexStream, vertBytes + compactBytes + lineBytes + glyphBytes + 48);
+    }
 
-    // Set texture to TMU 0 (if any):
-    glUniform1i(shaderProgTris2D_ColorTexture, 0);
+    // One upload per stream for the whole frame, then only
+    // attribute offsets and textures change between commands.
+    GLintptr vbOffset      = 0;
+    GLintptr compactOffset = 0;
+    GLintptr ibOffset      = 0;
+    GLintptr linesOffset   = 0;
+    GLintptr glyphsOffset  = 0;
+    GLuint   trisVbo       = vboTris2D;
+    GLuint   compactVbo    = vboCompact2D;
+    GLuint   linesVbo      = vboLines2D;
+    GLuint   glyphsVbo     = vboGlyphs2D;
+
+    if (frame.indexCount > 0)
+    {
+        if (frame.vertCount > 0)
+        {
+            vbOffset = uploadStream(&vertexStream, vboTris2D, frame.verts, vertBytes);
+            trisVbo  = (bufferStreaming != BufferStreaming::Disabled) ? vertexStream.handle : vboTris2D;
+        }
+        if (compactBytes > 0)
+        {
+            compactOffset = uploadStream(&vertexStream, vboCompact2D, frame.compactVerts, compactBytes);
+            compactVbo    = (bufferStreaming != BufferStreaming::Disabled) ? vertexStream.handle : vboCompact2D;
+        }
+        ibOffset = uploadStream(&indexStream, iboTris2D, frame.indexes, indexBytes);
+    }
+    if (frame.lineVertCount > 0)
+    {
+        linesOffset = uploadStream(&vertexStream, vboLines2D, frame.lineVerts, lineBytes);
+        linesVbo    = (bufferStreaming != BufferStreaming::Disabled) ? vertexStream.handle : vboLines2D;
+    }
+    if (glyphBytes > 0)
+    {
+        glyphsOffset = uploadStream(&vertexStream, vboGlyphs2D, frame.glyphs, glyphBytes);
+        glyphsVbo    = (bufferStreaming != BufferStreaming::Disabled) ? vertexStream.handle : vboGlyphs2D;
+    }
 
     GLuint currentTexId = 0;
-    for (int i = 0; i < drawInfoCount; ++i)
+    bool trisProgramSet = false;
+    bool compactScale   = false; // Position scale of the tris program.
+
+    for (int c = 0; c < frame.commandCount; ++c)
     {
-        int viewportX = drawInfo[i].viewportX;
-        int viewportY = drawInfo[i].viewportY;
-        int viewportW = drawInfo[i].viewportW;
-        int viewportH = drawInfo[i].viewportH;
+        const DrawCommand & cmd = frame.commands[c];
 
-        int clipX = drawInfo[i].clipBoxX;
-        int clipY = drawInfo[i].clipBoxY;
-        int clipW = drawInfo[i].clipBoxW;
-        int clipH = drawInfo[i].clipBoxH;
+        if (cmd.type == DrawCommandType::Lines)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, linesVbo);
+            setLines2DVertexFormat(linesOffset + cmd.firstVertex * sizeof(VertexPC));
+            setLines2DProgram(frame.frameMaxZ);
+            glDrawArrays(GL_LINES, 0, cmd.vertexCount);
+            currUploadStats.drawCalls++;
+            trisProgramSet = false;
+            continue;
+        }
 
-        // Invert Y for OpenGL. In GL the origin of the
-        // window/framebuffer is the bottom left corner,
-        // and so is the origin of the viewport/scissor-box
-        // (that's why the `- viewportH` part is also needed).
-        const int framebufferH = glStates.viewport[3] - glStates.viewport[1];
-        viewportY = framebufferH - viewportY - viewportH;
-        clipY = framebufferH - clipY - clipH;
+        if (cmd.type == DrawCommandType::Glyphs)
+        {
+            // Instances start at the attribute offsets, like the vertexes of the other commands.
+            glBindBuffer(GL_ARRAY_BUFFER, glyphsVbo);
+            setGlyphs2DVertexFormat(glyphsOffset + cmd.firstVertex * sizeof(GlyphInstance));
+            setGlyphs2DProgram(frame);
+            bindTris2DTexture(cmd.texture, &currentTexId);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, cmd.vertexCount);
+            resetGlyphs2DVertexFormat();
+            currUploadStats.drawCalls++;
+            trisProgramSet = false;
+            continue;
+        }
 
-        glViewport(viewportX, viewportY, viewportW, viewportH);
-        glScissor(clipX, clipY, clipW, clipH);
+        if (!trisProgramSet)
+        {
+            setTris2DProgram(frame.frameMaxZ);
+            trisProgramSet = true;
+            compactScale   = false;
+        }
 
-        const GLTextureRecord * texGl = reinterpret_cast<const GLTextureRecord *>(drawInfo[i].texture);
-        if (texGl != nullptr && texGl->texId != currentTexId)
+        // Only the unclipped triangles come in the compact format.
+        const bool compactCmd = (hasCompactVerts && cmd.type == DrawCommandType::Triangles);
+        if (compactCmd != compactScale)
         {
-            currentTexId = texGl->texId;
-            glBindTexture(GL_TEXTURE_2D, currentTexId);
+            setTris2DPositionScale(compactCmd);
+            compactScale = compactCmd;
+        }
+
+        // Indexes are relative to the command's first vertex.
+        if (compactCmd)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, compactVbo);
+            setTris2DCompactVertexFormat(compactOffset + cmd.firstVertex * sizeof(VertexPTCCompact));
         }
         else
         {
-            if (whiteTexture == nullptr)
-            {
-                makeWhiteTexture();
-                NTB_ASSERT(whiteTexture != nullptr);
-            }
-
-            if (whiteTexture->texId != currentTexId)
-            {
-                currentTexId = whiteTexture->texId;
-                glBindTexture(GL_TEXTURE_2D, currentTexId);
-            }
+            glBindBuffer(GL_ARRAY_BUFFER, trisVbo);
+            setTris2DVertexFormat(vbOffset + cmd.firstVertex * sizeof(VertexPTC));
         }
+        const GLintptr cmdIbOffset = ibOffset + cmd.firstIndex * sizeof(std::uint16_t);
 
-        // Issue the draw call:
-        glDrawElements(GL_TRIANGLES, drawInfo[i].indexCount, GL_UNSIGNED_SHORT,
-                       offsetPtr(drawInfo[i].firstIndex * sizeof(std::uint16_t)));
+        if (cmd.type == DrawCommandType::ClippedTriangles)
+        {
+            drawClippedRanges(frame.drawInfos + cmd.firstDrawInfo, cmd.drawInfoCount, cmdIbOffset,
+                              frame.frameMaxZ, &currentTexId);
+            trisProgramSet = !batchClippedDraws; // The batched path uses its own shader.
+        }
+        else
+        {
+            bindTris2DTexture(cmd.texture, &currentTexId);
+            glDrawElements(GL_TRIANGLES, cmd.indexCount, GL_UNSIGNED_SHORT, offsetPtr(cmdIbOffset));
+            currUploadStats.drawCalls++;
+        }
     }
 
-    glDisable(GL_SCISSOR_TEST);
-    glViewport(glStates.viewport[0], glStates.viewport[1],
-               glStates.viewport[2], glStates.viewport[3]);
-
     if (checkGLErrors)
     {
         checkGLError(__FILE__, __LINE__);
@@ -990,6 +2060,11 @@ void RenderInterfaceDefaultGLCore::recordGLStates()
     glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &glStates.vbo);
     glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &glStates.ibo);
 
+    if (hasMultiDrawIndirect)
+    {
+        glGetIntegerv(GL_DRAW_INDIRECT_BUFFER_BINDING, &glStates.drawIndirectBuffer);
+    }
+
     // Viewport will be recorded every frame, regardless of saveGLStates.
 }
 
@@ -1029,6 +2104,10 @@ void RenderInterfaceDefaultGLCore::restoreGLStates() const
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glStates.ibo);
     }
+    if (hasMultiDrawIndirect)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, glStates.drawIndirectBuffer);
+    }
     if (glStates.shaderProg != 0)
     {
         glUseProgram(glStates.shaderProg);
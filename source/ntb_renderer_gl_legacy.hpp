@@ -44,6 +44,7 @@ public:
     bool isSavingGLStates() const;
     void setSaveGLStates(bool doSave);
 
+    // Drawing without the depth test makes the GUIs generate their frames in DrawOrder::Painter.
     bool isDrawingWithDepthTest() const;
     void setDrawWithDepthTest(bool doDepthTest);
 
@@ -61,6 +62,7 @@ public:
 
     void beginDraw() override;
     void endDraw()   override;
+    DrawOrder getDrawOrder() const override;
 
     void getViewport(int * viewportX, int * viewportY,
                      int * viewportW, int * viewportH) const override;
@@ -262,6 +264,12 @@ void RenderInterfaceDefaultGLLegacy::endDraw()
     }
 }
 
+DrawOrder RenderInterfaceDefaultGLLegacy::getDrawOrder() const
+{
+    // Without the depth test, the UI is layered by drawing it in order.
+    return drawWithDepth ? DrawOrder::DepthLayers : DrawOrder::Painter;
+}
+
 void RenderInterfaceDefaultGLLegacy::getViewport(int * viewportX, int * viewportY,
                                                  int * viewportW, int * viewportH) const
 {
@@ -285,7 +293,7 @@ TextureHandle RenderInterfaceDefaultGLLegacy::createTexture(int widthPixels, int
     NTB_ASSERT(colorChannels <= 4); // Up to GL_RGBA
     NTB_ASSERT(pixels != nullptr);
 
-    GLTextureRecord * newTex = implAllocT<GLTextureRecord>();
+    GLTextureRecord * newTex = implAllocT<GLTextureRecord>(MemoryTag::Renderer);
     newTex->width  = widthPixels;
     newTex->height = heightPixels;
     newTex->texId  = 0;
@@ -408,7 +416,7 @@ void * RenderInterfaceDefaultGLLegacy::grayscaleToRgba(int widthPixels, int heig
         std::uint8_t r, g, b, a;
     };
 
-    Rgba * expanded = implAllocT<Rgba>(widthPixels * heightPixels);
+    Rgba * expanded = implAllocT<Rgba>(MemoryTag::Renderer, widthPixels * heightPixels);
     const auto p = static_cast<const std::uint8_t *>(pixels);
 
     // Expand graymap the RGBA:
@@ -0,0 +1,1335 @@
+#pragma once
+// ================================================================================================
+// -*- C++ -*-
+// File: ntb_renderer_recording.hpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  Recording RenderInterface decorator for NTB. RenderInterfaceRecorder forwards every call to
+//  a target RenderInterface and serializes the calls into a compact binary command stream, which
+//  can be written to a file. RenderStreamReplayer later feeds a stream into any RenderInterface
+//  at full speed and reports the throughput, so renderer backends can be profiled offline with
+//  exactly what NTB submitted.
+//
+//  Vertexes, indexes and draw infos are delta-encoded as variable length integers, and a frame
+//  identical to the previous one is stored as a single byte. The stream is read in place, so a
+//  file can be memory-mapped (see RenderStreamFile) and replayed without loading or parsing it
+//  up front. Texture pixels are stored uncompressed and passed straight from the stream to
+//  createTexture().
+//
+//  This header file is optional and won't be compiled into the library if you don't include it.
+//  #define NTB_DEFAULT_RENDERER_RECORDING before including the file in a .cpp to enable the
+//  implementation.
+// ================================================================================================
+
+#include "ntb.hpp"
+#include "ntb_utils.hpp"
+
+#include <cstdio>
+
+namespace ntb
+{
+
+// ========================================================
+// Render stream format:
+// ========================================================
+
+// File starts with the header, then a sequence of commands up to the end of the file.
+// Each command is an op byte followed by its payload. All multibyte integers are unsigned
+// LEB128 varints, signed ones zigzag encoded first.
+struct RenderStreamHeader
+{
+    char          magic[4];   // "NTBR"
+    std::uint32_t version;    // RenderStreamHeader::kVersion
+    std::uint32_t headerSize; // sizeof(RenderStreamHeader), commands follow.
+    std::uint32_t reserved;
+
+    static const std::uint32_t kVersion = 2;
+};
+
+enum class RenderStreamOp : std::uint8_t
+{
+    BeginDraw = 1,     // No payload.
+    EndDraw,           // No payload.
+    CreateTexture,     // id, width, height, channels, raw pixels.
+    DestroyTexture,    // id
+    PackedFrame,       // payload size, counts, draw order, then the delta-encoded arrays.
+    RepeatPackedFrame  // No payload. Same as the last PackedFrame.
+};
+
+// ========================================================
+// class RenderInterfaceRecorder:
+// ========================================================
+
+class RenderInterfaceRecorder final
+    : public RenderInterface
+{
+public:
+
+    // The target receives all calls after they are recorded. It may be null,
+    // in which case the recorder behaves like the default null renderer.
+    explicit RenderInterfaceRecorder(RenderInterface * target);
+    virtual ~RenderInterfaceRecorder();
+
+    // Not copyable.
+    RenderInterfaceRecorder(const RenderInterfaceRecorder &) = delete;
+    RenderInterfaceRecorder & operator = (const RenderInterfaceRecorder &) = delete;
+
+    // -- Local queries and helpers --
+
+    // Start writing the stream to a file. The stream is flushed to it at every endDraw().
+    // Anything recorded before is discarded. Textures already created are not in the new
+    // stream, so open the file before the first frame is drawn.
+    bool openFile(const char * filename);
+    void closeFile();
+    bool isWritingFile() const;
+
+    // Stream bytes held in memory. With a file open, these are the bytes not yet flushed;
+    // otherwise the whole stream recorded so far, header included.
+    const std::uint8_t * getStreamData() const;
+    int getStreamSize() const;
+
+    RenderInterface * getTarget() const;
+    int getFrameCount() const;                    // Packed frames recorded.
+    int getRepeatedFrameCount() const;            // Of which were identical to the previous.
+    std::int64_t getStreamBytesRecorded() const;  // Encoded size, header included.
+    std::int64_t getRawBytesSubmitted() const;    // Size of the arrays NTB submitted.
+
+    //
+    // ntb::RenderInterface overrides:
+    //
+
+    // -- Miscellaneous --
+
+    void beginDraw() override;
+    void endDraw()   override;
+    int getMaxZ() const override;
+    DrawOrder getDrawOrder() const override;
+
+    void getViewport(int * viewportX, int * viewportY,
+                     int * viewportW, int * viewportH) const override;
+
+    // -- Texture allocation --
+
+    TextureHandle createTexture(int widthPixels, int heightPixels,
+                                int colorChannels, const void * pixels) override;
+
+    void destroyTexture(TextureHandle texture) override;
+
+    // -- Drawing commands --
+
+    // Direct calls are recorded as single command packed frames.
+    void draw2DLines(const VertexPC * verts, int vertCount, int frameMaxZ) override;
+
+    void draw2DTriangles(const VertexPTC * verts, int vertCount,
+                         const std::uint16_t * indexes, int indexCount,
+                         TextureHandle texture, int frameMaxZ) override;
+
+    void drawClipped2DTriangles(const VertexPTC * verts, int vertCount,
+                                const std::uint16_t * indexes, int indexCount,
+                                const DrawClippedInfo * drawInfo,
+                                int drawInfoCount, int frameMaxZ) override;
+
+    void drawPackedFrame(const PackedFrame & frame) override;
+
+private:
+
+    struct TextureId
+    {
+        TextureHandle handle;
+        std::uint32_t id;
+    };
+
+    void recordPackedFrame(const PackedFrame & frame);
+    void encodePackedFrame(const PackedFrame & frame, PODArray & out) const;
+    std::uint32_t findTextureId(TextureHandle texture) const;
+
+    void writeHeader();
+    void flushToFile();
+
+    RenderInterface * target;
+    std::FILE       * file;
+
+    PODArray stream;          // [std::uint8_t]
+    PODArray framePayload;    // [std::uint8_t] Scratch for the frame being encoded.
+    PODArray lastPayload;     // [std::uint8_t] Previous frame, for the repeat check.
+    PODArray textureIds;      // [TextureId]
+    std::uint32_t nextTextureId;
+
+    int          frameCount;
+    int          repeatedFrameCount;
+    std::int64_t streamBytesFlushed;
+    std::int64_t rawBytesSubmitted;
+};
+
+// ========================================================
+// class RenderStreamReplayer:
+// ========================================================
+
+struct RenderReplayStats
+{
+    int          frames;         // PackedFrames submitted, repeats included.
+    int          repeatedFrames;
+    int          drawCommands;
+    int          texturesCreated;
+    std::int64_t vertexes;       // Triangle and line vertexes submitted.
+    std::int64_t indexes;
+    std::int64_t streamBytes;    // Stream bytes decoded.
+    double       milliseconds;   // Wall time of the whole replay.
+
+    double getFramesPerSecond() const;
+    double getMegabytesPerSecond() const;
+};
+
+class RenderStreamReplayer final
+{
+public:
+
+    RenderStreamReplayer();
+    ~RenderStreamReplayer();
+
+    // Not copyable.
+    RenderStreamReplayer(const RenderStreamReplayer &) = delete;
+    RenderStreamReplayer & operator = (const RenderStreamReplayer &) = delete;
+
+    // Submits every command of the stream to the target as fast as possible. The data is read
+    // in place and must stay valid during the call. Textures the stream didn't destroy are
+    // destroyed at the end. Returns false if the stream is malformed; commands up to the error
+    // are still replayed. Decoding scratch memory is kept for the next replay.
+    bool replay(const void * streamData, std::int64_t streamSize,
+                RenderInterface & target, RenderReplayStats * outStats = nullptr);
+
+private:
+
+    PODArray verts;      // [VertexPTC]
+    PODArray indexes;    // [std::uint16_t]
+    PODArray lineVerts;  // [VertexPC]
+    PODArray drawInfos;  // [DrawClippedInfo]
+    PODArray commands;   // [DrawCommand]
+    PODArray textures;   // [TextureHandle] Indexed by stream texture id.
+};
+
+// ========================================================
+// class RenderStreamFile:
+// ========================================================
+
+// Read-only view of a recorded stream file. Memory-mapped where
+// supported, otherwise loaded in full into a heap buffer.
+class RenderStreamFile final
+{
+public:
+
+    RenderStreamFile();
+    ~RenderStreamFile();
+
+    // Not copyable.
+    RenderStreamFile(const RenderStreamFile &) = delete;
+    RenderStreamFile & operator = (const RenderStreamFile &) = delete;
+
+    bool open(const char * filename);
+    void close();
+
+    const void * getData() const;
+    std::int64_t getSize() const;
+    bool isMemoryMapped() const;
+
+private:
+
+    void       * data;
+    std::int64_t size;
+    bool         mapped;
+};
+
+// ========================================================
+
+inline bool RenderInterfaceRecorder::isWritingFile() const
+{
+    return file != nullptr;
+}
+
+inline const std::uint8_t * RenderInterfaceRecorder::getStreamData() const
+{
+    return stream.getData<std::uint8_t>();
+}
+
+inline int RenderInterfaceRecorder::getStreamSize() const
+{
+    return stream.getSize();
+}
+
+inline RenderInterface * RenderInterfaceRecorder::getTarget() const
+{
+    return target;
+}
+
+inline int RenderInterfaceRecorder::getFrameCount() const
+{
+    return frameCount;
+}
+
+inline int RenderInterfaceRecorder::getRepeatedFrameCount() const
+{
+    return repeatedFrameCount;
+}
+
+inline std::int64_t RenderInterfaceRecorder::getStreamBytesRecorded() const
+{
+    return streamBytesFlushed + stream.getSize();
+}
+
+inline std::int64_t RenderInterfaceRecorder::getRawBytesSubmitted() const
+{
+    return rawBytesSubmitted;
+}
+
+inline double RenderReplayStats::getFramesPerSecond() const
+{
+    return (milliseconds > 0.0) ? (frames * 1000.0 / milliseconds) : 0.0;
+}
+
+inline double RenderReplayStats::getMegabytesPerSecond() const
+{
+    return (milliseconds > 0.0) ? ((streamBytes / (1024.0 * 1024.0)) * 1000.0 / milliseconds) : 0.0;
+}
+
+inline const void * RenderStreamFile::getData() const
+{
+    return data;
+}
+
+inline std::int64_t RenderStreamFile::getSize() const
+{
+    return size;
+}
+
+inline bool RenderStreamFile::isMemoryMapped() const
+{
+    return mapped;
+}
+
+} // namespace ntb {}
+
+// ================== End of header file ==================
+
+// ================================================================================================
+//
+//                             RenderInterfaceRecorder Implementation
+//
+// ================================================================================================
+
+#ifdef NTB_DEFAULT_RENDERER_RECORDING
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define NTB_RENDER_STREAM_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else // !POSIX
+    #define NTB_RENDER_STREAM_MMAP 0
+#endif // POSIX
+
+namespace ntb
+{
+namespace
+{
+
+// ========================================================
+// Stream encoding helpers:
+// ========================================================
+
+inline std::uint64_t zigzagEncode(const std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t zigzagDecode(const std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+inline void writeByte(PODArray & out, const std::uint8_t byte)
+{
+    out.pushBack(byte);
+}
+
+inline void writeVarint(PODArray & out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        writeByte(out, static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    writeByte(out, static_cast<std::uint8_t>(value));
+}
+
+inline void writeSigned(PODArray & out, const std::int64_t value)
+{
+    writeVarint(out, zigzagEncode(value));
+}
+
+// Screen positions and depths are mostly whole numbers, UVs mostly repeat the previous
+// vertex, so floats get two predictors: Whole numbers are sent as the difference from
+// the last whole number, anything else as the difference of the bits from the last
+// fractional value. The low bit of the varint says which one it is.
+struct FloatPredictor
+{
+    std::int32_t  lastInt  = 0;
+    std::uint32_t lastBits = 0;
+};
+
+inline bool isSmallWholeFloat(const Float32 value)
+{
+    return std::floor(value) == value && std::fabs(value) < 16777216.0f && !(value == 0.0f && std::signbit(value));
+}
+
+inline void writeFloat(PODArray & out, FloatPredictor & pred, const Float32 value)
+{
+    if (isSmallWholeFloat(value))
+    {
+        const std::int32_t i = static_cast<std::int32_t>(value);
+        writeVarint(out, zigzagEncode(static_cast<std::int64_t>(i) - pred.lastInt) << 1);
+        pred.lastInt = i;
+    }
+    else
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeVarint(out, (zigzagEncode(static_cast<std::int32_t>(bits - pred.lastBits)) << 1) | 1);
+        pred.lastBits = bits;
+    }
+}
+
+// True if [first, first+count) is inside [0, total), without overflowing the sum.
+inline bool isRangeInside(const int first, const int count, const int total)
+{
+    return first >= 0 && count >= 0 && first <= total - count;
+}
+
+// Bounds-checked reader over the stream bytes. Sticks to failed on any error.
+struct StreamReader
+{
+    const std::uint8_t * ptr;
+    const std::uint8_t * end;
+    bool failed;
+
+    std::int64_t getRemaining() const { return end - ptr; }
+
+    std::uint8_t readByte()
+    {
+        if (ptr == end)
+        {
+            failed = true;
+            return 0;
+        }
+        return *ptr++;
+    }
+
+    std::uint64_t readVarint()
+    {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            const std::uint8_t byte = readByte();
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    std::int64_t readSigned()
+    {
+        return zigzagDecode(readVarint());
+    }
+
+    // Element counts. Every element takes at least one byte, so larger counts are corrupt.
+    int readCount()
+    {
+        const std::uint64_t count = readVarint();
+        if (count > static_cast<std::uint64_t>(getRemaining()))
+        {
+            failed = true;
+            return 0;
+        }
+        return static_cast<int>(count);
+    }
+
+    // Non-negative value that has to fit an int, like the offsets of the draw commands.
+    int readInt()
+    {
+        const std::uint64_t value = readVarint();
+        if (value > static_cast<std::uint64_t>(INT_MAX))
+        {
+            failed = true;
+            return 0;
+        }
+        return static_cast<int>(value);
+    }
+
+    // Signed delta from 'prev', where the sum has to fit an int.
+    int readIntDelta(const int prev)
+    {
+        const std::int64_t delta = readSigned();
+        if (delta < INT_MIN || delta > INT_MAX)
+        {
+            failed = true;
+            return 0;
+        }
+
+        const std::int64_t value = prev + delta;
+        if (value < INT_MIN || value > INT_MAX)
+        {
+            failed = true;
+            return 0;
+        }
+        return static_cast<int>(value);
+    }
+
+    Float32 readFloat(FloatPredictor & pred)
+    {
+        const std::uint64_t value = readVarint();
+        if ((value & 1) == 0)
+        {
+            pred.lastInt = static_cast<std::int32_t>(pred.lastInt + zigzagDecode(value >> 1));
+            return static_cast<Float32>(pred.lastInt);
+        }
+
+        pred.lastBits += static_cast<std::uint32_t>(zigzagDecode(value >> 1));
+        Float32 result;
+        std::memcpy(&result, &pred.lastBits, sizeof(result));
+        return result;
+    }
+};
+
+} // namespace {}
+
+// ========================================================
+// RenderInterfaceRecorder:
+// ========================================================
+
+RenderInterfaceRecorder::RenderInterfaceRecorder(RenderInterface * renderTarget)
+    : target(renderTarget)
+    , file(nullptr)
+    , stream(sizeof(std::uint8_t), MemoryTag::Renderer)
+    , framePayload(sizeof(std::uint8_t), MemoryTag::Renderer)
+    , lastPayload(sizeof(std::uint8_t), MemoryTag::Renderer)
+    , textureIds(sizeof(TextureId), MemoryTag::Renderer)
+    , nextTextureId(1)
+    , frameCount(0)
+    , repeatedFrameCount(0)
+    , streamBytesFlushed(0)
+    , rawBytesSubmitted(0)
+{
+    // The header is written lazily, since memory can only
+    // be allocated after the library is initialized.
+}
+
+RenderInterfaceRecorder::~RenderInterfaceRecorder()
+{
+    closeFile();
+}
+
+bool RenderInterfaceRecorder::openFile(const char * filename)
+{
+    NTB_ASSERT(filename != nullptr);
+
+    closeFile();
+    file = std::fopen(filename, "wb");
+    if (file == nullptr)
+    {
+        errorF("Unable to open \"%s\" for writing!", filename);
+        return false;
+    }
+
+    stream.clear();
+    lastPayload.clear();
+    streamBytesFlushed = 0;
+    writeHeader();
+    return true;
+}
+
+void RenderInterfaceRecorder::closeFile()
+{
+    if (file != nullptr)
+    {
+        flushToFile();
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+void RenderInterfaceRecorder::writeHeader()
+{
+    RenderStreamHeader header;
+    std::memcpy(header.magic, "NTBR", 4);
+    header.version    = RenderStreamHeader::kVersion;
+    header.headerSize = sizeof(RenderStreamHeader);
+    header.reserved   = 0;
+
+    stream.append(&header, sizeof(header));
+}
+
+void RenderInterfaceRecorder::flushToFile()
+{
+    if (file == nullptr || stream.isEmpty())
+    {
+        return;
+    }
+
+    if (std::fwrite(stream.getData<std::uint8_t>(), 1, stream.getSize(), file) != static_cast<std::size_t>(stream.getSize()))
+    {
+        errorF("Failed to write the render stream file!");
+    }
+
+    streamBytesFlushed += stream.getSize();
+    stream.clear();
+}
+
+void RenderInterfaceRecorder::beginDraw()
+{
+    if (streamBytesFlushed == 0 && stream.isEmpty())
+    {
+        writeHeader();
+    }
+    writeByte(stream, static_cast<std::uint8_t>(RenderStreamOp::BeginDraw));
+
+    if (target != nullptr)
+    {
+        target->beginDraw();
+    }
+}
+
+void RenderInterfaceRecorder::endDraw()
+{
+    writeByte(stream, static_cast<std::uint8_t>(RenderStreamOp::EndDraw));
+    flushToFile();
+
+    if (target != nullptr)
+    {
+        target->endDraw();
+    }
+}
+
+int RenderInterfaceRecorder::getMaxZ() const
+{
+    return (target != nullptr) ? target->getMaxZ() : RenderInterface::getMaxZ();
+}
+
+DrawOrder RenderInterfaceRecorder::getDrawOrder() const
+{
+    return (target != nullptr) ? target->getDrawOrder() : RenderInterface::getDrawOrder();
+}
+
+void RenderInterfaceRecorder::getViewport(int * viewportX, int * viewportY,
+                                          int * viewportW, int * viewportH) const
+{
+    if (target != nullptr)
+    {
+        target->getViewport(viewportX, viewportY, viewportW, viewportH);
+    }
+    else
+    {
+        RenderInterface::getViewport(viewportX, viewportY, viewportW, viewportH);
+    }
+}
+
+// ========================================================
+
+TextureHandle RenderInterfaceRecorder::createTexture(const int widthPixels, const int heightPixels,
+                                                     const int colorChannels, const void * pixels)
+{
+    NTB_ASSERT(widthPixels   > 0);
+    NTB_ASSERT(heightPixels  > 0);
+    NTB_ASSERT(colorChannels > 0);
+    NTB_ASSERT(pixels != nullptr);
+
+    if (streamBytesFlushed == 0 && stream.isEmpty())
+    {
+        writeHeader();
+    }
+
+    const std::uint32_t id = nextTextureId++;
+    writeByte(stream, static_cast<std::uint8_t>(RenderStreamOp::CreateTexture));
+    writeVarint(stream, id);
+    writeVarint(stream, widthPixels);
+    writeVarint(stream, heightPixels);
+    writeVarint(stream, colorChannels);
+    stream.append(pixels, widthPixels * heightPixels * colorChannels);
+
+    // Without a target, the id itself is a unique non-null handle.
+    TextureId entry;
+    entry.id     = id;
+    entry.handle = (target != nullptr) ?
+                   target->createTexture(widthPixels, heightPixels, colorChannels, pixels) :
+                   reinterpret_cast<TextureHandle>(static_cast<std::uintptr_t>(id));
+
+    textureIds.pushBack(entry);
+    return entry.handle;
+}
+
+void RenderInterfaceRecorder::destroyTexture(TextureHandle texture)
+{
+    for (int i = 0; i < textureIds.getSize(); ++i)
+    {
+        if (textureIds.get<TextureId>(i).handle == texture)
+        {
+            writeByte(stream, static_cast<std::uint8_t>(RenderStreamOp::DestroyTexture));
+            writeVarint(stream, textureIds.get<TextureId>(i).id);
+            textureIds.eraseSwap(i);
+            break;
+        }
+    }
+
+    if (target != nullptr)
+    {
+        target->destroyTexture(texture);
+    }
+}
+
+std::uint32_t RenderInterfaceRecorder::findTextureId(TextureHandle texture) const
+{
+    if (texture != nullptr)
+    {
+        for (int i = 0; i < textureIds.getSize(); ++i)
+        {
+            if (textureIds.get<TextureId>(i).handle == texture)
+            {
+                return textureIds.get<TextureId>(i).id;
+            }
+        }
+    }
+    return 0; // Null or not created through the recorder.
+}
+
+// ========================================================
+
+void RenderInterfaceRecorder::draw2DLines(const VertexPC * verts, const int vertCount, const int frameMaxZ)
+{
+    DrawCommand cmd = {};
+    cmd.type        = DrawCommandType::Lines;
+    cmd.vertexCount = vertCount;
+
+    PackedFrame frame = {};
+    frame.lineVerts     = verts;
+    frame.commands      = &cmd;
+    frame.lineVertCount = vertCount;
+    frame.commandCount  = 1;
+    frame.frameMaxZ     = frameMaxZ;
+    recordPackedFrame(frame);
+
+    if (target != nullptr)
+    {
+        target->draw2DLines(verts, vertCount, frameMaxZ);
+    }
+}
+
+void RenderInterfaceRecorder::draw2DTriangles(const VertexPTC * verts, const int vertCount,
+                                              const std::uint16_t * indexes, const int indexCount,
+                                              TextureHandle texture, const int frameMaxZ)
+{
+    DrawCommand cmd = {};
+    cmd.type        = DrawCommandType::Triangles;
+    cmd.texture     = texture;
+    cmd.vertexCount = vertCount;
+    cmd.indexCount  = indexCount;
+
+    PackedFrame frame = {};
+    frame.verts        = verts;
+    frame.indexes      = indexes;
+    frame.commands     = &cmd;
+    frame.vertCount    = vertCount;
+    frame.indexCount   = indexCount;
+    frame.commandCount = 1;
+    frame.frameMaxZ    = frameMaxZ;
+    recordPackedFrame(frame);
+
+    if (target != nullptr)
+    {
+        target->draw2DTriangles(verts, vertCount, indexes, indexCount, texture, frameMaxZ);
+    }
+}
+
+void RenderInterfaceRecorder::drawClipped2DTriangles(const VertexPTC * verts, const int vertCount,
+                                                     const std::uint16_t * indexes, const int indexCount,
+                                                     const DrawClippedInfo * drawInfo,
+                                                     const int drawInfoCount, const int frameMaxZ)
+{
+    DrawCommand cmd   = {};
+    cmd.type          = DrawCommandType::ClippedTriangles;
+    cmd.vertexCount   = vertCount;
+    cmd.indexCount    = indexCount;
+    cmd.drawInfoCount = drawInfoCount;
+
+    PackedFrame frame = {};
+    frame.verts         = verts;
+    frame.indexes       = indexes;
+    frame.drawInfos     = drawInfo;
+    frame.commands      = &cmd;
+    frame.vertCount     = vertCount;
+    frame.indexCount    = indexCount;
+    frame.drawInfoCount = drawInfoCount;
+    frame.commandCount  = 1;
+    frame.frameMaxZ     = frameMaxZ;
+    recordPackedFrame(frame);
+
+    if (target != nullptr)
+    {
+        target->drawClipped2DTriangles(verts, vertCount, indexes, indexCount, drawInfo, drawInfoCount, frameMaxZ);
+    }
+}
+
+void RenderInterfaceRecorder::drawPackedFrame(const PackedFrame & frame)
+{
+    recordPackedFrame(frame);
+
+    if (target != nullptr)
+    {
+        target->drawPackedFrame(frame);
+    }
+}
+
+void RenderInterfaceRecorder::recordPackedFrame(const PackedFrame & frame)
+{
+    framePayload.clear();
+    encodePackedFrame(frame, framePayload);
+
+    ++frameCount;
+    rawBytesSubmitted += (frame.vertCount     * sizeof(VertexPTC))     +
+                         (frame.indexCount    * sizeof(std::uint16_t)) +
+                         (frame.lineVertCount * sizeof(VertexPC))      +
+                         (frame.drawInfoCount * sizeof(DrawClippedInfo)) +
+                         (frame.commandCount  * sizeof(DrawCommand));
+
+    // Frame-to-frame delta: An unchanged UI resubmits the exact same frame.
+    if (framePayload.getSize() == lastPayload.getSize() &&
+        std::memcmp(framePayload.getData<std::uint8_t>(), lastPayload.getData<std::uint8_t>(), framePayload.getSize()) == 0)
+    {
+        writeByte(stream, static_cast<std::uint8_t>(RenderStreamOp::RepeatPackedFrame));
+        ++repeatedFrameCount;
+        return;
+    }
+
+    writeByte(stream, static_cast<std::uint8_t>(RenderStreamOp::PackedFrame));
+    writeVarint(stream, framePayload.getSize());
+    stream.append(framePayload.getData<std::uint8_t>(), framePayload.getSize());
+
+    lastPayload.clear();
+    lastPayload.append(framePayload.getData<std::uint8_t>(), framePayload.getSize());
+}
+
+void RenderInterfaceRecorder::encodePackedFrame(const PackedFrame & frame, PODArray & out) const
+{
+    writeVarint(out, frame.vertCount);
+    writeVarint(out, frame.indexCount);
+    writeVarint(out, frame.lineVertCount);
+    writeVarint(out, frame.drawInfoCount);
+    writeVarint(out, frame.commandCount);
+    writeSigned(out, frame.frameMaxZ);
+    writeByte(out, static_cast<std::uint8_t>(frame.drawOrder));
+
+    // Vertexes: Each field predicted from the same field of the previous vertex.
+    FloatPredictor px, py, pz, pu, pv;
+    Color32 prevColor = 0;
+    for (int i = 0; i < frame.vertCount; ++i)
+    {
+        const VertexPTC & v = frame.verts[i];
+        writeFloat(out, px, v.x);
+        writeFloat(out, py, v.y);
+        writeFloat(out, pz, v.z);
+        writeFloat(out, pu, v.u);
+        writeFloat(out, pv, v.v);
+        writeVarint(out, v.color ^ prevColor);
+        prevColor = v.color;
+    }
+
+    int prevIndex = 0;
+    for (int i = 0; i < frame.indexCount; ++i)
+    {
+        writeSigned(out, frame.indexes[i] - prevIndex);
+        prevIndex = frame.indexes[i];
+    }
+
+    FloatPredictor lx, ly, lz;
+    prevColor = 0;
+    for (int i = 0; i < frame.lineVertCount; ++i)
+    {
+        const VertexPC & v = frame.lineVerts[i];
+        writeFloat(out, lx, v.x);
+        writeFloat(out, ly, v.y);
+        writeFloat(out, lz, v.z);
+        writeVarint(out, v.color ^ prevColor);
+        prevColor = v.color;
+    }
+
+    DrawClippedInfo prevInfo = {};
+    for (int i = 0; i < frame.drawInfoCount; ++i)
+    {
+        const DrawClippedInfo & info = frame.drawInfos[i];
+        writeVarint(out, findTextureId(info.texture));
+        writeSigned(out, static_cast<std::int64_t>(info.viewportX)  - prevInfo.viewportX);
+        writeSigned(out, static_cast<std::int64_t>(info.viewportY)  - prevInfo.viewportY);
+        writeSigned(out, static_cast<std::int64_t>(info.viewportW)  - prevInfo.viewportW);
+        writeSigned(out, static_cast<std::int64_t>(info.viewportH)  - prevInfo.viewportH);
+        writeSigned(out, static_cast<std::int64_t>(info.clipBoxX)   - prevInfo.clipBoxX);
+        writeSigned(out, static_cast<std::int64_t>(info.clipBoxY)   - prevInfo.clipBoxY);
+        writeSigned(out, static_cast<std::int64_t>(info.clipBoxW)   - prevInfo.clipBoxW);
+        writeSigned(out, static_cast<std::int64_t>(info.clipBoxH)   - prevInfo.clipBoxH);
+        writeSigned(out, static_cast<std::int64_t>(info.firstIndex) - prevInfo.firstIndex);
+        writeSigned(out, static_cast<std::int64_t>(info.indexCount) - prevInfo.indexCount);
+        prevInfo = info;
+    }
+
+    for (int i = 0; i < frame.commandCount; ++i)
+    {
+        const DrawCommand & cmd = frame.commands[i];
+        writeByte(out, static_cast<std::uint8_t>(cmd.type));
+        writeVarint(out, findTextureId(cmd.texture));
+        writeVarint(out, cmd.firstVertex);
+        writeVarint(out, cmd.vertexCount);
+        writeVarint(out, cmd.firstIndex);
+        writeVarint(out, cmd.indexCount);
+        writeVarint(out, cmd.firstDrawInfo);
+        writeVarint(out, cmd.drawInfoCount);
+    }
+}
+
+// ========================================================
+// RenderStreamReplayer:
+// ========================================================
+
+RenderStreamReplayer::RenderStreamReplayer()
+    : verts(sizeof(VertexPTC), MemoryTag::Renderer)
+    , indexes(sizeof(std::uint16_t), MemoryTag::Renderer)
+    , lineVerts(sizeof(VertexPC), MemoryTag::Renderer)
+    , drawInfos(sizeof(DrawClippedInfo), MemoryTag::Renderer)
+    , commands(sizeof(DrawCommand), MemoryTag::Renderer)
+    , textures(sizeof(TextureHandle), MemoryTag::Renderer)
+{
+}
+
+RenderStreamReplayer::~RenderStreamReplayer()
+{
+}
+
+bool RenderStreamReplayer::replay(const void * streamData, const std::int64_t streamSize,
+                                  RenderInterface & target, RenderReplayStats * outStats)
+{
+    NTB_ASSERT(streamData != nullptr);
+
+    RenderStreamHeader header;
+    if (streamSize < static_cast<std::int64_t>(sizeof(header)))
+    {
+        errorF("Render stream too small to be valid!");
+        return false;
+    }
+
+    std::memcpy(&header, streamData, sizeof(header));
+    if (std::memcmp(header.magic, "NTBR", 4) != 0 || header.version != RenderStreamHeader::kVersion ||
+        header.headerSize < sizeof(header) || header.headerSize > streamSize)
+    {
+        errorF("Not a version %u NTB render stream!", RenderStreamHeader::kVersion);
+        return false;
+    }
+
+    RenderReplayStats stats = {};
+    const auto startTime = std::chrono::steady_clock::now();
+
+    StreamReader reader;
+    reader.ptr    = static_cast<const std::uint8_t *>(streamData) + header.headerSize;
+    reader.end    = static_cast<const std::uint8_t *>(streamData) + streamSize;
+    reader.failed = false;
+
+    // Id 0 is the null texture.
+    textures.clear();
+    textures.pushBack(static_cast<TextureHandle>(nullptr));
+
+    auto getTexture = [this, &reader](const std::uint64_t id) -> TextureHandle
+    {
+        if (id >= static_cast<std::uint64_t>(textures.getSize()))
+        {
+            reader.failed = true;
+            return nullptr;
+        }
+        return textures.get<TextureHandle>(static_cast<int>(id));
+    };
+
+    PackedFrame frame = {};
+    bool haveFrame = false;
+
+    auto submitFrame = [&target, &frame, &stats]()
+    {
+        target.drawPackedFrame(frame);
+        stats.frames       += 1;
+        stats.drawCommands += frame.commandCount;
+        stats.vertexes     += frame.vertCount + frame.lineVertCount;
+        stats.indexes      += frame.indexCount;
+    };
+
+    while (reader.ptr != reader.end && !reader.failed)
+    {
+        const RenderStreamOp op = static_cast<RenderStreamOp>(reader.readByte());
+        switch (op)
+        {
+        case RenderStreamOp::BeginDraw :
+            target.beginDraw();
+            break;
+
+        case RenderStreamOp::EndDraw :
+            target.endDraw();
+            break;
+
+        case RenderStreamOp::CreateTexture :
+            {
+                const std::uint64_t id = reader.readVarint();
+                const std::uint64_t w  = reader.readVarint();
+                const std::uint64_t h  = reader.readVarint();
+                const std::uint64_t c  = reader.readVarint();
+
+                if (reader.failed || id == 0 || id > 0xFFFF || w == 0 || h == 0 || c == 0 || c > 4 ||
+                    w > 0xFFFF || h > 0xFFFF || (w * h * c) > static_cast<std::uint64_t>(reader.getRemaining()))
+                {
+                    reader.failed = true;
+                    break;
+                }
+
+                // Pixels go straight from the (possibly memory-mapped) stream.
+                const TextureHandle tex = target.createTexture(static_cast<int>(w), static_cast<int>(h),
+                                                               static_cast<int>(c), reader.ptr);
+                reader.ptr += w * h * c;
+
+                while (textures.getSize() <= static_cast<int>(id))
+                {
+                    textures.pushBack(static_cast<TextureHandle>(nullptr));
+                }
+                textures.get<TextureHandle>(static_cast<int>(id)) = tex;
+                ++stats.texturesCreated;
+                break;
+            }
+
+        case RenderStreamOp::DestroyTexture :
+            {
+                const std::uint64_t id  = reader.readVarint();
+                const TextureHandle tex = getTexture(id);
+                if (tex != nullptr)
+                {
+                    target.destroyTexture(tex);
+                    textures.get<TextureHandle>(static_cast<int>(id)) = nullptr;
+                }
+                break;
+            }
+
+        case RenderStreamOp::PackedFrame :
+            {
+                const std::uint64_t payloadSize = reader.readVarint();
+                if (payloadSize > static_cast<std::uint64_t>(reader.getRemaining()))
+                {
+                    reader.failed = true;
+                    break;
+                }
+                const std::uint8_t * payloadEnd = reader.ptr + payloadSize;
+
+                const int vertCount     = reader.readCount();
+                const int indexCount    = reader.readCount();
+                const int lineVertCount = reader.readCount();
+                const int drawInfoCount = reader.readCount();
+                const int commandCount  = reader.readCount();
+                const int frameMaxZ     = static_cast<int>(reader.readSigned());
+                const std::uint8_t order = reader.readByte();
+                if (order > static_cast<std::uint8_t>(DrawOrder::Painter))
+                {
+                    reader.failed = true;
+                    break;
+                }
+
+                // Scratch arrays only grow, so replaying allocates nothing once warmed up.
+                verts.clear();     verts.resize(vertCount);
+                indexes.clear();   indexes.resize(indexCount);
+                lineVerts.clear(); lineVerts.resize(lineVertCount);
+                drawInfos.clear(); drawInfos.resize(drawInfoCount);
+                commands.clear();  commands.resize(commandCount);
+
+                FloatPredictor px, py, pz, pu, pv;
+                Color32 prevColor = 0;
+                for (int i = 0; i < vertCount; ++i)
+                {
+                    VertexPTC & v = verts.get<VertexPTC>(i);
+                    v.x = reader.readFloat(px);
+                    v.y = reader.readFloat(py);
+                    v.z = reader.readFloat(pz);
+                    v.u = reader.readFloat(pu);
+                    v.v = reader.readFloat(pv);
+                    v.color = prevColor ^ static_cast<Color32>(reader.readVarint());
+                    prevColor = v.color;
+                }
+
+                int prevIndex = 0;
+                for (int i = 0; i < indexCount && !reader.failed; ++i)
+                {
+                    prevIndex = reader.readIntDelta(prevIndex);
+                    if (prevIndex < 0 || prevIndex > UINT16_MAX)
+                    {
+                        reader.failed = true;
+                    }
+                    indexes.get<std::uint16_t>(i) = static_cast<std::uint16_t>(prevIndex);
+                }
+
+                FloatPredictor lx, ly, lz;
+                prevColor = 0;
+                for (int i = 0; i < lineVertCount; ++i)
+                {
+                    VertexPC & v = lineVerts.get<VertexPC>(i);
+                    v.x = reader.readFloat(lx);
+                    v.y = reader.readFloat(ly);
+                    v.z = reader.readFloat(lz);
+                    v.color = prevColor ^ static_cast<Color32>(reader.readVarint());
+                    prevColor = v.color;
+                }
+
+                DrawClippedInfo prevInfo = {};
+                for (int i = 0; i < drawInfoCount; ++i)
+                {
+                    DrawClippedInfo & info = drawInfos.get<DrawClippedInfo>(i);
+                    info.texture    = getTexture(reader.readVarint());
+                    info.viewportX  = reader.readIntDelta(prevInfo.viewportX);
+                    info.viewportY  = reader.readIntDelta(prevInfo.viewportY);
+                    info.viewportW  = reader.readIntDelta(prevInfo.viewportW);
+                    info.viewportH  = reader.readIntDelta(prevInfo.viewportH);
+                    info.clipBoxX   = reader.readIntDelta(prevInfo.clipBoxX);
+                    info.clipBoxY   = reader.readIntDelta(prevInfo.clipBoxY);
+                    info.clipBoxW   = reader.readIntDelta(prevInfo.clipBoxW);
+                    info.clipBoxH   = reader.readIntDelta(prevInfo.clipBoxH);
+                    info.firstIndex = reader.readIntDelta(prevInfo.firstIndex);
+                    info.indexCount = reader.readIntDelta(prevInfo.indexCount);
+                    prevInfo = info;
+                }
+
+                for (int i = 0; i < commandCount; ++i)
+                {
+                    DrawCommand & cmd = commands.get<DrawCommand>(i);
+                    const std::uint8_t type = reader.readByte();
+                    cmd.type          = static_cast<DrawCommandType>(type);
+                    cmd.texture       = getTexture(reader.readVarint());
+                    cmd.firstVertex   = reader.readInt();
+                    cmd.vertexCount   = reader.readInt();
+                    cmd.firstIndex    = reader.readInt();
+                    cmd.indexCount    = reader.readInt();
+                    cmd.firstDrawInfo = reader.readInt();
+                    cmd.drawInfoCount = reader.readInt();
+
+                    // Ranges must be inside the decoded arrays.
+                    const int maxVerts = (cmd.type == DrawCommandType::Lines) ? lineVertCount : vertCount;
+                    if (reader.failed || type > static_cast<std::uint8_t>(DrawCommandType::Lines) ||
+                        !isRangeInside(cmd.firstVertex,   cmd.vertexCount,   maxVerts)   ||
+                        !isRangeInside(cmd.firstIndex,    cmd.indexCount,    indexCount) ||
+                        !isRangeInside(cmd.firstDrawInfo, cmd.drawInfoCount, drawInfoCount))
+                    {
+                        reader.failed = true;
+                        break;
+                    }
+
+                    // Indexes are relative to the command's first vertex and
+                    // the clipped ranges to the command's first index.
+                    const int indexedCount = (cmd.type == DrawCommandType::Lines) ? 0 : cmd.indexCount;
+                    const std::uint16_t * cmdIndexes = indexes.getData<std::uint16_t>() + cmd.firstIndex;
+                    for (int n = 0; n < indexedCount; ++n)
+                    {
+                        if (cmdIndexes[n] >= cmd.vertexCount)
+                        {
+                            reader.failed = true;
+                            break;
+                        }
+                    }
+                    if (cmd.type == DrawCommandType::ClippedTriangles)
+                    {
+                        for (int n = 0; n < cmd.drawInfoCount; ++n)
+                        {
+                            const DrawClippedInfo & info = drawInfos.get<DrawClippedInfo>(cmd.firstDrawInfo + n);
+                            if (!isRangeInside(info.firstIndex, info.indexCount, cmd.indexCount))
+                            {
+                                reader.failed = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                if (reader.failed || reader.ptr != payloadEnd)
+                {
+                    reader.failed = true;
+                    break;
+                }
+
+                frame.verts         = verts.getData<VertexPTC>();
+                frame.indexes       = indexes.getData<std::uint16_t>();
+                frame.lineVerts     = lineVerts.getData<VertexPC>();
+                frame.drawInfos     = drawInfos.getData<DrawClippedInfo>();
+                frame.commands      = commands.getData<DrawCommand>();
+                frame.vertCount     = vertCount;
+                frame.indexCount    = indexCount;
+                frame.lineVertCount = lineVertCount;
+                frame.drawInfoCount = drawInfoCount;
+                frame.commandCount  = commandCount;
+                frame.frameMaxZ     = frameMaxZ;
+                frame.drawOrder     = static_cast<DrawOrder>(order);
+                haveFrame = true;
+
+                submitFrame();
+                break;
+            }
+
+        case RenderStreamOp::RepeatPackedFrame :
+            if (!haveFrame)
+            {
+                reader.failed = true;
+                break;
+            }
+            submitFrame();
+            ++stats.repeatedFrames;
+            break;
+
+        default :
+            reader.failed = true;
+            break;
+        } // switch (op)
+    }
+
+    if (reader.failed)
+    {
+        errorF("Malformed NTB render stream at byte offset %lld!",
+               static_cast<long long>(reader.ptr - static_cast<const std::uint8_t *>(streamData)));
+    }
+
+    for (int i = 1; i < textures.getSize(); ++i)
+    {
+        if (textures.get<TextureHandle>(i) != nullptr)
+        {
+            target.destroyTexture(textures.get<TextureHandle>(i));
+        }
+    }
+    textures.clear();
+
+    const auto endTime = std::chrono::steady_clock::now();
+    stats.streamBytes  = reader.ptr - static_cast<const std::uint8_t *>(streamData);
+    stats.milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    if (outStats != nullptr)
+    {
+        (*outStats) = stats;
+    }
+    return !reader.failed;
+}
+
+// ========================================================
+// RenderStreamFile:
+// ========================================================
+
+RenderStreamFile::RenderStreamFile()
+    : data(nullptr)
+    , size(0)
+    , mapped(false)
+{
+}
+
+RenderStreamFile::~RenderStreamFile()
+{
+    close();
+}
+
+bool RenderStreamFile::open(const char * filename)
+{
+    NTB_ASSERT(filename != nullptr);
+    close();
+
+    #if NTB_RENDER_STREAM_MMAP
+    const int fd = ::open(filename, O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void * ptr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED)
+            {
+                data   = ptr;
+                size   = st.st_size;
+                mapped = true;
+            }
+        }
+        ::close(fd);
+
+        if (mapped)
+        {
+            return true;
+        }
+    }
+    #endif // NTB_RENDER_STREAM_MMAP
+
+    // Fall back to reading the whole file.
+    std::FILE * fp = std::fopen(filename, "rb");
+    if (fp == nullptr)
+    {
+        errorF("Unable to open \"%s\" for reading!", filename);
+        return false;
+    }
+
+    std::fseek(fp, 0, SEEK_END);
+    const long fileSize = std::ftell(fp);
+    std::fseek(fp, 0, SEEK_SET);
+
+    if (fileSize <= 0)
+    {
+        errorF("Render stream file \"%s\" is empty!", filename);
+        std::fclose(fp);
+        return false;
+    }
+
+    data = implAllocT<std::uint8_t>(MemoryTag::Renderer, static_cast<std::uint32_t>(fileSize));
+    size = fileSize;
+
+    const bool ok = (std::fread(data, 1, fileSize, fp) == static_cast<std::size_t>(fileSize));
+    std::fclose(fp);
+
+    if (!ok)
+    {
+        errorF("Failed to read render stream file \"%s\"!", filename);
+        close();
+    }
+    return ok;
+}
+
+void RenderStreamFile::close()
+{
+    if (data != nullptr)
+    {
+        #if NTB_RENDER_STREAM_MMAP
+        if (mapped)
+        {
+            ::munmap(data, static_cast<std::size_t>(size));
+        }
+        else
+        #endif // NTB_RENDER_STREAM_MMAP
+        {
+            implFree(data);
+        }
+    }
+
+    data   = nullptr;
+    size   = 0;
+    mapped = false;
+}
+
+} // namespace ntb {}
+
+// ================ End of implementation =================
+#endif // NTB_DEFAULT_RENDERER_RECORDING
+// ================ End of implementation =================
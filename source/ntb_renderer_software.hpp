@@ -0,0 +1,1371 @@
+#pragma once
+// ================================================================================================
+// -*- C++ -*-
+// File: ntb_renderer_software.hpp
+// Author: Guilherme R. Lampert
+// Created on: 16/10/26
+//
+// Brief:
+//  CPU software rasterizer RenderInterface for NTB. Draws into an in-memory RGBA framebuffer,
+//  so the UI can be rendered without a GPU, dumped to PNG/PPM and compared pixel-by-pixel with
+//  a golden image. It follows the conventions of the default GL renderers (pixel centers, blend
+//  mode, GEQUAL depth test and bilinear texture filtering), so the output closely matches them.
+//
+//  Primitives are recorded during the frame and rasterized by endDraw(). The framebuffer is split
+//  into tiles, primitives are binned to the tiles they touch, then the tiles are rasterized in
+//  parallel by a small pool of worker threads. Each tile draws its primitives in submission order,
+//  so the output is the same for any number of threads. Triangle coverage uses fixed-point edge
+//  functions, four pixels at a time with SSE2 when available.
+//
+//  This header file is optional and won't be compiled into the library if you don't include it.
+//  #define NTB_DEFAULT_RENDERER_SOFTWARE before including the file in a .cpp to enable the
+//  implementation.
+// ================================================================================================
+
+#include "ntb.hpp"
+#include "ntb_utils.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Define to 0 before including this file to always use the scalar rasterizer.
+#ifndef NTB_SOFTWARE_RENDERER_SSE2
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define NTB_SOFTWARE_RENDERER_SSE2 1
+    #else // !SSE2
+        #define NTB_SOFTWARE_RENDERER_SSE2 0
+    #endif // SSE2
+#endif // NTB_SOFTWARE_RENDERER_SSE2
+
+#if NTB_SOFTWARE_RENDERER_SSE2
+    #include <emmintrin.h>
+#endif // NTB_SOFTWARE_RENDERER_SSE2
+
+namespace ntb
+{
+
+// ========================================================
+// class RenderInterfaceSoftware:
+// ========================================================
+
+class RenderInterfaceSoftware final
+    : public RenderInterface
+{
+public:
+
+    // Zero threads uses one per hardware thread.
+    RenderInterfaceSoftware(int framebufferW, int framebufferH, int threadCount = 0);
+    virtual ~RenderInterfaceSoftware();
+
+    // Not copyable.
+    RenderInterfaceSoftware(const RenderInterfaceSoftware &) = delete;
+    RenderInterfaceSoftware & operator = (const RenderInterfaceSoftware &) = delete;
+
+    // -- Local queries and helpers --
+
+    // The framebuffer is allocated by the first clearFramebuffer() or beginDraw() after a
+    // resize, since memory can only be allocated after ntb::initialize(). Contents are
+    // undefined until the next clearFramebuffer().
+    void setFramebufferSize(int w, int h);
+    int getFramebufferWidth() const;
+    int getFramebufferHeight() const;
+
+    // RGBA, 8-bits per channel, top row first. Null until allocated.
+    const std::uint8_t * getFramebufferPixels() const;
+
+    // Like glClear; the UI is drawn over what is already in the framebuffer,
+    // so call this once before rendering the GUIs of a frame. Depth is cleared to 0.
+    void clearFramebuffer(Color32 clearColor);
+
+    // Depth testing is on by default, like the GL renderers. Drawing without it skips the
+    // depth buffer and makes the GUIs generate their frames in DrawOrder::Painter.
+    bool isDrawingWithDepthTest() const;
+    void setDrawWithDepthTest(bool doDepthTest);
+
+    // Number of threads rasterizing tiles at endDraw(), including the calling thread.
+    void setThreadCount(int threadCount);
+    int getThreadCount() const;
+
+    // Image dumps of the framebuffer. Errors are reported via ShellInterface::errorF().
+    bool savePPM(const char * filename) const; // Binary RGB (P6). Alpha is dropped.
+    bool savePNG(const char * filename) const; // RGBA. Uncompressed (stored) deflate blocks.
+
+    // Number of pixels whose RGB differ by more than 'tolerance' in any channel from
+    // a binary PPM of the same dimensions, or -1 if the file can't be read or compared.
+    int compareWithPPM(const char * filename, int tolerance = 0) const;
+
+    // Primitives rasterized by the last endDraw().
+    int getLastFrameTriangleCount() const;
+    int getLastFrameLineCount() const;
+
+    //
+    // ntb::RenderInterface overrides:
+    //
+
+    // -- Miscellaneous --
+
+    void beginDraw() override;
+    void endDraw()   override;
+    DrawOrder getDrawOrder() const override;
+
+    void getViewport(int * viewportX, int * viewportY,
+                     int * viewportW, int * viewportH) const override;
+
+    // -- Texture allocation --
+
+    TextureHandle createTexture(int widthPixels, int heightPixels,
+                                int colorChannels, const void * pixels) override;
+
+    void destroyTexture(TextureHandle texture) override;
+
+    // -- Drawing commands --
+
+    void draw2DLines(const VertexPC * verts, int vertCount, int frameMaxZ) override;
+
+    void draw2DTriangles(const VertexPTC * verts, int vertCount,
+                         const std::uint16_t * indexes, int indexCount,
+                         TextureHandle texture, int frameMaxZ) override;
+
+    void drawClipped2DTriangles(const VertexPTC * verts, int vertCount,
+                                const std::uint16_t * indexes, int indexCount,
+                                const DrawClippedInfo * drawInfo,
+                                int drawInfoCount, int frameMaxZ) override;
+
+private:
+
+    static const int kTileSize   = 64;
+    static const int kMaxThreads = 16;
+
+    struct SWTextureRecord : public ListNode<SWTextureRecord>
+    {
+        int            width;
+        int            height;
+        std::uint8_t * pixels; // RGBA, allocated in the same block as the record.
+    };
+
+    // Vertex already in framebuffer space: top-left origin, pixel centers at +0.5.
+    struct SWVertex
+    {
+        Float32 x, y, z;
+        Float32 u, v;
+        Color32 color;
+    };
+
+    // A triangle or line recorded for the frame.
+    struct SWPrimitive
+    {
+        int firstVert;
+        int vertCount; // 3 for triangles, 2 for lines.
+        const SWTextureRecord * texture;
+        int clipX0, clipY0; // Inclusive.
+        int clipX1, clipY1; // Exclusive.
+    };
+
+    struct SWRect
+    {
+        int x0, y0; // Inclusive.
+        int x1, y1; // Exclusive.
+    };
+
+    void addTriangles(const VertexPTC * verts, int vertCount, const std::uint16_t * indexes, int indexCount,
+                      TextureHandle texture, const SWRect & viewport, const SWRect & clipBox);
+
+    void binPrimitives();
+    void rasterizeTiles();
+    void rasterizeTile(int tileIndex);
+    void rasterizeTriangle(const SWPrimitive & prim, const SWRect & rect);
+    void rasterizeLine(const SWPrimitive & prim, const SWRect & rect);
+    void shadePixel(int x, int y, Float32 z, Float32 u, Float32 v, const Float32 color[4], const SWTextureRecord * texture);
+
+    static void sampleTexture(const SWTextureRecord * texture, Float32 u, Float32 v, Float32 texel[4]);
+
+    void startWorkers(int threadCount);
+    void stopWorkers();
+    void workerLoop(int startSerial);
+
+    void allocFramebuffer();
+    void freeFramebuffer();
+    void freeAllTextures();
+
+    // Framebuffer:
+    int            fbWidth;
+    int            fbHeight;
+    std::uint8_t * colorBuffer; // RGBA
+    Float32      * depthBuffer;
+    int            tilesX;
+    int            tilesY;
+
+    // Primitives of the current frame and their per-tile lists.
+    PODArray frameVerts;      // [SWVertex]
+    PODArray framePrims;      // [SWPrimitive]
+    PODArray tileFirstPrim;   // [int] tilesX*tilesY+1 offsets into tilePrims.
+    PODArray tilePrims;       // [int] Indexes into framePrims, tile by tile.
+    int      lastTriangleCount;
+    int      lastLineCount;
+    bool     drawWithDepth;
+
+    // Worker pool. Tiles are handed out by the atomic counter.
+    int                     threadCount;
+    std::thread             workers[kMaxThreads];
+    std::mutex              workMutex;
+    std::condition_variable workStartCv;
+    std::condition_variable workDoneCv;
+    std::atomic<int>        nextTile;
+    int                     frameSerial;
+    int                     workersBusy;
+    bool                    quitWorkers;
+
+    IntrusiveList<SWTextureRecord> textures;
+};
+
+// ========================================================
+
+inline int RenderInterfaceSoftware::getFramebufferWidth() const
+{
+    return fbWidth;
+}
+
+inline int RenderInterfaceSoftware::getFramebufferHeight() const
+{
+    return fbHeight;
+}
+
+inline const std::uint8_t * RenderInterfaceSoftware::getFramebufferPixels() const
+{
+    return colorBuffer;
+}
+
+inline int RenderInterfaceSoftware::getThreadCount() const
+{
+    return threadCount;
+}
+
+inline bool RenderInterfaceSoftware::isDrawingWithDepthTest() const
+{
+    return drawWithDepth;
+}
+
+inline void RenderInterfaceSoftware::setDrawWithDepthTest(const bool doDepthTest)
+{
+    drawWithDepth = doDepthTest;
+}
+
+inline int RenderInterfaceSoftware::getLastFrameTriangleCount() const
+{
+    return lastTriangleCount;
+}
+
+inline int RenderInterfaceSoftware::getLastFrameLineCount() const
+{
+    return lastLineCount;
+}
+
+} // namespace ntb {}
+
+// ================== End of header file ==================
+
+// ================================================================================================
+//
+//                              RenderInterfaceSoftware Implementation
+//
+// ================================================================================================
+
+#ifdef NTB_DEFAULT_RENDERER_SOFTWARE
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace ntb
+{
+
+RenderInterfaceSoftware::RenderInterfaceSoftware(const int framebufferW, const int framebufferH, const int threads)
+    : fbWidth(0)
+    , fbHeight(0)
+    , colorBuffer(nullptr)
+    , depthBuffer(nullptr)
+    , tilesX(0)
+    , tilesY(0)
+    , frameVerts(sizeof(SWVertex), MemoryTag::Renderer)
+    , framePrims(sizeof(SWPrimitive), MemoryTag::Renderer)
+    , tileFirstPrim(sizeof(int), MemoryTag::Renderer)
+    , tilePrims(sizeof(int), MemoryTag::Renderer)
+    , lastTriangleCount(0)
+    , lastLineCount(0)
+    , drawWithDepth(true)
+    , threadCount(0)
+    , nextTile(0)
+    , frameSerial(0)
+    , workersBusy(0)
+    , quitWorkers(false)
+{
+    setFramebufferSize(framebufferW, framebufferH);
+    setThreadCount(threads);
+}
+
+RenderInterfaceSoftware::~RenderInterfaceSoftware()
+{
+    stopWorkers();
+    freeAllTextures();
+    freeFramebuffer();
+}
+
+void RenderInterfaceSoftware::setFramebufferSize(const int w, const int h)
+{
+    NTB_ASSERT(w > 0 && h > 0);
+
+    freeFramebuffer();
+    fbWidth  = w;
+    fbHeight = h;
+    tilesX   = (w + kTileSize - 1) / kTileSize;
+    tilesY   = (h + kTileSize - 1) / kTileSize;
+}
+
+void RenderInterfaceSoftware::allocFramebuffer()
+{
+    if (colorBuffer == nullptr)
+    {
+        colorBuffer = implAllocT<std::uint8_t>(MemoryTag::Renderer, fbWidth * fbHeight * 4);
+        depthBuffer = implAllocT<Float32>(MemoryTag::Renderer, fbWidth * fbHeight);
+    }
+}
+
+void RenderInterfaceSoftware::freeFramebuffer()
+{
+    implFree(colorBuffer);
+    implFree(depthBuffer);
+    colorBuffer = nullptr;
+    depthBuffer = nullptr;
+}
+
+void RenderInterfaceSoftware::clearFramebuffer(const Color32 clearColor)
+{
+    allocFramebuffer();
+
+    std::uint8_t r, g, b, a;
+    unpackColor(clearColor, r, g, b, a);
+
+    const int pixelCount = fbWidth * fbHeight;
+    for (int p = 0; p < pixelCount; ++p)
+    {
+        colorBuffer[(p * 4) + 0] = r;
+        colorBuffer[(p * 4) + 1] = g;
+        colorBuffer[(p * 4) + 2] = b;
+        colorBuffer[(p * 4) + 3] = a;
+        depthBuffer[p] = 0.0f;
+    }
+}
+
+// ========================================================
+// Worker threads:
+// ========================================================
+
+void RenderInterfaceSoftware::setThreadCount(int threads)
+{
+    if (threads <= 0)
+    {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threads = std::max(1, std::min(threads, static_cast<int>(kMaxThreads)));
+
+    if (threads != threadCount)
+    {
+        stopWorkers();
+        startWorkers(threads);
+    }
+}
+
+void RenderInterfaceSoftware::startWorkers(const int threads)
+{
+    threadCount = threads;
+    quitWorkers = false;
+
+    // The thread calling endDraw() rasterizes tiles too. Workers get the current frame
+    // serial up front, so they can't miss a frame started before they first lock the mutex.
+    for (int t = 0; t < threadCount - 1; ++t)
+    {
+        workers[t] = std::thread(&RenderInterfaceSoftware::workerLoop, this, frameSerial);
+    }
+}
+
+void RenderInterfaceSoftware::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(workMutex);
+        quitWorkers = true;
+    }
+    workStartCv.notify_all();
+
+    for (int t = 0; t < threadCount - 1; ++t)
+    {
+        workers[t].join();
+    }
+    threadCount = 0;
+}
+
+void RenderInterfaceSoftware::workerLoop(const int startSerial)
+{
+    std::unique_lock<std::mutex> lock(workMutex);
+    int lastSerial = startSerial;
+
+    for (;;)
+    {
+        workStartCv.wait(lock, [this, lastSerial]() { return quitWorkers || frameSerial != lastSerial; });
+        if (quitWorkers)
+        {
+            return;
+        }
+        lastSerial = frameSerial;
+
+        lock.unlock();
+        for (int tile = nextTile++; tile < tilesX * tilesY; tile = nextTile++)
+        {
+            rasterizeTile(tile);
+        }
+        lock.lock();
+
+        if (--workersBusy == 0)
+        {
+            workDoneCv.notify_one();
+        }
+    }
+}
+
+void RenderInterfaceSoftware::rasterizeTiles()
+{
+    const int tileCount = tilesX * tilesY;
+    if (threadCount <= 1)
+    {
+        for (int tile = 0; tile < tileCount; ++tile)
+        {
+            rasterizeTile(tile);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workMutex);
+        nextTile    = 0;
+        workersBusy = threadCount - 1;
+        ++frameSerial;
+    }
+    workStartCv.notify_all();
+
+    for (int tile = nextTile++; tile < tileCount; tile = nextTile++)
+    {
+        rasterizeTile(tile);
+    }
+
+    std::unique_lock<std::mutex> lock(workMutex);
+    workDoneCv.wait(lock, [this]() { return workersBusy == 0; });
+}
+
+// ========================================================
+// Frame recording:
+// ========================================================
+
+void RenderInterfaceSoftware::beginDraw()
+{
+    allocFramebuffer();
+    frameVerts.clear();
+    framePrims.clear();
+}
+
+void RenderInterfaceSoftware::endDraw()
+{
+    binPrimitives();
+    rasterizeTiles();
+
+    lastTriangleCount = 0;
+    lastLineCount     = 0;
+    for (int p = 0; p < framePrims.getSize(); ++p)
+    {
+        if (framePrims.get<SWPrimitive>(p).vertCount == 3)
+        {
+            ++lastTriangleCount;
+        }
+        else
+        {
+            ++lastLineCount;
+        }
+    }
+}
+
+DrawOrder RenderInterfaceSoftware::getDrawOrder() const
+{
+    // Without the depth test, the UI is layered by drawing it in order.
+    return drawWithDepth ? DrawOrder::DepthLayers : DrawOrder::Painter;
+}
+
+void RenderInterfaceSoftware::getViewport(int * viewportX, int * viewportY,
+                                          int * viewportW, int * viewportH) const
+{
+    NTB_ASSERT(viewportX != nullptr);
+    NTB_ASSERT(viewportY != nullptr);
+    NTB_ASSERT(viewportW != nullptr);
+    NTB_ASSERT(viewportH != nullptr);
+
+    (*viewportX) = 0;
+    (*viewportY) = 0;
+    (*viewportW) = fbWidth;
+    (*viewportH) = fbHeight;
+}
+
+void RenderInterfaceSoftware::draw2DLines(const VertexPC * verts, const int vertCount, int /* frameMaxZ */)
+{
+    NTB_ASSERT(verts != nullptr);
+    NTB_ASSERT(vertCount > 0);
+
+    for (int v = 0; v + 1 < vertCount; v += 2)
+    {
+        SWPrimitive prim;
+        prim.firstVert = frameVerts.getSize();
+        prim.vertCount = 2;
+        prim.texture   = nullptr;
+        prim.clipX0    = 0;
+        prim.clipY0    = 0;
+        prim.clipX1    = fbWidth;
+        prim.clipY1    = fbHeight;
+        framePrims.pushBack(prim);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            // Same -0.5 shift as the GL renderers' vertex shaders.
+            const VertexPC & in = verts[v + i];
+            const SWVertex out = { in.x - 0.5f, in.y - 0.5f, in.z, 0.0f, 0.0f, in.color };
+            frameVerts.pushBack(out);
+        }
+    }
+}
+
+void RenderInterfaceSoftware::draw2DTriangles(const VertexPTC * verts, const int vertCount,
+                                              const std::uint16_t * indexes, const int indexCount,
+                                              TextureHandle texture, int /* frameMaxZ */)
+{
+    NTB_ASSERT(verts   != nullptr);
+    NTB_ASSERT(indexes != nullptr);
+    NTB_ASSERT(vertCount  > 0);
+    NTB_ASSERT(indexCount > 0);
+
+    const SWRect fullscreen = { 0, 0, fbWidth, fbHeight };
+    addTriangles(verts, vertCount, indexes, indexCount, texture, fullscreen, fullscreen);
+}
+
+void RenderInterfaceSoftware::drawClipped2DTriangles(const VertexPTC * verts, const int vertCount,
+                                                     const std::uint16_t * indexes, const int indexCount,
+                                                     const DrawClippedInfo * drawInfo,
+                                                     const int drawInfoCount, int /* frameMaxZ */)
+{
+    NTB_ASSERT(verts    != nullptr);
+    NTB_ASSERT(indexes  != nullptr);
+    NTB_ASSERT(drawInfo != nullptr);
+
+    NTB_ASSERT(vertCount     > 0);
+    NTB_ASSERT(indexCount    > 0);
+    NTB_ASSERT(drawInfoCount > 0);
+
+    // Assert only.
+    (void)indexCount;
+
+    for (int i = 0; i < drawInfoCount; ++i)
+    {
+        const DrawClippedInfo & info = drawInfo[i];
+        NTB_ASSERT(info.firstIndex + info.indexCount <= indexCount);
+
+        const SWRect viewport = { info.viewportX, info.viewportY, info.viewportX + info.viewportW, info.viewportY + info.viewportH };
+        const SWRect clipBox  = { info.clipBoxX,  info.clipBoxY,  info.clipBoxX  + info.clipBoxW,  info.clipBoxY  + info.clipBoxH  };
+        addTriangles(verts, vertCount, indexes + info.firstIndex, info.indexCount, info.texture, viewport, clipBox);
+    }
+}
+
+void RenderInterfaceSoftware::addTriangles(const VertexPTC * verts, const int vertCount,
+                                           const std::uint16_t * indexes, const int indexCount,
+                                           TextureHandle texture, const SWRect & viewport, const SWRect & clipBox)
+{
+    // Pixels outside the viewport are also clipped, like the GL clip volume would.
+    SWPrimitive prim;
+    prim.vertCount = 3;
+    prim.texture   = reinterpret_cast<const SWTextureRecord *>(texture);
+    prim.clipX0    = std::max(std::max(clipBox.x0, viewport.x0), 0);
+    prim.clipY0    = std::max(std::max(clipBox.y0, viewport.y0), 0);
+    prim.clipX1    = std::min(std::min(clipBox.x1, viewport.x1), fbWidth);
+    prim.clipY1    = std::min(std::min(clipBox.y1, viewport.y1), fbHeight);
+
+    if (prim.clipX0 >= prim.clipX1 || prim.clipY0 >= prim.clipY1)
+    {
+        return;
+    }
+
+    // Vertexes are given relative to the whole framebuffer and
+    // squeezed into the viewport, same as glViewport would do.
+    const Float32 scaleX = static_cast<Float32>(viewport.x1 - viewport.x0) / fbWidth;
+    const Float32 scaleY = static_cast<Float32>(viewport.y1 - viewport.y0) / fbHeight;
+
+    for (int i = 0; i + 2 < indexCount; i += 3)
+    {
+        prim.firstVert = frameVerts.getSize();
+        framePrims.pushBack(prim);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            NTB_ASSERT(indexes[i + k] < vertCount);
+            (void)vertCount;
+
+            const VertexPTC & in = verts[indexes[i + k]];
+            const SWVertex out = {
+                viewport.x0 + (in.x - 0.5f) * scaleX,
+                viewport.y0 + (in.y - 0.5f) * scaleY,
+                in.z, in.u, in.v, in.color
+            };
+            frameVerts.pushBack(out);
+        }
+    }
+}
+
+// ========================================================
+// Binning and rasterization:
+// ========================================================
+
+void RenderInterfaceSoftware::binPrimitives()
+{
+    const int tileCount = tilesX * tilesY;
+    const int primCount = framePrims.getSize();
+    const SWVertex * verts = frameVerts.getData<SWVertex>();
+
+    tileFirstPrim.resize(tileCount + 1);
+    int * tileFirst = tileFirstPrim.getData<int>();
+    std::memset(tileFirst, 0, (tileCount + 1) * sizeof(int));
+
+    // Range of tiles touched by each primitive, bounding box clamped to its clip rect.
+    auto getTileRange = [this, verts](const SWPrimitive & prim, int & tx0, int & ty0, int & tx1, int & ty1) -> bool
+    {
+        Float32 minX = verts[prim.firstVert].x, maxX = minX;
+        Float32 minY = verts[prim.firstVert].y, maxY = minY;
+        for (int v = 1; v < prim.vertCount; ++v)
+        {
+            minX = std::min(minX, verts[prim.firstVert + v].x);
+            maxX = std::max(maxX, verts[prim.firstVert + v].x);
+            minY = std::min(minY, verts[prim.firstVert + v].y);
+            maxY = std::max(maxY, verts[prim.firstVert + v].y);
+        }
+
+        const int x0 = std::max(prim.clipX0, static_cast<int>(std::max(minX - 1.0f, -1.0f)));
+        const int y0 = std::max(prim.clipY0, static_cast<int>(std::max(minY - 1.0f, -1.0f)));
+        const int x1 = std::min(prim.clipX1, static_cast<int>(std::min(maxX + 2.0f, static_cast<Float32>(fbWidth))));
+        const int y1 = std::min(prim.clipY1, static_cast<int>(std::min(maxY + 2.0f, static_cast<Float32>(fbHeight))));
+        if (x0 >= x1 || y0 >= y1)
+        {
+            return false;
+        }
+
+        tx0 = x0 / kTileSize;
+        ty0 = y0 / kTileSize;
+        tx1 = (x1 - 1) / kTileSize;
+        ty1 = (y1 - 1) / kTileSize;
+        return true;
+    };
+
+    // Count pass, then a prefix sum into offsets, then the fill pass.
+    int tx0, ty0, tx1, ty1;
+    for (int p = 0; p < primCount; ++p)
+    {
+        if (getTileRange(framePrims.get<SWPrimitive>(p), tx0, ty0, tx1, ty1))
+        {
+            for (int ty = ty0; ty <= ty1; ++ty)
+            {
+                for (int tx = tx0; tx <= tx1; ++tx)
+                {
+                    tileFirst[(ty * tilesX) + tx + 1]++;
+                }
+            }
+        }
+    }
+
+    for (int t = 0; t < tileCount; ++t)
+    {
+        tileFirst[t + 1] += tileFirst[t];
+    }
+
+    tilePrims.resize(std::max(tileFirst[tileCount], 1));
+    int * binned = tilePrims.getData<int>();
+
+    for (int p = 0; p < primCount; ++p)
+    {
+        if (getTileRange(framePrims.get<SWPrimitive>(p), tx0, ty0, tx1, ty1))
+        {
+            for (int ty = ty0; ty <= ty1; ++ty)
+            {
+                for (int tx = tx0; tx <= tx1; ++tx)
+                {
+                    binned[tileFirst[(ty * tilesX) + tx]++] = p;
+                }
+            }
+        }
+    }
+
+    // The fill pass moved each offset to the start of the next tile.
+    for (int t = tileCount; t > 0; --t)
+    {
+        tileFirst[t] = tileFirst[t - 1];
+    }
+    tileFirst[0] = 0;
+}
+
+void RenderInterfaceSoftware::rasterizeTile(const int tileIndex)
+{
+    const int tx = tileIndex % tilesX;
+    const int ty = tileIndex / tilesX;
+
+    const SWRect tileRect = {
+        tx * kTileSize,
+        ty * kTileSize,
+        std::min((tx + 1) * kTileSize, fbWidth),
+        std::min((ty + 1) * kTileSize, fbHeight)
+    };
+
+    const int * tileFirst = tileFirstPrim.getData<int>();
+    const int * binned    = tilePrims.getData<int>();
+
+    for (int i = tileFirst[tileIndex]; i < tileFirst[tileIndex + 1]; ++i)
+    {
+        const SWPrimitive & prim = framePrims.get<SWPrimitive>(binned[i]);
+        const SWRect rect = {
+            std::max(tileRect.x0, prim.clipX0),
+            std::max(tileRect.y0, prim.clipY0),
+            std::min(tileRect.x1, prim.clipX1),
+            std::min(tileRect.y1, prim.clipY1)
+        };
+
+        if (prim.vertCount == 3)
+        {
+            rasterizeTriangle(prim, rect);
+        }
+        else
+        {
+            rasterizeLine(prim, rect);
+        }
+    }
+}
+
+void RenderInterfaceSoftware::rasterizeTriangle(const SWPrimitive & prim, const SWRect & rect)
+{
+    // 28.4 fixed-point vertex positions. Anything further than this is way off screen anyway.
+    const Float32 kMaxCoord = 65536.0f;
+    const SWVertex * v[3] = {
+        frameVerts.getData<SWVertex>() + prim.firstVert + 0,
+        frameVerts.getData<SWVertex>() + prim.firstVert + 1,
+        frameVerts.getData<SWVertex>() + prim.firstVert + 2
+    };
+
+    std::int64_t fx[3], fy[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        fx[i] = static_cast<std::int64_t>(std::floor(std::max(-kMaxCoord, std::min(v[i]->x, kMaxCoord)) * 16.0f + 0.5f));
+        fy[i] = static_cast<std::int64_t>(std::floor(std::max(-kMaxCoord, std::min(v[i]->y, kMaxCoord)) * 16.0f + 0.5f));
+    }
+
+    // No face culling; make the winding consistent instead.
+    std::int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) - (fy[1] - fy[0]) * (fx[2] - fx[0]);
+    if (area == 0)
+    {
+        return;
+    }
+    if (area < 0)
+    {
+        std::swap(v[1],  v[2]);
+        std::swap(fx[1], fx[2]);
+        std::swap(fy[1], fy[2]);
+        area = -area;
+    }
+
+    // Pixels whose centers fall inside the bounding box.
+    const std::int64_t minFX = std::min(fx[0], std::min(fx[1], fx[2]));
+    const std::int64_t maxFX = std::max(fx[0], std::max(fx[1], fx[2]));
+    const std::int64_t minFY = std::min(fy[0], std::min(fy[1], fy[2]));
+    const std::int64_t maxFY = std::max(fy[0], std::max(fy[1], fy[2]));
+
+    const int x0 = std::max(rect.x0, static_cast<int>((minFX - 8 + 15) >> 4));
+    const int y0 = std::max(rect.y0, static_cast<int>((minFY - 8 + 15) >> 4));
+    const int x1 = std::min(rect.x1, static_cast<int>(((maxFX - 8) >> 4) + 1));
+    const int y1 = std::min(rect.y1, static_cast<int>(((maxFY - 8) >> 4) + 1));
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    // Edge functions: w[e] > 0 inside, for edge e opposite to vertex e. Stepping one pixel
+    // changes them by stepX/stepY. Pixels exactly on an edge belong to only one of the
+    // triangles sharing it, with the same tie-breaking GL gets in its bottom-up window space.
+    std::int64_t stepX[3], stepY[3], rowW[3];
+    int bias[3];
+    const std::int64_t px = (static_cast<std::int64_t>(x0) << 4) + 8;
+    const std::int64_t py = (static_cast<std::int64_t>(y0) << 4) + 8;
+
+    for (int e = 0; e < 3; ++e)
+    {
+        const int a = (e + 1) % 3;
+        const int b = (e + 2) % 3;
+        const std::int64_t dx = fx[b] - fx[a];
+        const std::int64_t dy = fy[b] - fy[a];
+
+        stepX[e] = -dy * 16;
+        stepY[e] =  dx * 16;
+        rowW[e]  = dx * (py - fy[a]) - dy * (px - fx[a]);
+        bias[e]  = (dy < 0 || (dy == 0 && dx < 0)) ? 0 : -1;
+    }
+
+    const Float32 invArea = 1.0f / static_cast<Float32>(area);
+    const Float32 colors[3][4] = {
+        { byteToFloat((v[0]->color >> 16) & 0xFF), byteToFloat((v[0]->color >> 8) & 0xFF), byteToFloat(v[0]->color & 0xFF), byteToFloat(v[0]->color >> 24) },
+        { byteToFloat((v[1]->color >> 16) & 0xFF), byteToFloat((v[1]->color >> 8) & 0xFF), byteToFloat(v[1]->color & 0xFF), byteToFloat(v[1]->color >> 24) },
+        { byteToFloat((v[2]->color >> 16) & 0xFF), byteToFloat((v[2]->color >> 8) & 0xFF), byteToFloat(v[2]->color & 0xFF), byteToFloat(v[2]->color >> 24) }
+    };
+
+    auto shadeCovered = [&](const int x, const int y, const std::int64_t w0, const std::int64_t w1, const std::int64_t w2)
+    {
+        const Float32 l0 = static_cast<Float32>(w0) * invArea;
+        const Float32 l1 = static_cast<Float32>(w1) * invArea;
+        const Float32 l2 = static_cast<Float32>(w2) * invArea;
+
+        Float32 color[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            color[c] = (l0 * colors[0][c]) + (l1 * colors[1][c]) + (l2 * colors[2][c]);
+        }
+
+        shadePixel(x, y,
+                   (l0 * v[0]->z) + (l1 * v[1]->z) + (l2 * v[2]->z),
+                   (l0 * v[0]->u) + (l1 * v[1]->u) + (l2 * v[2]->u),
+                   (l0 * v[0]->v) + (l1 * v[1]->v) + (l2 * v[2]->v),
+                   color, prim.texture);
+    };
+
+    #if NTB_SOFTWARE_RENDERER_SSE2
+    // With the 28.4 positions, triangles under 1024 pixels on each side keep the edge
+    // functions well within 32-bits over their bounding box, so 4 pixels go per SSE2 step.
+    if ((maxFX - minFX) < (1024 << 4) && (maxFY - minFY) < (1024 << 4))
+    {
+        __m128i stepX4[3], laneOffs[3];
+        for (int e = 0; e < 3; ++e)
+        {
+            const int s = static_cast<int>(stepX[e]);
+            stepX4[e]   = _mm_set1_epi32(s * 4);
+            laneOffs[e] = _mm_setr_epi32(0, s, s * 2, s * 3);
+        }
+
+        for (int y = y0; y < y1; ++y)
+        {
+            __m128i w[3];
+            for (int e = 0; e < 3; ++e)
+            {
+                w[e] = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(rowW[e]) + bias[e]), laneOffs[e]);
+            }
+
+            for (int x = x0; x < x1; x += 4)
+            {
+                // Sign bit set in a lane if any edge function is negative there.
+                const __m128i outside = _mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]);
+                int covered = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+                if (x1 - x < 4)
+                {
+                    covered &= (1 << (x1 - x)) - 1;
+                }
+
+                while (covered != 0)
+                {
+                    const int lane = (covered & 1) ? 0 : (covered & 2) ? 1 : (covered & 4) ? 2 : 3;
+                    covered &= ~(1 << lane);
+
+                    const std::int64_t colOffs = static_cast<std::int64_t>(x - x0 + lane);
+                    shadeCovered(x + lane, y,
+                                 rowW[0] + colOffs * stepX[0],
+                                 rowW[1] + colOffs * stepX[1],
+                                 rowW[2] + colOffs * stepX[2]);
+                }
+
+                for (int e = 0; e < 3; ++e)
+                {
+                    w[e] = _mm_add_epi32(w[e], stepX4[e]);
+                }
+            }
+
+            for (int e = 0; e < 3; ++e)
+            {
+                rowW[e] += stepY[e];
+            }
+        }
+        return;
+    }
+    #endif // NTB_SOFTWARE_RENDERER_SSE2
+
+    for (int y = y0; y < y1; ++y)
+    {
+        std::int64_t w[3] = { rowW[0], rowW[1], rowW[2] };
+        for (int x = x0; x < x1; ++x)
+        {
+            if ((w[0] + bias[0]) >= 0 && (w[1] + bias[1]) >= 0 && (w[2] + bias[2]) >= 0)
+            {
+                shadeCovered(x, y, w[0], w[1], w[2]);
+            }
+            w[0] += stepX[0];
+            w[1] += stepX[1];
+            w[2] += stepX[2];
+        }
+
+        for (int e = 0; e < 3; ++e)
+        {
+            rowW[e] += stepY[e];
+        }
+    }
+}
+
+void RenderInterfaceSoftware::rasterizeLine(const SWPrimitive & prim, const SWRect & rect)
+{
+    // One pixel wide line, one pixel per column (or row) along the major axis.
+    // Like GL_LINES, the last endpoint is not drawn.
+    const SWVertex & a = frameVerts.get<SWVertex>(prim.firstVert + 0);
+    const SWVertex & b = frameVerts.get<SWVertex>(prim.firstVert + 1);
+
+    const Float32 dx = b.x - a.x;
+    const Float32 dy = b.y - a.y;
+    const bool xMajor = std::fabs(dx) >= std::fabs(dy);
+
+    const Float32 major0 = xMajor ? a.x : a.y;
+    const Float32 major1 = xMajor ? b.x : b.y;
+    const Float32 length = major1 - major0;
+    if (length == 0.0f)
+    {
+        return;
+    }
+
+    const Float32 colorA[4] = { byteToFloat((a.color >> 16) & 0xFF), byteToFloat((a.color >> 8) & 0xFF), byteToFloat(a.color & 0xFF), byteToFloat(a.color >> 24) };
+    const Float32 colorB[4] = { byteToFloat((b.color >> 16) & 0xFF), byteToFloat((b.color >> 8) & 0xFF), byteToFloat(b.color & 0xFF), byteToFloat(b.color >> 24) };
+
+    // Pixels whose centers are in [major0, major1) when going right/down, (major1, major0] otherwise.
+    const int step  = (length > 0.0f) ? 1 : -1;
+    const int first = (step > 0) ? static_cast<int>(std::ceil(major0 - 0.5f)) : static_cast<int>(std::floor(major0 - 0.5f));
+    const int last  = (step > 0) ? static_cast<int>(std::ceil(major1 - 0.5f)) : static_cast<int>(std::floor(major1 - 0.5f));
+
+    for (int m = first; m != last; m += step)
+    {
+        const Float32 t = ((static_cast<Float32>(m) + 0.5f) - major0) / length;
+        const Float32 minor = xMajor ? (a.y + t * dy) : (a.x + t * dx);
+        const int x = xMajor ? m : static_cast<int>(std::floor(minor));
+        const int y = xMajor ? static_cast<int>(std::floor(minor)) : m;
+
+        if (x < rect.x0 || x >= rect.x1 || y < rect.y0 || y >= rect.y1)
+        {
+            continue;
+        }
+
+        Float32 color[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            color[c] = colorA[c] + t * (colorB[c] - colorA[c]);
+        }
+        shadePixel(x, y, a.z + t * (b.z - a.z), 0.0f, 0.0f, color, nullptr);
+    }
+}
+
+void RenderInterfaceSoftware::shadePixel(const int x, const int y, const Float32 z, const Float32 u, const Float32 v,
+                                         const Float32 color[4], const SWTextureRecord * texture)
+{
+    // Same as the GL renderers: glDepthFunc(GL_GEQUAL), depth writes on,
+    // and glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) on all four channels.
+    const int pixel = (y * fbWidth) + x;
+    if (drawWithDepth)
+    {
+        if (z < depthBuffer[pixel])
+        {
+            return;
+        }
+        depthBuffer[pixel] = z;
+    }
+
+    Float32 src[4] = { color[0], color[1], color[2], color[3] };
+    if (texture != nullptr)
+    {
+        Float32 texel[4];
+        sampleTexture(texture, u, v, texel);
+        for (int c = 0; c < 4; ++c)
+        {
+            src[c] *= texel[c];
+        }
+    }
+
+    std::uint8_t * dst = colorBuffer + (pixel * 4);
+    const Float32 srcAlpha = std::max(0.0f, std::min(src[3], 1.0f));
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const Float32 blended = (src[c] * srcAlpha) + (byteToFloat(dst[c]) * (1.0f - srcAlpha));
+        dst[c] = static_cast<std::uint8_t>(std::max(0.0f, std::min(blended, 1.0f)) * 255.0f + 0.5f);
+    }
+}
+
+void RenderInterfaceSoftware::sampleTexture(const SWTextureRecord * texture, const Float32 u, const Float32 v, Float32 texel[4])
+{
+    // Bilinear filtering with clamp to edge (GL_LINEAR + GL_CLAMP_TO_EDGE).
+    const Float32 tx = (u * texture->width)  - 0.5f;
+    const Float32 ty = (v * texture->height) - 0.5f;
+    const Float32 fx = std::floor(tx);
+    const Float32 fy = std::floor(ty);
+    const Float32 wx = tx - fx;
+    const Float32 wy = ty - fy;
+
+    const int x0 = std::max(0, std::min(static_cast<int>(fx),     texture->width  - 1));
+    const int x1 = std::max(0, std::min(static_cast<int>(fx) + 1, texture->width  - 1));
+    const int y0 = std::max(0, std::min(static_cast<int>(fy),     texture->height - 1));
+    const int y1 = std::max(0, std::min(static_cast<int>(fy) + 1, texture->height - 1));
+
+    const std::uint8_t * p00 = texture->pixels + ((y0 * texture->width) + x0) * 4;
+    const std::uint8_t * p10 = texture->pixels + ((y0 * texture->width) + x1) * 4;
+    const std::uint8_t * p01 = texture->pixels + ((y1 * texture->width) + x0) * 4;
+    const std::uint8_t * p11 = texture->pixels + ((y1 * texture->width) + x1) * 4;
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const Float32 top    = byteToFloat(p00[c]) + wx * (byteToFloat(p10[c]) - byteToFloat(p00[c]));
+        const Float32 bottom = byteToFloat(p01[c]) + wx * (byteToFloat(p11[c]) - byteToFloat(p01[c]));
+        texel[c] = top + wy * (bottom - top);
+    }
+}
+
+// ========================================================
+// Textures:
+// ========================================================
+
+TextureHandle RenderInterfaceSoftware::createTexture(const int widthPixels, const int heightPixels,
+                                                     const int colorChannels, const void * pixels)
+{
+    NTB_ASSERT(widthPixels   >  0);
+    NTB_ASSERT(heightPixels  >  0);
+    NTB_ASSERT(colorChannels >  0);
+    NTB_ASSERT(colorChannels <= 4);
+    NTB_ASSERT(pixels != nullptr);
+
+    // Record and RGBA pixels in a single block.
+    const int recordSize = static_cast<int>((sizeof(SWTextureRecord) + 15) & ~15);
+    std::uint8_t * block = implAllocT<std::uint8_t>(MemoryTag::Renderer, recordSize + (widthPixels * heightPixels * 4));
+
+    SWTextureRecord * newTex = reinterpret_cast<SWTextureRecord *>(block);
+    newTex->width  = widthPixels;
+    newTex->height = heightPixels;
+    newTex->pixels = block + recordSize;
+    newTex->prev   = nullptr;
+    newTex->next   = nullptr;
+
+    // Expand to RGBA. Single channel textures are alpha-only (used by font bitmaps),
+    // same as the GL texture swizzle: RGB = 1, A = the channel.
+    const std::uint8_t * src = static_cast<const std::uint8_t *>(pixels);
+    for (int p = 0; p < widthPixels * heightPixels; ++p)
+    {
+        std::uint8_t * dst = newTex->pixels + (p * 4);
+        switch (colorChannels)
+        {
+        case 1 :
+            dst[0] = dst[1] = dst[2] = 255;
+            dst[3] = src[p];
+            break;
+        case 2 :
+            dst[0] = dst[1] = dst[2] = src[(p * 2) + 0];
+            dst[3] = src[(p * 2) + 1];
+            break;
+        case 3 :
+            dst[0] = src[(p * 3) + 0];
+            dst[1] = src[(p * 3) + 1];
+            dst[2] = src[(p * 3) + 2];
+            dst[3] = 255;
+            break;
+        default :
+            std::memcpy(dst, src + (p * 4), 4);
+            break;
+        } // switch (colorChannels)
+    }
+
+    textures.pushBack(newTex);
+    return reinterpret_cast<TextureHandle>(newTex);
+}
+
+void RenderInterfaceSoftware::destroyTexture(TextureHandle texture)
+{
+    if (texture == nullptr)
+    {
+        return;
+    }
+
+    SWTextureRecord * found = nullptr;
+    SWTextureRecord * iter  = textures.getFirst();
+
+    for (int count = textures.getSize(); count--; iter = iter->next)
+    {
+        if (iter == reinterpret_cast<const SWTextureRecord *>(texture))
+        {
+            found = iter;
+            break;
+        }
+    }
+
+    if (!found)
+    {
+        errorF("Software texture handle %p not allocated from this RenderInterface!",
+               reinterpret_cast<const void *>(texture));
+        return;
+    }
+
+    textures.unlink(found);
+    implFree(found);
+}
+
+void RenderInterfaceSoftware::freeAllTextures()
+{
+    textures.unlinkAndFreeAll();
+}
+
+// ========================================================
+// Image dumps:
+// ========================================================
+
+bool RenderInterfaceSoftware::savePPM(const char * filename) const
+{
+    NTB_ASSERT(filename != nullptr);
+    if (colorBuffer == nullptr)
+    {
+        errorF("Software renderer framebuffer not allocated yet!");
+        return false;
+    }
+
+    std::FILE * fp = std::fopen(filename, "wb");
+    if (fp == nullptr)
+    {
+        errorF("Unable to open \"%s\" for writing!", filename);
+        return false;
+    }
+
+    std::fprintf(fp, "P6\n%i %i\n255\n", fbWidth, fbHeight);
+
+    // One write per scanline, with the alpha stripped.
+    std::uint8_t * rowBuffer = implAllocT<std::uint8_t>(MemoryTag::Renderer, fbWidth * 3);
+    for (int y = 0; y < fbHeight; ++y)
+    {
+        const std::uint8_t * src = colorBuffer + (y * fbWidth * 4);
+        for (int x = 0; x < fbWidth; ++x)
+        {
+            rowBuffer[(x * 3) + 0] = src[(x * 4) + 0];
+            rowBuffer[(x * 3) + 1] = src[(x * 4) + 1];
+            rowBuffer[(x * 3) + 2] = src[(x * 4) + 2];
+        }
+        std::fwrite(rowBuffer, 1, fbWidth * 3, fp);
+    }
+    implFree(rowBuffer);
+
+    const bool ok = (std::ferror(fp) == 0);
+    std::fclose(fp);
+    return ok;
+}
+
+bool RenderInterfaceSoftware::savePNG(const char * filename) const
+{
+    NTB_ASSERT(filename != nullptr);
+    if (colorBuffer == nullptr)
+    {
+        errorF("Software renderer framebuffer not allocated yet!");
+        return false;
+    }
+
+    std::FILE * fp = std::fopen(filename, "wb");
+    if (fp == nullptr)
+    {
+        errorF("Unable to open \"%s\" for writing!", filename);
+        return false;
+    }
+
+    std::uint32_t crcTable[256];
+    for (std::uint32_t n = 0; n < 256; ++n)
+    {
+        std::uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+        {
+            c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        }
+        crcTable[n] = c;
+    }
+
+    std::uint32_t crc = 0;
+    auto crcBytes = [&crc, &crcTable](const std::uint8_t * bytes, const int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            crc = crcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        }
+    };
+    auto writeU32 = [fp](const std::uint32_t value)
+    {
+        const std::uint8_t bytes[4] = {
+            static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+            static_cast<std::uint8_t>(value >> 8),  static_cast<std::uint8_t>(value)
+        };
+        std::fwrite(bytes, 1, 4, fp);
+    };
+    // Chunk data is written and checksummed piecewise between begin and end.
+    auto beginChunk = [&](const char * type, const std::uint32_t length)
+    {
+        writeU32(length);
+        std::fwrite(type, 1, 4, fp);
+        crc = 0xFFFFFFFFu;
+        crcBytes(reinterpret_cast<const std::uint8_t *>(type), 4);
+    };
+    auto chunkData = [&](const std::uint8_t * bytes, const int count)
+    {
+        std::fwrite(bytes, 1, count, fp);
+        crcBytes(bytes, count);
+    };
+    auto endChunk = [&]()
+    {
+        writeU32(crc ^ 0xFFFFFFFFu);
+    };
+
+    static const std::uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(signature, 1, sizeof(signature), fp);
+
+    const std::uint8_t header[13] = {
+        static_cast<std::uint8_t>(fbWidth  >> 24), static_cast<std::uint8_t>(fbWidth  >> 16),
+        static_cast<std::uint8_t>(fbWidth  >> 8),  static_cast<std::uint8_t>(fbWidth),
+        static_cast<std::uint8_t>(fbHeight >> 24), static_cast<std::uint8_t>(fbHeight >> 16),
+        static_cast<std::uint8_t>(fbHeight >> 8),  static_cast<std::uint8_t>(fbHeight),
+        8, 6, 0, 0, 0 // 8-bits RGBA, deflate, no filtering, no interlacing.
+    };
+    beginChunk("IHDR", sizeof(header));
+    chunkData(header, sizeof(header));
+    endChunk();
+
+    // zlib stream of stored deflate blocks. Each scanline is prefixed by filter type 0.
+    const int rowBytes    = (fbWidth * 4) + 1;
+    const int rawSize     = rowBytes * fbHeight;
+    const int kBlockSize  = 65535;
+    const int blockCount  = (rawSize + kBlockSize - 1) / kBlockSize;
+    const std::uint32_t idatSize = 2 + (blockCount * 5) + rawSize + 4;
+
+    beginChunk("IDAT", idatSize);
+    const std::uint8_t zlibHeader[2] = { 0x78, 0x01 };
+    chunkData(zlibHeader, 2);
+
+    std::uint32_t adlerA = 1;
+    std::uint32_t adlerB = 0;
+    int rawOffset = 0;
+
+    // Each block is assembled with its header, then written at once.
+    std::uint8_t * blockBuffer = implAllocT<std::uint8_t>(MemoryTag::Renderer, 5 + kBlockSize);
+
+    for (int block = 0; block < blockCount; ++block)
+    {
+        const int size = std::min(kBlockSize, rawSize - rawOffset);
+        blockBuffer[0] = static_cast<std::uint8_t>((block == blockCount - 1) ? 1 : 0);
+        blockBuffer[1] = static_cast<std::uint8_t>(size & 0xFF);
+        blockBuffer[2] = static_cast<std::uint8_t>(size >> 8);
+        blockBuffer[3] = static_cast<std::uint8_t>(~size & 0xFF);
+        blockBuffer[4] = static_cast<std::uint8_t>((~size >> 8) & 0xFF);
+
+        // Copies the scanlines in spans, which can start and end mid-row.
+        std::uint8_t * dest = blockBuffer + 5;
+        for (int filled = 0; filled < size;)
+        {
+            const int row = (rawOffset + filled) / rowBytes;
+            const int col = (rawOffset + filled) % rowBytes;
+            if (col == 0)
+            {
+                dest[filled++] = 0; // Filter type.
+                continue;
+            }
+
+            const int span = std::min(rowBytes - col, size - filled);
+            std::memcpy(dest + filled, colorBuffer + (row * fbWidth * 4) + (col - 1), span);
+            filled += span;
+        }
+
+        for (int i = 0; i < size; ++i)
+        {
+            adlerA = (adlerA + dest[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+
+        chunkData(blockBuffer, 5 + size);
+        rawOffset += size;
+    }
+
+    implFree(blockBuffer);
+
+    const std::uint32_t adler = (adlerB << 16) | adlerA;
+    const std::uint8_t adlerBytes[4] = {
+        static_cast<std::uint8_t>(adler >> 24), static_cast<std::uint8_t>(adler >> 16),
+        static_cast<std::uint8_t>(adler >> 8),  static_cast<std::uint8_t>(adler)
+    };
+    chunkData(adlerBytes, 4);
+    endChunk();
+
+    beginChunk("IEND", 0);
+    endChunk();
+
+    const bool ok = (std::ferror(fp) == 0);
+    std::fclose(fp);
+    return ok;
+}
+
+int RenderInterfaceSoftware::compareWithPPM(const char * filename, const int tolerance) const
+{
+    NTB_ASSERT(filename != nullptr);
+    if (colorBuffer == nullptr)
+    {
+        errorF("Software renderer framebuffer not allocated yet!");
+        return -1;
+    }
+
+    std::FILE * fp = std::fopen(filename, "rb");
+    if (fp == nullptr)
+    {
+        errorF("Unable to open \"%s\" for reading!", filename);
+        return -1;
+    }
+
+    int w = 0, h = 0, maxVal = 0;
+    if (std::fscanf(fp, "P6 %i %i %i", &w, &h, &maxVal) != 3 || std::fgetc(fp) == EOF ||
+        w != fbWidth || h != fbHeight || maxVal != 255)
+    {
+        errorF("\"%s\" is not a %ix%i binary PPM image!", filename, fbWidth, fbHeight);
+        std::fclose(fp);
+        return -1;
+    }
+
+    int differing = 0;
+    for (int p = 0; p < fbWidth * fbHeight; ++p)
+    {
+        std::uint8_t rgb[3];
+        if (std::fread(rgb, 1, 3, fp) != 3)
+        {
+            errorF("\"%s\" is truncated!", filename);
+            std::fclose(fp);
+            return -1;
+        }
+
+        const std::uint8_t * ours = colorBuffer + (p * 4);
+        for (int c = 0; c < 3; ++c)
+        {
+            if (std::abs(static_cast<int>(rgb[c]) - static_cast<int>(ours[c])) > tolerance)
+            {
+                ++differing;
+                break;
+            }
+        }
+    }
+
+    std::fclose(fp);
+    return differing;
+}
+
+} // namespace ntb {}
+
+// ================ End of implementation =================
+#endif // NTB_DEFAULT_RENDERER_SOFTWARE
+// ================ End of implementation =================
@@ -12,6 +12,8 @@
 namespace ntb
 {
 
+AllocationStats g_allocationStats{};
+
 // ========================================================
 // Assorted helper functions:
 // ========================================================
@@ -20,20 +22,30 @@ std::uint32_t hashString(const char * cstr)
 {
     NTB_ASSERT(cstr != nullptr);
 
-    // Simple and fast One-at-a-Time (OAT) hash algorithm:
-    //  http://en.wikipedia.org/wiki/Jenkins_hash_function
-    //
-    std::uint32_t h = 0;
-    while (*cstr != '\0')
+    // Word-at-a-time version of hashStringCT() (same results). Needs the length
+    // upfront so the 8 bytes loads never read past the end of the string.
+    const int length = lengthOfString(cstr);
+    std::uint64_t h  = detail::hashSeed(length);
+
+    int remaining = length;
+    while (remaining >= 8)
     {
-        h += *cstr++;
-        h += (h << 10);
-        h ^= (h >>  6);
+        std::uint64_t word;
+        std::memcpy(&word, cstr, sizeof(word));
+        #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        word = __builtin_bswap64(word);
+        #endif // Big-endian
+        h = detail::hashWord(h, word);
+        cstr      += 8;
+        remaining -= 8;
     }
-    h += (h <<  3);
-    h ^= (h >> 11);
-    h += (h << 15);
-    return h;
+
+    if (remaining > 0)
+    {
+        h = detail::hashTail(h, detail::hashLoadBytes(cstr, remaining));
+    }
+
+    return detail::hashFinal(h);
 }
 
 int copyString(char * dest, int destSizeInChars, const char * source)
@@ -58,6 +70,47 @@ int copyString(char * dest, int destSizeInChars, const char * source)
     return static_cast<int>(ptr - dest - 1);
 }
 
+// Two ASCII digits for each value in [0,99], so decimal
+// conversions only need a divide for every two digits.
+static const char kDecimalDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+// Writes the decimal digits of 'number' backwards, ending right before 'end'.
+// Returns a pointer to the first (most significant) digit written.
+static char * writeDecimalDigitsBackwards(std::uint64_t number, char * end)
+{
+    while (number >= 100)
+    {
+        const int pair = static_cast<int>(number % 100) * 2;
+        number /= 100;
+        *--end = kDecimalDigitPairs[pair + 1];
+        *--end = kDecimalDigitPairs[pair];
+    }
+
+    if (number >= 10)
+    {
+        const int pair = static_cast<int>(number) * 2;
+        *--end = kDecimalDigitPairs[pair + 1];
+        *--end = kDecimalDigitPairs[pair];
+    }
+    else
+    {
+        *--end = static_cast<char>(number + '0');
+    }
+    return end;
+}
+
 bool intToString(std::uint64_t number, char * dest, const int destSizeInChars, const int numBase, const bool isNegative)
 {
     NTB_ASSERT(dest != nullptr);
@@ -72,70 +125,198 @@ bool intToString(std::uint64_t number, char * dest, const int destSizeInChars, c
         return errorF("Bad numeric base in ntb::intToString()!");
     }
 
-    char * ptr = dest;
-    int length = 0;
+    // Digits are written backwards from the end of this buffer, which fits
+    // the longest possible output: 64 binary digits of an unsigned 64-bits integer.
+    char digits[72];
+    char * const end = digits + sizeof(digits);
+    char * first;
 
-    if (numBase == 16)
+    if (numBase == 10)
     {
-        // Add an "0x" in front of hexadecimal values:
-        *ptr++ = '0';
-        *ptr++ = 'x';
-        length += 2;
+        // Negative decimal, so output '-' and negate.
+        // Other bases display the two's complement bit pattern instead.
+        if (isNegative)
+        {
+            number = 0 - number;
+        }
+
+        first = writeDecimalDigitsBackwards(number, end);
+
+        if (isNegative)
+        {
+            *--first = '-';
+        }
     }
     else
     {
-        if (isNegative && numBase == 10)
+        // Power of two bases can shift & mask instead of dividing.
+        const int shift = (numBase == 16) ? 4 : (numBase == 8) ? 3 : 1;
+        const std::uint64_t mask = static_cast<std::uint64_t>(numBase - 1);
+
+        first = end;
+        do
         {
-            // Negative decimal, so output '-' and negate:
-            length++;
-            *ptr++ = '-';
-            number = static_cast<std::uint64_t>(-static_cast<std::int64_t>(number));
+            *--first = kHexDigits[number & mask];
+            number >>= shift;
+        } while (number > 0);
+
+        if (numBase == 16)
+        {
+            // Add an "0x" in front of hexadecimal values:
+            *--first = 'x';
+            *--first = '0';
         }
     }
 
-    // Save pointer to the first digit so we can reverse the string later.
-    char * firstDigit = ptr;
+    // Check for buffer overflow. Return an empty string in such case.
+    const int length = static_cast<int>(end - first);
+    if (length >= destSizeInChars)
+    {
+        dest[0] = '\0';
+        return errorF("Buffer overflow in integer => string conversion!");
+    }
 
-    // Main conversion loop:
-    do
+    std::memcpy(dest, first, length);
+    dest[length] = '\0';
+
+    // Converted successfully.
+    return true;
+}
+
+int fixedFloatToString(const Float64 number, char * dest, const int destSizeInChars, const int decimals)
+{
+    NTB_ASSERT(dest != nullptr);
+    NTB_ASSERT(destSizeInChars > 0);
+
+    // Scale factor for each supported precision. Must fit in 32 bits (see below).
+    static const std::uint64_t kPowersOf10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+    if (decimals < 0 || decimals >= lengthOfArray(kPowersOf10))
+    {
+        return -1;
+    }
+
+    // Decompose the IEEE double into sign, exponent and 53-bits mantissa.
+    std::uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+
+    const bool isNegative   = (bits >> 63) != 0;
+    const int  biasedExp    = static_cast<int>((bits >> 52) & 0x7FF);
+    std::uint64_t mantissa  = bits & ((std::uint64_t(1) << 52) - 1);
+
+    if (biasedExp == 0x7FF)
     {
-        const int digitVal = number % numBase;
-        number /= numBase;
+        return -1; // Inf or NaN
+    }
 
-        // Convert to ASCII and store:
-        if (digitVal > 9)
+    int exponent;
+    if (biasedExp == 0) // Denormalized
+    {
+        exponent = 1 - 1075;
+    }
+    else
+    {
+        mantissa |= (std::uint64_t(1) << 52);
+        exponent = biasedExp - 1075;
+    }
+
+    // The exact value is mantissa * 2^exponent. Scaling that by 10^decimals and rounding to
+    // the nearest integer (ties to even) gives the exact digits printf("%.Nf") would print.
+    // mantissa < 2^53 and 10^decimals < 2^32, so the product fits in 85 bits (prodHi:prodLo).
+    const std::uint64_t scale  = kPowersOf10[decimals];
+    const std::uint64_t partLo = (mantissa & 0xFFFFFFFF) * scale;
+    const std::uint64_t partHi = (mantissa >> 32) * scale;
+    std::uint64_t prodLo = partLo + (partHi << 32);
+    std::uint64_t prodHi = (partHi >> 32) + (prodLo < partLo ? 1 : 0);
+
+    std::uint64_t scaled;
+    if (exponent >= 0)
+    {
+        // Integer values of 2^53 or more. Only if the shifted result still fits in 64 bits.
+        if (prodHi != 0 || exponent >= 64 || (exponent > 0 && (prodLo >> (64 - exponent)) != 0))
+        {
+            return -1;
+        }
+        scaled = prodLo << exponent;
+    }
+    else
+    {
+        const int shift = -exponent;
+        if (shift >= 128)
         {
-            *ptr++ = static_cast<char>((digitVal - 10) + 'A'); // A letter (hexadecimal)
+            scaled = 0; // Way below the precision requested; rounds to zero.
         }
         else
         {
-            *ptr++ = static_cast<char>(digitVal + '0'); // A digit
+            bool roundBit, stickyBits;
+            if (shift < 64)
+            {
+                if ((prodHi >> shift) != 0)
+                {
+                    return -1; // Doesn't fit in 64 bits.
+                }
+                scaled     = (prodLo >> shift) | (prodHi << (64 - shift));
+                roundBit   = ((prodLo >> (shift - 1)) & 1) != 0;
+                stickyBits = (prodLo & ((std::uint64_t(1) << (shift - 1)) - 1)) != 0;
+            }
+            else if (shift == 64)
+            {
+                scaled     = prodHi;
+                roundBit   = (prodLo >> 63) != 0;
+                stickyBits = (prodLo & ((std::uint64_t(1) << 63) - 1)) != 0;
+            }
+            else
+            {
+                const int hiShift = shift - 64;
+                scaled     = prodHi >> hiShift;
+                roundBit   = ((prodHi >> (hiShift - 1)) & 1) != 0;
+                stickyBits = prodLo != 0 || (prodHi & ((std::uint64_t(1) << (hiShift - 1)) - 1)) != 0;
+            }
+
+            if (roundBit && (stickyBits || (scaled & 1) != 0))
+            {
+                if (++scaled == 0)
+                {
+                    return -1; // Overflowed.
+                }
+            }
         }
-        ++length;
-    } while (number > 0 && length < destSizeInChars);
+    }
 
-    // Check for buffer overflow. Return an empty string in such case.
-    if (length >= destSizeInChars)
+    // Integer part, then the fractional digits padded with leading zeros.
+    char digits[48];
+    char * const end = digits + sizeof(digits);
+    char * first = end;
+
+    if (decimals > 0)
     {
-        dest[0] = '\0';
-        return errorF("Buffer overflow in integer => string conversion!");
+        const std::uint64_t fraction = scaled % scale;
+        first = writeDecimalDigitsBackwards(fraction, end);
+        while ((end - first) < decimals)
+        {
+            *--first = '0';
+        }
+        *--first = '.';
     }
 
-    *ptr-- = '\0';
+    first = writeDecimalDigitsBackwards(scaled / scale, first);
 
-    // We now have the digits of the number in the buffer,
-    // but in reverse order. So reverse the string now.
-    do
+    // printf keeps the sign of negative values that round to zero, so do we.
+    if (isNegative)
     {
-        const char tmp = *ptr;
-        *ptr = *firstDigit;
-        *firstDigit = tmp;
-        --ptr;
-        ++firstDigit;
-    } while (firstDigit < ptr);
+        *--first = '-';
+    }
 
-    // Converted successfully.
-    return true;
+    const int length = static_cast<int>(end - first);
+    if (length >= destSizeInChars)
+    {
+        return -1;
+    }
+
+    std::memcpy(dest, first, length);
+    dest[length] = '\0';
+    return length;
 }
 
 int decodeUtf8(const char * encodedBuffer, int * outCharLength)
@@ -440,17 +621,17 @@ void HLSToRGB(const Float32 hue, const Float32 light, const Float32 saturation,
 // class PODArray:
 // ========================================================
 
-PODArray::PODArray(const int itemSizeBytes)
+PODArray::PODArray(const int itemSizeBytes, const MemoryTag memTag)
 {
     // Default constructor creates an empty array.
     // First insertion will init with default capacity.
     // No memory is allocated until them.
-    initInternal(itemSizeBytes);
+    initInternal(itemSizeBytes, memTag);
 }
 
 PODArray::PODArray(const int itemSizeBytes, const int sizeInItems)
 {
-    initInternal(itemSizeBytes);
+    initInternal(itemSizeBytes, MemoryTag::PODArray);
     resize(sizeInItems);
     // New items are left uninitialized.
 }
@@ -460,13 +641,14 @@ PODArray::~PODArray()
     deallocate();
 }
 
-void PODArray::initInternal(const int itemSize)
+void PODArray::initInternal(const int itemSize, const MemoryTag memTag)
 {
-    // Can we fit the value in the 16 bits of m_itemSize?
-    NTB_ASSERT(itemSize <= UINT16_MAX);
+    // Can we fit the value in the 12 bits of m_itemSize?
+    NTB_ASSERT(itemSize > 0 && itemSize <= 4095);
     m_used     = 0;
     m_capacity = 0;
     m_itemSize = itemSize;
+    m_memTag   = static_cast<std::uint64_t>(memTag);
     m_basePtr  = nullptr;
 }
 
@@ -513,7 +695,7 @@ void PODArray::allocate(const int capacityHint)
                            (itemSize <= 8) ?  8 : 4;
 
     const int newCapacity = capacityHint + allocExtra;
-    std::uint8_t * newMemory = implAllocT<std::uint8_t>(newCapacity * itemSize);
+    std::uint8_t * newMemory = implAllocT<std::uint8_t>(MemoryTag(m_memTag), newCapacity * itemSize);
 
     // Preserve old data, if any:
     if (getSize() > 0)
@@ -533,7 +715,7 @@ void PODArray::allocateExact(const int capacityWanted)
     }
 
     const int itemSize = getItemSize();
-    std::uint8_t * newMemory  = implAllocT<std::uint8_t>(capacityWanted * itemSize);
+    std::uint8_t * newMemory  = implAllocT<std::uint8_t>(MemoryTag(m_memTag), capacityWanted * itemSize);
     if (getSize() > 0) // Preserve old data, if any:
     {
         std::memcpy(newMemory, m_basePtr, getSize() * itemSize);
@@ -566,6 +748,29 @@ void PODArray::resize(const int newSizeInItems)
     setSize(newSizeInItems);
 }
 
+void PODArray::append(const void * items, const int count)
+{
+    NTB_ASSERT(count >= 0);
+    if (count == 0)
+    {
+        return;
+    }
+
+    NTB_ASSERT(items != nullptr);
+    const int currSize = getSize();
+    const int newSize  = currSize + count;
+    if (newSize > getCapacity())
+    {
+        // Double the capacity, not the size. Arrays that are cleared and refilled
+        // every frame would otherwise regrow by just the few items they gained.
+        allocate(std::max(newSize, getCapacity() * 2));
+    }
+
+    const int itemSize = getItemSize();
+    std::memcpy(m_basePtr + (currSize * itemSize), items, count * itemSize);
+    setSize(newSize);
+}
+
 void PODArray::erase(const int index)
 {
     NTB_ASSERT(index >= 0 && index < getSize());
@@ -573,7 +778,7 @@ void PODArray::erase(const int index)
     const int newSize = getSize() - 1;
     if (newSize > 0) // If it wasn't the last item, we shift the remaining:
     {
-        const int remaining = newSize - (index + 1);
+        const int remaining = newSize - index;
         if (remaining > 0)
         {
             const int itemSize = getItemSize();
@@ -600,15 +805,345 @@ void PODArray::eraseSwap(const int index)
     setSize(newSize);
 }
 
+// ========================================================
+// class ObjectPool:
+// ========================================================
+
+// Alignment of the block header and object slots. Same as what malloc provides.
+static constexpr int kObjectPoolAlignment = 16;
+
+static int alignObjectPoolSize(const int size)
+{
+    return (size + (kObjectPoolAlignment - 1)) & ~(kObjectPoolAlignment - 1);
+}
+
+ObjectPool::ObjectPool(const int objectSizeBytes, const int blockObjectCount)
+    : blocks(nullptr)
+    , freeList(nullptr)
+    , stats()
+    , slotSize(alignObjectPoolSize(std::max(objectSizeBytes, int(sizeof(FreeSlot)))))
+    , objectsPerBlock(blockObjectCount)
+    , pooled(true)
+{
+    NTB_ASSERT(objectSizeBytes > 0);
+    NTB_ASSERT(blockObjectCount > 0);
+}
+
+ObjectPool::~ObjectPool()
+{
+    // Leaking the live objects is better than leaving them with dangling memory.
+    if (stats.liveObjects == 0)
+    {
+        releaseBlocks();
+    }
+}
+
+void * ObjectPool::allocate()
+{
+    if (stats.liveObjects == 0)
+    {
+        pooled = getShellInterface().usePooledObjectAllocation();
+    }
+
+    ++stats.totalAllocs;
+    ++stats.liveObjects;
+
+    if (!pooled)
+    {
+        return implAllocT<std::uint8_t>(MemoryTag::ObjectPool, slotSize);
+    }
+
+    if (freeList == nullptr)
+    {
+        allocateBlock();
+    }
+
+    FreeSlot * slot = freeList;
+    freeList = slot->next;
+    --stats.freeSlots;
+    return slot;
+}
+
+void ObjectPool::deallocate(void * ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    NTB_ASSERT(stats.liveObjects > 0);
+    ++stats.totalFrees;
+    --stats.liveObjects;
+
+    if (!pooled)
+    {
+        implFree(ptr);
+        return;
+    }
+
+    FreeSlot * slot = static_cast<FreeSlot *>(ptr);
+    slot->next = freeList;
+    freeList   = slot;
+    ++stats.freeSlots;
+}
+
+void ObjectPool::releaseBlocks()
+{
+    NTB_ASSERT(stats.liveObjects == 0);
+
+    while (blocks != nullptr)
+    {
+        Block * next = blocks->next;
+        implFree(blocks);
+        blocks = next;
+    }
+
+    freeList         = nullptr;
+    stats.freeSlots  = 0;
+    stats.blockCount = 0;
+    stats.blockBytes = 0;
+}
+
+void ObjectPool::allocateBlock()
+{
+    const int headerSize = alignObjectPoolSize(int(sizeof(Block)));
+    const int blockSize  = headerSize + (slotSize * objectsPerBlock);
+
+    std::uint8_t * memory = implAllocT<std::uint8_t>(MemoryTag::ObjectPool, blockSize);
+    Block * block = reinterpret_cast<Block *>(memory);
+    block->next = blocks;
+    blocks = block;
+
+    // Thread the new slots into the free list, in address order.
+    std::uint8_t * firstSlot = memory + headerSize;
+    for (int i = objectsPerBlock - 1; i >= 0; --i)
+    {
+        FreeSlot * slot = reinterpret_cast<FreeSlot *>(firstSlot + (i * slotSize));
+        slot->next = freeList;
+        freeList   = slot;
+    }
+
+    stats.freeSlots  += objectsPerBlock;
+    stats.blockCount += 1;
+    stats.blockBytes += blockSize;
+}
+
+// ========================================================
+// class FrameArena:
+// ========================================================
+
+// Size of the first block, allocated on demand. Enough
+// for the value strings of a few dozen long variables.
+static constexpr int kFrameArenaInitialSize = 4096;
+
+FrameArena * FrameArena::current = nullptr;
+
+FrameArena::FrameArena()
+    : block(nullptr)
+    , spills(nullptr)
+    , blockSize(0)
+    , used(0)
+    , highWater(0)
+    , heapAllocs(0)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    NTB_ASSERT(current != this);
+    releaseMemory();
+}
+
+void * FrameArena::allocate(const int sizeBytes)
+{
+    NTB_ASSERT(sizeBytes > 0);
+
+    if (block == nullptr)
+    {
+        blockSize = kFrameArenaInitialSize;
+        block = implAllocT<std::uint8_t>(MemoryTag::FrameArena, blockSize);
+        ++heapAllocs;
+    }
+
+    const int alignedSize = alignObjectPoolSize(sizeBytes);
+    const int offset = used;
+
+    used += alignedSize;
+    highWater = std::max(highWater, used);
+
+    if (used <= blockSize)
+    {
+        return block + offset;
+    }
+
+    // Out of space. Spill to the heap until reset() regrows the block.
+    const int headerSize = alignObjectPoolSize(int(sizeof(Spill)));
+    std::uint8_t * memory = implAllocT<std::uint8_t>(MemoryTag::FrameArena, headerSize + alignedSize);
+    ++heapAllocs;
+
+    Spill * spill = reinterpret_cast<Spill *>(memory);
+    spill->next = spills;
+    spills = spill;
+
+    return memory + headerSize;
+}
+
+void FrameArena::reset()
+{
+    while (spills != nullptr)
+    {
+        Spill * next = spills->next;
+        implFree(spills);
+        spills = next;
+    }
+
+    // Regrow with some slack, so a frame slightly busier than
+    // the worst one seen so far doesn't spill straight away.
+    if (highWater > blockSize)
+    {
+        implFree(block);
+        blockSize = alignObjectPoolSize(highWater + (highWater / 2));
+        block = implAllocT<std::uint8_t>(MemoryTag::FrameArena, blockSize);
+        ++heapAllocs;
+    }
+
+    used = 0;
+}
+
+void FrameArena::releaseMemory()
+{
+    while (spills != nullptr)
+    {
+        Spill * next = spills->next;
+        implFree(spills);
+        spills = next;
+    }
+
+    implFree(block);
+    block     = nullptr;
+    blockSize = 0;
+    used      = 0;
+    highWater = 0;
+}
+
+// ========================================================
+// class HashIndex:
+// ========================================================
+
+HashIndex::HashIndex()
+    : slots(nullptr)
+    , capacity(0)
+    , count(0)
+    , stale(false)
+{
+}
+
+HashIndex::~HashIndex()
+{
+    deallocate();
+}
+
+void HashIndex::insert(const std::uint32_t hashCode, void * item)
+{
+    NTB_ASSERT(item != nullptr);
+
+    // Keep the load factor under 1/2 so the probe sequences stay short.
+    if ((count + 1) * 2 > capacity)
+    {
+        grow();
+    }
+
+    const int mask = capacity - 1;
+    int slot = static_cast<int>(hashCode & mask);
+    while (slots[slot].item != nullptr)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    slots[slot].item     = item;
+    slots[slot].hashCode = hashCode;
+    ++count;
+}
+
+void HashIndex::clear()
+{
+    if (slots != nullptr)
+    {
+        std::memset(slots, 0, capacity * sizeof(Slot));
+    }
+    count = 0;
+    stale = false;
+}
+
+void HashIndex::deallocate()
+{
+    implFree(slots);
+    slots    = nullptr;
+    capacity = 0;
+    count    = 0;
+    stale    = false;
+}
+
+int HashIndex::findFirst(const std::uint32_t hashCode) const
+{
+    if (count == 0)
+    {
+        return -1;
+    }
+    return findFrom(static_cast<int>(hashCode & (capacity - 1)), hashCode);
+}
+
+int HashIndex::findNext(const int slot, const std::uint32_t hashCode) const
+{
+    NTB_ASSERT(slot >= 0 && slot < capacity);
+    return findFrom((slot + 1) & (capacity - 1), hashCode);
+}
+
+int HashIndex::findFrom(int slot, const std::uint32_t hashCode) const
+{
+    // An empty slot ends the probe sequence.
+    const int mask = capacity - 1;
+    while (slots[slot].item != nullptr)
+    {
+        if (slots[slot].hashCode == hashCode)
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+void HashIndex::grow()
+{
+    Slot * const oldSlots    = slots;
+    const int    oldCapacity = capacity;
+
+    capacity = (oldCapacity > 0) ? (oldCapacity * 2) : 16;
+    slots    = implAllocT<Slot>(MemoryTag::HashIndex, capacity);
+    std::memset(slots, 0, capacity * sizeof(Slot));
+    count    = 0;
+
+    for (int i = 0; i < oldCapacity; ++i)
+    {
+        if (oldSlots[i].item != nullptr)
+        {
+            insert(oldSlots[i].hashCode, oldSlots[i].item);
+        }
+    }
+    implFree(oldSlots);
+}
+
 // ========================================================
 // class SmallStr:
 // ========================================================
 
 void SmallStr::initInternal(const char * str, const int len)
 {
-    m_length   =  0;
-    m_maxSize  = -1;
-    m_capacity = sizeof(m_backingStore);
+    m_length    =  0;
+    m_maxSize   = -1;
+    m_capacity  = sizeof(m_backingStore);
+    m_transient = false;
     std::memset(&m_backingStore, 0, sizeof(m_backingStore));
 
     if (str != nullptr)
@@ -625,21 +1160,33 @@ void SmallStr::reallocInternal(int newCapacity, const bool preserveOldStr)
     // avoid more allocations if the string grows again in the future.
     // This can be tuned for environments with more limited memory.
     newCapacity += 64;
-    char * newMemory = implAllocT<char>(newCapacity);
+
+    // Transient strings outside a frame fall back to the heap and stay there.
+    FrameArena * arena = isTransient() ? FrameArena::getCurrent() : nullptr;
+    char * newMemory = (arena != nullptr) ? static_cast<char *>(arena->allocate(newCapacity)) : implAllocT<char>(MemoryTag::SmallStr, newCapacity);
 
     if (preserveOldStr)
     {
         std::memcpy(newMemory, c_str(), getLength() + 1);
     }
-    if (isDyn)
+    if (isDyn && !isTransient())
     {
         implFree(m_backingStore.dynamic);
     }
 
-    m_capacity = newCapacity;
+    m_capacity  = newCapacity;
+    m_transient = (arena != nullptr);
     m_backingStore.dynamic = newMemory;
 }
 
+SmallStr SmallStr::makeTransient(const char * str)
+{
+    SmallStr result;
+    result.markTransient();
+    result.set(str);
+    return result;
+}
+
 void SmallStr::set(const char * str, const int len)
 {
     NTB_ASSERT(str != nullptr);
@@ -824,6 +1371,26 @@ void SmallStr::clear()
     c_str()[0] = '\0';
 }
 
+// Precision of a "%f" or "%.Nf" printf format (N a single digit), or -1 if it is anything else.
+static int parseFixedFloatFormat(const char * format)
+{
+    NTB_ASSERT(format != nullptr);
+
+    if (format[0] != '%')
+    {
+        return -1;
+    }
+    if (format[1] == 'f' && format[2] == '\0')
+    {
+        return 6; // printf default
+    }
+    if (format[1] == '.' && format[2] >= '0' && format[2] <= '9' && format[3] == 'f' && format[4] == '\0')
+    {
+        return format[2] - '0';
+    }
+    return -1;
+}
+
 SmallStr SmallStr::fromPointer(const void * const ptr, const int base)
 {
     // Hexadecimal is the default for pointers.
@@ -838,7 +1405,7 @@ SmallStr SmallStr::fromPointer(const void * const ptr, const int base)
         char buffer[NumConvBufSize];
         std::snprintf(buffer, sizeof(buffer), "0x%0*zX", width, addr);
         buffer[sizeof(buffer) - 1] = '\0';
-        return buffer;
+        return makeTransient(buffer);
     }
     else
     {
@@ -851,9 +1418,15 @@ SmallStr SmallStr::fromNumber(const Float64 num, const int base, const char * co
 {
     if (base == 10)
     {
+        // The "%f" and "%.Nf" formats used by the UI go through the fast formatter.
+        // Anything else it can't handle exactly like printf falls back to snprintf.
         char buffer[NumConvBufSize];
-        std::snprintf(buffer, sizeof(buffer), format, num);
-        buffer[sizeof(buffer) - 1] = '\0';
+        const int decimals = parseFixedFloatFormat(format);
+        if (decimals < 0 || fixedFloatToString(num, buffer, sizeof(buffer), decimals) < 0)
+        {
+            std::snprintf(buffer, sizeof(buffer), format, num);
+            buffer[sizeof(buffer) - 1] = '\0';
+        }
 
         // Trim trailing zeros to the right of the decimal point:
         for (char * ptr = buffer; *ptr != '\0'; ++ptr)
@@ -875,7 +1448,7 @@ SmallStr SmallStr::fromNumber(const Float64 num, const int base, const char * co
             }
             break;
         }
-        return buffer;
+        return makeTransient(buffer);
     }
     else
     {
@@ -894,21 +1467,23 @@ SmallStr SmallStr::fromNumber(const std::int64_t num, const int base)
 {
     char buffer[NumConvBufSize];
     intToString(static_cast<std::uint64_t>(num), buffer, sizeof(buffer), base, (num < 0));
-    return buffer;
+    return makeTransient(buffer);
 }
 
 SmallStr SmallStr::fromNumber(const std::uint64_t num, const int base)
 {
     char buffer[NumConvBufSize];
     intToString(num, buffer, sizeof(buffer), base, false);
-    return buffer;
+    return makeTransient(buffer);
 }
 
 SmallStr SmallStr::fromFloatVec(const Float32 vec[], const int elemCount, const char * const prefix, const char * const format)
 {
     NTB_ASSERT(elemCount > 0);
 
-    SmallStr str(prefix);
+    SmallStr str;
+    str.markTransient();
+    str += prefix;
     str += "{";
     for (int i = 0; i < elemCount; ++i)
     {
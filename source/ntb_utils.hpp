@@ -39,6 +39,7 @@ namespace ntb
 std::uint32_t hashString(const char * cstr);
 int copyString(char * dest, int destSizeInChars, const char * source);
 bool intToString(std::uint64_t number, char * dest, int destSizeInChars, int numBase, bool isNegative);
+int fixedFloatToString(Float64 number, char * dest, int destSizeInChars, int decimals); // -1 if not handled.
 int decodeUtf8(const char * encodedBuffer, int * outCharLength);
 
 template<int Size>
@@ -88,11 +89,20 @@ void HLSToRGB(Float32 hue, Float32 light, Float32 saturation, Float32 & fR, Floa
 // Internal memory allocator:
 // ========================================================
 
+// Counters of every implAllocT() call, by the subsystem that made it.
+extern AllocationStats g_allocationStats;
+
 template<typename T>
-inline T * implAllocT(const std::uint32_t countInItems = 1)
+inline T * implAllocT(const MemoryTag tag, const std::uint32_t countInItems = 1)
 {
     NTB_ASSERT(countInItems != 0);
-    return static_cast<T *>(getShellInterface().memAlloc(countInItems * sizeof(T)));
+    NTB_ASSERT(tag < MemoryTag::Count);
+
+    const std::uint32_t sizeInBytes = countInItems * sizeof(T);
+    g_allocationStats.allocCount[int(tag)] += 1;
+    g_allocationStats.allocBytes[int(tag)] += sizeInBytes;
+
+    return static_cast<T *>(getShellInterface().memAlloc(sizeInBytes));
 }
 
 inline void implFree(void * ptrToFree)
@@ -118,6 +128,136 @@ inline void destroy(T * obj)
     }
 }
 
+// ========================================================
+// class ObjectPool:
+// ========================================================
+
+// Fixed-size object allocator that hands out slots from blocks
+// of contiguous memory, recycling freed slots with a free list.
+// Blocks are only returned to the ShellInterface by releaseBlocks(),
+// once the pool has no live objects. If the ShellInterface opts out
+// of pooling (usePooledObjectAllocation), objects are allocated
+// individually with implAllocT instead, but still counted in the stats.
+class ObjectPool final
+{
+public:
+
+    ObjectPool(int objectSizeBytes, int blockObjectCount);
+    ~ObjectPool();
+
+    // Not copyable.
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool & operator = (const ObjectPool &) = delete;
+
+    // Uninitialized memory for one object. Use with construct/destroy.
+    void * allocate();
+    void deallocate(void * ptr);
+
+    // Frees all blocks. The pool must not have any live objects.
+    void releaseBlocks();
+
+    ObjectPoolStats getStats() const { return stats; }
+
+private:
+
+    // Header at the start of each block, followed by the object slots.
+    struct Block
+    {
+        Block * next;
+    };
+
+    // Free slots store the link to the next free one.
+    struct FreeSlot
+    {
+        FreeSlot * next;
+    };
+
+    void allocateBlock();
+
+    Block *         blocks;
+    FreeSlot *      freeList;
+    ObjectPoolStats stats;
+    int             slotSize;        // Object size rounded up to the alignment.
+    int             objectsPerBlock;
+    bool            pooled;          // Decided when the pool has no live objects.
+};
+
+template<typename T>
+inline T * poolAllocT(ObjectPool & pool)
+{
+    return static_cast<T *>(pool.allocate());
+}
+
+// ========================================================
+// class FrameArena:
+// ========================================================
+
+// Linear allocator for memory that only lives during a frame,
+// such as the temporary strings used to format variable values.
+// Allocating just bumps an offset into a single block, nothing is
+// freed individually, and reset() rewinds the whole block at once.
+// When the block runs out, allocations spill to implAllocT and the
+// block is regrown to the frame's high-water mark on the next reset(),
+// so once the UI settles a frame makes no heap allocations at all.
+class FrameArena final
+{
+public:
+
+    FrameArena();
+    ~FrameArena();
+
+    // Not copyable.
+    FrameArena(const FrameArena &) = delete;
+    FrameArena & operator = (const FrameArena &) = delete;
+
+    // Uninitialized memory valid until the next reset().
+    void * allocate(int sizeBytes);
+
+    // Invalidates everything allocated since the last reset.
+    void reset();
+
+    // Frees the block and any spilled allocations.
+    void releaseMemory();
+
+    int getBlockSize()      const { return blockSize;  }
+    int getHighWaterMark()  const { return highWater;  }
+    int getHeapAllocCount() const { return heapAllocs; } // implAllocT calls made by the arena so far.
+
+    // The arena transient SmallStrs take memory from, or null if not inside a frame.
+    static FrameArena * getCurrent() { return current; }
+
+    // Makes an arena the current one for the lifetime of the scope.
+    class Scope final
+    {
+    public:
+        explicit Scope(FrameArena & arena) : previous(current) { current = &arena; }
+        ~Scope() { current = previous; }
+
+        Scope(const Scope &) = delete;
+        Scope & operator = (const Scope &) = delete;
+
+    private:
+        FrameArena * previous;
+    };
+
+private:
+
+    // Allocations that didn't fit in the block.
+    struct Spill
+    {
+        Spill * next;
+    };
+
+    std::uint8_t * block;
+    Spill *        spills;
+    int            blockSize;
+    int            used;       // Bytes used from the block, including spills.
+    int            highWater;  // Max bytes used between two resets.
+    int            heapAllocs;
+
+    static FrameArena * current;
+};
+
 // ========================================================
 // class PODArray:
 // ========================================================
@@ -140,7 +280,8 @@ class PODArray final
 public:
 
     // Constructor must receive the size in bytes of the stored type.
-    explicit PODArray(int itemSizeBytes);
+    // The tag is the subsystem the memory is accounted to (see AllocationStats).
+    explicit PODArray(int itemSizeBytes, MemoryTag memTag = MemoryTag::PODArray);
     PODArray(int itemSizeBytes, int sizeInItems);
 
     // Not copyable.
@@ -196,6 +337,10 @@ public:
         setSize(currSize + 1);
     }
 
+    // Append 'count' items copied from 'items', which must have the same
+    // item size of the array. Reallocations grow like pushBack().
+    void append(const void * items, int count);
+
     // Decrement size by one, removing element at the end of the array.
     void popBack()
     {
@@ -276,7 +421,7 @@ public:
 
 private:
 
-    void initInternal(int itemSize);
+    void initInternal(int itemSize, MemoryTag memTag);
     void setNewStorage(std::uint8_t * newMemory);
 
     void setSize(const int amount)     { m_used     = amount; }
@@ -289,11 +434,12 @@ private:
     // PODArray total size should not be beyond
     // 16 bytes on a 64-bits architecture.
     //
-    // Max item size is UINT16_MAX bytes (16-bits)
+    // Max item size is 4095 bytes (12-bits)
     //
     std::uint64_t m_used     : 24; // Slots used by items.
     std::uint64_t m_capacity : 24; // Total slots allocated.
-    std::uint64_t m_itemSize : 16; // Size in bytes of each item.
+    std::uint64_t m_itemSize : 12; // Size in bytes of each item.
+    std::uint64_t m_memTag   : 4;  // MemoryTag for the allocations.
 
     // Pointer to first slot.
     std::uint8_t * m_basePtr;
@@ -301,17 +447,99 @@ private:
 
 static_assert(sizeof(PODArray) <= 16, "Unexpected size for ntb::PODArray!");
 
+// ========================================================
+// class HashIndex:
+// ========================================================
+
+// Open addressing hash table (linear probing) mapping the hashString()
+// codes of named items (GUIs, Panels, Variables) to the items themselves.
+// It is kept alongside the PODArray that owns the items to make the lookups
+// by name or hash code constant time. Removals don't patch the table, they
+// just invalidate() it, and it is rebuilt from the array on the next lookup.
+class HashIndex final
+{
+public:
+
+     HashIndex();
+    ~HashIndex();
+
+    // Not copyable.
+    HashIndex(const HashIndex &) = delete;
+    HashIndex & operator = (const HashIndex &) = delete;
+
+    // Adds an item. Different items can have the same hash code.
+    void insert(std::uint32_t hashCode, void * item);
+
+    // Empties the index, but keeps the memory. Also clears the stale flag.
+    void clear();
+
+    // Frees all memory and empties the index.
+    void deallocate();
+
+    // Flags the index as out-of-date with its array, e.g.: after an item was
+    // removed or renamed. findItemByName/findItemByHashCode will rebuild it.
+    void invalidate() { stale = true; }
+    bool isStale() const { return stale; }
+
+    // Slot of the first/next item with the given hash code, or -1 if there are no more.
+    int findFirst(std::uint32_t hashCode) const;
+    int findNext(int slot, std::uint32_t hashCode) const;
+
+    void * getItem(const int slot) const
+    {
+        NTB_ASSERT(slot >= 0 && slot < capacity);
+        return slots[slot].item;
+    }
+
+    int getSize()     const { return count;    }
+    int getCapacity() const { return capacity; }
+
+private:
+
+    struct Slot
+    {
+        void *        item; // Null for empty slots.
+        std::uint32_t hashCode;
+    };
+
+    void grow();
+    int findFrom(int slot, std::uint32_t hashCode) const;
+
+    Slot * slots;
+    int    capacity; // Always a power of two.
+    int    count;
+    bool   stale;
+};
+
 // ========================================================
 // PODArray utils:
 // ========================================================
 
 template<typename T>
-inline T findItemByName(const PODArray & arr, const char * name)
+inline void rebuildHashIndex(const PODArray & arr, HashIndex & index)
 {
+    index.clear();
     const int count = arr.getSize();
     for (int i = 0; i < count; ++i)
     {
         T item = arr.get<T>(i);
+        index.insert(item->getHashCode(), item);
+    }
+}
+
+template<typename T>
+inline T findItemByName(const PODArray & arr, HashIndex & index, const char * name)
+{
+    if (index.isStale())
+    {
+        rebuildHashIndex<T>(arr, index);
+    }
+
+    // Items with colliding hash codes are told apart by the name.
+    const std::uint32_t hashCode = hashString(name);
+    for (int slot = index.findFirst(hashCode); slot >= 0; slot = index.findNext(slot, hashCode))
+    {
+        T item = static_cast<T>(index.getItem(slot));
         if (stringsEqual(item->getName(), name))
         {
             return item;
@@ -321,22 +549,19 @@ inline T findItemByName(const PODArray & arr, const char * name)
 }
 
 template<typename T>
-inline T findItemByHashCode(const PODArray & arr, const std::uint32_t hashCode)
+inline T findItemByHashCode(const PODArray & arr, HashIndex & index, const std::uint32_t hashCode)
 {
-    const int count = arr.getSize();
-    for (int i = 0; i < count; ++i)
+    if (index.isStale())
     {
-        T item = arr.get<T>(i);
-        if (item->getHashCode() == hashCode)
-        {
-            return item;
-        }
+        rebuildHashIndex<T>(arr, index);
     }
-    return nullptr;
+
+    const int slot = index.findFirst(hashCode);
+    return (slot >= 0) ? static_cast<T>(index.getItem(slot)) : nullptr;
 }
 
 template<typename T, typename U>
-inline bool eraseAndDestroyItem(PODArray & arr, U item)
+inline bool eraseAndDestroyItem(PODArray & arr, U item, ObjectPool & pool)
 {
     int eraseIndex = -1;
     const int count = arr.getSize();
@@ -352,9 +577,10 @@ inline bool eraseAndDestroyItem(PODArray & arr, U item)
 
     if (eraseIndex >= 0)
     {
+        T itemToDestroy = arr.get<T>(eraseIndex);
         arr.eraseSwap(eraseIndex);
-        destroy(item);
-        implFree(item);
+        destroy(itemToDestroy);
+        pool.deallocate(itemToDestroy);
         return true;
     }
 
@@ -362,17 +588,18 @@ inline bool eraseAndDestroyItem(PODArray & arr, U item)
 }
 
 template<typename T>
-inline void destroyAllItems(PODArray & arr)
+inline void destroyAllItems(PODArray & arr, ObjectPool & pool)
 {
     const int count = arr.getSize();
     for (int i = 0; i < count; ++i)
     {
         T item = arr.get<T>(i);
         destroy(item);
-        implFree(item);
+        pool.deallocate(item);
     }
 
     arr.deallocate();
+    pool.releaseBlocks();
 }
 
 // ========================================================
@@ -395,7 +622,8 @@ public:
     }
     ~SmallStr()
     {
-        if (isDynamic())
+        // Transient memory belongs to the FrameArena.
+        if (isDynamic() && !isTransient())
         {
             implFree(m_backingStore.dynamic);
         }
@@ -493,6 +721,18 @@ public:
     int  getLength()   const { return m_length;      }
     int  getCapacity() const { return m_capacity;    }
     int  getMaxSize()  const { return m_maxSize;     }
+    bool isTransient() const { return m_transient;   }
+
+    // Transient strings take their dynamic memory from the current
+    // FrameArena instead of the heap, if a frame is in progress. Only
+    // meant for temporaries that die before the frame ends. A copy
+    // of a transient string is a normal string. Must be called while
+    // the string is still using the inline buffer.
+    void markTransient()
+    {
+        NTB_ASSERT(!isDynamic());
+        m_transient = true;
+    }
 
     // String manipulation:
     void set(const char * str, int len);
@@ -505,6 +745,7 @@ public:
     void clear();
 
     // Covert numbers/pointers/vectors to string:
+    // (results are transient, copy them to keep them past the frame)
     static SmallStr fromPointer(const void * ptr, int base = 16);
     static SmallStr fromNumber(Float64 num, int base = 10, const char * format = "%f");
     static SmallStr fromNumber(std::int64_t num, int base = 10);
@@ -514,6 +755,7 @@ public:
 private:
 
     void initInternal(const char * str, int len);
+    static SmallStr makeTransient(const char * str);
     void reallocInternal(int newCapacity, bool preserveOldStr);
 
     // For the number => string converters.
@@ -523,7 +765,7 @@ private:
     // Bitfield used here to avoid additional
     // unnecessary padding and because we don't
     // really need the full range of an integer
-    // for SmallStr. So the 3 fields are packed
+    // for SmallStr. So the 4 fields are packed
     // into 64-bits, making the total structure
     // size = 48 bytes.
     // m_maxSize limit is INT16_MAX (16-bits with sign).
@@ -532,10 +774,11 @@ private:
     // and sizes of Panel string variables, which are
     // actually already capped to 256 chars anyways.
     //
-    std::uint64_t m_length   : 24; // Chars used in string, not counting a '\0' at the end.
-    std::uint64_t m_capacity : 24; // Total chars available for use.
-    std::int64_t  m_maxSize  : 16; // Max size (counting the '\0') that this string is allowed to have.
-                                   // If -1, can have any size. This is only used by the UI text fields.
+    std::uint64_t m_length    : 24; // Chars used in string, not counting a '\0' at the end.
+    std::uint64_t m_capacity  : 23; // Total chars available for use.
+    std::uint64_t m_transient : 1;  // Takes dynamic memory from the FrameArena. See markTransient().
+    std::int64_t  m_maxSize   : 16; // Max size (counting the '\0') that this string is allowed to have.
+                                    // If -1, can have any size. This is only used by the UI text fields.
 
     // Either we are using the small fixed-size buffer
     // or the 'dynamic' field which is heap allocated.
@@ -934,6 +1177,14 @@ struct Rectangle
         xMaxs = std::max(xMaxs, other.xMaxs);
         return *this;
     }
+    Rectangle & expandToFit(const Rectangle & other)
+    {
+        xMins = std::min(xMins, other.xMins);
+        yMins = std::min(yMins, other.yMins);
+        xMaxs = std::max(xMaxs, other.xMaxs);
+        yMaxs = std::max(yMaxs, other.yMaxs);
+        return *this;
+    }
 
     Float32 getAspect() const
     {
@@ -14,25 +14,98 @@
 namespace ntb
 {
 
+// ========================================================
+// class GeometrySegment:
+// ========================================================
+
+GeometrySegment::GeometrySegment()
+    : zLayerFirst(0)
+    , zLayerCount(0)
+    , drawOrder(DrawOrder::DepthLayers)
+    , lineQuadWidth(0)
+    , glyphInstances(false)
+    , firstVertex2D(0)
+    , firstVertexText(0)
+    , firstVertexClipped(0)
+    , baseVertex2D(0)
+    , baseVertexText(0)
+    , baseVertexClipped(0)
+    , chunks2D(sizeof(IndexChunk), MemoryTag::GeometryBatch)
+    , chunksText(sizeof(IndexChunk), MemoryTag::GeometryBatch)
+    , chunksClipped(sizeof(IndexChunk), MemoryTag::GeometryBatch)
+    , drawItems(sizeof(DrawItem), MemoryTag::GeometryBatch)
+    , linesBatch(sizeof(VertexPC), MemoryTag::GeometryBatch)
+    , verts2DBatch(sizeof(VertexPTC), MemoryTag::GeometryBatch)
+    , tris2DBatch(sizeof(std::uint16_t), MemoryTag::GeometryBatch)
+    , textVertsBatch(sizeof(VertexPTC), MemoryTag::GeometryBatch)
+    , textTrisBatch(sizeof(std::uint16_t), MemoryTag::GeometryBatch)
+    , glyphsBatch(sizeof(GlyphInstance), MemoryTag::GeometryBatch)
+    , drawClippedInfos(sizeof(DrawClippedInfo), MemoryTag::GeometryBatch)
+    , vertsClippedBatch(sizeof(VertexPTC), MemoryTag::GeometryBatch)
+    , trisClippedBatch(sizeof(std::uint16_t), MemoryTag::GeometryBatch)
+{
+}
+
+void GeometrySegment::clear()
+{
+    linesBatch.clear();
+    verts2DBatch.clear();
+    tris2DBatch.clear();
+    textVertsBatch.clear();
+    textTrisBatch.clear();
+    glyphsBatch.clear();
+    drawClippedInfos.clear();
+    vertsClippedBatch.clear();
+    trisClippedBatch.clear();
+    chunks2D.clear();
+    chunksText.clear();
+    chunksClipped.clear();
+    drawItems.clear();
+
+    zLayerFirst        = 0;
+    zLayerCount        = 0;
+    drawOrder          = DrawOrder::DepthLayers;
+    lineQuadWidth      = 0;
+    glyphInstances     = false;
+    firstVertex2D      = 0;
+    firstVertexText    = 0;
+    firstVertexClipped = 0;
+    baseVertex2D       = 0;
+    baseVertexText     = 0;
+    baseVertexClipped  = 0;
+}
+
 // ========================================================
 // class GeometryBatch:
 // ========================================================
 
-// TODO: Add macro switch to optionally sort primitives in the GeometryBatch by Z/depth?
+// Entry of the per-cell item lists of GeometryBatch::sortDrawItems().
+struct SortCellNode
+{
+    int item;
+    int next; // Next node of the same cell, or -1.
+};
+
 GeometryBatch::GeometryBatch()
     : glyphTex(nullptr)
     , currentZ(0)
-    , baseVertex2D(0)
-    , baseVertexText(0)
-    , baseVertexClipped(0)
-    , linesBatch(sizeof(VertexPC))
-    , verts2DBatch(sizeof(VertexPTC))
-    , tris2DBatch(sizeof(std::uint16_t))
-    , textVertsBatch(sizeof(VertexPTC))
-    , textTrisBatch(sizeof(std::uint16_t))
-    , drawClippedInfos(sizeof(DrawClippedInfo))
-    , vertsClippedBatch(sizeof(VertexPTC))
-    , trisClippedBatch(sizeof(std::uint16_t))
+    , drawOrder(DrawOrder::DepthLayers)
+    , glyphInstances(false)
+    , sortPrimitives(false)
+    , linesAsQuads(false)
+    , lineWidth(1)
+    , packedItems(false)
+    , packedCompact(false)
+    , drawCallStats()
+    , target(&frameGeometry)
+    , packedVerts(sizeof(VertexPTC), MemoryTag::GeometryBatch)
+    , packedCompactVerts(sizeof(VertexPTCCompact), MemoryTag::GeometryBatch)
+    , packedIndexes(sizeof(std::uint16_t), MemoryTag::GeometryBatch)
+    , packedCommands(sizeof(DrawCommand), MemoryTag::GeometryBatch)
+    , packedLineVerts(sizeof(VertexPC), MemoryTag::GeometryBatch)
+    , packedDrawInfos(sizeof(DrawClippedInfo), MemoryTag::GeometryBatch)
+    , packedGlyphs(sizeof(GlyphInstance), MemoryTag::GeometryBatch)
+    , sortCellNodes(sizeof(SortCellNode), MemoryTag::GeometryBatch)
 {
     createGlyphTexture();
 }
@@ -49,94 +122,841 @@ GeometryBatch::~GeometryBatch()
 void GeometryBatch::preallocateBatches(const int lines, const int quads,
                                        const int textGlyphs, const int drawClipped)
 {
-    linesBatch.allocate(lines * 2);          // 2 vertexes per line
+    frameGeometry.linesBatch.allocate(lines * 2);          // 2 vertexes per line
 
-    verts2DBatch.allocate(quads * 4);        // 4 vertexes per 2D quad
-    tris2DBatch.allocate(quads  * 6);        // 6 indexes per 2D quad (2 tris)
+    frameGeometry.verts2DBatch.allocate(quads * 4);        // 4 vertexes per 2D quad
+    frameGeometry.tris2DBatch.allocate(quads  * 6);        // 6 indexes per 2D quad (2 tris)
 
-    textVertsBatch.allocate(textGlyphs * 4); // 4 vertexes per glyph quadrilateral
-    textTrisBatch.allocate(textGlyphs  * 6); // 6 indexes per glyph (2 tris)
+    frameGeometry.textVertsBatch.allocate(textGlyphs * 4); // 4 vertexes per glyph quadrilateral
+    frameGeometry.textTrisBatch.allocate(textGlyphs  * 6); // 6 indexes per glyph (2 tris)
 
-    drawClippedInfos.allocate(drawClipped);
-    vertsClippedBatch.allocate(drawClipped * 4);
-    trisClippedBatch.allocate(drawClipped  * 6);
+    frameGeometry.drawClippedInfos.allocate(drawClipped);
+    frameGeometry.vertsClippedBatch.allocate(drawClipped * 4);
+    frameGeometry.trisClippedBatch.allocate(drawClipped  * 6);
 }
 
 void GeometryBatch::beginDraw()
 {
-    // Ensure we are self consistent with begin/end calls!
-    NTB_ASSERT(baseVertex2D == 0 && baseVertexText == 0 && baseVertexClipped == 0);
-    NTB_ASSERT(linesBatch.isEmpty());
-    NTB_ASSERT(verts2DBatch.isEmpty());
-    NTB_ASSERT(tris2DBatch.isEmpty());
-    NTB_ASSERT(textVertsBatch.isEmpty());
-    NTB_ASSERT(textTrisBatch.isEmpty());
-    NTB_ASSERT(drawClippedInfos.isEmpty());
-    NTB_ASSERT(vertsClippedBatch.isEmpty());
-    NTB_ASSERT(trisClippedBatch.isEmpty());
+    NTB_ASSERT(target == &frameGeometry); // Missing an endSegment()?
 
     RenderInterface & renderer = getRenderInterface();
     renderer.beginDraw();
-    currentZ = 0;
+
+    // Reset the batches and base vertex offsets from the previous frame:
+    frameGeometry.clear();
+    frameArena.reset();
+    currentZ  = 0;
+    drawOrder = renderer.getDrawOrder();
+    glyphInstances = renderer.supportsGlyphInstances();
+    frameGeometry.drawOrder = drawOrder;
+    frameGeometry.glyphInstances = glyphInstances;
 }
 
 void GeometryBatch::endDraw()
 {
+    NTB_ASSERT(target == &frameGeometry); // Missing an endSegment()?
+
     RenderInterface & renderer = getRenderInterface();
 
     // Continue anyway if exceeded (assuming the error handled doesn't throw).
     // The result might be a glitchy draw with overlapping elements.
-    if (++currentZ >= renderer.getMaxZ())
+    // Painter order has no Z layers, so there's no limit to exceed.
+    if (drawOrder == DrawOrder::DepthLayers && ++currentZ >= renderer.getMaxZ())
     {
         errorF("Max frame Z index exceeded! Provide a custom RenderInterface::getMaxZ()!");
         currentZ = renderer.getMaxZ() - 1;
     }
 
-    if (!verts2DBatch.isEmpty() && !tris2DBatch.isEmpty())
+    // The packed frame is only rebuilt by the next endDraw(),
+    // so it can still be resubmitted if nothing changes.
+    packFrame();
+    renderer.drawPackedFrame(makePackedFrame());
+    renderer.endDraw();
+}
+
+void GeometryBatch::resubmitLastFrame()
+{
+    frameArena.reset();
+
+    RenderInterface & renderer = getRenderInterface();
+    renderer.beginDraw();
+    renderer.drawPackedFrame(makePackedFrame());
+    renderer.endDraw();
+}
+
+// Max vertexes in a chunk of an indexed batch, so that all of them are addressable by 16-bits indexes.
+static constexpr int kMaxVertsPerIndexChunk = UINT16_MAX + 1;
+
+using IndexChunk = GeometrySegment::IndexChunk;
+
+// Where the current (last) chunk of an indexed batch starts.
+static IndexChunk getLastIndexChunk(const PODArray & chunks)
+{
+    if (chunks.isEmpty())
     {
-        renderer.draw2DTriangles(
-            verts2DBatch.getData<VertexPTC>(), verts2DBatch.getSize(),
-            tris2DBatch.getData<std::uint16_t>(), tris2DBatch.getSize(),
-            nullptr, currentZ); // untextured
+        return { 0, 0, 0 };
     }
+    return chunks.get<IndexChunk>(chunks.getSize() - 1);
+}
+
+// Calls drawFn(verts, vertCount, indexes, indexCount, firstDrawInfo, drawInfoCount) for each
+// non-empty chunk of an indexed batch. The 16-bits indexes are already relative to their chunk.
+template<typename DrawFunc>
+static void forEachIndexChunk(const PODArray & chunks, const PODArray & verts, const PODArray & indexes,
+                              const PODArray * drawInfos, DrawFunc drawFn)
+{
+    const IndexChunk batchEnd = { verts.getSize(), indexes.getSize(), (drawInfos != nullptr) ? drawInfos->getSize() : 0 };
+    const int chunkCount = chunks.getSize() + 1;
 
-    if (!drawClippedInfos.isEmpty() && !vertsClippedBatch.isEmpty() && !trisClippedBatch.isEmpty())
+    for (int c = 0; c < chunkCount; ++c)
     {
-        renderer.drawClipped2DTriangles(
-            vertsClippedBatch.getData<VertexPTC>(), vertsClippedBatch.getSize(),
-            trisClippedBatch.getData<std::uint16_t>(), trisClippedBatch.getSize(),
-            drawClippedInfos.getData<DrawClippedInfo>(), drawClippedInfos.getSize(), currentZ);
+        const IndexChunk start = (c > 0) ? chunks.get<IndexChunk>(c - 1) : IndexChunk{ 0, 0, 0 };
+        const IndexChunk end   = (c < chunkCount - 1) ? chunks.get<IndexChunk>(c) : batchEnd;
+
+        if (end.firstVertex > start.firstVertex && end.firstIndex > start.firstIndex)
+        {
+            drawFn(verts.getData<VertexPTC>() + start.firstVertex, end.firstVertex - start.firstVertex,
+                   indexes.getData<std::uint16_t>() + start.firstIndex, end.firstIndex - start.firstIndex,
+                   start.firstDrawInfo, end.firstDrawInfo - start.firstDrawInfo);
+        }
     }
+}
 
-    if (!textVertsBatch.isEmpty() && !textTrisBatch.isEmpty())
+void GeometryBatch::packFrame()
+{
+    const GeometrySegment & frame = frameGeometry;
+
+    packedVerts.clear();
+    packedCompactVerts.clear();
+    packedIndexes.clear();
+    packedCommands.clear();
+    packedLineVerts.clear();
+    packedDrawInfos.clear();
+    packedGlyphs.clear();
+    packedCompact = canPackCompactVertexes();
+
+    // Drawing strictly in order takes a new command every time the batch changes.
+    using DrawItem = GeometrySegment::DrawItem;
+    const int itemCount = frame.drawItems.getSize();
+    drawCallStats.primitives      = itemCount;
+    drawCallStats.inOrderCommands = 0;
+    for (int i = 0; i < itemCount; ++i)
     {
-        renderer.draw2DTriangles(
-            textVertsBatch.getData<VertexPTC>(), textVertsBatch.getSize(),
-            textTrisBatch.getData<std::uint16_t>(), textTrisBatch.getSize(),
-            glyphTex, currentZ); // textured
+        if (i == 0 || frame.drawItems.get<DrawItem>(i).batch != frame.drawItems.get<DrawItem>(i - 1).batch)
+        {
+            ++drawCallStats.inOrderCommands;
+        }
     }
 
-    if (!linesBatch.isEmpty())
+    packedItems = (drawOrder == DrawOrder::Painter || sortPrimitives);
+    if (packedItems)
     {
-        renderer.draw2DLines(linesBatch.getData<VertexPC>(), linesBatch.getSize(), currentZ);
+        int * itemOrder = static_cast<int *>(frameArena.allocate(std::max(itemCount, 1) * int(sizeof(int))));
+        if (sortPrimitives)
+        {
+            sortDrawItems(itemOrder);
+        }
+        else
+        {
+            for (int i = 0; i < itemCount; ++i)
+            {
+                itemOrder[i] = i;
+            }
+        }
+        packFrameItems(itemOrder);
+        drawCallStats.commands = packedCommands.getSize();
+        return;
     }
 
-    // Reset the batches:
-    linesBatch.clear();
-    verts2DBatch.clear();
-    tris2DBatch.clear();
-    textVertsBatch.clear();
-    textTrisBatch.clear();
-    drawClippedInfos.clear();
-    vertsClippedBatch.clear();
-    trisClippedBatch.clear();
+    // Usually a single command each, unless a batch has more vertexes than 16-bits indexes can address.
+    // Order is the same as the individual RenderInterface draw calls used to be submitted in.
+    auto packChunks = [this](const PODArray & chunks, const PODArray & verts, const PODArray & indexes,
+                             const PODArray * drawInfos, const DrawCommandType type, const TextureHandle texture)
+    {
+        forEachIndexChunk(chunks, verts, indexes, drawInfos,
+            [this, type, texture](const VertexPTC * chunkVerts, int vertCount, const std::uint16_t * chunkIndexes, int indexCount,
+                                  int firstDrawInfo, int drawInfoCount)
+            {
+                if (type == DrawCommandType::ClippedTriangles && drawInfoCount == 0)
+                {
+                    return;
+                }
+
+                DrawCommand cmd;
+                cmd.type          = type;
+                cmd.texture       = texture;
+                cmd.firstVertex   = appendPackedVerts(chunkVerts, vertCount, type == DrawCommandType::ClippedTriangles);
+                cmd.vertexCount   = vertCount;
+                cmd.firstIndex    = packedIndexes.getSize();
+                cmd.indexCount    = indexCount;
+                cmd.firstDrawInfo = firstDrawInfo;
+                cmd.drawInfoCount = drawInfoCount;
+
+                packedIndexes.append(chunkIndexes, indexCount);
+                packedCommands.pushBack(cmd);
+            });
+    };
 
-    // And the base vertex offsets:
-    baseVertex2D      = 0;
-    baseVertexText    = 0;
-    baseVertexClipped = 0;
+    packChunks(frame.chunks2D, frame.verts2DBatch, frame.tris2DBatch, nullptr,
+               DrawCommandType::Triangles, nullptr); // untextured
 
-    renderer.endDraw();
+    packChunks(frame.chunksClipped, frame.vertsClippedBatch, frame.trisClippedBatch, &frame.drawClippedInfos,
+               DrawCommandType::ClippedTriangles, nullptr);
+
+    packChunks(frame.chunksText, frame.textVertsBatch, frame.textTrisBatch, nullptr,
+               DrawCommandType::Triangles, glyphTex); // textured
+
+    // Instances have no indexes, so all the glyphs are always a single command.
+    if (!frame.glyphsBatch.isEmpty())
+    {
+        DrawCommand cmd = {};
+        cmd.type        = DrawCommandType::Glyphs;
+        cmd.texture     = glyphTex;
+        cmd.vertexCount = frame.glyphsBatch.getSize();
+        packedCommands.pushBack(cmd);
+    }
+
+    if (!frame.linesBatch.isEmpty())
+    {
+        DrawCommand cmd = {};
+        cmd.type        = DrawCommandType::Lines;
+        cmd.vertexCount = frame.linesBatch.getSize();
+        packedCommands.pushBack(cmd);
+    }
+    drawCallStats.commands = packedCommands.getSize();
+}
+
+int GeometryBatch::appendPackedVerts(const VertexPTC * verts, const int vertCount, const bool clipped)
+{
+    if (!packedCompact || clipped)
+    {
+        const int first = packedVerts.getSize();
+        packedVerts.append(verts, vertCount);
+        return first;
+    }
+
+    const int first = packedCompactVerts.getSize();
+    packedCompactVerts.resize(first + vertCount);
+    VertexPTCCompact * dest = packedCompactVerts.getData<VertexPTCCompact>() + first;
+    for (int v = 0; v < vertCount; ++v)
+    {
+        dest[v] = packCompactVertex(verts[v]);
+    }
+    return first;
+}
+
+bool GeometryBatch::canPackCompactVertexes() const
+{
+    // In painter's order everything is at Z 0, however many layers there are.
+    if (!getRenderInterface().supportsCompactVertexes() ||
+        (drawOrder == DrawOrder::DepthLayers && currentZ > kCompactVertexMaxZ))
+    {
+        return false;
+    }
+
+    // Positions can be anything if a Panel is dragged far enough off-screen. Rare, but
+    // that frame just goes in the full format. The clipped vertexes aren't packed.
+    const PODArray * batches[] = { &frameGeometry.verts2DBatch, &frameGeometry.textVertsBatch };
+    for (const PODArray * batch : batches)
+    {
+        const VertexPTC * verts = batch->getData<VertexPTC>();
+        const int vertCount = batch->getSize();
+        for (int v = 0; v < vertCount; ++v)
+        {
+            if (!isCompactVertexInRange(verts[v]))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Chunk of an indexed batch that holds the index (or DrawClippedInfo, if 'byDrawInfo') at 'position'.
+// Chunk 0 starts at the beginning of the batch, chunk c > 0 at chunks[c - 1].
+static int findIndexChunk(const PODArray & chunks, const int position, const bool byDrawInfo)
+{
+    int lo = 0;
+    int hi = chunks.getSize();
+    while (lo < hi)
+    {
+        const int mid = (lo + hi) / 2;
+        const IndexChunk & chunk = chunks.get<IndexChunk>(mid);
+        if ((byDrawInfo ? chunk.firstDrawInfo : chunk.firstIndex) <= position)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static IndexChunk getIndexChunkStart(const PODArray & chunks, const int chunk)
+{
+    return (chunk > 0) ? chunks.get<IndexChunk>(chunk - 1) : IndexChunk{ 0, 0, 0 };
+}
+
+static IndexChunk getIndexChunkEnd(const PODArray & chunks, const int chunk, const IndexChunk & batchEnd)
+{
+    return (chunk < chunks.getSize()) ? chunks.get<IndexChunk>(chunk) : batchEnd;
+}
+
+void GeometryBatch::packFrameItems(const int * itemOrder)
+{
+    const GeometrySegment & frame = frameGeometry;
+    using BatchType = GeometrySegment::BatchType;
+    using DrawItem  = GeometrySegment::DrawItem;
+
+    // Vertexes are copied whole and the commands address ranges of them. So are the clipped indexes,
+    // since the DrawClippedInfos address them relative to their chunk. The other indexes, lines, glyphs
+    // and clip infos are copied item by item, so that each command reads a contiguous range.
+    const int firstVertex2D      = appendPackedVerts(frame.verts2DBatch.getData<VertexPTC>(), frame.verts2DBatch.getSize(), false);
+    const int firstVertexText    = appendPackedVerts(frame.textVertsBatch.getData<VertexPTC>(), frame.textVertsBatch.getSize(), false);
+    const int firstVertexClipped = appendPackedVerts(frame.vertsClippedBatch.getData<VertexPTC>(), frame.vertsClippedBatch.getSize(), true);
+    const int firstIndexClipped  = packedIndexes.getSize();
+    packedIndexes.append(frame.trisClippedBatch.getData<std::uint16_t>(), frame.trisClippedBatch.getSize());
+
+    DrawCommand cmd    = {};
+    BatchType cmdBatch = BatchType::Lines;
+    int cmdChunk       = -1; // -1 if no command is open.
+
+    // Triangle commands are narrowed down to the vertexes their indexes actually use.
+    auto closeCommand = [this, &cmd, &cmdChunk]()
+    {
+        if (cmdChunk < 0)
+        {
+            return;
+        }
+        if (cmd.type == DrawCommandType::Triangles)
+        {
+            std::uint16_t * indexes = packedIndexes.getData<std::uint16_t>() + cmd.firstIndex;
+            int minIndex = kMaxVertsPerIndexChunk;
+            int maxIndex = 0;
+            for (int i = 0; i < cmd.indexCount; ++i)
+            {
+                minIndex = std::min(minIndex, static_cast<int>(indexes[i]));
+                maxIndex = std::max(maxIndex, static_cast<int>(indexes[i]));
+            }
+            for (int i = 0; i < cmd.indexCount; ++i)
+            {
+                indexes[i] = static_cast<std::uint16_t>(indexes[i] - minIndex);
+            }
+            cmd.firstVertex += minIndex;
+            cmd.vertexCount  = maxIndex - minIndex + 1;
+        }
+        packedCommands.pushBack(cmd);
+        cmdChunk = -1;
+    };
+
+    const int itemCount = frame.drawItems.getSize();
+    for (int i = 0; i < itemCount; ++i)
+    {
+        const DrawItem & item = frame.drawItems.get<DrawItem>(itemOrder[i]);
+
+        if (item.batch == BatchType::Lines)
+        {
+            if (cmdChunk < 0 || cmdBatch != BatchType::Lines)
+            {
+                closeCommand();
+                cmd             = {};
+                cmd.type        = DrawCommandType::Lines;
+                cmd.firstVertex = packedLineVerts.getSize();
+                cmdBatch        = BatchType::Lines;
+                cmdChunk        = 0;
+            }
+            packedLineVerts.append(frame.linesBatch.getData<VertexPC>() + item.first, item.end - item.first);
+            cmd.vertexCount += item.end - item.first;
+        }
+        else if (item.batch == BatchType::Clipped)
+        {
+            // One DrawClippedInfo per item. The command spans the whole index range of the chunk.
+            const int chunk = findIndexChunk(frame.chunksClipped, item.first, true);
+            if (cmdChunk != chunk || cmdBatch != BatchType::Clipped)
+            {
+                const IndexChunk batchEnd = { frame.vertsClippedBatch.getSize(), frame.trisClippedBatch.getSize(),
+                                              frame.drawClippedInfos.getSize() };
+                const IndexChunk start = getIndexChunkStart(frame.chunksClipped, chunk);
+                const IndexChunk end   = getIndexChunkEnd(frame.chunksClipped, chunk, batchEnd);
+
+                closeCommand();
+                cmd               = {};
+                cmd.type          = DrawCommandType::ClippedTriangles;
+                cmd.firstVertex   = firstVertexClipped + start.firstVertex;
+                cmd.vertexCount   = end.firstVertex - start.firstVertex;
+                cmd.firstIndex    = firstIndexClipped + start.firstIndex;
+                cmd.indexCount    = end.firstIndex - start.firstIndex;
+                cmd.firstDrawInfo = packedDrawInfos.getSize();
+                cmdBatch          = BatchType::Clipped;
+                cmdChunk          = chunk;
+            }
+            packedDrawInfos.append(frame.drawClippedInfos.getData<DrawClippedInfo>() + item.first, item.end - item.first);
+            cmd.drawInfoCount += item.end - item.first;
+        }
+        else if (item.batch == BatchType::Text && frame.glyphInstances)
+        {
+            if (cmdChunk < 0 || cmdBatch != BatchType::Text)
+            {
+                closeCommand();
+                cmd             = {};
+                cmd.type        = DrawCommandType::Glyphs;
+                cmd.texture     = glyphTex;
+                cmd.firstVertex = packedGlyphs.getSize();
+                cmdBatch        = BatchType::Text;
+                cmdChunk        = 0;
+            }
+            packedGlyphs.append(frame.glyphsBatch.getData<GlyphInstance>() + item.first, item.end - item.first);
+            cmd.vertexCount += item.end - item.first;
+        }
+        else
+        {
+            // A text string may cross into the next chunk, so go piece by piece.
+            const bool isText          = (item.batch == BatchType::Text);
+            const PODArray & chunks    = isText ? frame.chunksText : frame.chunks2D;
+            const PODArray & verts     = isText ? frame.textVertsBatch : frame.verts2DBatch;
+            const PODArray & indexes   = isText ? frame.textTrisBatch : frame.tris2DBatch;
+            const int firstBatchVertex = isText ? firstVertexText : firstVertex2D;
+            const IndexChunk batchEnd  = { verts.getSize(), indexes.getSize(), 0 };
+
+            for (int first = item.first; first < item.end;)
+            {
+                const int chunk = findIndexChunk(chunks, first, false);
+                const int last  = std::min(item.end, getIndexChunkEnd(chunks, chunk, batchEnd).firstIndex);
+
+                if (cmdChunk != chunk || cmdBatch != item.batch)
+                {
+                    closeCommand();
+                    cmd             = {};
+                    cmd.type        = DrawCommandType::Triangles;
+                    cmd.texture     = isText ? glyphTex : nullptr;
+                    cmd.firstVertex = firstBatchVertex + getIndexChunkStart(chunks, chunk).firstVertex;
+                    cmd.firstIndex  = packedIndexes.getSize();
+                    cmdBatch        = item.batch;
+                    cmdChunk        = chunk;
+                }
+                packedIndexes.append(indexes.getData<std::uint16_t>() + first, last - first);
+                cmd.indexCount += last - first;
+                first = last;
+            }
+        }
+    }
+    closeCommand();
+}
+
+Rectangle GeometryBatch::getDrawItemBounds(const GeometrySegment::DrawItem & item) const
+{
+    using BatchType = GeometrySegment::BatchType;
+    const GeometrySegment & frame = frameGeometry;
+
+    if (item.batch == BatchType::Clipped)
+    {
+        const DrawClippedInfo & info = frame.drawClippedInfos.get<DrawClippedInfo>(item.first);
+        return { std::max(info.clipBoxX, info.viewportX), std::max(info.clipBoxY, info.viewportY),
+                 std::min(info.clipBoxX + info.clipBoxW, info.viewportX + info.viewportW),
+                 std::min(info.clipBoxY + info.clipBoxH, info.viewportY + info.viewportH) };
+    }
+
+    Float32 x0 = 1e30f, y0 = 1e30f;
+    Float32 x1 = -1e30f, y1 = -1e30f;
+    auto addPoint = [&x0, &y0, &x1, &y1](const Float32 x, const Float32 y)
+    {
+        x0 = std::min(x0, x); y0 = std::min(y0, y);
+        x1 = std::max(x1, x); y1 = std::max(y1, y);
+    };
+
+    if (item.batch == BatchType::Lines)
+    {
+        const VertexPC * verts = frame.linesBatch.getData<VertexPC>();
+        for (int v = item.first; v < item.end; ++v)
+        {
+            addPoint(verts[v].x, verts[v].y);
+        }
+        // Lines are thin, so they could light the pixels just outside of their ends.
+        return { static_cast<int>(std::floor(x0)) - 1, static_cast<int>(std::floor(y0)) - 1,
+                 static_cast<int>(std::ceil(x1))  + 1, static_cast<int>(std::ceil(y1))  + 1 };
+    }
+
+    if (item.batch == BatchType::Text && frame.glyphInstances)
+    {
+        const GlyphInstance * glyphs = frame.glyphsBatch.getData<GlyphInstance>();
+        for (int g = item.first; g < item.end; ++g)
+        {
+            addPoint(glyphs[g].x, glyphs[g].y);
+            addPoint(glyphs[g].x + getCharWidth() * glyphs[g].scale, glyphs[g].y + getCharHeight() * glyphs[g].scale);
+        }
+        return { static_cast<int>(std::floor(x0)), static_cast<int>(std::floor(y0)),
+                 static_cast<int>(std::ceil(x1)),  static_cast<int>(std::ceil(y1)) };
+    }
+
+    const PODArray & batchVerts = (item.batch == BatchType::Text) ? frame.textVertsBatch : frame.verts2DBatch;
+    const VertexPTC * verts = batchVerts.getData<VertexPTC>();
+    for (int v = item.firstVertex; v < item.endVertex; ++v)
+    {
+        addPoint(verts[v].x, verts[v].y);
+    }
+    return { static_cast<int>(std::floor(x0)), static_cast<int>(std::floor(y0)),
+             static_cast<int>(std::ceil(x1)),  static_cast<int>(std::ceil(y1)) };
+}
+
+void GeometryBatch::sortDrawItems(int * itemOrder)
+{
+    using DrawItem = GeometrySegment::DrawItem;
+    const PODArray & items = frameGeometry.drawItems;
+    const int itemCount = items.getSize();
+    if (itemCount == 0)
+    {
+        return;
+    }
+
+    // Items are put in the cells of a screen grid they overlap, so each only
+    // has to be tested against the earlier items sharing a cell with it.
+    constexpr int kCellSize = 64;
+    int vpX, vpY, vpW, vpH;
+    getRenderInterface().getViewport(&vpX, &vpY, &vpW, &vpH);
+    const int cellsX = std::max(1, (vpW + kCellSize - 1) / kCellSize);
+    const int cellsY = std::max(1, (vpH + kCellSize - 1) / kCellSize);
+
+    int * cellHeads        = static_cast<int *>(frameArena.allocate(cellsX * cellsY * int(sizeof(int))));
+    Rectangle * bounds     = static_cast<Rectangle *>(frameArena.allocate(itemCount * int(sizeof(Rectangle))));
+    std::uint32_t * keys   = static_cast<std::uint32_t *>(frameArena.allocate(itemCount * int(sizeof(std::uint32_t))));
+    std::uint32_t * keys2  = static_cast<std::uint32_t *>(frameArena.allocate(itemCount * int(sizeof(std::uint32_t))));
+    int * order2           = static_cast<int *>(frameArena.allocate(itemCount * int(sizeof(int))));
+
+    std::fill(cellHeads, cellHeads + cellsX * cellsY, -1);
+    sortCellNodes.clear();
+
+    // An item goes at least one layer above every earlier item of another batch that it overlaps,
+    // and no lower than the earlier items of its own batch that it overlaps. The stable sort by
+    // layer then keeps the order of any two overlapping items and groups all the others by batch.
+    std::uint32_t maxKey = 0;
+    for (int i = 0; i < itemCount; ++i)
+    {
+        const DrawItem & item = items.get<DrawItem>(i);
+        const Rectangle b = getDrawItemBounds(item);
+        bounds[i] = b;
+
+        std::uint32_t layer = 0;
+        if (b.xMins < b.xMaxs && b.yMins < b.yMaxs)
+        {
+            const int cx0 = clamp(b.xMins / kCellSize, 0, cellsX - 1);
+            const int cy0 = clamp(b.yMins / kCellSize, 0, cellsY - 1);
+            const int cx1 = clamp((b.xMaxs - 1) / kCellSize, 0, cellsX - 1);
+            const int cy1 = clamp((b.yMaxs - 1) / kCellSize, 0, cellsY - 1);
+
+            for (int cy = cy0; cy <= cy1; ++cy)
+            {
+                for (int cx = cx0; cx <= cx1; ++cx)
+                {
+                    for (int n = cellHeads[cy * cellsX + cx]; n >= 0; n = sortCellNodes.get<SortCellNode>(n).next)
+                    {
+                        const int other = sortCellNodes.get<SortCellNode>(n).item;
+                        const Rectangle & ob = bounds[other];
+                        if (b.xMins < ob.xMaxs && ob.xMins < b.xMaxs && b.yMins < ob.yMaxs && ob.yMins < b.yMaxs)
+                        {
+                            const std::uint32_t otherLayer = keys[other] >> 2;
+                            const bool sameBatch = (items.get<DrawItem>(other).batch == item.batch);
+                            layer = std::max(layer, sameBatch ? otherLayer : otherLayer + 1);
+                        }
+                    }
+                }
+            }
+            for (int cy = cy0; cy <= cy1; ++cy)
+            {
+                for (int cx = cx0; cx <= cx1; ++cx)
+                {
+                    const SortCellNode node = { i, cellHeads[cy * cellsX + cx] };
+                    cellHeads[cy * cellsX + cx] = sortCellNodes.getSize();
+                    sortCellNodes.pushBack(node);
+                }
+            }
+        }
+
+        // Layer first, then batch, so the batches of a layer come out grouped.
+        keys[i]      = (layer << 2) | static_cast<std::uint32_t>(item.batch);
+        itemOrder[i] = i;
+        maxKey       = std::max(maxKey, keys[i]);
+    }
+
+    // Stable LSD radix sort of the keys, 8 bits per pass, only as many passes as the largest key needs.
+    std::uint32_t * srcKeys  = keys;
+    std::uint32_t * dstKeys  = keys2;
+    int           * srcOrder = itemOrder;
+    int           * dstOrder = order2;
+    for (int shift = 0; shift < 32 && (maxKey >> shift) != 0; shift += 8)
+    {
+        int offsets[256] = {};
+        for (int i = 0; i < itemCount; ++i)
+        {
+            offsets[(srcKeys[i] >> shift) & 0xFF]++;
+        }
+        for (int d = 0, sum = 0; d < 256; ++d)
+        {
+            const int count = offsets[d];
+            offsets[d] = sum;
+            sum += count;
+        }
+        for (int i = 0; i < itemCount; ++i)
+        {
+            const int dst = offsets[(srcKeys[i] >> shift) & 0xFF]++;
+            dstKeys[dst]  = srcKeys[i];
+            dstOrder[dst] = srcOrder[i];
+        }
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcOrder, dstOrder);
+    }
+    if (srcOrder != itemOrder)
+    {
+        std::copy(srcOrder, srcOrder + itemCount, itemOrder);
+    }
+}
+
+PackedFrame GeometryBatch::makePackedFrame() const
+{
+    // Unless packed item by item, lines and clip infos are used straight
+    // from the frame batches, they are already a single array.
+    const PODArray & lineVerts = packedItems ? packedLineVerts : frameGeometry.linesBatch;
+    const PODArray & drawInfos = packedItems ? packedDrawInfos : frameGeometry.drawClippedInfos;
+    const PODArray & glyphs    = packedItems ? packedGlyphs    : frameGeometry.glyphsBatch;
+    const FontCharSet & charSet = detail::getFontCharSet();
+
+    PackedFrame packed;
+    packed.verts            = packedVerts.getData<VertexPTC>();
+    packed.indexes          = packedIndexes.getData<std::uint16_t>();
+    packed.lineVerts        = lineVerts.getData<VertexPC>();
+    packed.drawInfos        = drawInfos.getData<DrawClippedInfo>();
+    packed.commands         = packedCommands.getData<DrawCommand>();
+    packed.compactVerts     = packedCompact ? packedCompactVerts.getData<VertexPTCCompact>() : nullptr;
+    packed.compactVertCount = packedCompactVerts.getSize();
+    packed.glyphs           = glyphs.getData<GlyphInstance>();
+    packed.glyphCount       = glyphs.getSize();
+    packed.glyphWidth       = getCharWidth();
+    packed.glyphHeight      = getCharHeight();
+    packed.glyphUVWidth     = getCharWidth()  / charSet.bitmapWidth;
+    packed.glyphUVHeight    = getCharHeight() / charSet.bitmapHeight;
+    packed.vertCount        = packedVerts.getSize();
+    packed.indexCount       = packedIndexes.getSize();
+    packed.lineVertCount    = lineVerts.getSize();
+    packed.drawInfoCount    = drawInfos.getSize();
+    packed.commandCount     = packedCommands.getSize();
+    packed.frameMaxZ        = (drawOrder == DrawOrder::Painter) ? 1 : currentZ;
+    packed.drawOrder        = drawOrder;
+    return packed;
+}
+
+// Appends the vertexes of a segment, offsetting their Z by the difference
+// between the layer the segment was recorded at and the current frame layer.
+template<typename VertexType>
+static void appendSegmentVerts(PODArray & dest, const PODArray & src, const int zOffset)
+{
+    const int first = dest.getSize();
+    const int count = src.getSize();
+    dest.append(src.getData<VertexType>(), count);
+
+    if (zOffset != 0)
+    {
+        const Float32 z = static_cast<Float32>(zOffset);
+        VertexType * verts = dest.getData<VertexType>() + first;
+        for (int v = 0; v < count; ++v)
+        {
+            verts[v].z += z;
+        }
+    }
+}
+
+// Appends one indexed batch of a segment. Only the indexes of the segment's first chunk get offset
+// by the base vertex difference, since they continue the current chunk of the frame. If they don't
+// fit in there anymore, a new frame chunk starts with the segment instead. The chunks that were split
+// while recording the segment are already relative to their own start, so they are just appended.
+static void appendSegmentTriangles(PODArray & destVerts, PODArray & destIndexes, PODArray & destChunks,
+                                   PODArray * destDrawInfos, int & destBaseVertex,
+                                   const PODArray & srcVerts, const PODArray & srcIndexes, const PODArray & srcChunks,
+                                   const PODArray * srcDrawInfos, const int srcFirstVertex, const int srcBaseVertex,
+                                   const int zOffset)
+{
+    const IndexChunk destStart = { destVerts.getSize(), destIndexes.getSize(),
+                                   (destDrawInfos != nullptr) ? destDrawInfos->getSize() : 0 };
+
+    const IndexChunk srcFirstChunkEnd = !srcChunks.isEmpty() ? srcChunks.get<IndexChunk>(0) :
+        IndexChunk{ srcVerts.getSize(), srcIndexes.getSize(), (srcDrawInfos != nullptr) ? srcDrawInfos->getSize() : 0 };
+
+    int baseVertex = destBaseVertex;
+    if (baseVertex + srcFirstChunkEnd.firstVertex > kMaxVertsPerIndexChunk)
+    {
+        destChunks.pushBack<IndexChunk>(destStart);
+        baseVertex = 0;
+    }
+
+    appendSegmentVerts<VertexPTC>(destVerts, srcVerts, zOffset);
+    destIndexes.append(srcIndexes.getData<std::uint16_t>(), srcIndexes.getSize());
+
+    const int indexOffset = baseVertex - srcFirstVertex;
+    if (indexOffset != 0)
+    {
+        std::uint16_t * indexes = destIndexes.getData<std::uint16_t>() + destStart.firstIndex;
+        for (int i = 0; i < srcFirstChunkEnd.firstIndex; ++i)
+        {
+            NTB_ASSERT(indexes[i] + indexOffset >= 0);
+            NTB_ASSERT(indexes[i] + indexOffset < kMaxVertsPerIndexChunk);
+            indexes[i] = static_cast<std::uint16_t>(indexes[i] + indexOffset);
+        }
+    }
+
+    // DrawClippedInfo::firstIndex is relative to the chunk start too.
+    if (destDrawInfos != nullptr)
+    {
+        NTB_ASSERT(srcDrawInfos != nullptr);
+        destDrawInfos->append(srcDrawInfos->getData<DrawClippedInfo>(), srcDrawInfos->getSize());
+
+        const int firstIndexOffset = destStart.firstIndex - getLastIndexChunk(destChunks).firstIndex;
+        if (firstIndexOffset != 0)
+        {
+            DrawClippedInfo * infos = destDrawInfos->getData<DrawClippedInfo>() + destStart.firstDrawInfo;
+            for (int i = 0; i < srcFirstChunkEnd.firstDrawInfo; ++i)
+            {
+                infos[i].firstIndex += firstIndexOffset;
+            }
+        }
+    }
+
+    const int chunkCount = srcChunks.getSize();
+    for (int c = 0; c < chunkCount; ++c)
+    {
+        IndexChunk chunk = srcChunks.get<IndexChunk>(c);
+        chunk.firstVertex   += destStart.firstVertex;
+        chunk.firstIndex    += destStart.firstIndex;
+        chunk.firstDrawInfo += destStart.firstDrawInfo;
+        destChunks.pushBack<IndexChunk>(chunk);
+    }
+
+    destBaseVertex = srcChunks.isEmpty() ? baseVertex + (srcBaseVertex - srcFirstVertex) : srcBaseVertex;
+}
+
+void GeometryBatch::addDrawItem(const GeometrySegment::BatchType batch, const int first, const int end,
+                                const int firstVertex, const int endVertex)
+{
+    if (first < end)
+    {
+        target->drawItems.pushBack<GeometrySegment::DrawItem>({ batch, first, end, firstVertex, endVertex });
+    }
+}
+
+void GeometryBatch::beginSegment(GeometrySegment & segment)
+{
+    NTB_ASSERT(target == &frameGeometry); // Segments don't nest!
+    NTB_ASSERT(&segment != &frameGeometry);
+
+    // The segment continues from the current frame offsets,
+    // so endSegment() can append it without any rebasing.
+    segment.clear();
+    segment.zLayerFirst        = currentZ;
+    segment.drawOrder          = drawOrder;
+    segment.lineQuadWidth      = linesAsQuads ? lineWidth : 0;
+    segment.glyphInstances     = glyphInstances;
+    segment.firstVertex2D      = segment.baseVertex2D      = frameGeometry.baseVertex2D;
+    segment.firstVertexText    = segment.baseVertexText    = frameGeometry.baseVertexText;
+    segment.firstVertexClipped = segment.baseVertexClipped = frameGeometry.baseVertexClipped;
+
+    target = &segment;
+}
+
+void GeometryBatch::endSegment()
+{
+    NTB_ASSERT(target != &frameGeometry); // Missing a beginSegment()?
+
+    GeometrySegment & segment = *target;
+    segment.zLayerCount = currentZ - segment.zLayerFirst;
+
+    // appendSegment() advances the frame Z again.
+    target   = &frameGeometry;
+    currentZ = segment.zLayerFirst;
+    appendSegment(segment);
+}
+
+void GeometryBatch::appendSegment(const GeometrySegment & segment)
+{
+    NTB_ASSERT(target == &frameGeometry); // Can't append while recording a segment.
+    NTB_ASSERT(&segment != &frameGeometry);
+    NTB_ASSERT(canAppendSegment(segment)); // Recorded for a frame with a different order or lines?
+
+    GeometrySegment & frame = frameGeometry;
+    using BatchType = GeometrySegment::BatchType;
+    using DrawItem  = GeometrySegment::DrawItem;
+
+    // Everything is at Z 0 in painter order, nothing to rebase.
+    const int zOffset = (drawOrder == DrawOrder::Painter) ? 0 : currentZ - segment.zLayerFirst;
+
+    // Draw items of the segment are relative to its own batches.
+    const int itemCount = segment.drawItems.getSize();
+    for (int i = 0; i < itemCount; ++i)
+    {
+        DrawItem item = segment.drawItems.get<DrawItem>(i);
+        int base = 0;
+        int baseVertex = 0;
+        switch (item.batch)
+        {
+        case BatchType::Triangles2D :
+            base = frame.tris2DBatch.getSize();
+            baseVertex = frame.verts2DBatch.getSize();
+            break;
+        case BatchType::Text :
+            base = glyphInstances ? frame.glyphsBatch.getSize() : frame.textTrisBatch.getSize();
+            baseVertex = frame.textVertsBatch.getSize();
+            break;
+        case BatchType::Clipped :
+            base = frame.drawClippedInfos.getSize();
+            break;
+        case BatchType::Lines :
+            base = frame.linesBatch.getSize();
+            break;
+        default :
+            errorF("Bad batch type in GeometryBatch::appendSegment!");
+            break;
+        } // switch (item.batch)
+        item.first       += base;
+        item.end         += base;
+        item.firstVertex += baseVertex;
+        item.endVertex   += baseVertex;
+        frame.drawItems.pushBack(item);
+    }
+
+    appendSegmentVerts<VertexPC>(frame.linesBatch, segment.linesBatch, zOffset);
+    appendSegmentVerts<GlyphInstance>(frame.glyphsBatch, segment.glyphsBatch, zOffset);
+
+    appendSegmentTriangles(frame.verts2DBatch, frame.tris2DBatch, frame.chunks2D, nullptr, frame.baseVertex2D,
+                           segment.verts2DBatch, segment.tris2DBatch, segment.chunks2D, nullptr,
+                           segment.firstVertex2D, segment.baseVertex2D, zOffset);
+
+    appendSegmentTriangles(frame.textVertsBatch, frame.textTrisBatch, frame.chunksText, nullptr, frame.baseVertexText,
+                           segment.textVertsBatch, segment.textTrisBatch, segment.chunksText, nullptr,
+                           segment.firstVertexText, segment.baseVertexText, zOffset);
+
+    appendSegmentTriangles(frame.vertsClippedBatch, frame.trisClippedBatch, frame.chunksClipped,
+                           &frame.drawClippedInfos, frame.baseVertexClipped,
+                           segment.vertsClippedBatch, segment.trisClippedBatch, segment.chunksClipped,
+                           &segment.drawClippedInfos, segment.firstVertexClipped, segment.baseVertexClipped, zOffset);
+
+    currentZ += segment.zLayerCount;
+}
+
+bool GeometryBatch::canAppendSegment(const GeometrySegment & segment) const
+{
+    return segment.drawOrder == drawOrder && segment.lineQuadWidth == (linesAsQuads ? lineWidth : 0) &&
+           segment.glyphInstances == glyphInstances;
+}
+
+void GeometryBatch::reserveIndexRange(PODArray & chunks, int & baseVertex, const PODArray & verts,
+                                      const PODArray & indexes, const PODArray * drawInfos, const int vertCount)
+{
+    NTB_ASSERT(vertCount <= kMaxVertsPerIndexChunk);
+
+    if (baseVertex + vertCount > kMaxVertsPerIndexChunk)
+    {
+        const IndexChunk chunk = { verts.getSize(), indexes.getSize(), (drawInfos != nullptr) ? drawInfos->getSize() : 0 };
+        chunks.pushBack<IndexChunk>(chunk);
+        baseVertex = 0;
+    }
 }
 
 void GeometryBatch::drawClipped2DTriangles(const VertexPTC * verts, const int vertCount,
@@ -148,6 +968,9 @@ void GeometryBatch::drawClipped2DTriangles(const VertexPTC * verts, const int ve
     NTB_ASSERT(vertCount  > 0);
     NTB_ASSERT(indexCount > 0);
 
+    reserveIndexRange(target->chunksClipped, target->baseVertexClipped, target->vertsClippedBatch,
+                      target->trisClippedBatch, &target->drawClippedInfos, vertCount);
+
     DrawClippedInfo drawInfo;
     drawInfo.texture    = nullptr;
     drawInfo.viewportX  = viewport.getX();
@@ -158,17 +981,28 @@ void GeometryBatch::drawClipped2DTriangles(const VertexPTC * verts, const int ve
     drawInfo.clipBoxY   = clipBox.getY();
     drawInfo.clipBoxW   = clipBox.getWidth();
     drawInfo.clipBoxH   = clipBox.getHeight();
-    drawInfo.firstIndex = trisClippedBatch.getSize();
+    drawInfo.firstIndex = target->trisClippedBatch.getSize() - getLastIndexChunk(target->chunksClipped).firstIndex;
     drawInfo.indexCount = indexCount;
-    drawClippedInfos.pushBack<DrawClippedInfo>(drawInfo);
+    target->drawClippedInfos.pushBack<DrawClippedInfo>(drawInfo);
+
+    const int drawInfoIndex = target->drawClippedInfos.getSize() - 1;
+    addDrawItem(GeometrySegment::BatchType::Clipped, drawInfoIndex, drawInfoIndex + 1);
+
+    // The 3D objects being screen projected rely on their own Z to hide the back faces.
+    // Without a depth test, their triangles are sorted back to front instead.
+    if (drawOrder == DrawOrder::Painter)
+    {
+        drawClippedTrianglesSorted(verts, vertCount, indexes, indexCount);
+        return;
+    }
 
     for (int i = 0; i < indexCount; ++i)
     {
         NTB_ASSERT(indexes[i] < unsigned(vertCount));
-        NTB_ASSERT(indexes[i] + baseVertexClipped <= UINT16_MAX);
-        trisClippedBatch.pushBack<std::uint16_t>(indexes[i] + baseVertexClipped);
+        NTB_ASSERT(indexes[i] + target->baseVertexClipped < kMaxVertsPerIndexChunk);
+        target->trisClippedBatch.pushBack<std::uint16_t>(indexes[i] + target->baseVertexClipped);
     }
-    baseVertexClipped += vertCount;
+    target->baseVertexClipped += vertCount;
 
     const Float32 z = getNextZ();
     for (int v = 0; v < vertCount; ++v)
@@ -177,7 +1011,53 @@ void GeometryBatch::drawClipped2DTriangles(const VertexPTC * verts, const int ve
         vert.z += z; // Note that we actually add to the existing Z value.
                      // This is required by the 3D objects being screen protected.
 
-        vertsClippedBatch.pushBack<VertexPTC>(vert);
+        target->vertsClippedBatch.pushBack<VertexPTC>(vert);
+    }
+}
+
+void GeometryBatch::drawClippedTrianglesSorted(const VertexPTC * verts, const int vertCount,
+                                               const std::uint16_t * indexes, const int indexCount)
+{
+    struct SortTri
+    {
+        Float32 depth; // Sum of the vertex Zs. Higher Z is nearer, as with the GEQUAL depth test.
+        int     first; // First index of the triangle.
+    };
+
+    const int triCount = indexCount / 3;
+    SortTri * tris = static_cast<SortTri *>(frameArena.allocate(std::max(triCount, 1) * int(sizeof(SortTri))));
+
+    for (int t = 0; t < triCount; ++t)
+    {
+        const int first = t * 3;
+        NTB_ASSERT(indexes[first] < unsigned(vertCount) && indexes[first + 1] < unsigned(vertCount) && indexes[first + 2] < unsigned(vertCount));
+        tris[t].depth = verts[indexes[first]].z + verts[indexes[first + 1]].z + verts[indexes[first + 2]].z;
+        tris[t].first = first;
+    }
+
+    std::sort(tris, tris + triCount,
+              [](const SortTri & a, const SortTri & b)
+              {
+                  return (a.depth != b.depth) ? (a.depth < b.depth) : (a.first < b.first);
+              });
+
+    for (int t = 0; t < triCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            NTB_ASSERT(indexes[tris[t].first + k] + target->baseVertexClipped < kMaxVertsPerIndexChunk);
+            target->trisClippedBatch.pushBack<std::uint16_t>(indexes[tris[t].first + k] + target->baseVertexClipped);
+        }
+    }
+    target->baseVertexClipped += vertCount;
+
+    // Counts the layer, but everything goes at Z 0 so it also passes a depth test against the 2D elements.
+    getNextZ();
+    for (int v = 0; v < vertCount; ++v)
+    {
+        VertexPTC vert = verts[v];
+        vert.z = 0.0f;
+        target->vertsClippedBatch.pushBack<VertexPTC>(vert);
     }
 }
 
@@ -189,20 +1069,28 @@ void GeometryBatch::draw2DTriangles(const VertexPTC * verts, const int vertCount
     NTB_ASSERT(vertCount  > 0);
     NTB_ASSERT(indexCount > 0);
 
+    reserveIndexRange(target->chunks2D, target->baseVertex2D, target->verts2DBatch,
+                      target->tris2DBatch, nullptr, vertCount);
+
+    const int firstIndex  = target->tris2DBatch.getSize();
+    const int firstVertex = target->verts2DBatch.getSize();
+    addDrawItem(GeometrySegment::BatchType::Triangles2D, firstIndex, firstIndex + indexCount,
+                firstVertex, firstVertex + vertCount);
+
     for (int i = 0; i < indexCount; ++i)
     {
         NTB_ASSERT(indexes[i] < unsigned(vertCount));
-        NTB_ASSERT(indexes[i] + baseVertex2D <= UINT16_MAX);
-        tris2DBatch.pushBack<std::uint16_t>(indexes[i] + baseVertex2D);
+        NTB_ASSERT(indexes[i] + target->baseVertex2D < kMaxVertsPerIndexChunk);
+        target->tris2DBatch.pushBack<std::uint16_t>(indexes[i] + target->baseVertex2D);
     }
-    baseVertex2D += vertCount;
+    target->baseVertex2D += vertCount;
 
     const Float32 z = getNextZ();
     for (int v = 0; v < vertCount; ++v)
     {
         VertexPTC vert = verts[v];
         vert.z = z; // Just overwriting is fine.
-        verts2DBatch.pushBack<VertexPTC>(vert);
+        target->verts2DBatch.pushBack<VertexPTC>(vert);
     }
 }
 
@@ -211,6 +1099,12 @@ void GeometryBatch::drawLine(const int xFrom, const int yFrom,
                              const Color32 colorFrom,
                              const Color32 colorTo)
 {
+    if (linesAsQuads)
+    {
+        drawLineAsQuad(xFrom, yFrom, xTo, yTo, colorFrom, colorTo);
+        return;
+    }
+
     const Float32 z = getNextZ();
     const VertexPC vertFrom =
     {
@@ -224,8 +1118,11 @@ void GeometryBatch::drawLine(const int xFrom, const int yFrom,
         static_cast<Float32>(yTo),
         z, colorTo
     };
-    linesBatch.pushBack<VertexPC>(vertFrom);
-    linesBatch.pushBack<VertexPC>(vertTo);
+    const int firstVertex = target->linesBatch.getSize();
+    addDrawItem(GeometrySegment::BatchType::Lines, firstVertex, firstVertex + 2);
+
+    target->linesBatch.pushBack<VertexPC>(vertFrom);
+    target->linesBatch.pushBack<VertexPC>(vertTo);
 }
 
 void GeometryBatch::drawLine(const int xFrom, const int yFrom,
@@ -235,6 +1132,60 @@ void GeometryBatch::drawLine(const int xFrom, const int yFrom,
     drawLine(xFrom, yFrom, xTo, yTo, color, color);
 }
 
+void GeometryBatch::drawLineAsQuad(const int xFrom, const int yFrom,
+                                   const int xTo, const int yTo,
+                                   const Color32 colorFrom,
+                                   const Color32 colorTo)
+{
+    const bool xMajor   = std::abs(xTo - xFrom) >= std::abs(yTo - yFrom);
+    const int majorFrom = xMajor ? xFrom : yFrom;
+    const int majorTo   = xMajor ? xTo   : yTo;
+    const int minorFrom = xMajor ? yFrom : xFrom;
+    const int minorTo   = xMajor ? yTo   : xTo;
+    if (majorFrom == majorTo)
+    {
+        return; // A native line wouldn't light any pixel either.
+    }
+
+    // Edges of the pixels a native line lights along the major axis. Like GL_LINES, it starts at
+    // the first endpoint and doesn't light the last one. Wider lines are grown by the same number
+    // of pixels in both axes, as if drawn with a square pen, so rectangle outlines stay closed.
+    const bool forward  = majorTo > majorFrom;
+    const int growLow   = lineWidth / 2;
+    const int growHigh  = (lineWidth - 1) / 2;
+    const Float32 low   = (forward ? majorFrom - 0.5f : majorTo   + 0.5f) - growLow;
+    const Float32 high  = (forward ? majorTo   - 0.5f : majorFrom + 0.5f) + growHigh;
+    const Float32 slope = static_cast<Float32>(minorTo - minorFrom) / static_cast<Float32>(majorTo - majorFrom);
+
+    // Across the minor axis the quad is centered on the line (for odd widths).
+    const Float32 width     = static_cast<Float32>(lineWidth);
+    const Float32 minorLow  = minorFrom + (low  - majorFrom) * slope - 0.5f - growLow;
+    const Float32 minorHigh = minorFrom + (high - majorFrom) * slope - 0.5f - growLow;
+    const Color32 colorLow  = forward ? colorFrom : colorTo;
+    const Color32 colorHigh = forward ? colorTo   : colorFrom;
+
+    const Float32 quad[4][2] =
+    {
+        { low,  minorLow          },
+        { low,  minorLow  + width },
+        { high, minorHigh         },
+        { high, minorHigh + width }
+    };
+
+    VertexPTC verts[4];
+    for (int v = 0; v < 4; ++v)
+    {
+        verts[v].x = xMajor ? quad[v][0] : quad[v][1];
+        verts[v].y = xMajor ? quad[v][1] : quad[v][0];
+        verts[v].u = 0.0f;
+        verts[v].v = 0.0f;
+        verts[v].color = (v < 2) ? colorLow : colorHigh;
+    }
+
+    static const std::uint16_t indexes[6] = { 0, 1, 2, 2, 1, 3 };
+    draw2DTriangles(verts, lengthOfArray(verts), indexes, lengthOfArray(indexes));
+}
+
 void GeometryBatch::drawRectFilled(const Rectangle & rect, const Color32 c0,
                                    const Color32 c1, const Color32 c2, const Color32 c3)
 {
@@ -478,6 +1429,11 @@ void GeometryBatch::drawTextImpl(const char * text, const int textLength, Float3
     constexpr Float32 offsetU = +0.5f;
     constexpr Float32 offsetV = -0.5f;
 
+    // Glyphs are added as a single draw item once the string is done.
+    const int firstIndex  = target->textTrisBatch.getSize();
+    const int firstVertex = target->textVertsBatch.getSize();
+    const int firstGlyph  = target->glyphsBatch.getSize();
+
     int increment;
     for (int c = 0; c < textLength; c += increment)
     {
@@ -524,6 +1480,23 @@ void GeometryBatch::drawTextImpl(const char * text, const int textLength, Float3
         const Float32 u1 = u0 + (fixedWidth  / scaleU);
         const Float32 v1 = v0 + (fixedHeight / scaleV);
 
+        // The renderer builds the quad from the corner and the glyph size of the PackedFrame.
+        if (glyphInstances)
+        {
+            GlyphInstance glyph;
+            glyph.x     = x;
+            glyph.y     = y;
+            glyph.z     = charsZ;
+            glyph.scale = scaling;
+            glyph.u     = static_cast<std::uint16_t>(std::lround(clamp(u0, 0.0f, 1.0f) * UINT16_MAX));
+            glyph.v     = static_cast<std::uint16_t>(std::lround(clamp(v0, 0.0f, 1.0f) * UINT16_MAX));
+            glyph.color = color;
+            target->glyphsBatch.pushBack<GlyphInstance>(glyph);
+
+            x += chrW;
+            continue;
+        }
+
         VertexPTC verts[4];
         verts[0].x = x;
         verts[0].y = y;
@@ -546,20 +1519,33 @@ void GeometryBatch::drawTextImpl(const char * text, const int textLength, Float3
         verts[3].v = v1;
         verts[3].color = color;
 
+        reserveIndexRange(target->chunksText, target->baseVertexText, target->textVertsBatch,
+                          target->textTrisBatch, nullptr, 4);
+
         for (int i = 0; i < 6; ++i)
         {
-            NTB_ASSERT(indexes[i] + baseVertexText <= UINT16_MAX);
-            textTrisBatch.pushBack<std::uint16_t>(indexes[i] + baseVertexText);
+            NTB_ASSERT(indexes[i] + target->baseVertexText < kMaxVertsPerIndexChunk);
+            target->textTrisBatch.pushBack<std::uint16_t>(indexes[i] + target->baseVertexText);
         }
         for (int v = 0; v < 4; ++v)
         {
             verts[v].z = charsZ;
-            textVertsBatch.pushBack<VertexPTC>(verts[v]);
+            target->textVertsBatch.pushBack<VertexPTC>(verts[v]);
         }
 
-        baseVertexText += 4;
+        target->baseVertexText += 4;
         x += chrW;
     }
+
+    if (glyphInstances)
+    {
+        addDrawItem(GeometrySegment::BatchType::Text, firstGlyph, target->glyphsBatch.getSize());
+    }
+    else
+    {
+        addDrawItem(GeometrySegment::BatchType::Text, firstIndex, target->textTrisBatch.getSize(),
+                    firstVertex, target->textVertsBatch.getSize());
+    }
 }
 
 Float32 GeometryBatch::calcTextWidth(const char * text, const int textLength, const Float32 scaling)
@@ -1317,6 +2303,109 @@ Rectangle EditField::moveCursor(const Rectangle & displayBox, Float32 newPos, Fl
     return rect;
 }
 
+// ========================================================
+// class HitTestRows:
+// ========================================================
+
+HitTestRows::HitTestRows()
+    : activeChildren(sizeof(int), MemoryTag::Widgets)
+    , visitList(sizeof(int), MemoryTag::Widgets)
+    , bandStarts(sizeof(int), MemoryTag::Widgets)
+    , bandChildren(sizeof(int), MemoryTag::Widgets)
+    , firstY(0)
+    , bandHeight(1)
+    , bandCount(0)
+{
+}
+
+void HitTestRows::build(const Widget & owner)
+{
+    // About one band per child, so a list of variables stacked
+    // vertically ends up with one or two of them in each band.
+    const int childCount = owner.getChildCount();
+    const Rectangle & bounds = owner.getHitBounds();
+    const int height = std::max(bounds.getHeight(), 0) + 1; // yMaxs is inclusive.
+
+    firstY     = bounds.yMins;
+    bandHeight = std::max((height + childCount - 1) / std::max(childCount, 1), 8);
+    bandCount  = (height + bandHeight - 1) / bandHeight;
+
+    // Count the children overlapping each band, then turn the counts into offsets.
+    bandStarts.resize(bandCount + 1);
+    bandStarts.zeroFill();
+    int * starts = bandStarts.getData<int>();
+
+    for (int c = 0; c < childCount; ++c)
+    {
+        const Rectangle & childBounds = owner.getChild(c)->getHitBounds();
+        const int firstBand = clamp((childBounds.yMins - firstY) / bandHeight, 0, bandCount - 1);
+        const int lastBand  = clamp((childBounds.yMaxs - firstY) / bandHeight, 0, bandCount - 1);
+        for (int b = firstBand; b <= lastBand; ++b)
+        {
+            starts[b + 1]++;
+        }
+    }
+    for (int b = 0; b < bandCount; ++b)
+    {
+        starts[b + 1] += starts[b];
+    }
+
+    // Second pass writes the child indexes, in child order within each band.
+    // The visit list is free until the next mouse event, so it holds the write positions.
+    bandChildren.resize(starts[bandCount]);
+    visitList.resize(bandCount);
+    int * children = bandChildren.getData<int>();
+    int * writePos = visitList.getData<int>();
+    std::memcpy(writePos, starts, bandCount * sizeof(int));
+
+    for (int c = 0; c < childCount; ++c)
+    {
+        const Rectangle & childBounds = owner.getChild(c)->getHitBounds();
+        const int firstBand = clamp((childBounds.yMins - firstY) / bandHeight, 0, bandCount - 1);
+        const int lastBand  = clamp((childBounds.yMaxs - firstY) / bandHeight, 0, bandCount - 1);
+        for (int b = firstBand; b <= lastBand; ++b)
+        {
+            children[writePos[b]++] = c;
+        }
+    }
+    visitList.clear();
+
+    // The children keep their state, so carry over the ones still active.
+    activeChildren.clear();
+    for (int c = 0; c < childCount; ++c)
+    {
+        if (owner.getChild(c)->isHitActive())
+        {
+            activeChildren.pushBack(c);
+        }
+    }
+}
+
+void HitTestRows::clear()
+{
+    activeChildren.clear();
+    visitList.clear();
+    bandStarts.clear();
+    bandChildren.clear();
+    bandCount = 0;
+}
+
+const int * HitTestRows::getBand(const int y, int * outCount) const
+{
+    NTB_ASSERT(outCount != nullptr);
+
+    const int band = (y - firstY) / bandHeight;
+    if (y < firstY || band >= bandCount)
+    {
+        *outCount = 0;
+        return nullptr;
+    }
+
+    const int * starts = bandStarts.getData<int>();
+    *outCount = starts[band + 1] - starts[band];
+    return bandChildren.getData<int>() + starts[band];
+}
+
 // ========================================================
 // class Widget:
 // ========================================================
@@ -1325,12 +2414,16 @@ Widget::Widget()
     : gui(nullptr)
     , parent(nullptr)
     , colors(nullptr)
-    , children(sizeof(Widget *))
+    , children(sizeof(Widget *), MemoryTag::Widgets)
     , scaling(1.0f)
     , textScaling(1.0f)
     , flags(0)
+    , dirty(true)
+    , hitDirty(true)
+    , hitActive(false)
 {
     rect.setZero();
+    hitBounds.setZero();
     lastMousePos.setZero();
 }
 
@@ -1348,7 +2441,17 @@ void Widget::init(GUI * myGUI, Widget * myParent, const Rectangle & myRect, bool
 
     lastMousePos.setZero();
     setFlag(Flag_Visible, visible);
-    setNormalColors();
+
+    // The colors only change when entering or leaving the hover
+    // state, so they must match it if this is being reinitialized.
+    if (isMouseIntersecting())
+    {
+        setHighlightedColors();
+    }
+    else
+    {
+        setNormalColors();
+    }
 }
 
 bool Widget::onKeyPressed(KeyCode /*key*/, KeyModFlags /*modifiers*/)
@@ -1365,10 +2468,16 @@ bool Widget::onMouseButton(MouseButton button, int clicks)
         return false;
     }
 
-    const int childCount = getChildCount();
-    for (int c = 0; c < childCount; ++c)
+    updateHitBounds();
+
+    // Only the children that were active after the last mouse
+    // motion can respond, the others are not under the cursor.
+    const bool indexed = !hitRows.isEmpty();
+    const int count = indexed ? hitRows.activeChildren.getSize() : getChildCount();
+    for (int i = 0; i < count; ++i)
     {
-        if (getChild(c)->onMouseButton(button, clicks))
+        Widget * child = getChild(indexed ? hitRows.activeChildren.get<int>(i) : i);
+        if (child->isHitActive() && child->onMouseButton(button, clicks))
         {
             return true;
         }
@@ -1382,6 +2491,8 @@ bool Widget::onMouseButton(MouseButton button, int clicks)
 
 bool Widget::onMouseMotion(int mx, int my)
 {
+    updateHitBounds();
+
     // First, handle mouse drag:
     if (isMouseDragEnabled())
     {
@@ -1390,35 +2501,168 @@ bool Widget::onMouseMotion(int mx, int my)
 
     // Propagate the event to its children,
     // since they might overlap the parent.
+    // Only the ones with the cursor inside their hit bounds or that were
+    // active after the last event get it. The others would just be set
+    // to the normal state they already have.
     bool intersectingChildWidget = false;
-    const int childCount = getChildCount();
-    for (int c = 0; c < childCount; ++c)
+    bool activeChildWidget = false;
+    if (!hitRows.isEmpty())
+    {
+        // Merge the children in the band under the cursor with the ones active
+        // last time, which need the event to leave the hover state, in child order.
+        int bandSize = 0;
+        const int * band = hitRows.getBand(my, &bandSize);
+        const int * active = hitRows.activeChildren.getData<int>();
+        const int activeCount = hitRows.activeChildren.getSize();
+        const bool allChildren = isMouseDragEnabled(); // Children move with the parent.
+
+        hitRows.visitList.clear();
+        if (allChildren)
+        {
+            const int childCount = getChildCount();
+            for (int c = 0; c < childCount; ++c)
+            {
+                hitRows.visitList.pushBack(c);
+            }
+        }
+        else
+        {
+            int b = 0, a = 0;
+            while (b < bandSize || a < activeCount)
+            {
+                if (a == activeCount || (b < bandSize && band[b] < active[a]))
+                {
+                    if (shouldVisitForMotion(getChild(band[b]), mx, my))
+                    {
+                        hitRows.visitList.pushBack(band[b]);
+                    }
+                    ++b;
+                }
+                else
+                {
+                    if (b < bandSize && band[b] == active[a])
+                    {
+                        ++b;
+                    }
+                    hitRows.visitList.pushBack(active[a++]);
+                }
+            }
+        }
+
+        hitRows.activeChildren.clear();
+        const int visitCount = hitRows.visitList.getSize();
+        for (int i = 0; i < visitCount; ++i)
+        {
+            const int c = hitRows.visitList.get<int>(i);
+            if (c < getChildCount())
+            {
+                intersectingChildWidget |= visitChildForMotion(c, mx, my);
+                if (getChild(c)->isHitActive())
+                {
+                    hitRows.activeChildren.pushBack(c);
+                    activeChildWidget = true;
+                }
+            }
+        }
+    }
+    else
     {
-        intersectingChildWidget |= getChild(c)->onMouseMotion(mx, my);
+        const int childCount = getChildCount();
+        for (int c = 0; c < childCount; ++c)
+        {
+            if (shouldVisitForMotion(getChild(c), mx, my))
+            {
+                intersectingChildWidget |= visitChildForMotion(c, mx, my);
+                activeChildWidget |= getChild(c)->isHitActive();
+            }
+        }
     }
 
     // Even if it intersected a child element, we want
     // to notify the parent as well in case its rect
     // falls under the mouse cursor too.
-
-    if (rect.containsPoint(mx, my))
-    {
-        setHighlightedColors();
-        setMouseIntersecting(true);
-    }
-    else
-    {
-        setNormalColors();
-        setMouseIntersecting(false);
+    //
+    // Only entering or leaving the hover state changes the colors. Setting them
+    // every time would flip the bars a window highlights along with itself back
+    // and forth, redrawing the whole Panel on every mouse wiggle. The flag is
+    // still set every time, since that is where the windows highlight their bars.
+    const bool intersect = rect.containsPoint(mx, my);
+    if (intersect != isMouseIntersecting())
+    {
+        if (intersect)
+        {
+            setHighlightedColors();
+        }
+        else
+        {
+            setNormalColors();
+        }
     }
+    setMouseIntersecting(intersect);
 
     // Remember the mouse pointer position so we can
     // compute the displacement for mouse dragging.
     lastMousePos.x = mx;
     lastMousePos.y = my;
+
+    hitActive = isMouseIntersecting() || isMouseDragEnabled() ||
+                testFlag(Flag_HoldingScrollSlider) || activeChildWidget;
+
     return isMouseIntersecting() | intersectingChildWidget;
 }
 
+bool Widget::shouldVisitForMotion(const Widget * child, const int mx, const int my) const
+{
+    return child->isHitActive() || isMouseDragEnabled() || child->getHitBounds().containsPoint(mx, my);
+}
+
+bool Widget::visitChildForMotion(const int childIndex, const int mx, const int my)
+{
+    Widget * child = getChild(childIndex);
+
+    // An inactive child might have been skipped by the previous events, so its last
+    // mouse position is old. It would have been the same as this one's, which is still
+    // where the cursor was at the previous event, so catch up before it computes any
+    // displacement from it.
+    if (!child->isHitActive())
+    {
+        child->lastMousePos = lastMousePos;
+    }
+    return child->onMouseMotion(mx, my);
+}
+
+void Widget::refreshHitBounds()
+{
+    hitBounds = rect;
+
+    const int childCount = getChildCount();
+    for (int c = 0; c < childCount; ++c)
+    {
+        Widget * child = getChild(c);
+        child->refreshHitBounds();
+        hitBounds.expandToFit(child->getHitBounds());
+    }
+
+    if (childCount >= HitTestRows::MinChildren)
+    {
+        hitRows.build(*this);
+    }
+    else
+    {
+        hitRows.clear();
+    }
+    hitDirty = false;
+}
+
+void Widget::updateHitBounds()
+{
+    // Only the root keeps track of it, like the dirty flag.
+    if (parent == nullptr && hitDirty)
+    {
+        refreshHitBounds();
+    }
+}
+
 bool Widget::onMouseScroll(int /*yScroll*/)
 {
     // No default scroll event handling.
@@ -1452,6 +2696,11 @@ void Widget::onMove(int displacementX, int displacementY)
 {
     // Displacement may be positive or negative.
     rect.moveBy(displacementX, displacementY);
+
+    if (displacementX != 0 || displacementY != 0)
+    {
+        markDirty();
+    }
 }
 
 void Widget::onAdjustLayout()
@@ -1532,7 +2781,7 @@ void Widget::setNormalColors()
         // resizeHandle
         packColor(255, 255, 255),
     };
-    colors = &defaultColorsNormal;
+    setColors(&defaultColorsNormal);
 }
 
 void Widget::setHighlightedColors()
@@ -1588,7 +2837,30 @@ void Widget::setHighlightedColors()
         // resizeHandle
         packColor(255, 255, 255),
     };
-    colors = &defaultColorsMouseHover;
+    setColors(&defaultColorsMouseHover);
+}
+
+void Widget::markDirty() const
+{
+    // Only the root of the hierarchy keeps track of the dirty
+    // state, since the whole Panel window is redrawn in one go.
+    const Widget * root = this;
+    while (root->parent != nullptr)
+    {
+        root = root->parent;
+    }
+    root->dirty    = true;
+    root->hitDirty = true;
+}
+
+void Widget::markRedraw() const
+{
+    const Widget * root = this;
+    while (root->parent != nullptr)
+    {
+        root = root->parent;
+    }
+    root->dirty = true;
 }
 
 bool Widget::isChild(const Widget * widget) const
@@ -1795,6 +3067,7 @@ bool ButtonWidget::onMouseButton(MouseButton button, int clicks)
         {
             // Always toggle the button state.
             state = !state;
+            markDirty();
 
             // Fire the event if we have a listener.
             if (hasEventListener())
@@ -2196,7 +3469,6 @@ void InfoBarWidget::onResize(int displacementX, int displacementY, Corner corner
 
 ScrollBarWidget::ScrollBarWidget()
     : scrollBarOffsetY(0)
-    , scrollBarDisplacement(0)
     , scrollBarSizeFactor(0)
     , scrollBarThickness(0)
     , scrollBarButtonSize(0)
@@ -2382,34 +3654,24 @@ bool ScrollBarWidget::onMouseScroll(int yScroll)
 
 void ScrollBarWidget::doScrollUp()
 {
-    if (barSliderRect.yMins <= scrollStartY)
-    {
-        return;
-    }
-
-    if (parent != nullptr)
-    {
-        parent->onScrollContentUp();
-    }
-
-    if ((barSliderRect.yMins - (scrollBarDisplacement * 2)) < scrollStartY) // Don't go out of bounds
+    if (linesScrolledOut <= 0)
     {
-        scrollBarOffsetY -= scrollBarDisplacement;
-        // Snap to to the beginning of the scroll area.
-        scrollBarOffsetY += scrollStartY - (barSliderRect.yMins - scrollBarDisplacement);
+        return;
     }
-    else
+
+    if (parent != nullptr)
     {
-        scrollBarOffsetY -= scrollBarDisplacement;
+        parent->onScrollContentUp();
     }
 
     --linesScrolledOut;
-    barSliderRect = makeInnerBarRect();
+    refreshSliderRect();
+    markDirty();
 }
 
 void ScrollBarWidget::doScrollDown()
 {
-    if (barSliderRect.yMaxs >= scrollEndY)
+    if (linesScrolledOut >= linesOutOfView)
     {
         return;
     }
@@ -2419,18 +3681,24 @@ void ScrollBarWidget::doScrollDown()
         parent->onScrollContentDown();
     }
 
-    if ((barSliderRect.yMaxs + (scrollBarDisplacement * 2)) > scrollEndY) // Don't go out of bounds
+    ++linesScrolledOut;
+    refreshSliderRect();
+    markDirty();
+}
+
+void ScrollBarWidget::refreshSliderRect()
+{
+    // The slider position is proportional to the lines scrolled out, rather than a fixed number of
+    // pixels per line, so it still moves with more lines out of view than there are pixels to scroll.
+    if (linesOutOfView > 0)
     {
-        scrollBarOffsetY += scrollBarDisplacement;
-        // Snap to to the end of the scroll area.
-        scrollBarOffsetY -= (barSliderRect.yMaxs + scrollBarDisplacement) - scrollEndY;
+        const std::int64_t sliderRange = scrollEndY - scrollStartY - makeInnerBarRect().getHeight();
+        scrollBarOffsetY = static_cast<int>(sliderRange * linesScrolledOut / linesOutOfView);
     }
     else
     {
-        scrollBarOffsetY += scrollBarDisplacement;
+        scrollBarOffsetY = 0;
     }
-
-    ++linesScrolledOut;
     barSliderRect = makeInnerBarRect();
 }
 
@@ -2482,11 +3750,13 @@ void ScrollBarWidget::onAdjustLayout()
         {
             scrollBarSizeFactor = remap(4, 0, totalLines, 0, 100);
         }
+
+        // Rounds to zero with thousands of lines, but it is still scrollable.
+        scrollBarSizeFactor = std::max(scrollBarSizeFactor, 1);
     }
     else
     {
-        scrollBarSizeFactor   = 0;
-        scrollBarDisplacement = 0;
+        scrollBarSizeFactor = 0;
     }
 
     scrollBarOffsetY   = 0;
@@ -2497,15 +3767,9 @@ void ScrollBarWidget::onAdjustLayout()
     scrollStartY = upBtnRect.yMaxs   + Widget::uiScaled(5);
     scrollEndY   = downBtnRect.yMins - Widget::uiScaled(5);
 
-    if (linesOutOfView > 0)
-    {
-        const int sliderHeight = makeInnerBarRect().getHeight();
-        scrollBarDisplacement  = (scrollEndY - scrollStartY - sliderHeight) / linesOutOfView;
-        scrollBarOffsetY       = scrollBarDisplacement * linesScrolledOut;
-    }
-
-    // Now that we have the correct scrollBarOffsetY, rebuild the slider box:
-    barSliderRect = makeInnerBarRect();
+    // Now that we have the scroll area, place the slider box:
+    refreshSliderRect();
+    markDirty();
 }
 
 void ScrollBarWidget::updateLineScrollState(int lineCount, int linesOut)
@@ -2578,7 +3842,7 @@ Rectangle ScrollBarWidget::makeDownButtonRect() const
 // ========================================================
 
 ListWidget::ListWidget()
-    : entries(sizeof(Entry))
+    : entries(sizeof(Entry), MemoryTag::Widgets)
     , selectedEntry(None)
     , hoveredEntry(None)
 {
@@ -2698,6 +3962,7 @@ bool ListWidget::onMouseButton(MouseButton button, int clicks)
         {
             selectedEntry = index;
             eventHandled  = true;
+            markDirty();
 
             if (!onEntrySelectedDelegate.isNull())
             {
@@ -2712,6 +3977,7 @@ bool ListWidget::onMouseButton(MouseButton button, int clicks)
 bool ListWidget::onMouseMotion(int mx, int my)
 {
     bool eventHandled = Widget::onMouseMotion(mx, my);
+    const int prevHoveredEntry = hoveredEntry;
 
     // Check for intersection with the entries to highlight the hovered item:
     if (isMouseIntersecting())
@@ -2727,6 +3993,11 @@ bool ListWidget::onMouseMotion(int mx, int my)
         hoveredEntry = None;
     }
 
+    if (hoveredEntry != prevHoveredEntry)
+    {
+        markRedraw();
+    }
+
     return eventHandled;
 }
 
@@ -2752,6 +4023,7 @@ void ListWidget::allocEntries(int count)
     entries.zeroFill();
     selectedEntry = None;
     hoveredEntry  = None;
+    markDirty();
 }
 
 void ListWidget::addEntryText(int index, const char * value)
@@ -2762,6 +4034,7 @@ void ListWidget::addEntryText(int index, const char * value)
 
     addEntryRect(index, entry.lengthInChars);
     strings.append(value, entry.lengthInChars);
+    markDirty();
 }
 
 void ListWidget::addEntryRect(int entryIndex, int entryLengthInChars)
@@ -2940,6 +4213,7 @@ bool ColorPickerWidget::onMouseButton(MouseButton button, int clicks)
             const auto & selectedColor = detail::g_colorTable[selectedColorIndex];
 
             titleBar.setTitle(selectedColor.name);
+            markDirty();
 
             if (!onColorSelectedDelegate.isNull())
             {
@@ -2980,11 +4254,13 @@ bool ColorPickerWidget::onMouseScroll(int yScroll)
 void ColorPickerWidget::onScrollContentUp()
 {
     --colorButtonLinesScrolledUp;
+    markDirty();
 }
 
 void ColorPickerWidget::onScrollContentDown()
 {
     ++colorButtonLinesScrolledUp;
+    markDirty();
 }
 
 void ColorPickerWidget::refreshUsableRect()
@@ -3114,8 +4390,8 @@ View3DWidget::View3DWidget()
     , updateScrGeometry(true)
     , resettingAngles(false)
     , prevFrameTimeMs(0)
-    , scrProjectedVerts(sizeof(VertexPTC))
-    , scrProjectedIndexes(sizeof(std::uint16_t))
+    , scrProjectedVerts(sizeof(VertexPTC), MemoryTag::Widgets)
+    , scrProjectedIndexes(sizeof(std::uint16_t), MemoryTag::Widgets)
     , projParams()
 {
     mouseDelta.setZero();
@@ -3213,6 +4489,9 @@ void View3DWidget::onDraw(GeometryBatch & geoBatch) const
             resettingAngles = false;
         }
 
+        // Keep redrawing until the reset animation completes.
+        markDirty();
+
         if (!onAnglesChangedDelegate.isNull())
         {
             onAnglesChangedDelegate.invoke(this, rotationDegrees);
@@ -3331,8 +4610,12 @@ bool View3DWidget::onMouseButton(MouseButton button, int clicks)
             // Clicking the "R" button resets the angles.
             if (resetAnglesBtnRect.containsPoint(lastMousePos))
             {
+                // The window might not have been redrawn for a while, so restart
+                // the frame timer to avoid a large first step in the animation.
+                prevFrameTimeMs   = getShellInterface().getTimeMilliseconds();
                 resettingAngles   = true;
                 updateScrGeometry = true;
+                markDirty();
             }
             else
             {
@@ -3381,6 +4664,7 @@ bool View3DWidget::onMouseMotion(int mx, int my)
         resettingAngles   = false;
         updateScrGeometry = true;
         eventHandled      = true;
+        markRedraw();
 
         if (!onAnglesChangedDelegate.isNull())
         {
@@ -3399,6 +4683,7 @@ bool View3DWidget::onMouseScroll(int yScroll)
         resettingAngles   = false;
         updateScrGeometry = true;
         rotationDegrees.z = normalizeAngle360(rotationDegrees.z + (yScroll * mouseSensitivity));
+        markDirty();
 
         if (!onAnglesChangedDelegate.isNull())
         {
@@ -3420,6 +4705,7 @@ void View3DWidget::setMouseIntersecting(bool intersect)
     }
     else // If we lost mouse focus just cancel the last button down event.
     {
+        titleBar.setNormalColorsIfNotHovered();
         leftMouseButtonDown = false;
     }
 }
@@ -3607,7 +4893,7 @@ void View3DWidget::refreshProjectionViewport()
 // ========================================================
 
 MultiEditFieldWidget::MultiEditFieldWidget()
-    : fields(sizeof(Field))
+    : fields(sizeof(Field), MemoryTag::Widgets)
 {
 }
 
@@ -3843,8 +5129,13 @@ bool FloatValueSliderWidget::onButtonDown(ButtonWidget & button)
 
 VarDisplayWidget::VarDisplayWidget()
     : parentWindow(nullptr)
+    , nestedVars(sizeof(VarDisplayWidget *), MemoryTag::Widgets)
     , initialHeight(0)
     , titleWidth(0)
+    , rowIndent(0)
+    , rowMargin(0)
+    , rowTop(0)
+    , rowIndex(-1)
     , editFieldBackground(0)
 {
     dataDisplayRect.setZero();
@@ -3857,6 +5148,10 @@ VarDisplayWidget::~VarDisplayWidget()
     {
         parentWindow->removeEditField(&editField);
     }
+    if (parentWindow != nullptr)
+    {
+        parentWindow->removeVarRow(this);
+    }
 }
 
 void VarDisplayWidget::init(GUI * myGUI, VarDisplayWidget * myParent, const Rectangle & myRect,
@@ -3876,16 +5171,21 @@ void VarDisplayWidget::init(GUI * myGUI, VarDisplayWidget * myParent, const Rect
         titleWidth = (int)GeometryBatch::calcTextWidth(varName.c_str(), varName.getLength(), myGUI->getGlobalTextScaling());
     }
 
+    // Only the horizontal placement is kept, the window decides where the row goes vertically.
+    // The row starts out of view, until the window lays it out in updateVarRows().
+    if (myWindow != nullptr)
+    {
+        const Rectangle & windowRect = myWindow->getRect();
+        rowIndent = myRect.xMins - windowRect.xMins;
+        rowMargin = windowRect.xMaxs - myRect.xMaxs;
+        rowTop    = myRect.yMins - windowRect.yMins;
+    }
+    setFlag(Flag_ScrolledOutOfView, true);
+
     if (myParent != nullptr)
     {
         // Parent VarDisplayWidget gets an expand collapse button [+]/[-]
         myParent->addExpandCollapseButton();
-        myParent->addChild(this);
-    }
-    else if (myWindow != nullptr)
-    {
-        // Direct child of the window/panel.
-        myWindow->addChild(this);
     }
 
     const bool withValueEditButtons = testFlag(Flag_WithValueEditButtons);
@@ -3921,6 +5221,7 @@ void VarDisplayWidget::init(GUI * myGUI, VarDisplayWidget * myParent, const Rect
     if (parentWindow != nullptr)
     {
         parentWindow->addEditField(&editField);
+        parentWindow->addVarRow(this);
     }
 }
 
@@ -3945,21 +5246,7 @@ void VarDisplayWidget::onDraw(GeometryBatch & geoBatch) const
 
         if (!shouldDraw)
         {
-            editField.isVisisble = false;
-            expandCollapseButton.setVisible(false);
-            incrButton.setVisible(false);
-            decrButton.setVisible(false);
-            editPopupButton.setVisible(false);
-            checkboxButton.setVisible(false);
-
-            if (auto popupWidget = parentWindow->getPopupWidget())
-            {
-                if (popupWidget->getParent() == this)
-                {
-                    popupWidget->setVisible(false);
-                }
-            }
-
+            hideEditControls();
             return;
         }
         else
@@ -4012,15 +5299,28 @@ void VarDisplayWidget::onDraw(GeometryBatch & geoBatch) const
         drawVarName(geoBatch);          // Var name drawing (left side)
         drawVarValue(geoBatch);         // Displayed value (right side)
         drawValueEditButtons(geoBatch); // [+],[-] buttons (if enabled)
+        expandCollapseButton.onDraw(geoBatch);
     }
 
-    // Still go over the children even if this is not visible.
-    // The var might be scrolled out, but its children might
-    // still be visible.
+    // Nested vars are not children of this widget, the window draws
+    // the ones in view after their parent, same as any other row.
+}
+
+void VarDisplayWidget::hideEditControls() const
+{
+    editField.isVisisble = false;
+    expandCollapseButton.setVisible(false);
+    incrButton.setVisible(false);
+    decrButton.setVisible(false);
+    editPopupButton.setVisible(false);
+    checkboxButton.setVisible(false);
 
-    if (!isHierarchyCollapsed())
+    if (auto popupWidget = parentWindow->getPopupWidget())
     {
-        drawChildren(geoBatch);
+        if (popupWidget->getParent() == this)
+        {
+            popupWidget->setVisible(false);
+        }
     }
 }
 
@@ -4055,8 +5355,8 @@ void VarDisplayWidget::drawVarValue(GeometryBatch & geoBatch) const
     }
     else // Normal text display editor field:
     {
-        cachedValueText.clear();
-        if (!onGetVarValueText(cachedValueText))
+        bool changed = false;
+        if (!onUpdateVarValueText(cachedValueText, changed))
         {
             return;
         }
@@ -4068,6 +5368,64 @@ void VarDisplayWidget::drawVarValue(GeometryBatch & geoBatch) const
                            myColors.text.normal, myColors.text.selection, myColors.text.cursor,
                            backgroundColor, getTextScaling(), getScaling());
     }
+
+    // Blinking cursor needs to be redrawn continuously while editing.
+    if (editField.isActive)
+    {
+        markDirty();
+    }
+}
+
+bool VarDisplayWidget::refreshValueText() const
+{
+    // Only the values currently on display matter. Hidden
+    // ones will be queried when drawn again anyway.
+    if (!isVisible() || !editField.isVisisble)
+    {
+        return false;
+    }
+
+    // Displayed as a rectangle filled with the variable's color, no value text.
+    if (testFlag(Flag_ColorDisplayVar))
+    {
+        Color32 color = 0;
+        if (!onGetVarValueColor(color) || color == editFieldBackground)
+        {
+            return false;
+        }
+
+        editFieldBackground = color;
+        markDirty();
+        return true;
+    }
+
+    bool changed = false;
+    if (!onUpdateVarValueText(cachedValueText, changed) || !changed)
+    {
+        return false;
+    }
+
+    markDirty();
+    return true;
+}
+
+bool VarDisplayWidget::onUpdateVarValueText(SmallStr & valueText, bool & changed) const
+{
+    changed = false;
+
+    SmallStr newValueText;
+    newValueText.markTransient();
+    if (!onGetVarValueText(newValueText))
+    {
+        return false;
+    }
+
+    if (newValueText != valueText)
+    {
+        valueText = newValueText;
+        changed   = true;
+    }
+    return true;
 }
 
 void VarDisplayWidget::drawValueEditButtons(GeometryBatch & geoBatch) const
@@ -4098,6 +5456,11 @@ void VarDisplayWidget::onMove(int displacementX, int displacementY)
     {
         checkboxButton.onMove(displacementX, displacementY);
     }
+
+    if (hasExpandCollapseButton())
+    {
+        expandCollapseButton.onMove(displacementX, displacementY);
+    }
 }
 
 void VarDisplayWidget::onResize(int displacementX, int displacementY, Corner corner)
@@ -4141,12 +5504,8 @@ void VarDisplayWidget::onResize(int displacementX, int displacementY, Corner cor
         break;
     } // switch (corner)
 
-    // Propagate to the var hierarchy:
-    const int childCount = getChildCount();
-    for (int c = 0; c < childCount; ++c)
-    {
-        getChild(c)->onResize(displacementX, displacementY, corner);
-    }
+    // Nested vars in view are children of the window, so they get the event
+    // from it, and the ones out of view are laid out again when they come in.
 
     if (testFlag(Flag_WithValueEditButtons))
     {
@@ -4163,6 +5522,11 @@ void VarDisplayWidget::onResize(int displacementX, int displacementY, Corner cor
     {
         checkboxButton.onResize(displacementX, displacementY, corner);
     }
+
+    if (hasExpandCollapseButton())
+    {
+        expandCollapseButton.setRect(getExpandCollapseButtonRect());
+    }
 }
 
 void VarDisplayWidget::onAdjustLayout()
@@ -4184,6 +5548,8 @@ void VarDisplayWidget::onAdjustLayout()
     {
         expandCollapseButton.setRect(getExpandCollapseButtonRect());
     }
+
+    markDirty();
 }
 
 void VarDisplayWidget::onDisableEditing()
@@ -4218,6 +5584,11 @@ bool VarDisplayWidget::onMouseButton(MouseButton button, int clicks)
         isMouseIntersecting |= checkboxButton.onMouseButton(button, clicks);
     }
 
+    if (hasExpandCollapseButton())
+    {
+        isMouseIntersecting |= expandCollapseButton.onMouseButton(button, clicks);
+    }
+
     return isMouseIntersecting;
 }
 
@@ -4241,6 +5612,13 @@ bool VarDisplayWidget::onMouseMotion(int mx, int my)
         isMouseIntersecting |= checkboxButton.onMouseMotion(mx, my);
     }
 
+    // The button sits to the left of the row rect, so the row stays active while the cursor is over it.
+    if (hasExpandCollapseButton())
+    {
+        isMouseIntersecting |= expandCollapseButton.onMouseMotion(mx, my);
+        hitActive |= expandCollapseButton.isMouseIntersecting();
+    }
+
     return isMouseIntersecting;
 }
 
@@ -4315,13 +5693,6 @@ void VarDisplayWidget::addExpandCollapseButton()
     const Rectangle btnRect = getExpandCollapseButtonRect();
     expandCollapseButton.init(getGUI(), this, btnRect, isVisible(), ButtonWidget::Icon::Minus, this);
     expandCollapseButton.setState(true); // Hierarchy initially open.
-
-    // Note: Button is a child of the parent widget (WindowWidget), so that we
-    // keep this widget's children list reserved for nested VarDisplayWidgets.
-    if (parentWindow != nullptr)
-    {
-        parentWindow->addChild(&expandCollapseButton);
-    }
 }
 
 void VarDisplayWidget::setHierarchyVisibility(VarDisplayWidget * child, bool visible) const
@@ -4331,12 +5702,12 @@ void VarDisplayWidget::setHierarchyVisibility(VarDisplayWidget * child, bool vis
     child->setVisible(visible);
     child->setMinimized(!visible);
 
-    const int childCount = child->getChildCount();
-    for (int c = 0; c < childCount; ++c)
+    const int nestedCount = child->nestedVars.getSize();
+    for (int n = 0; n < nestedCount; ++n)
     {
         if (!child->isHierarchyCollapsed())
         {
-            setHierarchyVisibility(static_cast<VarDisplayWidget *>(child->getChild(c)), visible);
+            setHierarchyVisibility(child->nestedVars.get<VarDisplayWidget *>(n), visible);
         }
     }
 
@@ -4352,13 +5723,11 @@ void VarDisplayWidget::setHierarchyVisibility(VarDisplayWidget * child, bool vis
 
 void VarDisplayWidget::setExpandCollapseState(bool expanded)
 {
-    // Mark each child as hidden or visible, recursively:
-    const int childCount = getChildCount();
-    for (int c = 0; c < childCount; ++c)
+    // Mark each nested var as hidden or visible, recursively:
+    const int nestedCount = nestedVars.getSize();
+    for (int n = 0; n < nestedCount; ++n)
     {
-        // Children of VarDisplayWidget should only be other VarDisplayWidgets.
-        // The button is a child of the parent WindowWidget/Panel.
-        setHierarchyVisibility(static_cast<VarDisplayWidget *>(getChild(c)), expanded);
+        setHierarchyVisibility(nestedVars.get<VarDisplayWidget *>(n), expanded);
     }
 
     if (auto popupWidget = parentWindow->getPopupWidget())
@@ -4377,8 +5746,90 @@ void VarDisplayWidget::setExpandCollapseState(bool expanded)
     // Collapse the hidden variables in the window to fill the gaps.
     if (parentWindow != nullptr)
     {
-        parentWindow->onAdjustLayout();
+        parentWindow->invalidateVarRows(true);
+    }
+}
+
+void VarDisplayWidget::refreshHitBounds()
+{
+    Widget::refreshHitBounds();
+
+    // The expand/collapse button is outside the row rect.
+    if (hasExpandCollapseButton())
+    {
+        hitBounds.expandToFit(expandCollapseButton.getRect());
+    }
+}
+
+void VarDisplayWidget::setRowPosition(const int top)
+{
+    NTB_ASSERT(parentWindow != nullptr);
+    const Rectangle & windowRect = parentWindow->getRect();
+
+    const Rectangle newRect{ windowRect.xMins + rowIndent,
+                             windowRect.yMins + top,
+                             windowRect.xMaxs - rowMargin,
+                             windowRect.yMins + top + initialHeight };
+
+    // Coming back into view. The window might have started a drag in the meantime.
+    if (isScrolledOutOfView())
+    {
+        setScrolledOutOfView(false);
+        setMouseDragEnabled(parentWindow->isMouseDragEnabled());
+    }
+
+    // Only the rows in view get the scaling from the window, and the button is not a child.
+    if (getScaling() != parentWindow->getScaling() || getTextScaling() != parentWindow->getTextScaling())
+    {
+        setScaling(parentWindow->getScaling());
+        setTextScaling(parentWindow->getTextScaling());
+        expandCollapseButton.setScaling(parentWindow->getScaling());
+        expandCollapseButton.setTextScaling(parentWindow->getTextScaling());
+    }
+
+    // An open popup of this var follows the row.
+    if (top != rowTop)
+    {
+        if (auto popupWidget = parentWindow->getPopupWidget())
+        {
+            if (popupWidget->getParent() == this)
+            {
+                popupWidget->onMove(0, top - rowTop);
+            }
+        }
+        rowTop = top;
+    }
+
+    if (rect.xMins != newRect.xMins || rect.yMins != newRect.yMins ||
+        rect.xMaxs != newRect.xMaxs || rect.yMaxs != newRect.yMaxs)
+    {
+        rect = newRect;
+        onAdjustLayout();
+    }
+}
+
+void VarDisplayWidget::onScrolledOutOfView()
+{
+    setScrolledOutOfView(true);
+    setMouseDragEnabled(false);
+    hideEditControls();
+    clearHoverState();
+}
+
+void VarDisplayWidget::clearHoverState()
+{
+    // The mouse events stop at the rows in view, so a row leaving
+    // the view can't wait for the cursor to move away to lose its hover.
+    Widget * widgets[] = { this, &incrButton, &decrButton, &editPopupButton, &checkboxButton, &expandCollapseButton };
+    for (Widget * widget : widgets)
+    {
+        if (widget->isMouseIntersecting())
+        {
+            widget->setMouseIntersecting(false);
+            widget->setNormalColors();
+        }
     }
+    hitActive = false;
 }
 
 int VarDisplayWidget::getMinDataDisplayRectWidth() const
@@ -4503,6 +5954,15 @@ WindowWidget::WindowWidget()
     , scrollBarWidth(0)
     , minWindowWidth(0)
     , minWindowHeight(0)
+    , varRows(sizeof(VarDisplayWidget *), MemoryTag::Widgets)
+    , expandedRows(sizeof(VarDisplayWidget *), MemoryTag::Widgets)
+    , firstVarRow(0)
+    , varRowsInView(0)
+    , varRowTopSpacing(0)
+    , varRowStride(0)
+    , hasVarRows(false)
+    , varRowsOutdated(false)
+    , varRowListOutdated(false)
 {
     usableRect.setZero();
 }
@@ -4524,6 +5984,8 @@ void WindowWidget::init(GUI * myGUI, Widget * myParent, const Rectangle & myRect
     scrollBarWidth      = static_cast<std::int16_t>(scrollBarW);
     minWindowWidth      = static_cast<std::int16_t>(Widget::uiScaled(145)); // Defaults
     minWindowHeight     = static_cast<std::int16_t>(Widget::uiScaled(145));
+    varRowTopSpacing    = titleBarH + Widget::uiScaled(15); // Defaults, see setVarRowLayout()
+    varRowStride        = Widget::uiScaled(34);
 
     refreshBarRects(title, nullptr);
 
@@ -4607,6 +6069,222 @@ void WindowWidget::onAdjustLayout()
     // Keep the sub-rects up-to-date.
     refreshBarRects(nullptr, nullptr);
     refreshUsableRect();
+
+    // Might fit more or less rows now. Not done right away, since
+    // we might be in the middle of an event going over the children.
+    varRowsOutdated = true;
+    markDirty();
+}
+
+void WindowWidget::onScrollContentUp()
+{
+    if (hasVarRows && firstVarRow > 0)
+    {
+        --firstVarRow;
+        invalidateVarRows(false);
+    }
+}
+
+void WindowWidget::onScrollContentDown()
+{
+    if (hasVarRows && firstVarRow < expandedRows.getSize() - 1)
+    {
+        ++firstVarRow; // Clamped to the last page by updateVarRows().
+        invalidateVarRows(false);
+    }
+}
+
+void WindowWidget::addVarRow(VarDisplayWidget * row)
+{
+    NTB_ASSERT(row != nullptr);
+
+    // Nested vars go after the existing children of their parent var.
+    Widget * rowParent = row->getParent();
+    if (rowParent == this)
+    {
+        varRows.pushBack<VarDisplayWidget *>(row);
+    }
+    else
+    {
+        NTB_ASSERT(rowParent != nullptr);
+        static_cast<VarDisplayWidget *>(rowParent)->nestedVars.pushBack<VarDisplayWidget *>(row);
+    }
+
+    hasVarRows = true;
+    invalidateVarRows(true);
+}
+
+void WindowWidget::removeVarRow(VarDisplayWidget * row)
+{
+    NTB_ASSERT(row != nullptr);
+
+    if (popupWidget != nullptr && popupWidget->getParent() == row)
+    {
+        destroyPopupWidget();
+    }
+
+    // Rows in view are at the end of the children list.
+    if (!row->isScrolledOutOfView())
+    {
+        const int childCount = getChildCount();
+        for (int c = childCount - varRowsInView; c < childCount; ++c)
+        {
+            if (children.get<Widget *>(c) == row)
+            {
+                children.erase(c);
+                --varRowsInView;
+                break;
+            }
+        }
+        row->setScrolledOutOfView(true);
+    }
+
+    // Already detached by removeAllVarRows() or the removal of the parent var if null.
+    Widget * rowParent = row->getParent();
+    PODArray * siblings = nullptr;
+    if (rowParent == this)
+    {
+        siblings = &varRows;
+    }
+    else if (rowParent != nullptr)
+    {
+        siblings = &static_cast<VarDisplayWidget *>(rowParent)->nestedVars;
+    }
+
+    if (siblings != nullptr)
+    {
+        const int siblingCount = siblings->getSize();
+        for (int s = 0; s < siblingCount; ++s)
+        {
+            if (siblings->get<VarDisplayWidget *>(s) == row)
+            {
+                siblings->erase(s);
+                break;
+            }
+        }
+    }
+
+    // Nested vars go away with their parent, even if they outlive it.
+    detachVarRows(row->nestedVars);
+    invalidateVarRows(true);
+}
+
+void WindowWidget::removeAllVarRows()
+{
+    // Popups are always opened by one of the vars.
+    destroyPopupWidget();
+
+    while (varRowsInView > 0)
+    {
+        Widget * row = children.get<Widget *>(getChildCount() - 1);
+        children.popBack();
+        row->setScrolledOutOfView(true);
+        --varRowsInView;
+    }
+
+    // Each row removed afterwards finds itself already detached, so
+    // destroying all the vars doesn't search the lists for each one.
+    detachVarRows(varRows);
+    expandedRows.clear();
+    firstVarRow = 0;
+    invalidateVarRows(true);
+}
+
+void WindowWidget::detachVarRows(PODArray & rows)
+{
+    const int rowCount = rows.getSize();
+    for (int r = 0; r < rowCount; ++r)
+    {
+        VarDisplayWidget * row = rows.get<VarDisplayWidget *>(r);
+        detachVarRows(row->nestedVars);
+        row->setParent(nullptr);
+    }
+    rows.clear();
+}
+
+void WindowWidget::appendExpandedRows(VarDisplayWidget * row)
+{
+    row->rowIndex = expandedRows.getSize();
+    expandedRows.pushBack<VarDisplayWidget *>(row);
+
+    if (!row->isHierarchyCollapsed())
+    {
+        const int nestedCount = row->nestedVars.getSize();
+        for (int n = 0; n < nestedCount; ++n)
+        {
+            appendExpandedRows(row->nestedVars.get<VarDisplayWidget *>(n));
+        }
+    }
+}
+
+void WindowWidget::updateVarRows()
+{
+    if (!varRowsOutdated || !hasVarRows)
+    {
+        return;
+    }
+
+    if (varRowListOutdated)
+    {
+        expandedRows.clear();
+        const int topLevelCount = varRows.getSize();
+        for (int r = 0; r < topLevelCount; ++r)
+        {
+            appendExpandedRows(varRows.get<VarDisplayWidget *>(r));
+        }
+        varRowListOutdated = false;
+    }
+    varRowsOutdated = false;
+
+    // Rows that fit entirely in the usable area from the top spacing down.
+    const int rowCount = expandedRows.getSize();
+    int rowsFit = 0;
+    if (rowCount > 0 && varRowStride > 0)
+    {
+        const int rowHeight = expandedRows.get<VarDisplayWidget *>(0)->initialHeight;
+        const int space = usableRect.yMaxs - (rect.yMins + varRowTopSpacing) - rowHeight;
+        rowsFit = (space >= 0) ? (space / varRowStride) + 1 : 0;
+    }
+
+    const int maxFirstRow = std::max(rowCount - rowsFit, 0);
+    firstVarRow = std::min(std::max(firstVarRow, 0), maxFirstRow);
+    const int lastRow = std::min(firstVarRow + rowsFit, rowCount);
+
+    // Take the old rows in view off the children, keeping the state of the ones still in view.
+    while (varRowsInView > 0)
+    {
+        auto row = static_cast<VarDisplayWidget *>(children.get<Widget *>(getChildCount() - 1));
+        children.popBack();
+        --varRowsInView;
+
+        const int index = row->rowIndex;
+        if (index < firstVarRow || index >= lastRow || expandedRows.get<VarDisplayWidget *>(index) != row)
+        {
+            row->onScrolledOutOfView();
+        }
+    }
+
+    for (int r = firstVarRow; r < lastRow; ++r)
+    {
+        VarDisplayWidget * row = expandedRows.get<VarDisplayWidget *>(r);
+        row->setRowPosition(varRowTopSpacing + (r - firstVarRow) * varRowStride);
+        children.pushBack<Widget *>(row);
+    }
+    varRowsInView = lastRow - firstVarRow;
+
+    scrollBar.updateLineScrollState(rowCount, maxFirstRow, firstVarRow);
+    markDirty();
+}
+
+void WindowWidget::refreshHitBounds()
+{
+    Widget::refreshHitBounds();
+
+    // The popup is not one of the children, but can have children of its own.
+    if (popupWidget != nullptr)
+    {
+        popupWidget->refreshHitBounds();
+    }
 }
 
 void WindowWidget::onDisableEditing()
@@ -4615,6 +6293,7 @@ void WindowWidget::onDisableEditing()
     if (pEdit != nullptr)
     {
         pEdit->setActive(false);
+        markDirty();
     }
 }
 
@@ -4632,6 +6311,12 @@ void WindowWidget::setMouseIntersecting(bool intersect)
             infoBar.setHighlightedColors();
         }
     }
+    else
+    {
+        scrollBar.setNormalColorsIfNotHovered();
+        titleBar.setNormalColorsIfNotHovered();
+        infoBar.setNormalColorsIfNotHovered();
+    }
 }
 
 bool WindowWidget::onMouseButton(MouseButton button, int clicks)
@@ -4641,6 +6326,9 @@ bool WindowWidget::onMouseButton(MouseButton button, int clicks)
         return false;
     }
 
+    updateVarRows();
+    updateHitBounds();
+
     if (popupWidget != nullptr && popupWidget->onMouseButton(button, clicks))
     {
         return true;
@@ -4676,11 +6364,13 @@ bool WindowWidget::onMouseButton(MouseButton button, int clicks)
         }
     }
 
-    const int childCount = getChildCount();
-    for (int c = 0; c < childCount; ++c)
+    // Like Widget::onMouseButton, only the children active after the last mouse motion.
+    const bool indexed = !hitRows.isEmpty();
+    const int count = indexed ? hitRows.activeChildren.getSize() : getChildCount();
+    for (int i = 0; i < count; ++i)
     {
-        Widget * child = getChild(c);
-        if (child->onMouseButton(button, clicks))
+        Widget * child = getChild(indexed ? hitRows.activeChildren.get<int>(i) : i);
+        if (child->isHitActive() && child->onMouseButton(button, clicks))
         {
             // Bubble this message up to the parent (this)
             // or break the chain if one of the Widgets is
@@ -4709,6 +6399,9 @@ bool WindowWidget::onMouseMotion(int mx, int my)
         return false;
     }
 
+    updateVarRows();
+    updateHitBounds();
+
     // Window can go out from the sides and bottom, but not
     // out the top of the screen. We preempt movement at the
     // window level if that's the case.
@@ -4760,6 +6453,8 @@ bool WindowWidget::onMouseMotion(int mx, int my)
 
 bool WindowWidget::onMouseScroll(int yScroll)
 {
+    updateVarRows();
+
     // Allow child element to respond the event first (like a ColorPicker window)
     const int childCount = getChildCount();
     for (int c = 0; c < childCount; ++c)
@@ -4787,6 +6482,7 @@ bool WindowWidget::onKeyPressed(KeyCode key, KeyModFlags modifiers)
         return false;
     }
 
+    updateVarRows();
     const int childCount = getChildCount();
     for (int c = 0; c < childCount; ++c)
     {
@@ -4805,6 +6501,7 @@ void WindowWidget::destroyPopupWidget()
         destroy(popupWidget);
         implFree(popupWidget);
         popupWidget = nullptr;
+        markDirty();
     }
 }
 
@@ -4932,7 +6629,7 @@ void WindowWidget::refreshBarRects(const char * newTitle, const char * newInfoSt
                   btnOffsX, btnOffsY, titleBarButtonSize, gapBetweenButtons);
 
     // This is necessary to make sure we keep the highlighted colors on the bars.
-    // init() will always reset to the normal colors.
+    // init() resets them to the normal colors unless the cursor is over them.
     setMouseIntersecting(isMouseIntersecting());
 }
 
@@ -4999,8 +6696,8 @@ void ConsoleWindowWidget::init(GUI * myGUI, Widget * myParent, const Rectangle &
     maxLines   = maxLineCount;
     bufferUsed = 0;
     bufferSize = maxBufferSize;
-    lines      = implAllocT<Line>(maxLineCount);
-    buffer     = implAllocT<char>(maxBufferSize);
+    lines      = implAllocT<Line>(MemoryTag::Widgets, maxLineCount);
+    buffer     = implAllocT<char>(MemoryTag::Widgets, maxBufferSize);
 }
 
 void ConsoleWindowWidget::onDraw(GeometryBatch & geoBatch) const
@@ -5059,12 +6756,14 @@ void ConsoleWindowWidget::onScrollContentUp()
 {
     WindowWidget::onScrollContentUp();
     --firstLineDrawn;
+    markDirty();
 }
 
 void ConsoleWindowWidget::onScrollContentDown()
 {
     WindowWidget::onScrollContentDown();
     ++firstLineDrawn;
+    markDirty();
 }
 
 void ConsoleWindowWidget::pushLine(const char * text)
@@ -5094,6 +6793,7 @@ void ConsoleWindowWidget::pushLine(const char * text, int length)
 
     linesUsed  += 1;
     bufferUsed += length;
+    markDirty();
 }
 
 const char * ConsoleWindowWidget::getTextForLine(const Line & line) const
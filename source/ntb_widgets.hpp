@@ -30,6 +30,124 @@ enum class TextAlign
     Center
 };
 
+// ========================================================
+// class GeometrySegment:
+// ========================================================
+
+// A range of the GeometryBatch that was recorded between a
+// GeometryBatch::beginSegment/endSegment pair and kept around
+// by its owner (e.g. a Panel) so that it can be appended again
+// to a following frame without having to be re-tessellated.
+class GeometrySegment final
+{
+public:
+
+    GeometrySegment();
+
+    // Not copyable.
+    GeometrySegment(const GeometrySegment &) = delete;
+    GeometrySegment & operator = (const GeometrySegment &) = delete;
+
+    // Discards the recorded geometry but keeps the memory allocated.
+    void clear();
+
+    // True if nothing was recorded since the last clear().
+    bool isEmpty() const { return zLayerCount == 0; }
+
+    // Order of the frame the segment was recorded for. It can only be appended to frames with the same order.
+    DrawOrder getDrawOrder() const { return drawOrder; }
+
+    // Width of the lines recorded as quads, or 0 if they were recorded as native lines.
+    int getLineQuadWidth() const { return lineQuadWidth; }
+
+    // True if the text was recorded as GlyphInstances instead of triangles.
+    bool isUsingGlyphInstances() const { return glyphInstances; }
+
+    // Indexed triangle batches are split into chunks of at most 65536 vertexes,
+    // so they can be drawn with 16-bits indexes. Indexes (and DrawClippedInfo::firstIndex)
+    // are relative to the start of their chunk, and each chunk is a separate draw call.
+    // The chunk arrays hold where each chunk after the first one starts, so they
+    // stay empty unless the batch gets really big.
+    struct IndexChunk
+    {
+        int firstVertex;
+        int firstIndex;
+        int firstDrawInfo; // Only used by the clipped batch.
+    };
+
+    // Each draw call is also recorded as an item, so the frame can be packed in the order it
+    // was drawn (see DrawOrder::Painter) or sorted by layer. [first, end) are positions in the
+    // triangle indexes of the 2D and text batches, in the DrawClippedInfos of the clipped batch
+    // and in the vertexes of the lines batch. [firstVertex, endVertex) are the vertexes of the
+    // 2D and text triangles; a draw call always adds its vertexes in one contiguous range.
+    // With glyph instances, [first, end) of the text items are positions in the glyphs batch.
+    enum class BatchType
+    {
+        Triangles2D,
+        Text,
+        Clipped,
+        Lines
+    };
+    struct DrawItem
+    {
+        BatchType batch;
+        int first;
+        int end;
+        int firstVertex;
+        int endVertex;
+    };
+
+private:
+
+    friend class GeometryBatch;
+
+    // Z layer and vertex offsets of the frame when the segment was recorded.
+    // Appending the segment to another frame rebases its Z and the indexes
+    // of its first chunk by the difference to the current frame offsets.
+    int zLayerFirst;
+    int zLayerCount;
+    DrawOrder drawOrder;
+    int lineQuadWidth;
+    bool glyphInstances;
+    int firstVertex2D;
+    int firstVertexText;
+    int firstVertexClipped;
+
+    // Current offsets for the 2D/text index buffers,
+    // relative to the start of the current chunk.
+    int baseVertex2D;
+    int baseVertexText;
+    int baseVertexClipped;
+
+    // Starts of the chunks after the first. [IndexChunk]
+    PODArray chunks2D;
+    PODArray chunksText;
+    PODArray chunksClipped;
+
+    // Every draw call, in draw order. [DrawItem]
+    PODArray drawItems;
+
+    // Batch for 2D colored lines.
+    PODArray linesBatch;        // [VertexPC]
+
+    // Batch for all untextured 2D triangles (indexed).
+    PODArray verts2DBatch;      // [VertexPTC] Miscellaneous 2D elements.
+    PODArray tris2DBatch;       // [std::uint16_t] Triangle indexes for the 2D elements.
+
+    // Batch for all 2D text glyphs (indexed).
+    PODArray textVertsBatch;    // [VertexPTC] Vertexes for 2D text glyphs.
+    PODArray textTrisBatch;     // [std::uint16_t] Indexes for the 2D text triangles.
+
+    // Text glyphs when drawn by RenderInterfaces that supportsGlyphInstances(), instead of the above.
+    PODArray glyphsBatch;       // [GlyphInstance]
+
+    // Separate batch for the clipped 2D vertexes
+    // (normally sent from the 3D widgets).
+    PODArray drawClippedInfos;  // [DrawClippedInfo]
+    PODArray vertsClippedBatch; // [VertexPTC]
+    PODArray trisClippedBatch;  // [std::uint16_t]
+};
+
 // ========================================================
 // class GeometryBatch:
 // ========================================================
@@ -51,9 +169,31 @@ public:
     void preallocateBatches(int lines, int quads, int textGlyphs, int drawClipped);
 
     // Draw batch setup. Forwards to RenderInterface::beginDraw/endDraw.
+    // beginDraw() discards the geometry of the previous frame, endDraw() submits
+    // the new batches but keeps them around for a later resubmitLastFrame().
     void beginDraw();
     void endDraw();
 
+    // Submits the batches built by the last beginDraw/endDraw pair again, as they are.
+    // Used when nothing in the UI has changed since the previous frame. Also forwards
+    // to RenderInterface::beginDraw/endDraw, so it replaces a beginDraw/endDraw pair.
+    void resubmitLastFrame();
+
+    // Redirects the following draw calls to the given segment, which is cleared first.
+    // endSegment() then appends the recorded geometry to the frame. The segment can be
+    // appended to later frames with appendSegment() for as long as its contents are valid.
+    // Segments cannot be nested.
+    void beginSegment(GeometrySegment & segment);
+    void endSegment();
+
+    // Appends geometry recorded by a previous beginSegment/endSegment pair to the
+    // current frame. Z layers and indexes are rebased to the frame's current offsets.
+    void appendSegment(const GeometrySegment & segment);
+
+    // True if the segment was recorded with the current draw order, line and text settings.
+    // Otherwise it has to be recorded again before it can be appended.
+    bool canAppendSegment(const GeometrySegment & segment) const;
+
     // Filled triangles with clipping (used by the 3D widgets).
     void drawClipped2DTriangles(const VertexPTC * verts, int vertCount,
                                 const std::uint16_t * indexes, int indexCount,
@@ -66,6 +206,16 @@ public:
     void drawLine(int xFrom, int yFrom, int xTo, int yTo, Color32 color);
     void drawLine(int xFrom, int yFrom, int xTo, int yTo, Color32 colorFrom, Color32 colorTo);
 
+    // Lines are drawn as native one pixel lines by default, in a batch of their own.
+    // As quads they go in the 2D triangles batch instead, so the frame takes one draw
+    // command less, and they can be wider than one pixel. Both settings take effect for
+    // the geometry drawn after they are changed; segments recorded before that are
+    // rejected by canAppendSegment().
+    void setLinesAsQuads(bool asQuads) { linesAsQuads = asQuads; }
+    bool isDrawingLinesAsQuads() const { return linesAsQuads; }
+    void setLineWidth(int width) { lineWidth = std::max(width, 1); }
+    int getLineWidth() const { return lineWidth; }
+
     // Filled rectangle (possibly translucent):
     void drawRectFilled(const Rectangle & rect, Color32 color);
     void drawRectFilled(const Rectangle & rect, Color32 c0, Color32 c1, Color32 c2, Color32 c3);
@@ -96,13 +246,78 @@ public:
 
     // Next Z layer for the frame. Z layers are reset at beginDraw() and incremented
     // every time this method gets called, so no two draw call will have overlapping Z.
-    Float32 getNextZ() { return static_cast<Float32>(currentZ++); }
+    // With DrawOrder::Painter the layers are still counted, but everything is at Z 0.
+    Float32 getNextZ()
+    {
+        const int z = currentZ++;
+        return (drawOrder == DrawOrder::Painter) ? 0.0f : static_cast<Float32>(z);
+    }
+
+    // Order of the current frame, from RenderInterface::getDrawOrder() at beginDraw().
+    DrawOrder getDrawOrder() const { return drawOrder; }
+
+    // If the text of the current frame goes in GlyphInstances, from RenderInterface::supportsGlyphInstances()
+    // at beginDraw(). Otherwise each glyph is a quad of the text triangles batch.
+    bool isUsingGlyphInstances() const { return glyphInstances; }
+
+    // When enabled, endDraw() reorders the draw calls that don't overlap on screen, grouping them
+    // by layer and batch so the frame is drawn with as few commands as possible. Overlapping ones
+    // keep their relative order, so the result is the same as drawing everything in order, with or
+    // without the depth test. Takes effect on the next endDraw(). Off by default.
+    void setSortPrimitives(bool sort) { sortPrimitives = sort; }
+    bool isSortingPrimitives() const { return sortPrimitives; }
+
+    // Command counts of the frame built by the last endDraw().
+    DrawCallStats getLastDrawCallStats() const { return drawCallStats; }
+
+    // Scratch memory for transient per-frame work, such as the value strings of
+    // the variables. Reset by beginDraw() and resubmitLastFrame(), so anything
+    // allocated from it must be gone by the next frame. See FrameArena::Scope.
+    FrameArena & getFrameArena() { return frameArena; }
 
 private:
 
     // Calls in the RenderInterface to allocate the glyph bitmap.
     void createGlyphTexture();
 
+    // Copies the indexed batches of the frame into the packed arrays, one DrawCommand per chunk.
+    // With DrawOrder::Painter or sorting, packFrameItems() is used instead, which emits the draw
+    // items in order, merging consecutive ones from the same batch and chunk into a single command.
+    void packFrame();
+    void packFrameItems(const int * itemOrder);
+
+    // Appends to packedVerts, or to packedCompactVerts if packing compact vertexes and not
+    // 'clipped' (ClippedTriangles always use the full format). Returns the index of the first one.
+    int appendPackedVerts(const VertexPTC * verts, int vertCount, bool clipped);
+
+    // True if the renderer takes compact vertexes and all the unclipped ones of the frame fit them.
+    bool canPackCompactVertexes() const;
+
+    // Sort stage: Fills 'itemOrder' with the draw item indexes sorted by layer, then batch.
+    // An item's layer is the lowest one that keeps it above every earlier item it overlaps.
+    void sortDrawItems(int * itemOrder);
+
+    // Screen bounds of a draw item, for the overlap tests of sortDrawItems().
+    Rectangle getDrawItemBounds(const GeometrySegment::DrawItem & item) const;
+
+    // Painter order path of drawClipped2DTriangles(): triangles go back to front, all at Z 0.
+    void drawClippedTrianglesSorted(const VertexPTC * verts, int vertCount, const std::uint16_t * indexes, int indexCount);
+
+    // drawLine() path for setLinesAsQuads(). One pixel wide, it covers the same pixels as a native line,
+    // except maybe one pixel here and there where a diagonal passes exactly between two of them.
+    void drawLineAsQuad(int xFrom, int yFrom, int xTo, int yTo, Color32 colorFrom, Color32 colorTo);
+
+    // Records a draw call into the target's draw items.
+    void addDrawItem(GeometrySegment::BatchType batch, int first, int end, int firstVertex = 0, int endVertex = 0);
+
+    // PackedFrame view of the last packFrame(), for RenderInterface::drawPackedFrame().
+    PackedFrame makePackedFrame() const;
+
+    // Makes sure the next 'vertCount' vertexes of a batch can be addressed with
+    // 16-bits indexes, starting a new chunk (see GeometrySegment) if needed.
+    static void reserveIndexRange(PODArray & chunks, int & baseVertex, const PODArray & verts,
+                                  const PODArray & indexes, const PODArray * drawInfos, int vertCount);
+
     // Handles newlines, spaces and tabs. String doesn't have to be NUL-terminated, we rely on textLength instead.
     void drawTextImpl(const char * text, int textLength, Float32 x, Float32 y, Float32 scaling, Color32 color);
 
@@ -113,27 +328,48 @@ private:
     // incremented for each line/triangle that is added to the batch.
     int currentZ;
 
-    // Current offsets for the 2D/text index buffers.
-    std::uint16_t baseVertex2D;
-    std::uint16_t baseVertexText;
-    std::uint16_t baseVertexClipped;
+    // Draw order of the current (or last) frame.
+    DrawOrder drawOrder;
 
-    // Batch for 2D colored lines.
-    PODArray linesBatch;        // [VertexPC]
+    // See isUsingGlyphInstances().
+    bool glyphInstances;
 
-    // Batch for all untextured 2D triangles (indexed).
-    PODArray verts2DBatch;      // [VertexPTC] Miscellaneous 2D elements.
-    PODArray tris2DBatch;       // [std::uint16_t] Triangle indexes for the 2D elements.
+    // See setSortPrimitives().
+    bool sortPrimitives;
 
-    // Batch for all 2D text glyphs (indexed).
-    PODArray textVertsBatch;    // [VertexPTC] Vertexes for 2D text glyphs.
-    PODArray textTrisBatch;     // [std::uint16_t] Indexes for the 2D text triangles.
+    // See setLinesAsQuads(). The width only applies to quads.
+    bool linesAsQuads;
+    int lineWidth;
 
-    // Separate batch for the clipped 2D vertexes
-    // (normally sent from the 3D widgets).
-    PODArray drawClippedInfos;  // [DrawClippedInfo]
-    PODArray vertsClippedBatch; // [VertexPTC]
-    PODArray trisClippedBatch;  // [std::uint16_t]
+    // Set by packFrame() if the lines, glyphs and clip infos were copied to the packed arrays, in command order.
+    bool packedItems;
+
+    // Set by packFrame() if the Triangles commands draw from packedCompactVerts.
+    bool packedCompact;
+    DrawCallStats drawCallStats;
+
+    // Batches for the whole frame, sent to the RenderInterface at endDraw().
+    GeometrySegment frameGeometry;
+
+    // Where the draw calls go. Either the frameGeometry or the segment being recorded.
+    GeometrySegment * target;
+
+    // Unlike the arena, the batches must outlive the frame (for resubmitLastFrame and
+    // the Panel segment caches), so they are regular arrays that just keep their capacity.
+    FrameArena frameArena;
+
+    // The indexed batches of the last frame concatenated, so the
+    // RenderInterface can upload the whole frame at once.
+    PODArray packedVerts;        // [VertexPTC]
+    PODArray packedCompactVerts; // [VertexPTCCompact]
+    PODArray packedIndexes;      // [std::uint16_t]
+    PODArray packedCommands;     // [DrawCommand]
+    PODArray packedLineVerts;    // [VertexPC]
+    PODArray packedDrawInfos;    // [DrawClippedInfo]
+    PODArray packedGlyphs;       // [GlyphInstance]
+
+    // Per-cell item lists of sortDrawItems(), kept to reuse the memory. [SortCellNode]
+    PODArray sortCellNodes;
 };
 
 // ========================================================
@@ -258,6 +494,53 @@ public:
     Rectangle moveCursor(const Rectangle & displayBox, Float32 newPos, Float32 textScaling, Float32 uiScaling);
 };
 
+// ========================================================
+// class HitTestRows:
+// ========================================================
+
+// Index of the children of a Widget by horizontal bands of the screen, so that
+// the mouse events only test the children overlapping the band under the cursor,
+// instead of going over all of them. Only built for Widgets with a lot of children,
+// like a Panel window with thousands of variables. See Widget::refreshHitBounds().
+class HitTestRows final
+{
+public:
+
+    // Widgets with fewer children than this just test them all.
+    static constexpr int MinChildren = 32;
+
+    HitTestRows();
+
+    // Not copyable.
+    HitTestRows(const HitTestRows &) = delete;
+    HitTestRows & operator = (const HitTestRows &) = delete;
+
+    // Buckets the children of 'owner' by their hit bounds, which must be up-to-date.
+    void build(const Widget & owner);
+    void clear();
+    bool isEmpty() const { return bandCount == 0; }
+
+    // Indexes of the children in the band of the given Y, in child order.
+    // Children with the point outside their hit bounds are included too.
+    const int * getBand(int y, int * outCount) const;
+
+    // Children that were active after the last mouse motion event (see Widget::isHitActive),
+    // in child order. Kept by Widget::onMouseMotion, so they get the event that clears their
+    // hover state even after the cursor left their band.
+    PODArray activeChildren;  // [int]
+
+    // Scratch list of the children visited by a mouse motion event.
+    PODArray visitList;       // [int]
+
+private:
+
+    PODArray bandStarts;      // [int] bandCount+1 offsets into bandChildren.
+    PODArray bandChildren;    // [int] Child indexes of each band.
+    int      firstY;
+    int      bandHeight;
+    int      bandCount;
+};
+
 // ========================================================
 // class Widget:
 // ========================================================
@@ -350,6 +633,7 @@ public:
     void setRect(const Rectangle & newRect);
     void setNormalColors();
     void setHighlightedColors();
+    void setNormalColorsIfNotHovered();
 
     const ColorScheme & getColors() const;
     const Rectangle & getRect() const;
@@ -380,6 +664,25 @@ public:
     bool testFlag(std::uint32_t mask) const;
     void setFlag(std::uint32_t mask, int f);
 
+    // Redraw tracking. Any change that affects how a widget is drawn should call
+    // markDirty(), which flags the root of its hierarchy (normally a Panel window).
+    // isDirty/clearDirty are only meaningful for the root widget.
+    // markDirty() also invalidates the hit bounds of the hierarchy, since the change
+    // might have moved things around. markRedraw() is for the changes that only affect
+    // colors, like the mouse hover highlight, and keeps them.
+    void markDirty() const;
+    void markRedraw() const;
+    bool isDirty() const;
+    void clearDirty();
+
+    // Hit-testing. Each widget keeps the bounds of its rect and the rects of all
+    // its descendants, so the mouse events skip the children that are not under the
+    // cursor and have no hover or drag state to update. The root refreshes the bounds
+    // of the whole hierarchy at the start of the first mouse event after a markDirty().
+    const Rectangle & getHitBounds() const;
+    bool isHitActive() const;
+    virtual void refreshHitBounds();
+
     // Debug printing helpers:
     #if NEO_TWEAK_BAR_DEBUG
     virtual SmallStr getTypeString() const;
@@ -391,6 +694,11 @@ protected:
     void drawSelf(GeometryBatch & geoBatch) const;
     void drawChildren(GeometryBatch & geoBatch) const;
 
+    // Refreshes the hit bounds if this is the root and they were invalidated.
+    void updateHitBounds();
+    bool shouldVisitForMotion(const Widget * child, int mx, int my) const;
+    bool visitChildForMotion(int childIndex, int mx, int my);
+
     GUI               * gui;          // Direct pointer to the owning UI for things like color-scheme and scaling; never null.
     Widget            * parent;       // Direct parent in the hierarchy (Panel/Window); may be null.
     const ColorScheme * colors;       // A pointer so we can hot swap it, but never null.
@@ -398,8 +706,13 @@ protected:
     Float32             scaling;      // Scaling factor applied to the UI geometry.
     Float32             textScaling;  // Scaling applied to the text only.
     std::uint32_t       flags;        // Miscellaneous state flags (from the Flags enum).
+    mutable bool        dirty;        // Set by markDirty() on the root widget. Cleared once it gets redrawn.
+    mutable bool        hitDirty;     // Set by markDirty() on the root widget. Cleared by refreshHitBounds().
+    bool                hitActive;    // Hovered, dragged or holding a slider, itself or a descendant, after the last event.
     Rectangle           rect;         // Drawable rectangle.
+    Rectangle           hitBounds;    // Union of the rect and the hit bounds of the children.
     Point               lastMousePos; // Saved from last time onMouseMotion() was called.
+    HitTestRows         hitRows;      // Only built for widgets with lots of children.
 };
 
 // ========================================================
@@ -590,6 +903,7 @@ private:
 
     void doScrollUp();
     void doScrollDown();
+    void refreshSliderRect();
 
     Rectangle makeInnerBarRect() const;
     Rectangle makeUpButtonRect() const;
@@ -597,7 +911,6 @@ private:
 
     // Scroll slider states:
     int scrollBarOffsetY;      // Current Y start of slider bar.
-    int scrollBarDisplacement; // Amount to move each click.
     int scrollBarSizeFactor;   // Slider box scale: [0,100].
     int scrollBarThickness;    // Thickness of slider bar. A fraction of the bar's box.
     int scrollBarButtonSize;
@@ -992,6 +1305,7 @@ public:
     void onAdjustLayout() override final;
     void onDisableEditing() override final;
     void setVisible(bool visible) override final;
+    void refreshHitBounds() override final;
 
     bool onMouseButton(MouseButton button, int clicks) override final;
     bool onMouseMotion(int mx, int my) override final;
@@ -999,6 +1313,11 @@ public:
     bool onKeyPressed(KeyCode key, KeyModFlags modifiers) override final;
     bool onButtonDown(ButtonWidget & button) override final;
 
+    // Horizontal placement of the row, as the distance of its rect from the left side of the
+    // parent window. The window sets the vertical position (see WindowWidget::updateVarRows).
+    int getRowIndent() const;
+    void setRowIndent(int indent);
+
     void setButtonTextScaling(Float32 s);
     int getExpandCollapseButtonSize() const;
     Rectangle getExpandCollapseButtonRect() const;
@@ -1009,6 +1328,11 @@ public:
     const Rectangle & getDataDisplayRect() const;
     void setDataDisplayRect(const Rectangle & newRect);
 
+    // Queries the current value text of a displayed variable and compares it against the
+    // text drawn in the last frame. Marks the widget dirty and returns true if it changed.
+    // Colors displayed as a colored rectangle compare the color value instead.
+    bool refreshValueText() const;
+
     const WindowWidget * getParentWindow() const;
     WindowWidget * getParentWindow();
 
@@ -1023,6 +1347,12 @@ public:
 protected:
 
     virtual bool onGetVarValueText(SmallStr &) const { return false; }
+    virtual bool onGetVarValueColor(Color32 &) const { return false; }
+
+    // Brings 'valueText', which holds the text of the previous query, up-to-date with the
+    // variable value, setting 'changed' accordingly. Returns false if the variable has no
+    // value text, like onGetVarValueText(). Default reformats and compares the whole text.
+    virtual bool onUpdateVarValueText(SmallStr & valueText, bool & changed) const;
     virtual void onSetVarValueText(const SmallStr &) {}
 
     virtual void onIncrementButton() {}
@@ -1031,7 +1361,7 @@ protected:
     virtual void onCheckboxButton(bool)  {}
 
     void setExpandCollapseState(bool expanded);
-    void setEditFieldBackground(Color32 bg) { editFieldBackground = bg; }
+    void setEditFieldBackground(Color32 bg) { editFieldBackground = bg; markDirty(); }
     ButtonWidget & getEditPopupButton() { return editPopupButton; }
 
 private:
@@ -1048,25 +1378,46 @@ private:
     Rectangle makeDataDisplayAndButtonRects(ButtonRects & outBtnRects, bool withValueEditButtons, bool withEditPopupButton, bool withCheckboxButton) const;
     void setHierarchyVisibility(VarDisplayWidget* child, bool visible) const;
 
+    // Called by the parent window as the row enters or leaves the rows in view.
+    void setRowPosition(int top);
+    void onScrolledOutOfView();
+    void hideEditControls() const;
+    void clearHoverState();
+
     void drawVarName(GeometryBatch& geoBatch) const;
     void drawVarValue(GeometryBatch& geoBatch) const;
     void drawValueEditButtons(GeometryBatch& geoBatch) const;
 
 private:
 
+    // The window keeps the row lists and lays out the rows in view.
+    friend class WindowWidget;
+
     // Need the extra reference to the parent window because the
     // 'parent' field of a VarDisplayWidget might be another
     // VarDisplayWidget for nested var instances.
     WindowWidget * parentWindow;
 
+    // Nested child VarDisplayWidgets, in display order. They are not in the children
+    // list, since only the rows in view are children, and those of the window.
+    PODArray nestedVars; // [VarDisplayWidget *]
+
     // Cached data:
     Rectangle dataDisplayRect;
     int initialHeight;
     int titleWidth;
 
+    // Row placement in the parent window. The indent and margin are the distances of the
+    // rect from the left and right sides of the window, the top is the distance from the
+    // top of the window when it was last placed. rowIndex is the position in the window's
+    // list of expanded rows, only meaningful while the row is in that list.
+    int rowIndent;
+    int rowMargin;
+    int rowTop;
+    int rowIndex;
+
     // Button state true if hierarchy open, false if collapsed.
-    // Note that the button will be made a child of the parent widget (Window), so the
-    // VarDisplayWidget::children list only containers nested child VarDisplayWidgets.
+    // Drawn and fed the mouse events by the VarDisplayWidget, like the other buttons.
     mutable ButtonWidget expandCollapseButton;
 
     // [+][-] edit buttons for numbers.
@@ -1081,9 +1432,10 @@ private:
 
     // Mutable because EditField::drawSelf() needs to update some internal state.
     mutable EditField editField;
-    Color32 editFieldBackground;
+    mutable Color32 editFieldBackground; // Also updated by refreshValueText() for color display vars.
 
-    // Last value queried form the user variable as text. Updated by drawVarValue().
+    // Last value queried form the user variable as text.
+    // Updated by refreshValueText() and drawVarValue().
     mutable SmallStr cachedValueText;
 
     // Name displayed in the UI.
@@ -1110,7 +1462,10 @@ public:
     virtual void onMove(int displacementX, int displacementY) override;
     virtual void onAdjustLayout() override;
     virtual void onDisableEditing() override;
+    virtual void onScrollContentUp() override;
+    virtual void onScrollContentDown() override;
     virtual void setMouseIntersecting(bool intersect) override;
+    virtual void refreshHitBounds() override;
 
     virtual bool onMouseButton(MouseButton button, int clicks) override;
     virtual bool onMouseMotion(int mx, int my) override;
@@ -1143,6 +1498,25 @@ public:
     void setResizeable(bool resizeable);
     bool isResizeable() const;
 
+    // Variable rows. The VarDisplayWidgets of the window are kept in a flat list of the rows not
+    // under a collapsed hierarchy, and only the ones that fit in the usable rect are laid out
+    // and made children of the window, so drawing and the mouse events never go over the others.
+    // Scrolling just moves the first row in view. Changes are applied by updateVarRows(), which
+    // the window calls at the start of its input events and the owner must call before drawing.
+    void addVarRow(VarDisplayWidget * row);
+    void removeVarRow(VarDisplayWidget * row);
+    void removeAllVarRows();
+    void invalidateVarRows(bool listChanged);
+    void updateVarRows();
+
+    // Distance from the top of the window to the first row and from one row to the next.
+    void setVarRowLayout(int topSpacing, int rowStride);
+
+    int getVarRowCount() const;
+    int getFirstVarRowInView() const;
+    int getVarRowsInViewCount() const;
+    VarDisplayWidget * getVarRowInView(int index) const;
+
     #if NEO_TWEAK_BAR_DEBUG
     SmallStr getTypeString() const override;
     #endif // NEO_TWEAK_BAR_DEBUG
@@ -1153,6 +1527,8 @@ private:
     void resizeWithMin(Corner corner, int & x, int & y, int offsetX, int offsetY);
     void refreshBarRects(const char * newTitle, const char * newInfoString);
     void refreshUsableRect();
+    void appendExpandedRows(VarDisplayWidget * row);
+    void detachVarRows(PODArray & rows);
 
     Rectangle usableRect;     // Size discounting the top/side bars.
     Corner    resizingCorner; // Which corner being resized by user input.
@@ -1173,6 +1549,17 @@ private:
     std::int16_t scrollBarWidth;
     std::int16_t minWindowWidth;
     std::int16_t minWindowHeight;
+
+    // Variable rows. The ones in view are the last children of the window, after the bars.
+    PODArray varRows;            // [VarDisplayWidget *] Top-level rows, in insertion order.
+    PODArray expandedRows;       // [VarDisplayWidget *] All rows not under a collapsed hierarchy, in display order.
+    int      firstVarRow;        // Index in expandedRows of the first row in view. The scroll position.
+    int      varRowsInView;      // Number of rows at the end of the children list.
+    int      varRowTopSpacing;   // See setVarRowLayout().
+    int      varRowStride;
+    bool     hasVarRows;         // Set by the first addVarRow(). From then on the rows drive the scroll bar.
+    bool     varRowsOutdated;    // Rows in view have to be laid out again by updateVarRows().
+    bool     varRowListOutdated; // expandedRows has to be rebuilt as well.
 };
 
 // ========================================================
@@ -1314,18 +1701,35 @@ inline void Widget::setGUI(GUI * newGUI)
 inline void Widget::setParent(Widget * newParent)
 {
     parent = newParent;
+    markDirty();
 }
 
 inline void Widget::setColors(const ColorScheme * newColors)
 {
     NTB_ASSERT(newColors != nullptr);
-    colors = newColors;
+    if (colors != newColors)
+    {
+        colors = newColors;
+        markRedraw();
+    }
+}
+
+inline void Widget::setNormalColorsIfNotHovered()
+{
+    // For the bars a parent highlights along with itself. Their own mouse motion
+    // events only change the colors when they enter or leave the hover state, if
+    // they get the event at all, so the parent restores them when it loses the cursor.
+    if (!isMouseIntersecting())
+    {
+        setNormalColors();
+    }
 }
 
 inline void Widget::setRect(const Rectangle & newRect)
 {
     rect = newRect;
     onAdjustLayout();
+    markDirty();
 }
 
 inline const ColorScheme & Widget::getColors() const
@@ -1365,6 +1769,7 @@ inline void Widget::addChild(Widget * newChild)
 {
     NTB_ASSERT(newChild != nullptr);
     children.pushBack<Widget *>(newChild);
+    markDirty();
 }
 
 inline const Widget * Widget::getChild(int index) const
@@ -1385,11 +1790,13 @@ inline int Widget::getChildCount() const
 inline void Widget::orphanAllChildren()
 {
     children.clear();
+    markDirty();
 }
 
 inline void Widget::setScaling(Float32 s)
 {
     scaling = s;
+    markDirty();
     const int childCount = getChildCount();
     for (int c = 0; c < childCount; ++c)
     {
@@ -1400,6 +1807,7 @@ inline void Widget::setScaling(Float32 s)
 inline void Widget::setTextScaling(Float32 s)
 {
     textScaling = s;
+    markDirty();
     const int childCount = getChildCount();
     for (int c = 0; c < childCount; ++c)
     {
@@ -1437,7 +1845,41 @@ inline void Widget::setFlag(std::uint32_t mask, int f)
     // Using one of the Standford bit-hacks:
     // (Conditionally set or clear bit without branching)
     // http://graphics.stanford.edu/~seander/bithacks.html
-    flags = (flags & ~mask) | (-f & mask);
+    const std::uint32_t newFlags = (flags & ~mask) | (-f & mask);
+    if (newFlags != flags)
+    {
+        flags = newFlags;
+
+        // The hover and slider states change often, and never move anything.
+        if (mask & ~(Flag_MouseIntersecting | Flag_HoldingScrollSlider))
+        {
+            markDirty();
+        }
+        else
+        {
+            markRedraw();
+        }
+    }
+}
+
+inline bool Widget::isDirty() const
+{
+    return dirty;
+}
+
+inline void Widget::clearDirty()
+{
+    dirty = false;
+}
+
+inline const Rectangle & Widget::getHitBounds() const
+{
+    return hitBounds;
+}
+
+inline bool Widget::isHitActive() const
+{
+    return hitActive;
 }
 
 #if NEO_TWEAK_BAR_DEBUG
@@ -1458,7 +1900,11 @@ inline bool ButtonWidget::getState() const
 
 inline void ButtonWidget::setState(bool newState)
 {
-    state = newState;
+    if (state != newState)
+    {
+        state = newState;
+        markDirty();
+    }
 }
 
 inline bool ButtonWidget::isCheckboxButton() const
@@ -1473,7 +1919,11 @@ inline ButtonWidget::Icon ButtonWidget::getIcon() const
 
 inline void ButtonWidget::setIcon(Icon newIcon)
 {
-    icon = newIcon;
+    if (icon != newIcon)
+    {
+        icon = newIcon;
+        markDirty();
+    }
 }
 
 inline bool ButtonWidget::hasEventListener() const
@@ -1505,6 +1955,7 @@ inline SmallStr ButtonWidget::getTypeString() const
 inline void TitleBarWidget::setTitle(const char * newTitle)
 {
     titleText = newTitle;
+    markDirty();
 }
 
 inline const char * TitleBarWidget::getTitle() const
@@ -1532,6 +1983,7 @@ inline void InfoBarWidget::setText(const char * newText)
 {
     infoText  = " » ";
     infoText += newText;
+    markDirty();
 }
 
 inline const char * InfoBarWidget::getText() const
@@ -1628,6 +2080,11 @@ inline void ColorPickerWidget::setMouseIntersecting(bool intersect)
         titleBar.setHighlightedColors();
         scrollBar.setHighlightedColors();
     }
+    else
+    {
+        titleBar.setNormalColorsIfNotHovered();
+        scrollBar.setNormalColorsIfNotHovered();
+    }
 }
 
 inline void ColorPickerWidget::setButtonTextScaling(Float32 s)
@@ -1708,7 +2165,9 @@ inline const Vec3 & View3DWidget::getRotationDegrees() const
 
 inline void View3DWidget::setRotationDegrees(const Vec3 & degrees)
 {
-    rotationDegrees = degrees;
+    rotationDegrees   = degrees;
+    updateScrGeometry = true;
+    markDirty();
 }
 
 #if NEO_TWEAK_BAR_DEBUG
@@ -1732,6 +2191,20 @@ inline int VarDisplayWidget::getExpandCollapseButtonSize() const
     return Widget::uiScaleBy(initialHeight, 0.8);
 }
 
+inline int VarDisplayWidget::getRowIndent() const
+{
+    return rowIndent;
+}
+
+inline void VarDisplayWidget::setRowIndent(int indent)
+{
+    rowIndent = indent;
+    if (parentWindow != nullptr)
+    {
+        parentWindow->invalidateVarRows(false);
+    }
+}
+
 inline bool VarDisplayWidget::hasExpandCollapseButton() const
 {
     return expandCollapseButton.getIcon() != ButtonWidget::Icon::None;
@@ -1750,6 +2223,7 @@ inline const Rectangle & VarDisplayWidget::getDataDisplayRect() const
 inline void VarDisplayWidget::setDataDisplayRect(const Rectangle & newRect)
 {
     dataDisplayRect = newRect;
+    markDirty();
 }
 
 inline const WindowWidget * VarDisplayWidget::getParentWindow() const
@@ -1771,11 +2245,13 @@ inline void VarDisplayWidget::setVarName(const SmallStr & name)
 {
     varName = name;
     titleWidth = (int)GeometryBatch::calcTextWidth(varName.c_str(), varName.getLength(), gui->getGlobalTextScaling());
+    markDirty();
 }
 
 inline void VarDisplayWidget::setVarName(const char * name)
 {
     varName = name;
+    markDirty();
 }
 
 // ========================================================
@@ -1826,6 +2302,7 @@ inline void WindowWidget::setPopupWidget(Widget * popup)
 {
     NTB_ASSERT(popupWidget == nullptr); // should call destroyPopupWidget first.
     popupWidget = popup;
+    markDirty();
 }
 
 inline Widget * WindowWidget::getPopupWidget() const
@@ -1868,4 +2345,39 @@ inline bool WindowWidget::isResizeable() const
     return !testFlag(Flag_NoResizing);
 }
 
+inline void WindowWidget::invalidateVarRows(bool listChanged)
+{
+    varRowsOutdated = true;
+    varRowListOutdated |= listChanged;
+    markDirty();
+}
+
+inline void WindowWidget::setVarRowLayout(int topSpacing, int rowStride)
+{
+    varRowTopSpacing = topSpacing;
+    varRowStride     = rowStride;
+    invalidateVarRows(false);
+}
+
+inline int WindowWidget::getVarRowCount() const
+{
+    return expandedRows.getSize();
+}
+
+inline int WindowWidget::getFirstVarRowInView() const
+{
+    return firstVarRow;
+}
+
+inline int WindowWidget::getVarRowsInViewCount() const
+{
+    return varRowsInView;
+}
+
+inline VarDisplayWidget * WindowWidget::getVarRowInView(int index) const
+{
+    NTB_ASSERT(index >= 0 && index < varRowsInView);
+    return static_cast<VarDisplayWidget *>(children.get<Widget *>(getChildCount() - varRowsInView + index));
+}
+
 } // namespace ntb {}